@@ -37,6 +37,16 @@
 #define _MODBUS_RTU_PRESET_RSP_LENGTH  2
 #define _MODBUS_RTU_CHECKSUM_LENGTH    2
 
+/* Above 19200 bauds the silent interval is fixed to 1750 us (Modbus over
+   serial line V1.02, 2.5.1.1) */
+#define _MODBUS_RTU_T35_FIXED_BAUD     19200
+#define _MODBUS_RTU_T35_FIXED          1750
+
+/* Margin added to t3.5 before addressing a slave, the time a slave needs to
+   release the RS485 line and get ready for the next request */
+#define _MODBUS_RTU_DEFAULT_TURNAROUND 5000
+#define _MODBUS_RTU_MAX_TURNAROUND     32
+
 /* Time waited beetween the RTS switch before transmit data or after transmit
    data before to read */
 #define _MODBUS_RTU_TIME_BETWEEN_RTS_SWITCH 10000
@@ -81,8 +91,20 @@ typedef struct _modbus_rtu {
 #endif
 #if HAVE_DECL_TIOCM_RTS
     int rts;
-    int onebyte_time;
 #endif
+    /* Time in micro second to send one byte */
+    int onebyte_time;
+    /* Silent interval between two frames in micro second */
+    int t35;
+    /* Turnaround in micro second, per slave and for everybody else */
+    int turnaround;
+    int turnaround_nb;
+    int turnaround_slave[_MODBUS_RTU_MAX_TURNAROUND];
+    int turnaround_time[_MODBUS_RTU_MAX_TURNAROUND];
+    /* Monotonic time in micro second of the end of the last frame on the line */
+    int64_t last_frame;
+    /* Monotonic time in micro second of the end of the last request sent */
+    int64_t last_request;
     /* To handle many slaves on the same link */
     int confirmation_to_ignore;
 } modbus_rtu_t;
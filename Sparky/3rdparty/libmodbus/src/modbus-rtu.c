@@ -24,6 +24,9 @@
 #ifndef _MSC_VER
 #include <unistd.h>
 #endif
+#if !defined(_WIN32)
+#include <time.h>
+#endif
 #include <assert.h>
 
 #include "modbus-private.h"
@@ -166,6 +169,18 @@ static int _modbus_rtu_build_response_basis(sft_t *sft, uint8_t *rsp)
 {
     /* In this case, the slave is certainly valid because a check is already
      * done in _modbus_rtu_listen */
+    if (sft->slave > 255) // DKOH : extended slaveid, answered the way it was asked
+    {
+        rsp[0] = 0xFA;
+        rsp[1] = (sft->slave>>24) & 0xFF;
+        rsp[2] = (sft->slave>>16) & 0xFF;
+        rsp[3] = (sft->slave>>8)  & 0xFF;
+        rsp[4] = (sft->slave)     & 0xFF;
+        rsp[5] = sft->function;
+
+        return _MODBUS_RTU_PRESET_RSP_LENGTH + 4;
+    }
+
     rsp[0] = sft->slave;
     rsp[1] = sft->function;
 
@@ -306,7 +321,78 @@ static void _modbus_rtu_ioctl_rts(int fd, int on)
 }
 #endif
 
-static ssize_t _modbus_rtu_send(modbus_t *ctx, const uint8_t *req, int req_length)
+/* Monotonic clock in micro second */
+static int64_t _modbus_rtu_now(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER freq;
+    LARGE_INTEGER count;
+
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (int64_t)(count.QuadPart / freq.QuadPart) * 1000000 +
+           (int64_t)(count.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+static void _modbus_rtu_wait(int64_t usec)
+{
+#if defined(_WIN32)
+    int64_t end = _modbus_rtu_now() + usec;
+
+    /* Sleep() has a granularity of a system tick (about 16 ms), spin over the
+       last tick to stay close to t3.5 */
+    if (usec > 20000) {
+        Sleep((DWORD)((usec - 16000) / 1000));
+    }
+    while (_modbus_rtu_now() < end);
+#else
+    struct timespec request;
+    struct timespec remaining;
+
+    request.tv_sec = usec / 1000000;
+    request.tv_nsec = (usec % 1000000) * 1000;
+    while (nanosleep(&request, &remaining) == -1 && errno == EINTR) {
+        request = remaining;
+    }
+#endif
+}
+
+static int _modbus_rtu_turnaround(modbus_rtu_t *ctx_rtu, int slave)
+{
+    int i;
+
+    for (i = 0; i < ctx_rtu->turnaround_nb; i++) {
+        if (ctx_rtu->turnaround_slave[i] == slave) {
+            return ctx_rtu->turnaround_time[i];
+        }
+    }
+
+    return ctx_rtu->turnaround;
+}
+
+/* Keep the line silent for t3.5 plus the turnaround of the addressed slave
+   since the end of the last frame */
+static void _modbus_rtu_pace(modbus_t *ctx)
+{
+    modbus_rtu_t *ctx_rtu = ctx->backend_data;
+    int64_t silence = ctx_rtu->t35 + _modbus_rtu_turnaround(ctx_rtu, ctx->slave);
+    int64_t elapsed = _modbus_rtu_now() - ctx_rtu->last_frame;
+
+    if (elapsed < silence) {
+        if (ctx->debug) {
+            printf("Pacing %d us\n", (int)(silence - elapsed));
+        }
+        _modbus_rtu_wait(silence - elapsed);
+    }
+}
+
+static ssize_t _modbus_rtu_write(modbus_t *ctx, const uint8_t *req, int req_length)
 {
 #if defined(_WIN32)
     modbus_rtu_t *ctx_rtu = ctx->backend_data;
@@ -340,6 +426,30 @@ static ssize_t _modbus_rtu_send(modbus_t *ctx, const uint8_t *req, int req_lengt
 #endif
 }
 
+static ssize_t _modbus_rtu_send(modbus_t *ctx, const uint8_t *req, int req_length)
+{
+    modbus_rtu_t *ctx_rtu = ctx->backend_data;
+    int64_t start;
+    int64_t now;
+    ssize_t size;
+
+    _modbus_rtu_pace(ctx);
+
+    start = _modbus_rtu_now();
+    size = _modbus_rtu_write(ctx, req, req_length);
+
+    /* write() returns once the driver has the bytes, the frame only ends
+       when the last character has left the wire */
+    now = _modbus_rtu_now();
+    ctx_rtu->last_frame = start + (int64_t)ctx_rtu->onebyte_time * req_length;
+    if (ctx_rtu->last_frame < now) {
+        ctx_rtu->last_frame = now;
+    }
+    ctx_rtu->last_request = ctx_rtu->last_frame;
+
+    return size;
+}
+
 static int _modbus_rtu_receive(modbus_t *ctx, uint8_t *req)
 {
     int rc;
@@ -365,11 +475,21 @@ static int _modbus_rtu_receive(modbus_t *ctx, uint8_t *req)
 
 static ssize_t _modbus_rtu_recv(modbus_t *ctx, uint16_t *rsp, int rsp_length)
 {
+    modbus_rtu_t *ctx_rtu = ctx->backend_data;
+    ssize_t size;
+
 #if defined(_WIN32)
-    return win32_ser_read(&((modbus_rtu_t *)ctx->backend_data)->w_ser, rsp, rsp_length);
+    size = win32_ser_read(&ctx_rtu->w_ser, rsp, rsp_length);
 #else
-    return read(ctx->s, rsp, rsp_length);
+    size = read(ctx->s, rsp, rsp_length);
 #endif
+
+    /* The line is busy up to the last received byte */
+    if (size > 0) {
+        ctx_rtu->last_frame = _modbus_rtu_now();
+    }
+
+    return size;
 }
 
 static int _modbus_rtu_flush(modbus_t *);
@@ -1071,6 +1191,86 @@ int modbus_rtu_get_rts(modbus_t *ctx)
     }
 }
 
+int modbus_rtu_set_turnaround(modbus_t *ctx, int slave, int usec)
+{
+    modbus_rtu_t *ctx_rtu;
+    int i;
+
+    if (ctx == NULL || usec < 0 ||
+        ctx->backend->backend_type != _MODBUS_BACKEND_TYPE_RTU) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    ctx_rtu = ctx->backend_data;
+
+    if (slave == MODBUS_RTU_TURNAROUND_DEFAULT) {
+        ctx_rtu->turnaround = usec;
+        return 0;
+    }
+
+    for (i = 0; i < ctx_rtu->turnaround_nb; i++) {
+        if (ctx_rtu->turnaround_slave[i] == slave) {
+            ctx_rtu->turnaround_time[i] = usec;
+            return 0;
+        }
+    }
+
+    if (ctx_rtu->turnaround_nb == _MODBUS_RTU_MAX_TURNAROUND) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    ctx_rtu->turnaround_slave[ctx_rtu->turnaround_nb] = slave;
+    ctx_rtu->turnaround_time[ctx_rtu->turnaround_nb] = usec;
+    ctx_rtu->turnaround_nb++;
+
+    return 0;
+}
+
+int modbus_rtu_get_turnaround(modbus_t *ctx, int slave)
+{
+    modbus_rtu_t *ctx_rtu;
+
+    if (ctx == NULL || ctx->backend->backend_type != _MODBUS_BACKEND_TYPE_RTU) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    ctx_rtu = ctx->backend_data;
+
+    if (slave == MODBUS_RTU_TURNAROUND_DEFAULT) {
+        return ctx_rtu->turnaround;
+    }
+
+    return _modbus_rtu_turnaround(ctx_rtu, slave);
+}
+
+int modbus_rtu_get_t35(modbus_t *ctx)
+{
+    if (ctx == NULL || ctx->backend->backend_type != _MODBUS_BACKEND_TYPE_RTU) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return ((modbus_rtu_t *)ctx->backend_data)->t35;
+}
+
+int64_t modbus_rtu_get_request_end(modbus_t *ctx)
+{
+    if (ctx == NULL || ctx->backend->backend_type != _MODBUS_BACKEND_TYPE_RTU) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return ((modbus_rtu_t *)ctx->backend_data)->last_request;
+}
+
+int64_t modbus_rtu_now(void)
+{
+    return _modbus_rtu_now();
+}
+
 static void _modbus_rtu_close(modbus_t *ctx)
 {
     /* Restore line settings and close file descriptor in RTU mode */
@@ -1226,10 +1426,22 @@ modbus_t* modbus_new_rtu(const char *device,
 #if HAVE_DECL_TIOCM_RTS
     /* The RTS use has been set by default */
     ctx_rtu->rts = MODBUS_RTU_RTS_NONE;
+#endif
 
     /* Calculate estimated time in micro second to send one byte */
     ctx_rtu->onebyte_time = (1000 * 1000) * (1 + data_bit + (parity == 'N' ? 0 : 1) + stop_bit) / baud;
-#endif
+
+    /* 3.5 characters of silence between frames */
+    if (baud > _MODBUS_RTU_T35_FIXED_BAUD) {
+        ctx_rtu->t35 = _MODBUS_RTU_T35_FIXED;
+    } else {
+        ctx_rtu->t35 = (ctx_rtu->onebyte_time * 7) / 2;
+    }
+
+    ctx_rtu->turnaround = _MODBUS_RTU_DEFAULT_TURNAROUND;
+    ctx_rtu->turnaround_nb = 0;
+    ctx_rtu->last_frame = 0;
+    ctx_rtu->last_request = 0;
 
     ctx_rtu->confirmation_to_ignore = FALSE;
 
@@ -44,6 +44,17 @@ MODBUS_API int modbus_rtu_get_serial_mode(modbus_t *ctx);
 MODBUS_API int modbus_rtu_set_rts(modbus_t *ctx, int mode);
 MODBUS_API int modbus_rtu_get_rts(modbus_t *ctx);
 
+/* Slave argument selecting the turnaround applied to every other slave */
+#define MODBUS_RTU_TURNAROUND_DEFAULT -1
+
+MODBUS_API int modbus_rtu_set_turnaround(modbus_t *ctx, int slave, int usec);
+MODBUS_API int modbus_rtu_get_turnaround(modbus_t *ctx, int slave);
+MODBUS_API int modbus_rtu_get_t35(modbus_t *ctx);
+
+/* Monotonic clock (us) of the pacing, and when the last request left the line */
+MODBUS_API int64_t modbus_rtu_get_request_end(modbus_t *ctx);
+MODBUS_API int64_t modbus_rtu_now(void);
+
 MODBUS_END_DECLS
 
 #endif /* MODBUS_RTU_H */
@@ -764,7 +764,7 @@ int modbus_reply(modbus_t *ctx, const uint8_t *req,
 {
     int offset = ctx->backend->header_length;
 	if (ctx->slave > MAX_MODBUS_ID) offset+=4; // DKOH
-    int slave = req[offset - 1];
+    int slave = (ctx->slave > MAX_MODBUS_ID) ? ctx->slave : req[offset - 1]; // extended id is the serial number, not its last byte
     int function = req[offset];
     uint16_t address = (req[offset + 1] << 8) + req[offset + 2];
     uint8_t rsp[MAX_MESSAGE_LENGTH];
@@ -1149,7 +1149,7 @@ int modbus_reply_exception(modbus_t *ctx, const uint8_t *req,
 {
     int offset = ctx->backend->header_length;
 	if (ctx->slave > MAX_MODBUS_ID) offset+=4; // DKOH
-    int slave = req[offset - 1];
+    int slave = (ctx->slave > MAX_MODBUS_ID) ? ctx->slave : req[offset - 1]; // extended id is the serial number, not its last byte
     int function = req[offset];
     uint8_t rsp[MAX_MESSAGE_LENGTH];
     int rsp_length;
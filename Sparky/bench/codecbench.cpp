@@ -0,0 +1,106 @@
+/// Compares the register codec against the string based conversion it
+/// replaced (sprintf per register, QByteArray::fromHex, binary string and
+/// a pow() loop over the mantissa).
+///
+/// usage: codecbench [values]
+
+#include <math.h>
+#include <stdio.h>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include "registercodec.h"
+
+#define BENCH_DEFAULT_VALUES        100000
+
+
+static float
+legacyToFloat(QByteArray f)
+{
+    bool ok;
+    int sign = 1;
+
+    f = f.toHex();
+    f = QByteArray::number(f.toLongLong(&ok, 16), 2);
+
+    if(f.length() == 32) {
+        if(f.at(0) == '1') sign =-1;
+        f.remove(0,1);
+    }
+
+    QByteArray fraction = f.right(23);
+    double mantissa = 0;
+    for(int i = 0; i < fraction.length(); i++){
+        if(fraction.at(i) == '1')
+            mantissa += 1.0 / (pow(2, i+1));
+    }
+
+    int exponent = f.left(f.length() - 23).toLongLong(&ok, 2) - 127;
+
+    return (sign * pow(2, exponent) * (mantissa + 1.0));
+}
+
+
+static float
+legacyDecode(const uint16_t * dest16)
+{
+    QString qs_output = "0x";
+
+    for (int i = 0; i < CODEC_WIDE_REGISTERS; ++i)
+    {
+        QString qs_tmp;
+        qs_tmp.sprintf("%04x", dest16[i]);
+        qs_output.append(qs_tmp);
+    }
+
+    return legacyToFloat(QByteArray::fromHex(qs_output.toLatin1()));
+}
+
+
+int
+main(int argc, char * argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    const int n = (argc > 1) ? QString(argv[1]).toInt() : BENCH_DEFAULT_VALUES;
+    QVector<float> values(n);
+    QVector<float> decoded(n);
+    QVector<uint16_t> regs(n*CODEC_WIDE_REGISTERS);
+    QElapsedTimer timer;
+    double sum = 0;
+    int mismatch = 0;
+
+    /// calibration-like values, no zero (the legacy path cannot decode it)
+    for (int i = 0; i < n; i++) values[i] = (i % 2 ? -1.0f : 1.0f) * (0.001f + (i % 1000) * 0.123f);
+    DeviceCodec::fromFloats(values.constData(), regs.data(), n);
+
+    timer.start();
+    for (int i = 0; i < n; i++) sum += legacyDecode(regs.constData() + i*CODEC_WIDE_REGISTERS);
+    const qint64 legacy = timer.nsecsElapsed();
+
+    timer.start();
+    for (int i = 0; i < n; i++) sum += DeviceCodec::toFloat(regs.constData() + i*CODEC_WIDE_REGISTERS);
+    const qint64 single = timer.nsecsElapsed();
+
+    timer.start();
+    DeviceCodec::toFloats(regs.constData(), decoded.data(), n);
+    const qint64 batch = timer.nsecsElapsed();
+
+    for (int i = 0; i < n; i++)
+    {
+        sum += decoded[i];
+        if (decoded[i] != values[i]) mismatch++;
+        if (legacyDecode(regs.constData() + i*CODEC_WIDE_REGISTERS) != values[i]) mismatch++;
+    }
+
+    printf("values   %d\n", n);
+    printf("legacy   %10.2f ns/value\n", (double) legacy / n);
+    printf("codec    %10.2f ns/value\n", (double) single / n);
+    printf("batch    %10.2f ns/value\n", (double) batch / n);
+    printf("speedup  %10.1fx\n", (batch > 0) ? (double) legacy / batch : 0.0);
+    printf("mismatch %d (checksum %g)\n", mismatch, sum);
+
+    return (mismatch == 0) ? 0 : 1;
+}
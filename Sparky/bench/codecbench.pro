@@ -0,0 +1,12 @@
+TARGET = codecbench
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+QT -= gui
+
+SOURCES += codecbench.cpp
+
+HEADERS += ../src/registercodec.h
+
+INCLUDEPATH += ../src
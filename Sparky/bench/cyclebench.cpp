@@ -0,0 +1,290 @@
+/// Times Sparky's acquisition cycle as the calibration engine runs it
+/// (CalEngine::readMasterPipe, then readPipe and writeSample per pipe)
+/// against the loopback simulator and writes the results as JSON.
+///
+/// usage: cyclebench [--pipes 1-3] [--cycles n] [--eea] [--serial sn]
+///                   [--gap n] [--turnaround us] [--baud n]
+///                   [--port tty | --sim path] [--out file]
+
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QVector>
+#include "calengine.h"
+
+#define BENCH_MAX_PIPES             3
+#define BENCH_DEFAULT_CYCLES        200
+#define BENCH_DEFAULT_SERIAL        1001    /// above 255, so the extended addressing is exercised
+#define BENCH_DEFAULT_BAUD          19200
+#define BENCH_DEFAULT_OUT           "cyclebench.json"
+#define BENCH_SIM_TIMEOUT           5000
+
+/// phases of one cycle
+enum BENCH_PHASE
+{
+    PHASE_MASTER,
+    PHASE_PIPE,
+    PHASE_WRITE,
+    PHASE_COUNT
+};
+
+
+/// prepare() asks nothing, the acquisition cycle neither
+class BenchOperator : public CalOperator
+{
+public:
+    bool confirm(const QString &, const QString &) { return true; }
+    double askValue(const QString &, const double value) { return value; }
+    QString askText(const QString &, const QString & text) { return text; }
+    void inform(const QString &, const QString &) {}
+};
+
+/// filled from the bus thread through the monitor hooks
+static std::atomic<qint64> requests(0);
+static std::atomic<qint64> bytesOut(0);
+static std::atomic<qint64> bytesIn(0);
+
+
+static void
+onBusItem(modbus_t *, uint8_t isOut, uint16_t slave, uint8_t func, uint16_t, uint16_t, uint16_t, uint16_t)
+{
+    if (!isOut) return;
+
+    /// raw bytes are only reported on receive, a read request is a fixed frame
+    requests++;
+    if (func == MODBUS_FC_READ_INPUT_REGISTERS) bytesOut += (slave > 255) ? 12 : 8;
+}
+
+
+static void
+onBusRaw(modbus_t *, uint8_t *, uint8_t len, uint8_t)
+{
+    bytesIn += len;
+}
+
+
+static double
+percentile(const QVector<qint64> & sorted, const double p)
+{
+    if (sorted.isEmpty()) return 0;
+
+    return sorted[qMin(sorted.size() - 1, (int) (p*sorted.size()))]/1000.0;
+}
+
+
+/// starts the simulator on a private link and waits for it to serve
+static bool
+startSimulator(QProcess & sim, const QString & program, const QString & link, const int pipes, const int serial, const bool isEEA)
+{
+    QStringList args;
+
+    args << "--link" << link << "--noise" << "0";
+    for (int i = 0; i < pipes; i++) args << ((isEEA) ? "--eea" : "--razor") << QString::number(serial + i);
+
+    sim.start(program, args);
+
+    if (!sim.waitForStarted(BENCH_SIM_TIMEOUT)) return false;
+
+    while (sim.canReadLine() || sim.waitForReadyRead(BENCH_SIM_TIMEOUT))
+    {
+        if (sim.readLine().startsWith("sparkysim: serving")) return true;
+    }
+
+    return false;
+}
+
+
+int
+main(int argc, char * argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    int pipes = 1;
+    int cycles = BENCH_DEFAULT_CYCLES;
+    int serial = BENCH_DEFAULT_SERIAL;
+    int gap = PLANNER_DEFAULT_GAP;
+    int turnaround = BUS_DEFAULT_TURNAROUND;
+    int baud = BENCH_DEFAULT_BAUD;
+    bool isEEA = false;
+    QString port;
+    QString simProgram = "sparkysim";
+    QString out = BENCH_DEFAULT_OUT;
+
+    for (int i = 1; i < args.size(); i++)
+    {
+        const QString value = args.value(i + 1);
+
+        if (args[i] == "--eea") { isEEA = true; continue; }
+
+        if (args[i] == "--pipes") pipes = qBound(1, value.toInt(), BENCH_MAX_PIPES);
+        else if (args[i] == "--cycles") cycles = qMax(1, value.toInt());
+        else if (args[i] == "--serial") serial = value.toInt();
+        else if (args[i] == "--gap") gap = value.toInt();
+        else if (args[i] == "--turnaround") turnaround = value.toInt();
+        else if (args[i] == "--baud") baud = value.toInt();
+        else if (args[i] == "--port") port = value;
+        else if (args[i] == "--sim") simProgram = value;
+        else if (args[i] == "--out") out = value;
+        else
+        {
+            fprintf(stderr, "usage: cyclebench [--pipes 1-3] [--cycles n] [--eea] [--serial sn]\n"
+                            "                  [--gap n] [--turnaround us] [--baud n]\n"
+                            "                  [--port tty | --sim path] [--out file]\n");
+            return 2;
+        }
+
+        i++;
+    }
+
+    QTemporaryDir dir;
+    QProcess sim;
+
+    if (port.isEmpty())
+    {
+        port = dir.filePath("ttySIM");
+
+        if (!startSimulator(sim, simProgram, port, pipes, serial, isEEA))
+        {
+            fprintf(stderr, "cyclebench: cannot start %s\n", qPrintable(simProgram));
+            return 1;
+        }
+    }
+
+    CAL_CONFIGS config;
+    BenchOperator op;
+    QString error;
+
+    config.port = port;
+    config.baud = baud;
+    config.readGap = gap;
+    config.turnaround = turnaround;
+    config.isEEA = isEEA;
+    config.isMaster = true;
+    config.loopVolume = 1;
+    config.mainServer = dir.path();
+    config.journal = dir.filePath("BENCH.JNL");
+    for (int i = 0; i < pipes; i++) config.serials.append(serial + i);
+
+    CalEngine engine(config, &op);
+
+    /// opens the port, checks every serial number and names the pipe files
+    if (!engine.prepare(error))
+    {
+        fprintf(stderr, "cyclebench: %s on %s\n", qPrintable(error), qPrintable(port));
+        return 1;
+    }
+
+    engine.bus()->setMonitor(onBusItem, onBusRaw);
+
+    QVector<qint64> latency;
+    qint64 phase[PHASE_COUNT] = {0};
+    QElapsedTimer total;
+    QElapsedTimer timer;
+
+    /// one untimed cycle so the first open and the simulator's start do not count
+    engine.readMasterPipe();
+    for (int i = 0; i < pipes; i++) engine.readPipe(i, false);
+
+    const int warmupFailed = engine.failedFrames();
+
+    requests = 0;
+    bytesOut = 0;
+    bytesIn = 0;
+    latency.reserve(cycles);
+    total.start();
+
+    for (int c = 0; c < cycles; c++)
+    {
+        const qint64 start = total.nsecsElapsed();
+
+        timer.start();
+        engine.readMasterPipe();
+        phase[PHASE_MASTER] += timer.nsecsElapsed();
+
+        for (int i = 0; i < pipes; i++)
+        {
+            timer.start();
+            engine.readPipe(i, true);
+            phase[PHASE_PIPE] += timer.nsecsElapsed();
+
+            timer.start();
+            engine.writeSample(i);
+            phase[PHASE_WRITE] += timer.nsecsElapsed();
+        }
+
+        latency.append((total.nsecsElapsed() - start)/1000);
+    }
+
+    const double seconds = total.nsecsElapsed()/1e9;
+    const qint64 busy = phase[PHASE_MASTER] + phase[PHASE_PIPE] + phase[PHASE_WRITE];
+    const int failed = engine.failedFrames() - warmupFailed;
+    double mean = 0;
+
+    engine.bus()->close();
+    if (sim.state() != QProcess::NotRunning)
+    {
+        sim.terminate();
+        sim.waitForFinished(BENCH_SIM_TIMEOUT);
+    }
+
+    for (int i = 0; i < latency.size(); i++) mean += latency[i];
+    mean /= latency.size()*1000.0;
+    std::sort(latency.begin(), latency.end());
+
+    QJsonObject cycle;
+    cycle["mean_ms"] = mean;
+    cycle["p50_ms"] = percentile(latency, 0.50);
+    cycle["p90_ms"] = percentile(latency, 0.90);
+    cycle["p99_ms"] = percentile(latency, 0.99);
+    cycle["max_ms"] = latency.last()/1000.0;
+
+    /// write is the data line, its formatting and the append
+    QJsonObject share;
+    share["master"] = (busy > 0) ? (double) phase[PHASE_MASTER]/busy : 0.0;
+    share["pipe"] = (busy > 0) ? (double) phase[PHASE_PIPE]/busy : 0.0;
+    share["write"] = (busy > 0) ? (double) phase[PHASE_WRITE]/busy : 0.0;
+
+    QJsonObject result;
+    result["analyzer"] = (isEEA) ? "eea" : "razor";
+    result["pipes"] = pipes;
+    result["cycles"] = cycles;
+    result["baud"] = baud;
+    result["gap"] = gap;
+    result["turnaround_us"] = turnaround;
+    result["seconds"] = seconds;
+    result["cycle"] = cycle;
+    result["transactions"] = (double) requests;
+    result["transactions_per_s"] = requests/seconds;
+    result["bytes_out"] = (double) bytesOut;
+    result["bytes_in"] = (double) bytesIn;
+    result["bytes_per_cycle"] = (double) (bytesOut + bytesIn)/cycles;
+    result["phase_share"] = share;
+    result["failed"] = failed;
+
+    QFile file(out);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        fprintf(stderr, "cyclebench: cannot write %s\n", qPrintable(out));
+        return 1;
+    }
+
+    file.write(QJsonDocument(result).toJson());
+    file.close();
+
+    printf("pipes      %d x %d cycles, %.2f s\n", pipes, cycles, seconds);
+    printf("cycle      p50 %.2f  p90 %.2f  p99 %.2f  max %.2f ms\n", percentile(latency, 0.50), percentile(latency, 0.90), percentile(latency, 0.99), latency.last()/1000.0);
+    printf("bus        %.1f transactions/s, %.0f bytes/cycle\n", requests/seconds, (double) (bytesOut + bytesIn)/cycles);
+    printf("share      master %.1f%%  pipe %.1f%%  write %.1f%%\n", 100.0*share["master"].toDouble(), 100.0*share["pipe"].toDouble(), 100.0*share["write"].toDouble());
+    printf("failed     %d\n", failed);
+
+    return (failed == 0) ? 0 : 1;
+}
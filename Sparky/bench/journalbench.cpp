@@ -0,0 +1,121 @@
+/// Resumes a journal the way a crash leaves it: BENCH_RECORDS complete
+/// checkpoints followed by a record torn off in the middle. The resumed
+/// journal has to go on after the last complete record, so that the
+/// checkpoints written after the resume parse again, last() returns the
+/// newest of them and no line holds the torn remainder.
+///
+/// usage: journalbench
+
+#include <stdio.h>
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QTemporaryDir>
+#include "caljournal.h"
+
+#define BENCH_RECORDS               5
+#define BENCH_RESUMED               3
+
+
+static QVariantMap
+record(const int step)
+{
+    QVariantMap map;
+
+    map["step"] = step;
+    map["state"] = "STATE_SAMPLE";
+    map["watercut"] = step*0.25;
+
+    return map;
+}
+
+
+/// checks one condition, the name goes out either way
+static bool
+check(const bool isOk, const char * name)
+{
+    printf("%-40s %s\n", name, (isOk) ? "ok" : "FAIL");
+
+    return isOk;
+}
+
+
+int
+main(int argc, char * argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTemporaryDir dir;
+    CalJournal journal;
+    QVariantMap last;
+    QString error;
+    int failed = 0;
+
+    if (!dir.isValid())
+    {
+        printf("no temporary directory\n");
+        return 1;
+    }
+
+    const QString fileName = dir.path() + "/LOOP1" + JOURNAL_EXT;
+
+    if (!journal.open(fileName, false)) return 1;
+
+    for (int step = 0; step < BENCH_RECORDS; step++) journal.append(record(step));
+
+    journal.close();
+
+    /// the power goes while the next record is being written
+    {
+        QFile file(fileName);
+        const QByteArray torn = QJsonDocument::fromVariant(record(BENCH_RECORDS)).toJson(QJsonDocument::Compact);
+
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) return 1;
+
+        file.write(torn.left(torn.size()/2));
+        file.close();
+    }
+
+    if (!check(CalJournal::last(fileName, last, error) && (last["step"].toInt() == BENCH_RECORDS - 1), "last skips the torn line")) failed++;
+
+    if (!check(journal.open(fileName, true), "resume opens the journal")) failed++;
+
+    for (int step = BENCH_RECORDS; step < BENCH_RECORDS + BENCH_RESUMED; step++) journal.append(record(step));
+
+    journal.close();
+
+    if (!check(CalJournal::last(fileName, last, error) && (last["step"].toInt() == BENCH_RECORDS + BENCH_RESUMED - 1), "last returns the resumed record")) failed++;
+
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly)) return 1;
+
+    const QByteArray content = file.readAll();
+    const QList<QByteArray> lines = content.split('\n');
+    int records = 0;
+    bool isTorn = false;
+
+    file.close();
+
+    for (int i = 0; i < lines.size(); i++)
+    {
+        if (lines[i].isEmpty()) continue;
+
+        if (QJsonDocument::fromJson(lines[i]).isObject()) records++;
+        else isTorn = true;
+    }
+
+    if (!check(!isTorn, "no line holds the torn remainder")) failed++;
+    if (!check(records == BENCH_RECORDS + BENCH_RESUMED, "every complete record is kept")) failed++;
+    if (!check(content.endsWith('\n'), "the journal ends with a complete line")) failed++;
+
+    /// a journal that ends cleanly is left as it is
+    const qint64 size = content.size();
+
+    if (!check(journal.open(fileName, true) && (QFile(fileName).size() == size), "a clean journal is not cut")) failed++;
+
+    journal.close();
+
+    printf("%d checks failed\n", failed);
+
+    return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,13 @@
+TARGET = journalbench
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+QT -= gui
+
+SOURCES += journalbench.cpp \
+    ../src/caljournal.cpp
+
+HEADERS += ../src/caljournal.h
+
+INCLUDEPATH += ../src
@@ -0,0 +1,122 @@
+/// Checks the settling estimator against known approach curves: a step of
+/// BENCH_STEP settling as final - step*exp(-k/tau) plus gaussian noise.
+/// Every trial is sampled until the estimator calls it settled; that call
+/// is wrong when the drift the curve still has to go is larger than the
+/// tolerance. On every curve the wrong calls must stay within
+/// 1 - confidence, which is what LOOP.StableConfidence promises. The classic rule (BENCH_CLASSIC
+/// readings in a row within the tolerance) is timed on the same samples.
+///
+/// usage: settlingbench [confidence] [trials]
+
+#include <math.h>
+#include <stdio.h>
+#include <random>
+#include <QCoreApplication>
+#include <QString>
+#include <QVector>
+#include "settlingestimator.h"
+
+#define BENCH_DEFAULT_CONFIDENCE    0.95
+#define BENCH_DEFAULT_TRIALS        200
+#define BENCH_SAMPLES               400
+#define BENCH_FINAL                 38.0
+#define BENCH_STEP                  18.0
+#define BENCH_TOLERANCE             0.1     /// zTemp
+#define BENCH_WINDOW                2.0     /// classic count only this close to the target
+#define BENCH_CLASSIC               5
+
+
+typedef struct BENCH_CURVE
+{
+    double tau;             /// samples
+    double noise;           /// standard deviation of a reading
+
+} BENCH_CURVES;
+
+
+/// first sample the classic rule fires at, BENCH_SAMPLES if it never does
+static int
+classicStop(const QVector<double> & values)
+{
+    int count = 0;
+
+    for (int k = 1; k < values.size(); k++)
+    {
+        if ((fabs(BENCH_FINAL - values[k]) < BENCH_WINDOW) && (fabs(values[k] - values[k-1]) <= BENCH_TOLERANCE)) count++;
+        else count = 0;
+
+        if (count >= BENCH_CLASSIC) return k;
+    }
+
+    return BENCH_SAMPLES;
+}
+
+
+int
+main(int argc, char * argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    const double confidence = (argc > 1) ? QString(argv[1]).toDouble() : BENCH_DEFAULT_CONFIDENCE;
+    const int trials = (argc > 2) ? QString(argv[2]).toInt() : BENCH_DEFAULT_TRIALS;
+    const double z = SettlingEstimator::zScore(confidence);
+    const BENCH_CURVES curves[] = {{5, 0.02}, {5, 0.05}, {10, 0.02}, {10, 0.05}, {20, 0.02}, {20, 0.05}, {40, 0.02}, {40, 0.05}, {10, 0.1}, {20, 0.1}, {40, 0.1}};
+    const int curveCount = sizeof(curves)/sizeof(curves[0]);
+    std::mt19937 random(1);
+    int calls = 0;
+    int wrong = 0;
+    int failed = 0;
+
+    printf("confidence %.3f (z %.3f), tolerance %g, %d trials per curve\n", confidence, z, BENCH_TOLERANCE, trials);
+    printf("    tau  noise   settled  wrong  worst drift  predicted  classic\n");
+
+    for (int c = 0; c < curveCount; c++)
+    {
+        std::normal_distribution<double> noise(0, curves[c].noise);
+        int curveCalls = 0;
+        int curveWrong = 0;
+        double worst = 0;
+        double predicted = 0;
+        double classic = 0;
+
+        for (int t = 0; t < trials; t++)
+        {
+            SettlingEstimator estimator;
+            QVector<double> values;
+            int stop = BENCH_SAMPLES;
+
+            for (int k = 0; k < BENCH_SAMPLES; k++)
+            {
+                values.append(BENCH_FINAL - BENCH_STEP*exp(-k/curves[c].tau) + noise(random));
+                estimator.add(values.last());
+
+                SETTLING_FITS f;
+
+                if ((stop < BENCH_SAMPLES) || !estimator.isSettled(BENCH_TOLERANCE, z, f) || (fabs(f.final - BENCH_FINAL) >= BENCH_WINDOW)) continue;
+
+                /// what the curve itself still has to go from here
+                const double drift = BENCH_STEP*exp(-k/curves[c].tau);
+
+                stop = k;
+                curveCalls++;
+                worst = qMax(worst, drift);
+                if (drift > BENCH_TOLERANCE) curveWrong++;
+            }
+
+            predicted += stop;
+            classic += classicStop(values);
+        }
+
+        const bool isOk = (curveWrong <= (1 - confidence)*curveCalls);
+
+        printf("%7.0f %6.2f %9d %6d %12.3f %10.1f %8.1f  %s\n", curves[c].tau, curves[c].noise, curveCalls, curveWrong, worst, predicted/trials, classic/trials, (isOk) ? "ok" : "FAIL");
+
+        calls += curveCalls;
+        wrong += curveWrong;
+        if (!isOk) failed++;
+    }
+
+    printf("wrong    %d of %d (%.3f, allowed %.3f), %d curves failed\n", wrong, calls, (calls > 0) ? (double) wrong/calls : 0, 1 - confidence, failed);
+
+    return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,13 @@
+TARGET = settlingbench
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+QT -= gui
+
+SOURCES += settlingbench.cpp \
+    ../src/settlingestimator.cpp
+
+HEADERS += ../src/settlingestimator.h
+
+INCLUDEPATH += ../src
@@ -0,0 +1,329 @@
+/// Runs full calibrations without the GUI and streams their progress to
+/// stdout. The loop is described by sparky.json (LOOP.* as saved by the
+/// GUI, CAL.* for what the GUI takes from its widgets). With a CAL.Loops
+/// array every entry is a loop of its own, on its own port, and all of
+/// them run at the same time; each output line starts with its loop.
+///
+/// usage: sparky-cli [--config file] [--port tty] [--out dir] [--yes] [--sim] [--resume] [--replay dir]
+///
+///   --port    only with a single loop
+///   --resume  goes on from the last checkpoint in each loop's journal
+///             (CAL.Journal, LOOP<n>.JNL in the output folder by default)
+///   --yes     answers every prompt with yes or its default value
+///   --sim     the loop is sparkysim: the heat exchanger is set through the
+///             simulator's setpoint register instead of asking the operator
+///   --replay  plays the calibration files under dir (the --out of an
+///             earlier run) back instead of reading the bus, on a virtual
+///             clock that starts with the recording; implies --yes and
+///             needs an output folder other than dir
+
+#include <signal.h>
+#include <stdio.h>
+#include <QCoreApplication>
+#include <QTextStream>
+#include <QDir>
+#include <QMutex>
+#include <QSet>
+#include <QSharedPointer>
+#include "calloops.h"
+#include "registercodec.h"
+
+/// sparkysim's heat exchanger setpoint on the control box (float), see
+/// SIM_MASTER_HEATER; a real control box has none, --sim only
+#define CLI_SIM_HEATER              2001
+
+static CalLoops * loops = NULL;
+
+/// the loops share stdout and stdin, one line or one question at a time
+static QMutex console;
+
+
+static void
+onSignal(int)
+{
+    if (loops) loops->abort();
+}
+
+
+static void
+dashboard(const QString & label, const QString & text)
+{
+    QMutexLocker lock(&console);
+
+    printf("%s %s\n", qPrintable(label), qPrintable(text));
+    fflush(stdout);
+}
+
+
+class ConsoleOperator : public CalOperator
+{
+public:
+    ConsoleOperator(const QString & label, const bool isAuto, const bool isSim) : m_label(label), m_isAuto(isAuto), m_isSim(isSim), m_engine(NULL) {}
+
+    void setEngine(CalEngine * engine) { m_engine = engine; }
+
+    bool confirm(const QString & title, const QString & text)
+    {
+        return ask(QString("? %1: %2 [y/n] ").arg(title).arg(text), "y").toLower().startsWith('y');
+    }
+
+    double askValue(const QString & title, const double value)
+    {
+        bool ok;
+
+        const double entered = ask(QString("? %1 [%2] ").arg(title).arg(value), QString::number(value)).toDouble(&ok);
+        return (ok) ? entered : value;
+    }
+
+    QString askText(const QString & title, const QString & text)
+    {
+        return ask(QString("? %1: %2 ").arg(title).arg(text), "");
+    }
+
+    void inform(const QString & title, const QString & text)
+    {
+        dashboard(m_label, QString("! %1: %2").arg(title).arg(text));
+    }
+
+    bool setHeatExchanger(const double target)
+    {
+        uint16_t regs[CODEC_WIDE_REGISTERS];
+
+        if (!m_isSim || (m_engine == NULL)) return CalOperator::setHeatExchanger(target);
+
+        DeviceCodec::fromFloat((float) target, regs);
+
+        const bool isOk = busWait(m_engine->bus()->submit<bool>(CONTROLBOX_SLAVE, [&regs](modbus_t * modbus)
+        {
+            return (modbus != NULL) && (modbus_write_registers(modbus, CLI_SIM_HEATER-1, CODEC_WIDE_REGISTERS, regs) == CODEC_WIDE_REGISTERS);
+        }));
+
+        dashboard(m_label, QString("  heat exchanger %1 %2 °C").arg((isOk) ? "set to" : "failed at").arg(target));
+        return isOk;
+    }
+
+private:
+    /// an empty line or --yes takes the default
+    QString ask(const QString & question, const QString & value)
+    {
+        QMutexLocker lock(&console);
+        QTextStream in(stdin);
+        QString line;
+
+        printf("%s %s", qPrintable(m_label), qPrintable(question));
+
+        if (m_isAuto)
+        {
+            printf("%s\n", qPrintable(value));
+            fflush(stdout);
+            return value;
+        }
+
+        fflush(stdout);
+        line = in.readLine().trimmed();
+        return (line.isEmpty()) ? value : line;
+    }
+
+    QString m_label;
+    bool m_isAuto;
+    bool m_isSim;
+    CalEngine * m_engine;
+};
+
+
+int
+main(int argc, char * argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    QString configPath = CAL_CONFIG_FILE;
+    QString port;
+    QString out;
+    QString replay;
+    bool isAuto = false;
+    bool isSim = false;
+    bool isResume = false;
+    QVector<CAL_CONFIGS> configs;
+    QStringList labels;
+    QVector<QSharedPointer<ConsoleOperator> > operators;   /// outlive the loops
+    QVector<QSharedPointer<CalReplay> > replays;
+    QVector<QSharedPointer<VirtualClock> > clocks;
+    QSet<QString> ports;
+    QString error;
+    CalLoops cal;
+
+    for (int i = 1; i < args.size(); i++)
+    {
+        const QString value = args.value(i + 1);
+
+        if (args[i] == "--yes") { isAuto = true; continue; }
+        if (args[i] == "--sim") { isSim = true; continue; }
+        if (args[i] == "--resume") { isResume = true; continue; }
+
+        if (args[i] == "--config") configPath = value;
+        else if (args[i] == "--port") port = value;
+        else if (args[i] == "--out") out = value;
+        else if (args[i] == "--replay") replay = value;
+        else
+        {
+            fprintf(stderr, "usage: sparky-cli [--config file] [--port tty] [--out dir] [--yes] [--sim] [--resume] [--replay dir]\n");
+            return 2;
+        }
+
+        i++;
+    }
+
+    if (!replay.isEmpty() && isResume)
+    {
+        fprintf(stderr, "sparky-cli: --replay starts from the beginning of the recording, it cannot --resume\n");
+        return 2;
+    }
+
+    /// nobody answers a replay, and the heat exchanger is on the recording
+    if (!replay.isEmpty())
+    {
+        isAuto = true;
+        isSim = false;
+    }
+
+    if (!loadCalConfigs(configPath, configs, error))
+    {
+        fprintf(stderr, "sparky-cli: %s\n", qPrintable(error));
+        return 1;
+    }
+
+    if (!port.isEmpty())
+    {
+        if (configs.size() > 1)
+        {
+            fprintf(stderr, "sparky-cli: --port needs a single loop, %s has %d\n", qPrintable(configPath), configs.size());
+            return 2;
+        }
+
+        configs[0].port = port;
+    }
+
+    for (int index = 0; index < configs.size(); index++)
+    {
+        CAL_CONFIGS & config = configs[index];
+        const QString label = QString("L%1").arg((config.loopNumber > 0) ? config.loopNumber : index + 1);
+
+        if (!out.isEmpty()) config.mainServer = out;
+
+        /// a recording is replayed as the calibration it was
+        if (!replay.isEmpty()) config.isSimulation = false;
+
+        /// the replay writes its own files, the recording is read only
+        if (!replay.isEmpty() && (QDir(config.mainServer).absolutePath() == QDir(replay).absolutePath()))
+        {
+            fprintf(stderr, "sparky-cli: %s: --replay needs an output folder other than the recording\n", qPrintable(label));
+            return 2;
+        }
+
+        /// one port cannot carry two loops, a replay uses none
+        if (replay.isEmpty() && ports.contains(config.port))
+        {
+            fprintf(stderr, "sparky-cli: %s: port %s is already used by another loop\n", qPrintable(label), qPrintable(config.port));
+            return 1;
+        }
+
+        ports.insert(config.port);
+
+        ConsoleOperator * op = new ConsoleOperator(label, isAuto, isSim);
+        CalEngine * engine = new CalEngine(config, op);
+
+        operators.append(QSharedPointer<ConsoleOperator>(op));
+        labels.append(label);
+        op->setEngine(engine);
+        cal.add(engine);
+
+        /// every loop reads the recording on its own, on its own clock
+        if (!replay.isEmpty())
+        {
+            QSharedPointer<CalReplay> recording(new CalReplay);
+
+            if (!recording->open(replay, error))
+            {
+                fprintf(stderr, "sparky-cli: %s: %s\n", qPrintable(label), qPrintable(error));
+                return 1;
+            }
+
+            QSharedPointer<VirtualClock> clock(new VirtualClock(recording->started()));
+
+            replays.append(recording);
+            clocks.append(clock);
+            engine->setReplay(recording.data());
+            engine->setClock(clock.data());
+        }
+
+        /// the engines report from their own threads, the mutex keeps
+        /// the lines of different loops apart
+        QObject::connect(engine, &CalEngine::stageChanged, [label](const QString & stage)
+        {
+            dashboard(label, QString("stage %1").arg(stage));
+        });
+
+        QObject::connect(engine, &CalEngine::message, [label](const QString & text)
+        {
+            dashboard(label, text);
+        });
+
+        QObject::connect(engine, &CalEngine::sampled, [label, engine](const int pipe, const CAL_SAMPLES & sample)
+        {
+            const CAL_PIPES & p = engine->pipes().at(pipe);
+
+            dashboard(label, QString().sprintf("  %s SN%-6d %6lld s  wc %6.2f %%  freq %9.3f MHz  temp %6.2f °C", qPrintable(p.pipeId), p.slave, sample.elapsed, sample.watercut, sample.frequency, sample.temperature));
+        });
+
+        QObject::connect(engine, &CalEngine::injected, [label](const INJECTION_PULSES & pulse)
+        {
+            dashboard(label, QString("  %1").arg(calPulseStream(pulse)));
+        });
+
+        /// the sample and wait states take turns all run long, only the
+        /// other transitions are worth a line
+        QObject::connect(engine, &CalEngine::transition, [label](const CAL_TIMINGS & t)
+        {
+            if ((t.event == EVENT_SAMPLE_READY) || (t.event == EVENT_TIMEOUT) || (t.event == EVENT_INJECTED) || (t.event == EVENT_NOT_READY)) return;
+
+            dashboard(label, QString().sprintf("  %8.1f s  %s -> %s on %s after %lld ms", t.at/1000.0, calStateName(t.from), calStateName(t.to), calEventName(t.event), t.duration));
+        });
+
+        if (!engine->prepare(error, isResume))
+        {
+            fprintf(stderr, "sparky-cli: %s: %s\n", qPrintable(label), qPrintable(error));
+            return 1;
+        }
+
+        for (int pipe = 0; pipe < engine->pipes().size(); pipe++) dashboard(label, QString("%1 SN%2 -> %3").arg(engine->pipes().at(pipe).pipeId).arg(engine->pipes().at(pipe).slave).arg(engine->pipes().at(pipe).mainDirPath));
+    }
+
+    loops = &cal;
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    QObject::connect(&cal, &CalLoops::loopFinished, [&labels, &cal](const int index, const bool isOk)
+    {
+        const CalEngine * engine = cal.engine(index);
+
+        dashboard(labels.at(index), (isOk) ? "finished" : "failed");
+
+        for (int state = 0; state < CAL_STATE_COUNT; state++)
+        {
+            if (engine->stateTime((CAL_STATE) state) > 0) dashboard(labels.at(index), QString().sprintf("  %-16s %10.1f s", calStateName(state), engine->stateTime((CAL_STATE) state)/1000.0));
+        }
+    });
+
+    QObject::connect(&cal, &CalLoops::finished, &app, &QCoreApplication::quit, Qt::QueuedConnection);
+
+    cal.start();
+    app.exec();
+
+    const bool isOk = cal.isOk();
+
+    loops = NULL;
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+
+    return (isOk) ? 0 : 1;
+}
@@ -0,0 +1,44 @@
+TARGET = sparky-cli
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+QT -= gui
+
+SOURCES += main.cpp \
+    ../src/calconfig.cpp \
+    ../src/calengine.cpp \
+    ../src/calclock.cpp \
+    ../src/caljournal.cpp \
+    ../src/calreplay.cpp \
+    ../src/settlingestimator.cpp \
+    ../src/channelstats.cpp \
+    ../src/loopmodel.cpp \
+    ../src/calloops.cpp \
+    ../src/calstream.cpp \
+    ../src/modbusbus.cpp \
+    ../src/readplanner.cpp \
+    ../src/injectionscheduler.cpp \
+    ../3rdparty/libmodbus/src/modbus.c \
+    ../3rdparty/libmodbus/src/modbus-data.c \
+    ../3rdparty/libmodbus/src/modbus-rtu.c \
+    ../3rdparty/libmodbus/src/modbus-tcp.c
+
+HEADERS += ../src/calconfig.h \
+    ../src/calengine.h \
+    ../src/calclock.h \
+    ../src/caljournal.h \
+    ../src/calreplay.h \
+    ../src/settlingestimator.h \
+    ../src/channelstats.h \
+    ../src/loopmodel.h \
+    ../src/calloops.h \
+    ../src/calstream.h \
+    ../src/modbusbus.h \
+    ../src/readplanner.h \
+    ../src/injectionscheduler.h \
+    ../src/registercodec.h
+
+INCLUDEPATH += ../src \
+               ../3rdparty/libmodbus \
+               ../3rdparty/libmodbus/src
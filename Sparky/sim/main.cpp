@@ -0,0 +1,129 @@
+/// Loopback simulator of a calibration loop: Razor and EEA analyzers
+/// addressed by serial number, the control box with its pump coils and
+/// the timer slave, all on one pseudo terminal Sparky opens as its port.
+///
+/// usage: sparkysim [--razor sn]... [--eea sn]... [--link path] [--baud n]
+///                  [--speed x] [--watercut %] [--temp C] [--salinity %]
+///                  [--rate %/s] [--tau s] [--noise MHz] [--debug]
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "simserver.h"
+
+#define SIM_DEFAULT_BAUD            19200
+#define SIM_TICK_MS                 10
+
+static volatile sig_atomic_t isRunning = 1;
+
+
+static void
+onSignal(int)
+{
+    isRunning = 0;
+}
+
+
+static double
+now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+
+static int
+usage()
+{
+    fprintf(stderr, "usage: sparkysim [--razor sn]... [--eea sn]... [--link path] [--baud n]\n"
+                    "                 [--speed x] [--watercut %%] [--temp C] [--salinity %%]\n"
+                    "                 [--rate %%/s] [--tau s] [--noise MHz] [--debug]\n");
+    return 1;
+}
+
+
+int
+main(int argc, char ** argv)
+{
+    SimServer server;
+    SIM_LOOPS loop;
+    std::string link;
+    int baud = SIM_DEFAULT_BAUD;
+    double speed = 1.0;
+    double noise = SIM_DEFAULT_NOISE;
+    bool isDebug = false;
+    std::vector<int> razors;
+    std::vector<int> eeas;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char * arg = argv[i];
+        const char * value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--debug") == 0) { isDebug = true; continue; }
+        if (value == NULL) return usage();
+
+        if (strcmp(arg, "--razor") == 0) razors.push_back(atoi(value));
+        else if (strcmp(arg, "--eea") == 0) eeas.push_back(atoi(value));
+        else if (strcmp(arg, "--link") == 0) link = value;
+        else if (strcmp(arg, "--baud") == 0) baud = atoi(value);
+        else if (strcmp(arg, "--speed") == 0) speed = atof(value);
+        else if (strcmp(arg, "--watercut") == 0) loop.watercut = atof(value);
+        else if (strcmp(arg, "--temp") == 0) loop.temperature = loop.heater = atof(value);
+        else if (strcmp(arg, "--salinity") == 0) loop.salinity = atof(value);
+        else if (strcmp(arg, "--rate") == 0) loop.pumpRate = atof(value);
+        else if (strcmp(arg, "--tau") == 0) loop.tempTau = atof(value);
+        else if (strcmp(arg, "--noise") == 0) noise = atof(value);
+        else return usage();
+
+        i++;
+    }
+
+    if (!server.open(baud, link))
+    {
+        fprintf(stderr, "sparkysim: cannot open a pseudo terminal\n");
+        return 1;
+    }
+
+    server.setDebug(isDebug);
+
+    /// the control box starts at the loop temperature so the heater holds it
+    SimDevice * controlBox = new SimDevice(SIM_CONTROLBOX_SLAVE, SIM_CONTROLBOX, noise);
+    controlBox->setHeater(loop.heater);
+
+    SimDevice * timer = new SimDevice(SIM_TIMER_SLAVE, SIM_TIMER, noise);
+
+    server.add(controlBox);
+    server.add(timer);
+    for (size_t i = 0; i < razors.size(); i++) server.add(new SimDevice(razors[i], SIM_RAZOR, noise));
+    for (size_t i = 0; i < eeas.size(); i++) server.add(new SimDevice(eeas[i], SIM_EEA, noise));
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    printf("sparkysim: serving %d devices on %s\n", (int) server.devices().size(), (link.empty()) ? server.path().c_str() : link.c_str());
+    fflush(stdout);
+
+    double last = now();
+
+    while (isRunning)
+    {
+        server.poll(SIM_TICK_MS);
+
+        const double t = now();
+
+        timer->drive(controlBox, t);
+        controlBox->control(loop);
+        loop.step((t - last)*speed);
+        last = t;
+
+        for (size_t i = 0; i < server.devices().size(); i++) server.devices()[i]->publish(loop);
+    }
+
+    printf("sparkysim: %ld served, %ld ignored, %ld dropped\n", server.served(), server.ignored(), server.dropped());
+
+    return 0;
+}
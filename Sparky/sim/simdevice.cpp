@@ -0,0 +1,161 @@
+#include <string.h>
+#include "registercodec.h"
+#include "simdevice.h"
+
+void
+SIM_LOOP::
+step(const double dt)
+{
+    if (isWaterPump) watercut += pumpRate*dt*(100.0 - watercut)/100.0;
+    if (isOilPump) watercut -= pumpRate*dt*watercut/100.0;
+
+    if (watercut < 0) watercut = 0;
+    if (watercut > 100) watercut = 100;
+
+    temperature += (heater - temperature)*((dt < tempTau) ? dt/tempTau : 1.0);
+}
+
+
+SimDevice::
+SimDevice(const int slave, const int kind, const double noise) :
+    m_slave(slave),
+    m_kind(kind),
+    m_noise(noise),
+    m_offset((slave % 7)*0.1),
+    m_isTiming(false),
+    m_started(0),
+    m_mapping(modbus_mapping_new(SIM_BITS, 0, SIM_REGISTERS, SIM_REGISTERS)),
+    m_random(slave),
+    m_gauss(0.0, 1.0)
+{
+    /// the serial number register is what validateSerialNumber compares
+    if (kind == SIM_RAZOR) m_mapping->tab_input_registers[SIM_RAZ_SN-1] = (uint16_t) slave;
+    if (kind == SIM_EEA) m_mapping->tab_input_registers[SIM_EEA_SN-1] = (uint16_t) slave;
+}
+
+
+SimDevice::
+~SimDevice()
+{
+    modbus_mapping_free(m_mapping);
+}
+
+
+void
+SimDevice::
+setFloat(const int address, const float value)
+{
+    DeviceCodec::fromFloat(value, &m_mapping->tab_input_registers[address-1]);
+}
+
+
+float
+SimDevice::
+frequency(const SIM_LOOPS & loop)
+{
+    return (float) (1000.0 - 4.0*loop.watercut - 0.3*(loop.temperature - SIM_DEFAULT_TEMPERATURE) + m_offset + m_noise*m_gauss(m_random));
+}
+
+
+void
+SimDevice::
+publish(const SIM_LOOPS & loop)
+{
+    switch (m_kind)
+    {
+        case SIM_RAZOR:
+            setFloat(SIM_RAZ_WATERCUT, loop.watercut);
+            setFloat(SIM_RAZ_SALINITY, loop.salinity);
+            setFloat(SIM_RAZ_TEMPERATURE, loop.temperature);
+            setFloat(SIM_RAZ_FREQ, frequency(loop));
+            setFloat(SIM_RAZ_OIL_RP, 50.0 + 0.4*loop.watercut);
+            setFloat(SIM_RAZ_MEAS_AI, 0);
+            setFloat(SIM_RAZ_TRIM_AI, 0);
+            break;
+
+        case SIM_EEA:
+            setFloat(SIM_EEA_WATERCUT, loop.watercut);
+            setFloat(SIM_EEA_SALINITY, loop.salinity);
+            setFloat(SIM_EEA_TEMPERATURE, loop.temperature);
+            setFloat(SIM_EEA_FREQ, frequency(loop));
+            setFloat(SIM_EEA_OIL_RP, 50.0 + 0.4*loop.watercut);
+            setFloat(SIM_EEA_PRESSURE, 1.0);
+            break;
+
+        case SIM_CONTROLBOX:
+            setFloat(SIM_MASTER_WATERCUT, loop.watercut);
+            setFloat(SIM_MASTER_SALINITY, loop.salinity);
+            setFloat(SIM_MASTER_OIL_ADJUST, 0);
+            setFloat(SIM_MASTER_OIL_RP, 50.0 + 0.4*loop.watercut);
+            setFloat(SIM_MASTER_TEMPERATURE, loop.temperature);
+            setFloat(SIM_MASTER_FREQ, frequency(loop));
+            setFloat(SIM_MASTER_PHASE, 10.0 + 1.5*loop.watercut);
+            setFloat(SIM_MASTER_PRESSURE, 1.0);
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+/// holding registers written by the master read back as input registers
+void
+SimDevice::
+mirror(const int address, const int nb)
+{
+    if ((address < 0) || (nb <= 0) || (address + nb > SIM_REGISTERS)) return;
+
+    memcpy(&m_mapping->tab_input_registers[address], &m_mapping->tab_registers[address], nb*sizeof(uint16_t));
+}
+
+
+/// pump coils and the heater setpoint of the control box drive the loop
+void
+SimDevice::
+control(SIM_LOOPS & loop) const
+{
+    if (m_kind != SIM_CONTROLBOX) return;
+
+    loop.isOilPump = m_mapping->tab_bits[SIM_COIL_OIL_PUMP-1];
+    loop.isWaterPump = m_mapping->tab_bits[SIM_COIL_WATER_PUMP-1];
+    loop.heater = DeviceCodec::toFloat(&m_mapping->tab_registers[SIM_MASTER_HEATER-1]);
+}
+
+
+void
+SimDevice::
+setHeater(const float setpoint)
+{
+    DeviceCodec::fromFloat(setpoint, &m_mapping->tab_registers[SIM_MASTER_HEATER-1]);
+    mirror(SIM_MASTER_HEATER-1, CODEC_WIDE_REGISTERS);
+}
+
+
+/// the timer slave runs the control box water pump for the written time
+void
+SimDevice::
+drive(SimDevice * controlBox, const double now)
+{
+    if ((m_kind != SIM_TIMER) || (controlBox == NULL)) return;
+
+    const bool isStart = m_mapping->tab_bits[SIM_TIMER_COIL_START];
+    const double duration = DeviceCodec::toInt32(&m_mapping->tab_registers[SIM_TIMER_REG_DURATION])/1000.0;
+    uint8_t * pump = &controlBox->mapping()->tab_bits[SIM_COIL_WATER_PUMP-1];
+
+    if (isStart && !m_isTiming)
+    {
+        m_isTiming = true;
+        m_started = now;
+        *pump = TRUE;
+        DeviceCodec::fromInt32(0, &m_mapping->tab_input_registers[SIM_TIMER_REG_ELAPSED]);
+    }
+
+    if (m_isTiming && (!isStart || (now - m_started >= duration)))
+    {
+        m_isTiming = false;
+        *pump = FALSE;
+        m_mapping->tab_bits[SIM_TIMER_COIL_START] = FALSE;
+        DeviceCodec::fromInt32((int32_t) ((now - m_started)*1000.0 + 0.5), &m_mapping->tab_input_registers[SIM_TIMER_REG_ELAPSED]);
+    }
+}
@@ -0,0 +1,125 @@
+#ifndef SIMDEVICE_H
+#define SIMDEVICE_H
+
+#include <stdint.h>
+#include <random>
+#include "modbus.h"
+
+/// register map of the simulated devices, same numbers as mainwindow.h
+#define SIM_CONTROLBOX_SLAVE        100
+#define SIM_TIMER_SLAVE             101
+#define SIM_COIL_OIL_PUMP           60
+#define SIM_COIL_WATER_PUMP         61
+
+#define SIM_RAZ_SN                  201
+#define SIM_RAZ_WATERCUT            3
+#define SIM_RAZ_SALINITY            9
+#define SIM_RAZ_TEMPERATURE         33
+#define SIM_RAZ_FREQ                19
+#define SIM_RAZ_OIL_RP              61
+#define SIM_RAZ_MEAS_AI             173
+#define SIM_RAZ_TRIM_AI             175
+
+#define SIM_EEA_SN                  40001
+#define SIM_EEA_WATERCUT            11
+#define SIM_EEA_SALINITY            21
+#define SIM_EEA_TEMPERATURE         15
+#define SIM_EEA_FREQ                111
+#define SIM_EEA_OIL_RP              115
+#define SIM_EEA_PRESSURE            1005
+
+#define SIM_MASTER_WATERCUT         11
+#define SIM_MASTER_SALINITY         21
+#define SIM_MASTER_OIL_ADJUST       23
+#define SIM_MASTER_OIL_RP           115
+#define SIM_MASTER_TEMPERATURE      15
+#define SIM_MASTER_FREQ             111
+#define SIM_MASTER_PHASE            17
+#define SIM_MASTER_PRESSURE         1005
+
+/// control box holding register (float) standing in for the heat exchanger
+/// setpoint the operator turns by hand on a real loop; sparky-cli --sim
+/// writes it (CLI_SIM_HEATER)
+#define SIM_MASTER_HEATER           2001
+
+/// timer slave, wire addresses as in injectionscheduler.h
+#define SIM_TIMER_COIL_START        0
+#define SIM_TIMER_REG_DURATION      0       /// ms, two registers
+#define SIM_TIMER_REG_ELAPSED       2       /// ms, two input registers
+
+/// mapping sizes, the EEA serial number sits at 40001
+#define SIM_BITS                    10000
+#define SIM_REGISTERS               40002
+
+/// loop defaults
+#define SIM_DEFAULT_WATERCUT        0.0
+#define SIM_DEFAULT_TEMPERATURE     25.0
+#define SIM_DEFAULT_SALINITY        3.0
+#define SIM_DEFAULT_PUMP_RATE       0.5     /// %/s of the remaining phase
+#define SIM_DEFAULT_TEMP_TAU        60.0    /// s, first order heat exchanger
+#define SIM_DEFAULT_NOISE           0.02    /// MHz rms on the frequency
+
+enum SIM_KIND
+{
+    SIM_RAZOR,
+    SIM_EEA,
+    SIM_CONTROLBOX,
+    SIM_TIMER
+};
+
+
+/// Fluid in the loop. The pumps drive the watercut, the heat exchanger
+/// pulls the temperature towards its setpoint.
+typedef struct SIM_LOOP
+{
+    double watercut;
+    double temperature;
+    double heater;
+    double salinity;
+    double pumpRate;
+    double tempTau;
+    bool isOilPump;
+    bool isWaterPump;
+
+    SIM_LOOP() : watercut(SIM_DEFAULT_WATERCUT), temperature(SIM_DEFAULT_TEMPERATURE), heater(SIM_DEFAULT_TEMPERATURE), salinity(SIM_DEFAULT_SALINITY), pumpRate(SIM_DEFAULT_PUMP_RATE), tempTau(SIM_DEFAULT_TEMP_TAU), isOilPump(false), isWaterPump(false) {}
+
+    void step(const double dt);
+
+} SIM_LOOPS;
+
+
+/// One slave on the simulated bus with its own register mapping. Measured
+/// values are published into the input registers, whatever the master
+/// writes to holding registers reads back through the input registers.
+class SimDevice
+{
+public:
+    SimDevice(const int slave, const int kind, const double noise = SIM_DEFAULT_NOISE);
+    ~SimDevice();
+
+    int slave() const { return m_slave; }
+    int kind() const { return m_kind; }
+    modbus_mapping_t * mapping() { return m_mapping; }
+
+    void publish(const SIM_LOOPS &);
+    void mirror(const int, const int);
+    void control(SIM_LOOPS &) const;
+    void setHeater(const float);
+    void drive(SimDevice *, const double);
+
+private:
+    void setFloat(const int, const float);
+    float frequency(const SIM_LOOPS &);
+
+    int m_slave;
+    int m_kind;
+    double m_noise;
+    double m_offset;    /// per device spread so pipes do not read alike
+    bool m_isTiming;
+    double m_started;   /// s, start of the running timer pulse
+    modbus_mapping_t * m_mapping;
+    std::mt19937 m_random;
+    std::normal_distribution<double> m_gauss;
+};
+
+#endif // SIMDEVICE_H
@@ -0,0 +1,282 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include "modbus-rtu.h"
+#include "simserver.h"
+
+static int64_t
+nowMs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec*1000 + ts.tv_nsec/1000000;
+}
+
+
+/// crc of an rtu frame, low byte first on the wire
+static uint16_t
+crc16(const uint8_t * data, const int len)
+{
+    uint16_t crc = 0xFFFF;
+
+    for (int i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : (crc >> 1);
+    }
+
+    return crc;
+}
+
+
+SimServer::
+SimServer() :
+    m_master(-1),
+    m_slaveFd(-1),
+    m_ctx(NULL),
+    m_size(0),
+    m_lastByte(0),
+    m_served(0),
+    m_ignored(0),
+    m_dropped(0)
+{
+}
+
+
+SimServer::
+~SimServer()
+{
+    close();
+
+    for (size_t i = 0; i < m_devices.size(); i++) delete m_devices[i];
+}
+
+
+bool
+SimServer::
+open(const int baud, const std::string & link)
+{
+    struct termios tios;
+
+    close();
+
+    m_master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if ((m_master < 0) || (grantpt(m_master) != 0) || (unlockpt(m_master) != 0))
+    {
+        close();
+        return false;
+    }
+
+    m_path = ptsname(m_master);
+    m_slaveFd = ::open(m_path.c_str(), O_RDWR | O_NOCTTY);
+
+    if (m_slaveFd < 0)
+    {
+        close();
+        return false;
+    }
+
+    /// raw until the master configures its side
+    tcgetattr(m_slaveFd, &tios);
+    cfmakeraw(&tios);
+    tcsetattr(m_slaveFd, TCSANOW, &tios);
+
+    /// the context only formats replies, it writes to the pty master
+    m_ctx = modbus_new_rtu(m_path.c_str(), baud, 'N', 8, 1);
+
+    if (m_ctx == NULL)
+    {
+        close();
+        return false;
+    }
+
+    modbus_set_socket(m_ctx, m_master);
+    modbus_rtu_set_turnaround(m_ctx, MODBUS_RTU_TURNAROUND_DEFAULT, 0);
+
+    if (!link.empty())
+    {
+        unlink(link.c_str());
+        if (symlink(m_path.c_str(), link.c_str()) == 0) m_link = link;
+    }
+
+    return true;
+}
+
+
+void
+SimServer::
+close()
+{
+    if (!m_link.empty()) unlink(m_link.c_str());
+    if (m_ctx) modbus_free(m_ctx);
+    if (m_slaveFd >= 0) ::close(m_slaveFd);
+    if (m_master >= 0) ::close(m_master);
+
+    m_ctx = NULL;
+    m_slaveFd = -1;
+    m_master = -1;
+    m_size = 0;
+    m_link.clear();
+}
+
+
+void
+SimServer::
+setDebug(const bool isDebug)
+{
+    if (m_ctx) modbus_set_debug(m_ctx, isDebug);
+}
+
+
+void
+SimServer::
+add(SimDevice * device)
+{
+    m_devices.push_back(device);
+}
+
+
+SimDevice *
+SimServer::
+find(const int slave) const
+{
+    for (size_t i = 0; i < m_devices.size(); i++)
+    {
+        if (m_devices[i]->slave() == slave) return m_devices[i];
+    }
+
+    return NULL;
+}
+
+
+/// full length of the buffered request, 0 while more bytes are needed,
+/// -1 for a function the simulator does not frame
+int
+SimServer::
+frameLength() const
+{
+    const int header = (m_buffer[0] == 0xFA) ? 5 : 1;
+
+    if (m_size < header + 1) return 0;
+
+    switch (m_buffer[header])
+    {
+        case MODBUS_FC_READ_COILS:
+        case MODBUS_FC_READ_DISCRETE_INPUTS:
+        case MODBUS_FC_READ_HOLDING_REGISTERS:
+        case MODBUS_FC_READ_INPUT_REGISTERS:
+        case MODBUS_FC_WRITE_SINGLE_COIL:
+        case MODBUS_FC_WRITE_SINGLE_REGISTER:
+            return header + 7;
+
+        case MODBUS_FC_WRITE_MULTIPLE_COILS:
+        case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+            return (m_size < header + 6) ? 0 : header + 8 + m_buffer[header + 5];
+
+        default:
+            return -1;
+    }
+}
+
+
+/// answers one complete request, a real slave stays silent on a bad crc
+/// or a request for someone else
+bool
+SimServer::
+serve(const int len)
+{
+    const uint16_t crc = crc16(m_buffer, len - 2);
+
+    if ((m_buffer[len - 2] != (crc & 0xFF)) || (m_buffer[len - 1] != (crc >> 8)))
+    {
+        m_dropped++;
+        return false;
+    }
+
+    const bool isExtended = (m_buffer[0] == 0xFA);
+    const int header = (isExtended) ? 5 : 1;
+    const int slave = (isExtended) ? (int) (((uint32_t) m_buffer[1] << 24) | ((uint32_t) m_buffer[2] << 16) | ((uint32_t) m_buffer[3] << 8) | m_buffer[4]) : m_buffer[0];
+    SimDevice * device = find(slave);
+
+    if (device == NULL)
+    {
+        m_ignored++;
+        return false;
+    }
+
+    modbus_set_slave(m_ctx, device->slave());
+
+    if (modbus_reply(m_ctx, m_buffer, len, device->mapping()) < 0) return false;
+
+    const int function = m_buffer[header];
+    const int address = (m_buffer[header + 1] << 8) | m_buffer[header + 2];
+
+    if (function == MODBUS_FC_WRITE_SINGLE_REGISTER) device->mirror(address, 1);
+    if (function == MODBUS_FC_WRITE_MULTIPLE_REGISTERS) device->mirror(address, (m_buffer[header + 3] << 8) | m_buffer[header + 4]);
+
+    m_served++;
+    return true;
+}
+
+
+/// waits up to timeout ms for bytes and serves every complete request,
+/// returns the number of requests answered
+int
+SimServer::
+poll(const int timeout)
+{
+    struct timeval tv;
+    fd_set set;
+    int served = 0;
+
+    if (m_master < 0) return -1;
+
+    FD_ZERO(&set);
+    FD_SET(m_master, &set);
+    tv.tv_sec = timeout/1000;
+    tv.tv_usec = (timeout%1000)*1000;
+
+    if (select(m_master + 1, &set, NULL, NULL, &tv) > 0)
+    {
+        const ssize_t n = read(m_master, m_buffer + m_size, SIM_BUFFER_SIZE - m_size);
+
+        if (n > 0)
+        {
+            m_size += n;
+            m_lastByte = nowMs();
+        }
+    }
+    else if ((m_size > 0) && (nowMs() - m_lastByte > SIM_FRAME_GAP_MS))
+    {
+        m_size = 0;
+        m_dropped++;
+    }
+
+    while (m_size > 0)
+    {
+        const int len = frameLength();
+
+        if ((len < 0) || (len > SIM_BUFFER_SIZE))
+        {
+            m_size = 0;
+            m_dropped++;
+            break;
+        }
+
+        if ((len == 0) || (m_size < len)) break;
+
+        if (serve(len)) served++;
+
+        m_size -= len;
+        memmove(m_buffer, m_buffer + len, m_size);
+    }
+
+    return served;
+}
@@ -0,0 +1,61 @@
+#ifndef SIMSERVER_H
+#define SIMSERVER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "modbus.h"
+#include "simdevice.h"
+
+/// silence after which a partial frame is dropped
+#define SIM_FRAME_GAP_MS            20
+
+#define SIM_BUFFER_SIZE             512
+
+/// Serves the simulated devices on the master side of a pseudo terminal.
+/// Sparky opens the slave side like any serial port. Requests are framed
+/// here rather than by modbus_receive, whose extended 0xFA handling keys on
+/// the context slave and so cannot tell which device is being asked; the
+/// matching device is then answered through modbus_reply with its mapping.
+class SimServer
+{
+public:
+    SimServer();
+    ~SimServer();
+
+    bool open(const int baud, const std::string & link = std::string());
+    void close();
+    const std::string & path() const { return m_path; }
+    void setDebug(const bool);
+
+    void add(SimDevice *);
+    SimDevice * find(const int) const;
+    const std::vector<SimDevice *> & devices() const { return m_devices; }
+
+    int poll(const int);
+
+    long served() const { return m_served; }
+    long ignored() const { return m_ignored; }
+    long dropped() const { return m_dropped; }
+
+private:
+    int frameLength() const;
+    bool serve(const int);
+
+    int m_master;
+    int m_slaveFd;      /// kept open so reads do not fail while no one is attached
+    modbus_t * m_ctx;
+    std::string m_path;
+    std::string m_link;
+    std::vector<SimDevice *> m_devices;
+
+    uint8_t m_buffer[SIM_BUFFER_SIZE];
+    int m_size;
+    int64_t m_lastByte;
+
+    long m_served;
+    long m_ignored;
+    long m_dropped;
+};
+
+#endif // SIMSERVER_H
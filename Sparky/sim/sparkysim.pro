@@ -0,0 +1,21 @@
+TARGET = sparkysim
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle qt
+
+SOURCES += main.cpp \
+    simdevice.cpp \
+    simserver.cpp \
+    ../3rdparty/libmodbus/src/modbus.c \
+    ../3rdparty/libmodbus/src/modbus-data.c \
+    ../3rdparty/libmodbus/src/modbus-rtu.c \
+    ../3rdparty/libmodbus/src/modbus-tcp.c
+
+HEADERS += simdevice.h \
+    simserver.h \
+    ../src/registercodec.h \
+    ../3rdparty/libmodbus/src/modbus.h
+
+INCLUDEPATH += ../src \
+               ../3rdparty/libmodbus \
+               ../3rdparty/libmodbus/src
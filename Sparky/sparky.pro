@@ -6,6 +6,25 @@ QT += gui widgets charts concurrent
 
 SOURCES += src/main.cpp \
     src/mainwindow.cpp \
+    src/readplanner.cpp \
+    src/writeplanner.cpp \
+    src/modbusbus.cpp \
+    src/profilestation.cpp \
+    src/busmonitormodel.cpp \
+    src/buscapture.cpp \
+    src/captureviewer.cpp \
+    src/calstream.cpp \
+    src/injectionscheduler.cpp \
+    src/calconfig.cpp \
+    src/calengine.cpp \
+    src/calloops.cpp \
+    src/calclock.cpp \
+    src/caljournal.cpp \
+    src/calreplay.cpp \
+    src/settlingestimator.cpp \
+    src/channelstats.cpp \
+    src/loopmodel.cpp \
+    src/tempsync.cpp \
     3rdparty/qextserialport/qextserialport.cpp	\
     3rdparty/libmodbus/src/modbus.c \
     3rdparty/libmodbus/src/modbus-data.c \
@@ -18,6 +37,27 @@ SOURCES += src/main.cpp \
 #    src/qcgaugewidget.cpp
 
 HEADERS += src/mainwindow.h \
+    src/readplanner.h \
+    src/writeplanner.h \
+    src/modbusbus.h \
+    src/profilestation.h \
+    src/busmonitormodel.h \
+    src/buscapture.h \
+    src/captureviewer.h \
+    src/calstream.h \
+    src/injectionscheduler.h \
+    src/calconfig.h \
+    src/calengine.h \
+    src/calloops.h \
+    src/calclock.h \
+    src/caljournal.h \
+    src/calreplay.h \
+    src/settlingestimator.h \
+    src/channelstats.h \
+    src/loopmodel.h \
+    src/tempsync.h \
+    src/registercodec.h \
+    src/tracering.h \
     src/BatchProcessor.h \
     3rdparty/qextserialport/qextserialport.h \
     3rdparty/qextserialport/qextserialenumerator.h \
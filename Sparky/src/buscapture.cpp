@@ -0,0 +1,364 @@
+#include <string.h>
+#include <stddef.h>
+#include <algorithm>
+#include <QDateTime>
+#include "buscapture.h"
+
+BusCaptureWriter::
+BusCaptureWriter()
+{
+}
+
+
+BusCaptureWriter::
+~BusCaptureWriter()
+{
+    close();
+}
+
+
+bool
+BusCaptureWriter::
+open(const QString & fileName)
+{
+    close();
+
+    m_file.setFileName(fileName);
+
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) return false;
+
+    /// a new file starts with its header, an existing one is continued
+    if (m_file.size() == 0)
+    {
+        CAPTURE_HEADERS header;
+
+        memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+        header.version = CAPTURE_VERSION;
+        header.recordSize = sizeof(CAPTURE_RECORDS);
+        header.wallStart = QDateTime::currentMSecsSinceEpoch();
+        header.timeStart = MonitorRing::now();
+
+        m_file.write((const char *) &header, sizeof(header));
+    }
+
+    return true;
+}
+
+
+void
+BusCaptureWriter::
+close()
+{
+    if (m_file.isOpen()) m_file.close();
+}
+
+
+void
+BusCaptureWriter::
+write(const TRACE_RECORDS & trace)
+{
+    CAPTURE_RECORDS record;
+
+    if (!m_file.isOpen()) return;
+
+    record.time = trace.time;
+    record.kind = trace.kind;
+    record.flags = 0;
+    if (trace.isRequest) record.flags |= CAPTURE_REQUEST;
+    if ((trace.kind == TRACE_ITEM) && (trace.expectedCRC != trace.actualCRC)) record.flags |= CAPTURE_CRC_ERROR;
+    if (trace.isNewline) record.flags |= CAPTURE_NEWLINE;
+    record.func = trace.func;
+    record.len = (trace.kind == TRACE_RAW) ? trace.len : 0;
+    record.slave = trace.slave;
+    record.addr = trace.addr;
+    record.nb = trace.nb;
+    record.expectedCRC = trace.expectedCRC;
+    record.actualCRC = trace.actualCRC;
+
+    m_file.write((const char *) &record, sizeof(record));
+    if (record.len > 0) m_file.write((const char *) trace.data, record.len);
+}
+
+
+void
+BusCaptureWriter::
+flush()
+{
+    if (m_file.isOpen()) m_file.flush();
+}
+
+
+BusCaptureReader::
+BusCaptureReader() :
+    m_window(NULL),
+    m_windowStart(0),
+    m_windowSize(0),
+    m_size(0),
+    m_count(0),
+    m_firstTime(0),
+    m_lastTime(0)
+{
+    memset(&m_header, 0, sizeof(m_header));
+}
+
+
+BusCaptureReader::
+~BusCaptureReader()
+{
+    close();
+}
+
+
+bool
+BusCaptureReader::
+open(const QString & fileName)
+{
+    close();
+
+    m_file.setFileName(fileName);
+
+    if (!m_file.open(QIODevice::ReadOnly)) return false;
+
+    m_size = m_file.size();
+
+    if (m_size < (qint64) sizeof(CAPTURE_HEADERS))
+    {
+        close();
+        return false;
+    }
+
+    const uchar * data = at(0, sizeof(CAPTURE_HEADERS));
+
+    if (data == NULL)
+    {
+        close();
+        return false;
+    }
+
+    memcpy(&m_header, data, sizeof(m_header));
+
+    if ((memcmp(m_header.magic, CAPTURE_MAGIC, sizeof(m_header.magic)) != 0) || (m_header.recordSize != sizeof(CAPTURE_RECORDS)))
+    {
+        close();
+        return false;
+    }
+
+    /// one pass over the record headers, a torn last record is left out
+    CAPTURE_RECORDS record;
+    qint64 pos = sizeof(CAPTURE_HEADERS);
+
+    while (pos + (qint64) sizeof(CAPTURE_RECORDS) <= m_size)
+    {
+        if ((data = at(pos, sizeof(CAPTURE_RECORDS))) == NULL) break;
+
+        memcpy(&record, data, sizeof(record));
+
+        if (pos + (qint64) sizeof(CAPTURE_RECORDS) + record.len > m_size) break;
+
+        if ((m_count % CAPTURE_INDEX_STRIDE) == 0)
+        {
+            m_offsets.append(pos);
+            m_times.append(record.time);
+        }
+
+        if (m_count == 0) m_firstTime = record.time;
+        m_lastTime = record.time;
+        m_count++;
+
+        pos += sizeof(CAPTURE_RECORDS) + record.len;
+    }
+
+    return true;
+}
+
+
+void
+BusCaptureReader::
+close()
+{
+    unmap();
+    if (m_file.isOpen()) m_file.close();
+
+    m_size = 0;
+    m_count = 0;
+    m_firstTime = 0;
+    m_lastTime = 0;
+    m_offsets.clear();
+    m_times.clear();
+}
+
+
+/// len bytes at pos, moving the mapped window there if they are outside it
+const uchar *
+BusCaptureReader::
+at(const qint64 pos, const qint64 len) const
+{
+    if ((pos < 0) || (pos + len > m_size)) return NULL;
+
+    if ((m_window == NULL) || (pos < m_windowStart) || (pos + len > m_windowStart + m_windowSize))
+    {
+        unmap();
+
+        m_windowStart = pos - (pos % CAPTURE_MAP_ALIGN);
+        m_windowSize = qMin(qMax((qint64) CAPTURE_MAP_WINDOW, pos + len - m_windowStart), m_size - m_windowStart);
+
+        m_window = m_file.map(m_windowStart, m_windowSize);
+
+        if (m_window == NULL) return NULL;
+    }
+
+    return m_window + (pos - m_windowStart);
+}
+
+
+void
+BusCaptureReader::
+unmap() const
+{
+    if (m_window) m_file.unmap(m_window);
+
+    m_window = NULL;
+    m_windowStart = 0;
+    m_windowSize = 0;
+}
+
+
+qint64
+BusCaptureReader::
+next(const qint64 pos) const
+{
+    const uchar * data = at(pos, sizeof(CAPTURE_RECORDS));
+
+    /// an unmappable record ends the walk at the end of the file
+    if (data == NULL) return m_size;
+
+    return pos + sizeof(CAPTURE_RECORDS) + data[offsetof(CAPTURE_RECORDS, len)];
+}
+
+
+qint64
+BusCaptureReader::
+offset(const qint64 n) const
+{
+    qint64 pos = m_offsets[n / CAPTURE_INDEX_STRIDE];
+
+    for (qint64 i = 0; i < n % CAPTURE_INDEX_STRIDE; i++) pos = next(pos);
+
+    return pos;
+}
+
+
+bool
+BusCaptureReader::
+record(const qint64 n, CAPTURE_RECORDS & record, QByteArray * raw) const
+{
+    if (!m_file.isOpen() || (n < 0) || (n >= m_count)) return false;
+
+    const qint64 pos = offset(n);
+    const uchar * data = at(pos, sizeof(CAPTURE_RECORDS));
+
+    if (data == NULL) return false;
+
+    memcpy(&record, data, sizeof(record));
+
+    if (raw)
+    {
+        if ((data = at(pos + sizeof(CAPTURE_RECORDS), record.len)) == NULL) return false;
+        *raw = QByteArray((const char *) data, record.len);
+    }
+
+    return true;
+}
+
+
+/// first record at or after the given time
+qint64
+BusCaptureReader::
+find(const int64_t time) const
+{
+    if (m_count == 0) return 0;
+
+    /// the last index block starting at or before the time
+    const int block = qMax(0, (int) (std::upper_bound(m_times.begin(), m_times.end(), time) - m_times.begin()) - 1);
+    qint64 n = (qint64) block * CAPTURE_INDEX_STRIDE;
+    qint64 pos = m_offsets[block];
+    CAPTURE_RECORDS record;
+
+    for (; n < m_count; n++)
+    {
+        const uchar * data = at(pos, sizeof(CAPTURE_RECORDS));
+
+        if (data == NULL) break;
+
+        memcpy(&record, data, sizeof(record));
+        if (record.time >= time) break;
+        pos = next(pos);
+    }
+
+    return n;
+}
+
+
+/// record numbers in [from, to) matching the filter, CAPTURE_ANY disables a field
+qint64
+BusCaptureReader::
+filter(const qint64 from, const qint64 to, const int slave, const int func, const bool isErrorOnly, QVector<qint64> & hits) const
+{
+    CAPTURE_RECORDS record;
+    const qint64 last = qMin(to, m_count);
+
+    if (!m_file.isOpen() || (from >= last)) return 0;
+
+    qint64 pos = offset(qMax(from, (qint64) 0));
+
+    for (qint64 n = qMax(from, (qint64) 0); n < last; n++)
+    {
+        const uchar * data = at(pos, sizeof(CAPTURE_RECORDS));
+
+        if (data == NULL) break;
+
+        memcpy(&record, data, sizeof(record));
+        pos = next(pos);
+
+        if (record.kind != TRACE_ITEM) continue;
+        if ((slave != CAPTURE_ANY) && (record.slave != slave)) continue;
+        if ((func != CAPTURE_ANY) && ((record.func & 0x7F) != func)) continue;
+        if (isErrorOnly && !isError(record)) continue;
+
+        hits.append(n);
+    }
+
+    return hits.size();
+}
+
+
+bool
+BusCaptureReader::
+isError(const CAPTURE_RECORDS & record)
+{
+    return (record.kind == TRACE_ITEM) && ((record.func > 127) || (record.flags & CAPTURE_CRC_ERROR));
+}
+
+
+QString
+BusCaptureReader::
+describe(const CAPTURE_RECORDS & record, const QByteArray & raw)
+{
+    QString text;
+
+    if (record.kind == TRACE_RAW)
+    {
+        for (int i = 0; i < raw.size(); i++) text += QString().sprintf("%.2x ", (uint8_t) raw[i]);
+        return text;
+    }
+
+    text = (record.flags & CAPTURE_REQUEST) ? "Req >> " : "<< Resp ";
+    text += "slave " + QString::number(record.slave);
+
+    if (record.func > 127) return text + QString(" exception (%1)").arg(record.func-128);
+
+    text += " func " + QString::number(record.func) + " addr " + QString::number(record.addr+1) + " nb " + QString::number(record.nb);
+    text += (record.flags & CAPTURE_CRC_ERROR) ? QString().sprintf(" crc %.4x (%.4x)", record.actualCRC, record.expectedCRC) : QString().sprintf(" crc %.4x", record.actualCRC);
+
+    return text;
+}
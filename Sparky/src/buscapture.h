@@ -0,0 +1,135 @@
+#ifndef BUSCAPTURE_H
+#define BUSCAPTURE_H
+
+#include <stdint.h>
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include "tracering.h"
+
+#define CAPTURE_MAGIC               "SPKCAP01"
+#define CAPTURE_VERSION             1
+#define CAPTURE_EXT                 ".CAP"
+
+/// records between two entries of the reader's time index
+#define CAPTURE_INDEX_STRIDE        1024
+
+/// the reader maps this much of the file at a time, on a 64 KiB boundary
+/// (the Windows allocation granularity); an index block is at most
+/// 1024 records of 275 bytes, so one window holds a whole block
+#define CAPTURE_MAP_WINDOW          (4*1024*1024)
+#define CAPTURE_MAP_ALIGN           (64*1024)
+
+/// a session's capture is closed and a new one started past this size
+#define CAPTURE_MAX_SIZE            ((qint64) 256*1024*1024)
+
+/// record flags
+#define CAPTURE_REQUEST             0x01
+#define CAPTURE_CRC_ERROR           0x02
+#define CAPTURE_NEWLINE             0x04
+
+/// filter wildcards
+#define CAPTURE_ANY                 -1
+
+#pragma pack(push, 1)
+
+/// file header, little endian
+typedef struct CAPTURE_HEADER
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;    /// size of CAPTURE_RECORD, raw bytes follow each record
+    int64_t wallStart;      /// ms since epoch at creation
+    int64_t timeStart;      /// steady clock (us) at creation, same clock as the records
+
+} CAPTURE_HEADERS;
+
+
+/// one monitor record, followed by len raw bytes
+typedef struct CAPTURE_RECORD
+{
+    int64_t time;
+    uint8_t kind;
+    uint8_t flags;
+    uint8_t func;
+    uint8_t len;
+    uint16_t slave;
+    uint16_t addr;
+    uint16_t nb;
+    uint16_t expectedCRC;
+    uint16_t actualCRC;
+
+} CAPTURE_RECORDS;
+
+#pragma pack(pop)
+
+
+/// Appends monitor records to an append-only capture file. Writes go
+/// through the QFile buffer and reach the disk on flush().
+class BusCaptureWriter
+{
+public:
+    BusCaptureWriter();
+    ~BusCaptureWriter();
+
+    bool open(const QString &);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+    bool isFull() const { return m_file.isOpen() && (m_file.size() >= CAPTURE_MAX_SIZE); }
+    QString fileName() const { return m_file.fileName(); }
+
+    void write(const TRACE_RECORDS &);
+    void flush();
+
+private:
+    QFile m_file;
+};
+
+
+/// Indexes a capture once and hands out records by number. Every
+/// CAPTURE_INDEX_STRIDE'th record offset and time is kept, so any record
+/// or time is reached with one binary search and a short walk. Only a
+/// window around the block being read is memory mapped, so a capture of
+/// any size opens in a 32 bit address space. Not thread safe.
+class BusCaptureReader
+{
+public:
+    BusCaptureReader();
+    ~BusCaptureReader();
+
+    bool open(const QString &);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+
+    const CAPTURE_HEADERS & header() const { return m_header; }
+    qint64 count() const { return m_count; }
+    int64_t firstTime() const { return m_firstTime; }
+    int64_t lastTime() const { return m_lastTime; }
+
+    bool record(const qint64, CAPTURE_RECORDS &, QByteArray * raw = NULL) const;
+    qint64 find(const int64_t) const;
+    qint64 filter(const qint64, const qint64, const int, const int, const bool, QVector<qint64> &) const;
+
+    static bool isError(const CAPTURE_RECORDS &);
+    static QString describe(const CAPTURE_RECORDS &, const QByteArray &);
+
+private:
+    qint64 offset(const qint64) const;
+    qint64 next(const qint64) const;
+    const uchar * at(const qint64, const qint64) const;
+    void unmap() const;
+
+    mutable QFile m_file;
+    mutable uchar * m_window;
+    mutable qint64 m_windowStart;
+    mutable qint64 m_windowSize;
+    qint64 m_size;
+    qint64 m_count;
+    int64_t m_firstTime;
+    int64_t m_lastTime;
+    CAPTURE_HEADERS m_header;
+    QVector<qint64> m_offsets;  /// of record i*CAPTURE_INDEX_STRIDE
+    QVector<int64_t> m_times;
+};
+
+#endif // BUSCAPTURE_H
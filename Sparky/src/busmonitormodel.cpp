@@ -0,0 +1,224 @@
+#include <QBrush>
+#include <QString>
+#include "busmonitormodel.h"
+
+BusMonitorModel::
+BusMonitorModel(QObject * parent) :
+    QAbstractTableModel(parent)
+{
+}
+
+
+void
+BusMonitorModel::
+setRetention(const int rows)
+{
+    beginResetModel();
+    m_frames.setCapacity(rows);
+    endResetModel();
+}
+
+
+void
+BusMonitorModel::
+clear()
+{
+    beginResetModel();
+    m_frames.clear();
+    endResetModel();
+}
+
+
+void
+BusMonitorModel::
+append(const QVector<BUS_FRAMES> & frames)
+{
+    if (frames.isEmpty()) return;
+
+    /// only the newest frames of a batch larger than the store are kept
+    const int n = qMin(frames.size(), m_frames.capacity());
+    const int overflow = m_frames.size() + n - m_frames.capacity();
+
+    if (overflow > 0)
+    {
+        beginRemoveRows(QModelIndex(), 0, overflow - 1);
+        m_frames.dropFront(overflow);
+        endRemoveRows();
+    }
+
+    beginInsertRows(QModelIndex(), m_frames.size(), m_frames.size() + n - 1);
+    for (int i = frames.size() - n; i < frames.size(); i++) m_frames.append(frames[i]);
+    endInsertRows();
+}
+
+
+int
+BusMonitorModel::
+rowCount(const QModelIndex & parent) const
+{
+    return (parent.isValid()) ? 0 : m_frames.size();
+}
+
+
+int
+BusMonitorModel::
+columnCount(const QModelIndex & parent) const
+{
+    return (parent.isValid()) ? 0 : MONITOR_COLUMNS;
+}
+
+
+QVariant
+BusMonitorModel::
+data(const QModelIndex & index, int role) const
+{
+    if (!index.isValid() || (index.row() >= m_frames.size())) return QVariant();
+
+    const BUS_FRAMES & frame = m_frames.at(index.row());
+    const bool isException = (frame.func > 127);
+
+    if (role == Qt::ForegroundRole)
+    {
+        if ((index.column() == 2) && isException) return QBrush(Qt::red);
+        if ((index.column() == 5) && !isException && (frame.expectedCRC != frame.actualCRC)) return QBrush(Qt::red);
+        return QVariant();
+    }
+
+    if (role == Qt::ToolTipRole) return tr("%1 ms").arg(frame.time/1000.0, 0, 'f', 3);
+
+    if (role != Qt::DisplayRole) return QVariant();
+
+    switch (index.column())
+    {
+        case 0: return (frame.isRequest) ? tr("Req >>") : tr("<< Resp");
+        case 1: return QString::number(frame.slave);
+        case 2: return (isException) ? tr("Exception (%1)").arg(frame.func-128) : QString::number(frame.func);
+        case 3: return (isException) ? QString() : QString::number(frame.addr);
+        case 4: return (isException) ? QString() : QString::number(frame.bytes);
+        case 5:
+            if (isException) return QString();
+            if (frame.expectedCRC == frame.actualCRC) return QString().sprintf("%.4x", frame.actualCRC);
+            return QString().sprintf("%.4x (%.4x)", frame.actualCRC, frame.expectedCRC);
+        default: return QVariant();
+    }
+}
+
+
+QVariant
+BusMonitorModel::
+headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole) return QVariant();
+    if (orientation == Qt::Vertical) return QString::number(section + 1);
+
+    switch (section)
+    {
+        case 0: return tr("I/O");
+        case 1: return tr("Slave ID");
+        case 2: return tr("Function code");
+        case 3: return tr("Start address");
+        case 4: return tr("Byte(s)");
+        case 5: return tr("CRC");
+        default: return QVariant();
+    }
+}
+
+
+BusHexModel::
+BusHexModel(QObject * parent) :
+    QAbstractListModel(parent)
+{
+}
+
+
+void
+BusHexModel::
+setRetention(const int rows)
+{
+    beginResetModel();
+    m_lines.setCapacity(rows);
+    endResetModel();
+}
+
+
+void
+BusHexModel::
+clear()
+{
+    beginResetModel();
+    m_lines.clear();
+    m_pending.clear();
+    m_open.clear();
+    endResetModel();
+}
+
+
+void
+BusHexModel::
+append(const uint8_t * data, const int len, const bool isNewline)
+{
+    for (int i = 0; i < len; i++)
+    {
+        m_open.append((char) data[i]);
+
+        if (m_open.size() == MONITOR_HEX_BYTES)
+        {
+            m_pending.append(m_open);
+            m_open.clear();
+        }
+    }
+
+    if (isNewline && !m_open.isEmpty())
+    {
+        m_pending.append(m_open);
+        m_open.clear();
+    }
+}
+
+
+void
+BusHexModel::
+flush()
+{
+    if (m_pending.isEmpty()) return;
+
+    const int n = qMin(m_pending.size(), m_lines.capacity());
+    const int overflow = m_lines.size() + n - m_lines.capacity();
+
+    if (overflow > 0)
+    {
+        beginRemoveRows(QModelIndex(), 0, overflow - 1);
+        m_lines.dropFront(overflow);
+        endRemoveRows();
+    }
+
+    beginInsertRows(QModelIndex(), m_lines.size(), m_lines.size() + n - 1);
+    for (int i = m_pending.size() - n; i < m_pending.size(); i++) m_lines.append(m_pending[i]);
+    endInsertRows();
+
+    m_pending.clear();
+}
+
+
+int
+BusHexModel::
+rowCount(const QModelIndex & parent) const
+{
+    return (parent.isValid()) ? 0 : m_lines.size();
+}
+
+
+QVariant
+BusHexModel::
+data(const QModelIndex & index, int role) const
+{
+    if (!index.isValid() || (index.row() >= m_lines.size()) || (role != Qt::DisplayRole)) return QVariant();
+
+    /// formatted on demand, the view only asks for what it shows
+    const QByteArray & line = m_lines.at(index.row());
+    QString dump;
+
+    for (int i = 0; i < line.size(); i++) dump += QString().sprintf("%.2x ", (uint8_t) line[i]);
+
+    return dump;
+}
@@ -0,0 +1,131 @@
+#ifndef BUSMONITORMODEL_H
+#define BUSMONITORMODEL_H
+
+#include <stdint.h>
+#include <QVector>
+#include <QByteArray>
+#include <QAbstractTableModel>
+#include <QAbstractListModel>
+
+/// rows kept by each monitor view unless configured otherwise
+#define MONITOR_DEFAULT_ROWS        10000
+
+/// raw bytes shown per hex line
+#define MONITOR_HEX_BYTES           32
+
+#define MONITOR_COLUMNS             6
+
+
+/// Fixed capacity FIFO, the oldest entries fall off the front. The storage
+/// is allocated once, so an append costs the same however long it runs.
+template <typename T>
+class CircularStore
+{
+public:
+    CircularStore(const int capacity = MONITOR_DEFAULT_ROWS) : m_first(0), m_size(0) { setCapacity(capacity); }
+
+    void setCapacity(const int capacity)
+    {
+        m_items.clear();
+        m_items.resize(qMax(capacity, 1));
+        m_first = 0;
+        m_size = 0;
+    }
+
+    int capacity() const { return m_items.size(); }
+    int size() const { return m_size; }
+    bool isFull() const { return m_size == m_items.size(); }
+    void clear() { m_first = 0; m_size = 0; }
+
+    void append(const T & item)
+    {
+        if (isFull()) dropFront(1);
+        m_items[(m_first + m_size) % m_items.size()] = item;
+        m_size++;
+    }
+
+    void dropFront(const int n)
+    {
+        const int k = qMin(n, m_size);
+        m_first = (m_first + k) % m_items.size();
+        m_size -= k;
+    }
+
+    const T & at(const int i) const { return m_items[(m_first + i) % m_items.size()]; }
+    T & last() { return m_items[(m_first + m_size - 1) % m_items.size()]; }
+
+private:
+    QVector<T> m_items;
+    int m_first;
+    int m_size;
+};
+
+
+typedef struct BUS_FRAME
+{
+    int64_t time;
+    bool isRequest;
+    uint16_t slave;
+    uint8_t func;
+    uint16_t addr;
+    uint16_t bytes;
+    uint16_t expectedCRC;
+    uint16_t actualCRC;
+
+    BUS_FRAME() : time(0), isRequest(false), slave(0), func(0), addr(0), bytes(0), expectedCRC(0), actualCRC(0) {}
+
+} BUS_FRAMES;
+
+
+/// Request/response log of the bus monitor. Frames are appended a batch
+/// at a time and only the retained window is kept, the view asks for the
+/// rows it shows.
+class BusMonitorModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit BusMonitorModel(QObject * parent = 0);
+
+    void setRetention(const int);
+    int retention() const { return m_frames.capacity(); }
+    void append(const QVector<BUS_FRAMES> &);
+    void clear();
+
+    int rowCount(const QModelIndex & parent = QModelIndex()) const;
+    int columnCount(const QModelIndex & parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &, int role = Qt::DisplayRole) const;
+    QVariant headerData(int, Qt::Orientation, int role = Qt::DisplayRole) const;
+
+private:
+    CircularStore<BUS_FRAMES> m_frames;
+};
+
+
+/// Raw byte dump of the bus monitor, one row per received frame or per
+/// MONITOR_HEX_BYTES of it. Bytes are kept binary and only the visible
+/// rows are formatted to hex. Chunks are collected with append() and
+/// reach the view on flush().
+class BusHexModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    explicit BusHexModel(QObject * parent = 0);
+
+    void setRetention(const int);
+    int retention() const { return m_lines.capacity(); }
+    void append(const uint8_t *, const int, const bool);
+    void flush();
+    void clear();
+
+    int rowCount(const QModelIndex & parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &, int role = Qt::DisplayRole) const;
+
+private:
+    CircularStore<QByteArray> m_lines;
+    QVector<QByteArray> m_pending;  /// complete lines not yet shown
+    QByteArray m_open;              /// line still waiting for the end of its frame
+};
+
+#endif // BUSMONITORMODEL_H
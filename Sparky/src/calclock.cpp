@@ -0,0 +1,17 @@
+#include <QThread>
+#include "calclock.h"
+
+void
+SystemClock::
+sleep(const qint64 ms)
+{
+    if (ms > 0) QThread::msleep(ms);
+}
+
+
+VirtualClock::
+VirtualClock(const QDateTime & epoch) :
+    m_epoch((epoch.isValid()) ? epoch : QDateTime(QDate(2000, 1, 1), QTime(0, 0))),
+    m_msecs(0)
+{
+}
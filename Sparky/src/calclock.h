@@ -0,0 +1,69 @@
+#ifndef CALCLOCK_H
+#define CALCLOCK_H
+
+#include <QDateTime>
+#include <QElapsedTimer>
+
+/// Every time the calibration engine reads, waits for or writes down goes
+/// through one of these. The system clock is the loop's own time; the
+/// virtual clock only moves when it is slept on, and then at once, so a
+/// replayed run takes no longer than its bookkeeping.
+class CalClock
+{
+public:
+    virtual ~CalClock() {}
+
+    /// ms on a monotonic clock, from an arbitrary start
+    virtual qint64 msecs() const = 0;
+    virtual void sleep(const qint64) = 0;
+
+    /// date and time for the file headers and the journal
+    virtual QDateTime now() const = 0;
+};
+
+
+class SystemClock : public CalClock
+{
+public:
+    SystemClock() { m_timer.start(); }
+
+    qint64 msecs() const { return m_timer.elapsed(); }
+    void sleep(const qint64);
+    QDateTime now() const { return QDateTime::currentDateTime(); }
+
+private:
+    QElapsedTimer m_timer;
+};
+
+
+/// time starts at epoch, by default the first of January 2000
+class VirtualClock : public CalClock
+{
+public:
+    explicit VirtualClock(const QDateTime & epoch = QDateTime());
+
+    qint64 msecs() const { return m_msecs; }
+    void sleep(const qint64 ms) { if (ms > 0) m_msecs += ms; }
+    QDateTime now() const { return m_epoch.addMSecs(m_msecs); }
+
+private:
+    QDateTime m_epoch;
+    qint64 m_msecs;
+};
+
+
+/// QElapsedTimer on a CalClock, 0 until started
+class CalTimer
+{
+public:
+    CalTimer() : m_clock(0), m_start(0) {}
+
+    void start(const CalClock * clock) { m_clock = clock; m_start = clock->msecs(); }
+    qint64 elapsed() const { return (m_clock) ? m_clock->msecs() - m_start : 0; }
+
+private:
+    const CalClock * m_clock;
+    qint64 m_start;
+};
+
+#endif // CALCLOCK_H
@@ -0,0 +1,197 @@
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include "calconfig.h"
+#include "caljournal.h"
+
+const QString SALINITY[SALINITY_COUNT] = {"0.02", "0.10", "0.20", "0.30", "0.40", "0.50", "1.00", "1.50", "2.00", "3.00", "5.00", "8.00", "11.00", "20.00", "25.00", "28.00"};
+
+/// fills the config from the variant map of sparky.json, numbers may be
+/// saved as strings
+void
+readCalConfig(const QVariantMap & json, CAL_CONFIGS & config)
+{
+    const QString cut = json[CAL_CUT].toString().toUpper();
+
+    /// file server
+    config.mainServer = json[MAIN_SERVER].toString();
+
+    /// calibration control variables
+    config.injectionOilPumpRate = json[LOOP_OIL_PUMP_RATE].toDouble();
+    config.injectionWaterPumpRate = json[LOOP_WATER_PUMP_RATE].toDouble();
+    config.minTemp = json[LOOP_MIN_TEMP].toInt();
+    config.maxTemp = json[LOOP_MAX_TEMP].toInt();
+    config.injectTemp = json[LOOP_INJECTION_TEMP].toInt();
+    config.xDelay = json[LOOP_X_DELAY].toInt();
+    config.yFreq = json[LOOP_Y_FREQ].toDouble();
+    config.zTemp = json[LOOP_Z_TEMP].toDouble();
+    config.intervalSmallPump = json[LOOP_INTERVAL_SMALL_PUMP].toDouble();
+    config.intervalBigPump = json[LOOP_INTERVAL_BIG_PUMP].toDouble();
+    config.intervalOilPump = json[LOOP_INTERVAL_OIL_PUMP].toDouble();
+    config.loopNumber = json[LOOP_NUMBER].toInt();
+    config.masterMin = json[LOOP_MASTER_MIN].toDouble();
+    config.masterMax = json[LOOP_MASTER_MAX].toDouble();
+    config.masterDelta = json[LOOP_MASTER_DELTA].toDouble();
+    config.masterDeltaFinal = json[LOOP_MASTER_DELTA_FINAL].toDouble();
+    config.maxInjectionWater = json[LOOP_MAX_INJECTION_WATER].toInt();
+    config.maxInjectionOil = json[LOOP_MAX_INJECTION_OIL].toInt();
+    config.readGap = json.contains(LOOP_READ_GAP) ? json[LOOP_READ_GAP].toInt() : PLANNER_DEFAULT_GAP;
+    config.turnaround = json.contains(LOOP_TURNAROUND) ? json[LOOP_TURNAROUND].toInt() : BUS_DEFAULT_TURNAROUND;
+    config.isInjectionTimer = json.contains(LOOP_INJECTION_TIMER) ? json[LOOP_INJECTION_TIMER].toBool() : false;
+    config.stableConfidence = json.contains(LOOP_STABLE_CONFIDENCE) ? json[LOOP_STABLE_CONFIDENCE].toDouble() : SETTLING_DEFAULT_CONFIDENCE;
+    config.isInjectionModel = json.contains(LOOP_INJECTION_MODEL) ? json[LOOP_INJECTION_MODEL].toBool() : true;
+
+    /// run settings
+    config.port = json[CAL_PORT].toString();
+    config.baud = json.contains(CAL_BAUD) ? json[CAL_BAUD].toInt() : CAL_DEFAULT_BAUD;
+    config.isEEA = (json[CAL_PRODUCT].toString().toUpper() == "EEA");
+    config.isMaster = json.contains(CAL_MASTER) ? json[CAL_MASTER].toBool() : false;
+    config.isTempRunOnly = json.contains(CAL_TEMPRUN_ONLY) ? json[CAL_TEMPRUN_ONLY].toBool() : false;
+    config.osc = json.contains(CAL_OSC) ? qBound(1, json[CAL_OSC].toInt(), 4) : 1;
+    config.loopVolume = json[CAL_LOOP_VOLUME].toDouble();
+    config.saltStart = json.contains(CAL_SALT_START) ? json[CAL_SALT_START].toString() : SALINITY[0];
+    config.saltStop = json.contains(CAL_SALT_STOP) ? json[CAL_SALT_STOP].toString() : SALINITY[SALINITY_COUNT-1];
+    config.operatorName = json[CAL_OPERATOR].toString();
+    config.journal = json[CAL_JOURNAL].toString();
+    config.isSimulation = json.contains(CAL_SIMULATION) ? json[CAL_SIMULATION].toBool() : false;
+
+    if (cut == "HIGH") config.cut = CUT_HIGH;
+    else if (cut == "FULL") config.cut = CUT_FULL;
+    else if (cut == "LOW") config.cut = CUT_LOW;
+    else config.cut = CUT_MID;
+
+    /// run bounds default to what selecting the cut sets in the GUI
+    const bool isWaterCut = (config.cut == CUT_HIGH) || (config.cut == CUT_FULL);
+    config.waterRunStart = json.contains(CAL_WATER_RUN_START) ? json[CAL_WATER_RUN_START].toDouble() : ((isWaterCut) ? 99 : 0);
+    config.waterRunStop = json.contains(CAL_WATER_RUN_STOP) ? json[CAL_WATER_RUN_STOP].toDouble() : ((isWaterCut) ? 60 : 0);
+    config.oilRunStart = json.contains(CAL_OIL_RUN_START) ? json[CAL_OIL_RUN_START].toDouble() : 0;
+    config.oilRunStop = json.contains(CAL_OIL_RUN_STOP) ? json[CAL_OIL_RUN_STOP].toDouble() : ((isWaterCut) ? 0 : 78);
+
+    /// empty or zero entries leave the pipe out, the others keep their row
+    const QVariantList serials = json[CAL_SERIALS].toList();
+
+    config.serials.clear();
+    config.rows.clear();
+
+    for (int row = 0; row < serials.size(); row++)
+    {
+        if (serials[row].toInt() <= 0) continue;
+
+        config.serials.append(serials[row].toInt());
+        config.rows.append(row);
+    }
+}
+
+
+static bool
+readJsonFile(const QString & path, QVariantMap & json, QString & error)
+{
+    QFile file(path);
+    QJsonParseError parseError;
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        error = QString("cannot open %1").arg(path);
+        return false;
+    }
+
+    const QJsonDocument jsonDoc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    file.close();
+
+    if (!jsonDoc.isObject())
+    {
+        error = QString("%1: %2").arg(path).arg(parseError.errorString());
+        return false;
+    }
+
+    json = jsonDoc.object().toVariantMap();
+    return true;
+}
+
+
+bool
+loadCalConfig(const QString & path, CAL_CONFIGS & config, QString & error)
+{
+    QVariantMap json;
+
+    if (!readJsonFile(path, json, error)) return false;
+
+    readCalConfig(json, config);
+    return true;
+}
+
+
+/// one config per entry of CAL.Loops, or the file itself without it
+bool
+loadCalConfigs(const QString & path, QVector<CAL_CONFIGS> & configs, QString & error)
+{
+    QVariantMap json;
+
+    configs.clear();
+
+    if (!readJsonFile(path, json, error)) return false;
+
+    QVariantList loops = json.take(CAL_LOOPS).toList();
+
+    if (loops.isEmpty()) loops.append(QVariantMap());
+
+    foreach (const QVariant & loop, loops)
+    {
+        QVariantMap merged = json;
+        const QVariantMap overrides = loop.toMap();
+        CAL_CONFIGS config;
+
+        for (QVariantMap::const_iterator i = overrides.constBegin(); i != overrides.constEnd(); ++i) merged[i.key()] = i.value();
+
+        readCalConfig(merged, config);
+        configs.append(config);
+    }
+
+    return true;
+}
+
+
+/// calibration folder of the cut, "\\HIGHCUT\\HC" and the like
+QString
+calCutPath(const CAL_CONFIGS & config)
+{
+    switch (config.cut)
+    {
+        case CUT_HIGH: return (config.isEEA) ? HIGH_EEA : HIGH_RAZ;
+        case CUT_FULL: return (config.isEEA) ? FULL_EEA : FULL_RAZ;
+        case CUT_LOW: return (config.isEEA) ? LOW_EEA : LOW_RAZ;
+        default: return (config.isEEA) ? MID_EEA : MID_RAZ;
+    }
+}
+
+
+QString
+calCutName(const CAL_CONFIGS & config)
+{
+    return calCutPath(config).split("\\").at(1);
+}
+
+
+/// CAL.Journal, or LOOP<n>.JNL next to the calibration folders
+QString
+calJournalPath(const CAL_CONFIGS & config)
+{
+    if (!config.journal.isEmpty()) return config.journal;
+
+    return QDir::cleanPath(config.mainServer+"/LOOP"+QString::number(config.loopNumber)+JOURNAL_EXT);
+}
+
+
+/// -1 if the value is not one of SALINITY
+int
+calSalinityIndex(const QString & salinity)
+{
+    for (int i = 0; i < SALINITY_COUNT; i++)
+    {
+        if (SALINITY[i] == salinity) return i;
+    }
+
+    return -1;
+}
@@ -0,0 +1,250 @@
+#ifndef CALCONFIG_H
+#define CALCONFIG_H
+
+#include <QString>
+#include <QVector>
+#include <QVariantMap>
+#include "readplanner.h"
+#include "modbusbus.h"
+#include "settlingestimator.h"
+
+#define RELEASE_VERSION             "0.1.5"
+#define PROJECT_NAME                "Sparky "
+
+#define PHASE_OIL					0
+#define PHASE_WATER					1
+#define PHASE_ERROR					2
+
+/// sub system	
+#define CONTROLBOX_SLAVE 	        100
+#define MODBUS_TIMER_SLAVE 			101
+#define OIL_MICROMOTION_SLAVE 	 	102
+#define WATER_MICROMOTION_SLAVE  	103
+
+#define COIL_OIL_PUMP				60
+#define COIL_WATER_PUMP				61
+
+#define EEA_ID_SN_PIPE  			40001 
+#define EEA_ID_WATERCUT  			11
+#define EEA_ID_SALINITY 			21
+#define EEA_ID_OIL_ADJUST  			23
+#define EEA_ID_TEMPERATURE  		15
+#define EEA_ID_WATER_ADJUST  		25
+#define EEA_ID_FREQ  				111 
+#define EEA_ID_OIL_RP  				115 
+#define EEA_ID_PRESSURE  			1005
+
+#define RAZ_ID_SN_PIPE  			201 
+#define RAZ_ID_WATERCUT  			3
+#define RAZ_ID_TEMPERATURE  		33 /// REG_TEMP_USER
+#define RAZ_ID_SALINITY  			9 
+#define RAZ_ID_OIL_ADJUST  			15
+#define RAZ_ID_WATER_ADJUST  		17
+#define RAZ_ID_FREQ  				19
+#define RAZ_ID_OIL_RP  				61
+
+/// factory registers
+#define FCT_RAZ_TEMP_ADJ    		781
+#define FCT_RAZ_UNLOCK      		999 /// coil, opens the factory registers for writing
+
+/// the control box reads like an EEA, plus the phase
+#define MASTER_ID_PHASE             17
+
+/// pipe cal status
+#define DONE						0
+#define ENABLED						1	
+#define DISABLED					2		
+
+/// calibration file names
+#define HIGH_EEA                    "\\HIGHCUT\\HC"
+#define FULL_EEA                    "\\FULLCUT\\FC" 
+#define MID_EEA                     "\\MIDCUT\\MC"
+#define LOW_EEA                     "\\LOWCUT\\LC"
+#define HIGH_RAZ                    "\\HIGHCUT_RAZ\\HC"
+#define FULL_RAZ                    "\\FULLCUT_RAZ\\FC" 
+#define MID_RAZ                     "\\MIDCUT_RAZ\\MC"
+#define LOW_RAZ                     "\\LOWCUT_RAZ\\LC"
+
+/// header lines
+#define HEADER3                     "Time From  Water  Osc  Tune Tuning            Incident Reflected              Injection  Master    Master      Master      Master      Master       Master   Master Pipe";
+#define HEADER4                     "Run Start   Cut   Band Type Voltage Frequency  Power     Power   Temperature    Time    Pressure Temperature Oil Adjust   Frequency   Watercut      Oil Rp   Phase  Watercut";
+#define HEADER5                     "========= ======= ==== ==== ======= ========= ======== ========= =========== ========== ======== =========== =========== =========== =========== =========== ====== ========";
+
+#define SIMULATION_EXT              ".SIM"
+
+#define EEA_INJECTION_FILE          "EEA INJECTION FILE"
+#define RAZ_INJECTION_FILE          "RAZOR INJECTION FILE"
+
+#define MAIN_SERVER                 "MainServer"
+#define LOCAL_SERVER                "LocalServer"
+
+/// LOOP.runMode
+#define TEMPRUN_MIN					"TEMPRUN MIN"	
+#define TEMPRUN_HIGH				"TEMPRUN HIGH"	
+#define TEMPRUN_INJECT				"TEMPRUN INJ"	
+#define TEMPRUN_ONLY				"TEMPRUN ONLY"	
+#define INJECT_RUN					"INJECT"	
+#define INJECT_STANDBY				"INJECT STANDBY"	
+#define SIMULATION_RUN				"SIMULATION"	
+#define STOP_CALIBRATION			"STOP"	
+#define READ_MASTERPIPE				"READ MASTER PIPE"	
+#define TEMP_IN_SYNC				"TEMP IN SYNC"	
+#define WATER_RUN					"WATER RUN"	
+#define OIL_RUN						"OIL RUN"	
+#define ROLLOVER_RUN                "ROLLOVER"
+
+//////////////////////////
+/////// JSON KEYS ////////
+//////////////////////////
+
+#define LOOP_OIL_PUMP_RATE            "LOOP.OilPumpRate"
+#define LOOP_WATER_PUMP_RATE          "LOOP.WaterPumpRate"
+#define LOOP_SMALL_WATER_PUMP_RATE    "LOOP.SmallWaterPumpRate"
+#define LOOP_BUCKET                   "LOOP.Bucket"
+#define LOOP_MARK                     "LOOP.Mark"
+#define LOOP_METHOD                   "LOOP.Method"
+#define LOOP_PRESSURE                 "LOOP.PresssureSensorSlope"
+#define LOOP_MIN_TEMP                 "LOOP.MinRefTemp"
+#define LOOP_MAX_TEMP                 "LOOP.MaxRefTemp"
+#define LOOP_INJECTION_TEMP           "LOOP.InjectionTemp"
+#define LOOP_X_DELAY                  "LOOP.XDelay"
+#define LOOP_Y_FREQ                   "LOOP.YFreq"
+#define LOOP_Z_TEMP                   "LOOP.ZTemp"
+#define LOOP_INTERVAL_SMALL_PUMP      "LOOP.IntervalSmallPump"
+#define LOOP_INTERVAL_BIG_PUMP  	  "LOOP.IntervalBigPump"
+#define LOOP_INTERVAL_OIL_PUMP  	  "LOOP.IntervalOilPump"
+#define LOOP_NUMBER  	  			  "LOOP.LoopNumber"
+#define LOOP_MASTER_MIN  			  "LOOP.MasterMin"
+#define LOOP_MASTER_MAX  			  "LOOP.MasterMax"
+#define LOOP_MASTER_DELTA  			  "LOOP.MasterDelta"
+#define LOOP_MASTER_DELTA_FINAL		  "LOOP.MasterDeltaFinal"
+#define LOOP_MAX_INJECTION_WATER   	  "LOOP.MaxInjectionWater"
+#define LOOP_MAX_INJECTION_OIL   	  "LOOP.MaxInjectionOil"
+#define LOOP_PORT_INDEX    	          "LOOP.PortIndex"
+#define LOOP_READ_GAP    	          "LOOP.ReadGap"
+#define LOOP_TURNAROUND    	          "LOOP.Turnaround"
+#define LOOP_MONITOR_ROWS    	      "LOOP.MonitorRows"
+#define LOOP_CAPTURE    	          "LOOP.Capture"
+#define LOOP_INJECTION_TIMER          "LOOP.InjectionTimer"
+#define LOOP_PIPES                    "LOOP.Pipes"
+#define LOOP_STABLE_CONFIDENCE        "LOOP.StableConfidence"
+#define LOOP_INJECTION_MODEL          "LOOP.InjectionModel"
+
+/// run settings the GUI takes from its widgets, read by the headless engine
+#define CAL_PORT                      "CAL.Port"
+#define CAL_BAUD                      "CAL.Baud"
+#define CAL_PRODUCT                   "CAL.Product"
+#define CAL_CUT                       "CAL.Cut"
+#define CAL_MASTER                    "CAL.Master"
+#define CAL_TEMPRUN_ONLY              "CAL.TempRunOnly"
+#define CAL_OSC                       "CAL.Osc"
+#define CAL_SERIALS                   "CAL.Serials"
+#define CAL_LOOP_VOLUME               "CAL.LoopVolume"
+#define CAL_SALT_START                "CAL.SaltStart"
+#define CAL_SALT_STOP                 "CAL.SaltStop"
+#define CAL_WATER_RUN_START           "CAL.WaterRunStart"
+#define CAL_WATER_RUN_STOP            "CAL.WaterRunStop"
+#define CAL_OIL_RUN_START             "CAL.OilRunStart"
+#define CAL_OIL_RUN_STOP              "CAL.OilRunStop"
+#define CAL_OPERATOR                  "CAL.Operator"
+#define CAL_JOURNAL                   "CAL.Journal"
+#define CAL_SIMULATION                "CAL.Simulation"
+
+/// one object per loop, its keys override the ones around it
+#define CAL_LOOPS                     "CAL.Loops"
+
+#define FILE_LIST                   "Filelist.LST"
+
+/// wire address = register number - ADDR_OFFSET
+#define ADDR_OFFSET         1
+
+#define RAZ_MEAS_AI         173
+#define RAZ_TRIM_AI         175
+
+#define MAX_PHASE_CHECKING          5
+
+/// consecutive readings within zTemp and yFreq before a pipe is stable
+#define CAL_STABLE_COUNT            5
+
+/// a pipe is checked for stability once this close to the target (°C)
+#define CAL_STABLE_WINDOW           2.0
+
+#define CAL_DEFAULT_BAUD            19200
+#define CAL_CONFIG_FILE             "sparky.json"
+
+/// salinities of the water runs, in order
+#define SALINITY_COUNT              16
+extern const QString SALINITY[SALINITY_COUNT];
+
+enum CAL_CUT
+{
+    CUT_HIGH,
+    CUT_FULL,
+    CUT_MID,
+    CUT_LOW
+};
+
+
+/// Everything one calibration needs, loaded from sparky.json. The LOOP.*
+/// keys are the ones the GUI saves; the CAL.* keys replace the widgets.
+typedef struct CAL_CONFIG
+{
+    QString mainServer;
+    double injectionOilPumpRate;
+    double injectionWaterPumpRate;
+    double minTemp;
+    double maxTemp;
+    double injectTemp;
+    int xDelay;                 /// ms between two cycles
+    double yFreq;
+    double zTemp;
+    double intervalSmallPump;
+    double intervalBigPump;
+    double intervalOilPump;
+    int loopNumber;
+    double masterMin;
+    double masterMax;
+    double masterDelta;
+    double masterDeltaFinal;
+    int maxInjectionWater;
+    int maxInjectionOil;
+    int readGap;
+    int turnaround;
+    bool isInjectionTimer;
+    double stableConfidence;    /// of the predicted stability, 0 leaves it to the count
+    bool isInjectionModel;      /// pump rate mode times injections by the loop model
+
+    QString port;
+    int baud;
+    bool isEEA;
+    int cut;
+    bool isMaster;
+    bool isTempRunOnly;
+    int osc;
+    QVector<int> serials;       /// one pipe per serial number
+    QVector<int> rows;          /// panel row of each serial, the pipe id is P<row + 1>
+    double loopVolume;          /// mL
+    QString saltStart;
+    QString saltStop;
+    double waterRunStart;
+    double waterRunStop;
+    double oilRunStart;
+    double oilRunStop;
+    QString operatorName;
+    QString journal;            /// checkpoint journal, empty for LOOP<n>.JNL in mainServer
+    bool isSimulation;          /// injection run into the existing folders, the pipes' watercut logged
+
+    CAL_CONFIG() : injectionOilPumpRate(0), injectionWaterPumpRate(0), minTemp(0), maxTemp(0), injectTemp(0), xDelay(0), yFreq(0), zTemp(0), intervalSmallPump(0.25), intervalBigPump(1), intervalOilPump(0.25), loopNumber(0), masterMin(0), masterMax(0), masterDelta(0), masterDeltaFinal(0), maxInjectionWater(80), maxInjectionOil(200), readGap(PLANNER_DEFAULT_GAP), turnaround(BUS_DEFAULT_TURNAROUND), isInjectionTimer(false), stableConfidence(SETTLING_DEFAULT_CONFIDENCE), isInjectionModel(true), baud(CAL_DEFAULT_BAUD), isEEA(false), cut(CUT_MID), isMaster(false), isTempRunOnly(false), osc(1), loopVolume(0), waterRunStart(0), waterRunStop(0), oilRunStart(0), oilRunStop(78), isSimulation(false) {}
+
+} CAL_CONFIGS;
+
+
+void readCalConfig(const QVariantMap &, CAL_CONFIGS &);
+bool loadCalConfig(const QString &, CAL_CONFIGS &, QString &);
+bool loadCalConfigs(const QString &, QVector<CAL_CONFIGS> &, QString &);
+QString calCutPath(const CAL_CONFIGS &);
+QString calCutName(const CAL_CONFIGS &);
+QString calJournalPath(const CAL_CONFIGS &);
+int calSalinityIndex(const QString &);
+
+#endif // CALCONFIG_H
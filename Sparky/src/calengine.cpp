@@ -0,0 +1,1828 @@
+#include <math.h>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QTextStream>
+#include <QVariantList>
+#include "readplanner.h"
+#include "calengine.h"
+
+CalEngine::
+CalEngine(const CAL_CONFIGS & config, CalOperator * op, QObject * parent) :
+    CalEngine(config, op, NULL, parent)
+{
+}
+
+
+/// the GUI hands in the bus its port is already open on; the engine
+/// neither opens nor deletes it
+CalEngine::
+CalEngine(const CAL_CONFIGS & config, CalOperator * op, ModbusBus * bus, QObject * parent) :
+    QObject(parent),
+    m_config(config),
+    m_operator(op),
+    m_bus((bus) ? bus : new ModbusBus),
+    m_isOwnBus(bus == NULL),
+    m_injection(new InjectionScheduler(m_bus)),
+    m_isAborted(0),
+    m_isSkip(0),
+    m_isPaused(0),
+    m_timebase(&m_systemClock),
+    m_replay(NULL),
+    m_failedFrames(0),
+    m_state(STATE_IDLE),
+    m_entered(0),
+    m_nextSample(0),
+    m_resume(STATE_IDLE),
+    m_isWaterRun(false),
+    m_isOilRun(false),
+    m_isIgnoreMaxInjection(false),
+    m_salinityIndex(0),
+    m_phaseRolloverCounter(0),
+    m_idSn(RAZ_ID_SN_PIPE),
+    m_idWatercut(RAZ_ID_WATERCUT),
+    m_idTemperature(RAZ_ID_TEMPERATURE),
+    m_idFreq(RAZ_ID_FREQ),
+    m_idOilRp(RAZ_ID_OIL_RP),
+    m_watercut(0),
+    m_runStart(0),
+    m_injectionTime(0),
+    m_totalInjectionTime(0),
+    m_totalInjectionVolume(0),
+    m_accumulatedInjectionTime(0),
+    m_deliveredInjectionTime(0)
+{
+    m_pipes.resize(config.serials.size());
+
+    for (int pipe = 0; pipe < m_pipes.size(); pipe++)
+    {
+        m_pipes[pipe].slave = config.serials[pipe];
+        m_pipes[pipe].row = (pipe < config.rows.size()) ? config.rows[pipe] : pipe;
+        m_pipes[pipe].pipeId = QString("P%1").arg(m_pipes[pipe].row + 1);
+        m_pipes[pipe].osc = config.osc;
+    }
+}
+
+
+CalEngine::
+~CalEngine()
+{
+    delete m_injection;
+    if (m_isOwnBus) delete m_bus;
+}
+
+
+QString
+CalEngine::
+journalPath() const
+{
+    return calJournalPath(m_config);
+}
+
+
+/// opens the bus and checks what prepareCalibration checks in the GUI,
+/// then creates the pipe folders; a resume keeps the folders and takes
+/// the run state from the journal instead
+bool
+CalEngine::
+prepare(QString & error, const bool isResume)
+{
+    if (m_pipes.isEmpty())
+    {
+        error = "No Valid Serial Number Exists!";
+        return false;
+    }
+
+    if (m_config.loopVolume < 1)
+    {
+        error = "No Valid Loop Volume Exists!";
+        return false;
+    }
+
+    if (!m_config.isMaster && ((m_config.injectionWaterPumpRate <= 0) || (m_config.injectionOilPumpRate <= 0)))
+    {
+        error = "No Valid Pump Rate Exists!";
+        return false;
+    }
+
+    /// a replay reads the recording, not the port
+    if ((m_replay == NULL) && !m_bus->isOpen() && !m_bus->open(m_config.port, m_config.baud, 'N', 8, 1))
+    {
+        error = "Bad Serial Connection";
+        return false;
+    }
+
+    m_bus->setTurnaround(m_config.turnaround);
+
+    readLoopConfiguration();
+
+    if (!validateSerialNumber())
+    {
+        error = "Invalid Serial Number!";
+        return false;
+    }
+
+    for (int pipe = 0; pipe < m_pipes.size(); pipe++)
+    {
+        const QString sn = QString::number(m_pipes[pipe].slave);
+
+        m_pipes[pipe].etimer.start(m_timebase);
+        m_pipes[pipe].mainDirPath = QDir::cleanPath(m_config.mainServer+QString(m_cut).replace('\\', '/')+QString::number((m_pipes[pipe].slave/100)*100)+"'s/"+m_cut.split("\\").at(2)+sn);
+    }
+
+    if (isResume)
+    {
+        QVariantMap record;
+
+        if (!CalJournal::last(journalPath(), record, error) || !restore(record, error)) return false;
+    }
+    else
+    {
+        m_resume = STATE_IDLE;
+
+        if (!startCalibration(error)) return false;
+    }
+
+    QDir().mkpath(QFileInfo(journalPath()).path());
+
+    if (!m_journal.open(journalPath(), isResume))
+    {
+        error = QString("Cannot Open The Journal %1").arg(journalPath());
+        return false;
+    }
+
+    return true;
+}
+
+
+void
+CalEngine::
+readLoopConfiguration()
+{
+    m_cut = calCutPath(m_config);
+    m_isWaterRun = (m_config.cut == CUT_HIGH) || (m_config.cut == CUT_FULL);
+    m_isOilRun = !m_isWaterRun;
+    m_salinityIndex = qMax(0, calSalinityIndex(m_config.saltStart));
+
+    /// razors always start with the temperature runs, EEAs only at lowcut;
+    /// a simulation goes straight to the injection
+    if (m_config.isSimulation) m_runMode = SIMULATION_RUN;
+    else m_runMode = ((m_config.isEEA) && (m_config.cut != CUT_LOW)) ? INJECT_RUN : TEMPRUN_MIN;
+
+    switch (m_config.cut)
+    {
+        case CUT_HIGH: m_filExt = ".HCI"; m_calExt = ".HCI"; m_rolExt = ".HCR"; break;
+        case CUT_FULL: m_filExt = ".FCI"; m_calExt = ".FCI"; m_rolExt = ".FCR"; break;
+        case CUT_LOW: m_filExt = ".LCT"; m_calExt = ".LCI"; m_rolExt = ".LCR"; break;
+        default: m_filExt = ".MCI"; m_calExt = ".MCI"; m_rolExt = ".MCR"; break;
+    }
+
+    m_idSn = (m_config.isEEA) ? EEA_ID_SN_PIPE : RAZ_ID_SN_PIPE;
+    m_idWatercut = (m_config.isEEA) ? EEA_ID_WATERCUT : RAZ_ID_WATERCUT;
+    m_idTemperature = (m_config.isEEA) ? EEA_ID_TEMPERATURE : RAZ_ID_TEMPERATURE;
+    m_idFreq = (m_config.isEEA) ? EEA_ID_FREQ : RAZ_ID_FREQ;
+    m_idOilRp = (m_config.isEEA) ? EEA_ID_OIL_RP : RAZ_ID_OIL_RP;
+}
+
+
+bool
+CalEngine::
+validateSerialNumber()
+{
+    for (int pipe = 0; pipe < m_pipes.size(); pipe++)
+    {
+        const int slave = m_pipes[pipe].slave;
+
+        /// nothing to ask in a replay, the recording answers for every pipe
+        if (m_replay != NULL)
+        {
+            m_pipes[pipe].status = ENABLED;
+            continue;
+        }
+
+        const BUS_REPLIES reply = busWait(m_bus->submit<BUS_REPLIES>(slave, [this](modbus_t * modbus)
+        {
+            BUS_REPLIES r;
+
+            if (modbus == NULL) return r;
+
+            r.regs.resize(1);
+            r.rc = modbus_read_input_registers(modbus, m_idSn-ADDR_OFFSET, 1, r.regs.data());
+            return r;
+        }));
+
+        if ((reply.rc != 1) || (reply.regs[0] != (uint16_t) slave))
+        {
+            m_pipes[pipe].status = DISABLED;
+            emit message(QString("%1 SN%2 does not answer with its serial number").arg(m_pipes[pipe].pipeId).arg(slave));
+            return false;
+        }
+
+        m_pipes[pipe].status = ENABLED;
+    }
+
+    return true;
+}
+
+
+/// an existing folder is kept as <folder>_N before a new one is created;
+/// a simulation writes into the folders a calibration left
+bool
+CalEngine::
+startCalibration(QString & error)
+{
+    QDir dir;
+
+    for (int pipe = 0; pipe < m_pipes.size(); pipe++)
+    {
+        CAL_PIPES & p = m_pipes[pipe];
+        int fileCounter = 2;
+
+        if (m_config.isSimulation)
+        {
+            if (!dir.exists(p.mainDirPath))
+            {
+                error = QString("No Simulation Directory Exists!! %1").arg(p.mainDirPath);
+                return false;
+            }
+
+            p.file = p.mainDirPath+"/"+QString("CALIBRAT__").append(QString::number(m_config.injectTemp)).append(SIMULATION_EXT);
+            continue;
+        }
+
+        if (dir.exists(p.mainDirPath))
+        {
+            while (dir.exists(p.mainDirPath+"_"+QString::number(fileCounter))) fileCounter++;
+            if (!dir.rename(p.mainDirPath, p.mainDirPath+"_"+QString::number(fileCounter)))
+            {
+                error = "Cannot Create The Calibration Folders";
+                return false;
+            }
+        }
+
+        if (!dir.mkpath(p.mainDirPath))
+        {
+            error = "Cannot Create The Calibration Folders";
+            return false;
+        }
+
+        if ((m_config.isEEA) && ((m_config.cut == CUT_HIGH) || (m_config.cut == CUT_FULL))) p.file = p.mainDirPath+"/"+QString::number(SALINITY[m_salinityIndex].toDouble()*100).append("_100").append(m_filExt);
+        else if ((m_config.isEEA) && (m_config.cut == CUT_MID)) p.file = p.mainDirPath+"/"+QString("OIL_").append(QString::number(m_config.injectTemp)).append(m_filExt);
+        else p.file = p.mainDirPath+"/"+QString("AMB_").append(QString::number(m_config.minTemp)).append(m_filExt);
+    }
+
+    return true;
+}
+
+
+/// what moves the sequence on; a state and event missing here fail the run
+static const CAL_TRANSITIONS CAL_TABLE[] =
+{
+    {STATE_IDLE,            EVENT_START,            STATE_TEMP_SETUP},
+    {STATE_IDLE,            EVENT_NEXT_RUN,         STATE_INJECT_SETUP},
+
+    {STATE_TEMP_SETUP,      EVENT_CONFIRMED,        STATE_TEMP_SAMPLE},
+    {STATE_TEMP_SETUP,      EVENT_DECLINED,         STATE_FAILED},
+    {STATE_TEMP_SAMPLE,     EVENT_SAMPLE_READY,     STATE_TEMP_WAIT},
+    {STATE_TEMP_SAMPLE,     EVENT_STABLE,           STATE_TEMP_NEXT},
+    {STATE_TEMP_WAIT,       EVENT_TIMEOUT,          STATE_TEMP_SAMPLE},
+    {STATE_TEMP_NEXT,       EVENT_NEXT_STAGE,       STATE_TEMP_SETUP},
+    {STATE_TEMP_NEXT,       EVENT_NEXT_RUN,         STATE_INJECT_SETUP},
+    {STATE_TEMP_NEXT,       EVENT_FINISHED,         STATE_DONE},
+
+    {STATE_INJECT_SETUP,    EVENT_CONFIRMED,        STATE_INJECT_SAMPLE},
+    {STATE_INJECT_SETUP,    EVENT_DECLINED,         STATE_FAILED},
+    {STATE_INJECT_SAMPLE,   EVENT_SAMPLE_READY,     STATE_INJECT},
+    {STATE_INJECT_SAMPLE,   EVENT_TARGET_REACHED,   STATE_INJECT_FINAL},
+    {STATE_INJECT,          EVENT_INJECTED,         STATE_INJECT_WAIT},
+    {STATE_INJECT,          EVENT_NOT_READY,        STATE_INJECT_WAIT},
+    {STATE_INJECT,          EVENT_DECLINED,         STATE_FAILED},
+    {STATE_INJECT_WAIT,     EVENT_TIMEOUT,          STATE_INJECT_SAMPLE},
+    {STATE_INJECT_FINAL,    EVENT_NEXT_RUN,         STATE_INJECT_SETUP},
+    {STATE_INJECT_FINAL,    EVENT_NEXT_STAGE,       STATE_ROLLOVER_SAMPLE},
+    {STATE_INJECT_FINAL,    EVENT_FINISHED,         STATE_DONE},
+    {STATE_INJECT_FINAL,    EVENT_DECLINED,         STATE_FAILED},
+
+    {STATE_ROLLOVER_SAMPLE, EVENT_SAMPLE_READY,     STATE_ROLLOVER_INJECT},
+    {STATE_ROLLOVER_SAMPLE, EVENT_FINISHED,         STATE_DONE},
+    {STATE_ROLLOVER_INJECT, EVENT_INJECTED,         STATE_ROLLOVER_WAIT},
+    {STATE_ROLLOVER_INJECT, EVENT_NOT_READY,        STATE_ROLLOVER_WAIT},
+    {STATE_ROLLOVER_INJECT, EVENT_DECLINED,         STATE_FAILED},
+    {STATE_ROLLOVER_WAIT,   EVENT_TIMEOUT,          STATE_ROLLOVER_SAMPLE},
+
+    {STATE_ANY,             EVENT_ABORT,            STATE_FAILED},
+    {STATE_ANY,             EVENT_ERROR,            STATE_FAILED}
+};
+
+
+const char *
+calStateName(const int state)
+{
+    static const char * NAMES[CAL_STATE_COUNT] = {"IDLE", "TEMP_SETUP", "TEMP_SAMPLE", "TEMP_WAIT", "TEMP_NEXT", "INJECT_SETUP", "INJECT_SAMPLE", "INJECT", "INJECT_WAIT", "INJECT_FINAL", "ROLLOVER_SAMPLE", "ROLLOVER_INJECT", "ROLLOVER_WAIT", "DONE", "FAILED"};
+
+    return ((state >= 0) && (state < CAL_STATE_COUNT)) ? NAMES[state] : "ANY";
+}
+
+
+const char *
+calEventName(const int event)
+{
+    static const char * NAMES[CAL_EVENT_COUNT] = {"START", "CONFIRMED", "DECLINED", "SAMPLE_READY", "STABLE", "TIMEOUT", "TARGET_REACHED", "INJECTED", "NOT_READY", "NEXT_STAGE", "NEXT_RUN", "FINISHED", "ABORT", "ERROR"};
+
+    return ((event >= 0) && (event < CAL_EVENT_COUNT)) ? NAMES[event] : "?";
+}
+
+
+/// runs the sequence to the end, false if it was cancelled or failed
+bool
+CalEngine::
+run()
+{
+    typedef CAL_EVENT (CalEngine::*CAL_ACTION)();
+
+    /// what each state does on entry, in CAL_STATE order
+    static const CAL_ACTION ACTIONS[CAL_STATE_COUNT] =
+    {
+        NULL,
+        &CalEngine::setupTempRun,
+        &CalEngine::sampleTempRun,
+        &CalEngine::waitForSample,
+        &CalEngine::nextTempRun,
+        &CalEngine::setupInjection,
+        &CalEngine::sampleInjection,
+        &CalEngine::injectStep,
+        &CalEngine::waitForSample,
+        &CalEngine::finalizeInjection,
+        &CalEngine::sampleRollover,
+        &CalEngine::injectRollover,
+        &CalEngine::waitForSample,
+        NULL,
+        NULL
+    };
+
+    m_state = STATE_IDLE;
+    m_entered = 0;
+    m_nextSample = 0;
+    m_stateTime.fill(0, CAL_STATE_COUNT);
+    m_stage.clear();
+    m_endText.clear();
+    m_clock.start(m_timebase);
+
+    if (m_resume == STATE_IDLE)
+    {
+        /// razors start with the temperature runs, EEAs above lowcut go
+        /// straight to the injection
+        dispatch((m_isAborted) ? EVENT_ABORT : ((m_runMode == TEMPRUN_MIN) ? EVENT_START : EVENT_NEXT_RUN));
+    }
+    else
+    {
+        m_state = m_resume;
+        m_stage = m_runMode;
+
+        emit message(QString("Resuming in %1 from %2").arg(calStateName(m_state)).arg(journalPath()));
+        emit stageChanged(m_stage);
+    }
+
+    while ((m_state != STATE_DONE) && (m_state != STATE_FAILED))
+    {
+        applyPipeStatus();
+
+        const CAL_EVENT event = (m_isAborted) ? EVENT_ABORT : (this->*ACTIONS[m_state])();
+
+        dispatch((m_isAborted) ? EVENT_ABORT : event);
+    }
+
+    m_journal.close();
+
+    /// whatever happened, no pump is left running
+    switchPump(COIL_WATER_PUMP, false);
+    switchPump(COIL_OIL_PUMP, false);
+
+    m_runMode = STOP_CALIBRATION;
+
+    emit message(m_endText);
+    emit stageChanged(m_runMode);
+
+    return (m_state == STATE_DONE);
+}
+
+
+/// looks the event up for the current state and moves on, every
+/// transition is reported with the time spent in the state it leaves
+void
+CalEngine::
+dispatch(const CAL_EVENT event)
+{
+    const qint64 now = m_clock.elapsed();
+    CAL_TIMINGS timing;
+
+    timing.from = m_state;
+    timing.event = event;
+    timing.to = STATE_FAILED;
+    timing.at = now;
+    timing.duration = now - m_entered;
+
+    for (unsigned i = 0; i < sizeof(CAL_TABLE)/sizeof(CAL_TABLE[0]); i++)
+    {
+        if (((CAL_TABLE[i].from == m_state) || (CAL_TABLE[i].from == STATE_ANY)) && (CAL_TABLE[i].event == event))
+        {
+            timing.to = CAL_TABLE[i].to;
+            break;
+        }
+    }
+
+    if ((timing.to == STATE_FAILED) && m_endText.isEmpty())
+    {
+        if (event == EVENT_DECLINED) m_endText = "Calibration cancelled!";
+        else if (event == EVENT_ABORT) m_endText = "Calibration aborted";
+        else m_endText = QString("No transition from %1 on %2").arg(calStateName(m_state)).arg(calEventName(event));
+    }
+
+    if ((timing.to == STATE_DONE) && m_endText.isEmpty()) m_endText = "Calibration has finished successfully.";
+
+    m_stateTime[m_state] += timing.duration;
+    m_state = timing.to;
+    m_entered = now;
+
+    emit transition(timing);
+
+    if (event == EVENT_INJECTED) emit progressed(-1, progress(-1));
+
+    /// an aborted run stays resumable from its last checkpoint, and a
+    /// wait state changes nothing worth a record
+    if ((event != EVENT_ABORT) && (event != EVENT_TIMEOUT) && !m_journal.append(checkpoint(timing))) emit message(QString("Cannot write the journal %1").arg(m_journal.fileName()));
+
+    if ((m_stage != m_runMode) && (m_state != STATE_DONE) && (m_state != STATE_FAILED))
+    {
+        m_stage = m_runMode;
+        emit stageChanged(m_stage);
+    }
+}
+
+
+/// everything run() needs to go on from the state just entered
+QVariantMap
+CalEngine::
+checkpoint(const CAL_TIMINGS & timing) const
+{
+    QVariantMap record;
+    QVariantList pipes;
+
+    for (int pipe = 0; pipe < m_pipes.size(); pipe++)
+    {
+        const CAL_PIPES & p = m_pipes[pipe];
+        QVariantMap entry;
+
+        entry["slave"] = p.slave;
+        entry["row"] = p.row;
+        entry["status"] = p.status;
+        entry["tempStability"] = p.tempStability;
+        entry["freqStability"] = p.freqStability;
+        entry["rolloverTracker"] = p.rolloverTracker;
+        entry["temperature"] = p.temperature;
+        entry["temperature_prev"] = p.temperature_prev;
+        entry["frequency"] = p.frequency;
+        entry["frequency_prev"] = p.frequency_prev;
+        entry["frequency_start"] = p.frequency_start;
+        entry["mainDirPath"] = p.mainDirPath;
+        entry["file"] = p.file;
+        entry["fileCalibrate"] = p.fileCalibrate;
+        entry["fileAdjusted"] = p.fileAdjusted;
+        entry["fileRollover"] = p.fileRollover;
+        entry["elapsed"] = p.elapsedBase + p.etimer.elapsed();
+        pipes.append(entry);
+    }
+
+    record["time"] = m_timebase->now().toString(Qt::ISODate);
+    record["at"] = timing.at;
+    record["event"] = calEventName(timing.event);
+    record["state"] = (int) timing.to;
+    record["stateName"] = calStateName(timing.to);
+    record["cut"] = m_config.cut;
+    record["isEEA"] = m_config.isEEA;
+
+    /// the run settings, for a front end that fills its own from them
+    record["isMaster"] = m_config.isMaster;
+    record["isTempRunOnly"] = m_config.isTempRunOnly;
+    record["isSimulation"] = m_config.isSimulation;
+    record["osc"] = m_config.osc;
+    record["loopVolume"] = m_config.loopVolume;
+    record["saltStart"] = m_config.saltStart;
+    record["saltStop"] = m_config.saltStop;
+    record["waterRunStart"] = m_config.waterRunStart;
+    record["waterRunStop"] = m_config.waterRunStop;
+    record["oilRunStart"] = m_config.oilRunStart;
+    record["oilRunStop"] = m_config.oilRunStop;
+
+    record["runMode"] = m_runMode;
+    record["currentTemp"] = m_currentTemp;
+    record["targetTemp"] = m_targetTemp;
+    record["isWaterRun"] = m_isWaterRun;
+    record["isOilRun"] = m_isOilRun;
+    record["isIgnoreMaxInjection"] = m_isIgnoreMaxInjection;
+    record["salinityIndex"] = m_salinityIndex;
+    record["phaseRolloverCounter"] = m_phaseRolloverCounter;
+    record["watercut"] = m_watercut;
+    record["runStart"] = m_runStart;
+    record["injectionTime"] = m_injectionTime;
+    record["totalInjectionTime"] = m_totalInjectionTime;
+    record["totalInjectionVolume"] = m_totalInjectionVolume;
+    record["accumulatedInjectionTime"] = m_accumulatedInjectionTime;
+    record["deliveredInjectionTime"] = m_deliveredInjectionTime;
+    record["model"] = m_model.state();
+    record["operatorName"] = m_operatorName;
+    record["pipes"] = pipes;
+
+    return record;
+}
+
+
+/// a checkpoint between the start and the end of a run
+bool
+CalEngine::
+isResumable(const QVariantMap & record)
+{
+    const int state = record["state"].toInt();
+
+    return (state > STATE_IDLE) && (state < STATE_DONE);
+}
+
+
+/// the journal has to belong to the same loop: same cut, product and
+/// serial numbers in the same rows
+bool
+CalEngine::
+restore(const QVariantMap & record, QString & error)
+{
+    const QVariantList pipes = record["pipes"].toList();
+    const int state = record["state"].toInt();
+
+    if ((record["cut"].toInt() != m_config.cut) || (record["isEEA"].toBool() != m_config.isEEA) || (pipes.size() != m_pipes.size()))
+    {
+        error = QString("%1 belongs to another calibration").arg(journalPath());
+        return false;
+    }
+
+    if (!isResumable(record))
+    {
+        error = QString("%1 ends in %2, nothing to resume").arg(journalPath()).arg(calStateName(state));
+        return false;
+    }
+
+    for (int pipe = 0; pipe < m_pipes.size(); pipe++)
+    {
+        const QVariantMap entry = pipes[pipe].toMap();
+        CAL_PIPES & p = m_pipes[pipe];
+
+        if ((entry["slave"].toInt() != p.slave) || (entry.contains("row") && (entry["row"].toInt() != p.row)))
+        {
+            error = QString("%1 belongs to another calibration").arg(journalPath());
+            return false;
+        }
+
+        p.status = entry["status"].toInt();
+        p.tempStability = entry["tempStability"].toInt();
+        p.freqStability = entry["freqStability"].toInt();
+        p.rolloverTracker = entry["rolloverTracker"].toInt();
+        p.temperature = entry["temperature"].toDouble();
+        p.temperature_prev = entry["temperature_prev"].toDouble();
+        p.frequency = entry["frequency"].toDouble();
+        p.frequency_prev = entry["frequency_prev"].toDouble();
+        p.frequency_start = entry["frequency_start"].toDouble();
+        p.mainDirPath = entry["mainDirPath"].toString();
+        p.file = entry["file"].toString();
+        p.fileCalibrate = entry["fileCalibrate"].toString();
+        p.fileAdjusted = entry["fileAdjusted"].toString();
+        p.fileRollover = entry["fileRollover"].toString();
+        p.elapsedBase = entry["elapsed"].toLongLong();
+        p.etimer.start(m_timebase);
+    }
+
+    m_runMode = record["runMode"].toString();
+    m_currentTemp = record["currentTemp"].toString();
+    m_targetTemp = record["targetTemp"].toString();
+    m_isWaterRun = record["isWaterRun"].toBool();
+    m_isOilRun = record["isOilRun"].toBool();
+    m_isIgnoreMaxInjection = record["isIgnoreMaxInjection"].toBool();
+    m_salinityIndex = record["salinityIndex"].toInt();
+    m_phaseRolloverCounter = record["phaseRolloverCounter"].toInt();
+    m_watercut = record["watercut"].toDouble();
+    m_runStart = record["runStart"].toDouble();
+    m_injectionTime = record["injectionTime"].toDouble();
+    m_totalInjectionTime = record["totalInjectionTime"].toDouble();
+    m_totalInjectionVolume = record["totalInjectionVolume"].toDouble();
+    m_accumulatedInjectionTime = record["accumulatedInjectionTime"].toDouble();
+    m_deliveredInjectionTime = record["deliveredInjectionTime"].toDouble();
+    m_model.setState(record["model"].toMap());
+    m_operatorName = record["operatorName"].toString();
+    m_resume = (CAL_STATE) state;
+
+    return true;
+}
+
+
+void
+CalEngine::
+abort()
+{
+    m_isAborted = 1;
+    m_injection->abort();
+}
+
+
+/// ends the current temperature stage as if every pipe were stable, a
+/// paused run goes on for it
+void
+CalEngine::
+skip()
+{
+    m_isSkip = 1;
+    m_isPaused = 0;
+}
+
+
+/// a paused run stays in its wait state, nothing is read or injected
+void
+CalEngine::
+pause(const bool isPaused)
+{
+    m_isPaused = (isPaused) ? 1 : 0;
+}
+
+
+/// cuts the running pulse short, the run goes on with what it delivered
+void
+CalEngine::
+stopInjection()
+{
+    m_injection->abort();
+}
+
+
+/// the pipe switches of the GUI, safe from any thread; run() takes them
+/// over before the next state
+void
+CalEngine::
+setPipeStatus(const int pipe, const int status)
+{
+    QMutexLocker lock(&m_pipeStatusMutex);
+
+    m_pipeStatus[pipe] = status;
+}
+
+
+void
+CalEngine::
+applyPipeStatus()
+{
+    QMutexLocker lock(&m_pipeStatusMutex);
+
+    for (QMap<int, int>::const_iterator i = m_pipeStatus.constBegin(); i != m_pipeStatus.constEnd(); ++i)
+    {
+        if ((i.key() >= 0) && (i.key() < m_pipes.size())) m_pipes[i.key()].status = i.value();
+    }
+
+    m_pipeStatus.clear();
+}
+
+
+CAL_PROGRESSES
+CalEngine::
+progress(const int pipe) const
+{
+    CAL_PROGRESSES p;
+
+    if ((pipe >= 0) && (pipe < m_pipes.size()))
+    {
+        p.status = m_pipes[pipe].status;
+        p.tempStability = m_pipes[pipe].tempStability;
+        p.freqStability = m_pipes[pipe].freqStability;
+    }
+
+    p.master = m_master;
+    p.watercut = m_watercut;
+    p.salinity = SALINITY[m_salinityIndex].toDouble();
+    p.injectionTime = m_injectionTime;
+    p.totalInjectionVolume = m_totalInjectionVolume;
+
+    return p;
+}
+
+
+/// the next sample is due one sample period after the last one started,
+/// only what is left of it is waited for
+CAL_EVENT
+CalEngine::
+waitForSample()
+{
+    qint64 left;
+
+    while (((left = m_nextSample - m_clock.elapsed()) > 0) || m_isPaused)
+    {
+        if (m_isAborted) return EVENT_ABORT;
+        if (m_isSkip) break;
+
+        m_timebase->sleep((left > 0) ? qMin(left, (qint64) CAL_WAIT_SLICE) : CAL_WAIT_SLICE);
+    }
+
+    return EVENT_TIMEOUT;
+}
+
+
+bool
+CalEngine::
+initTempRun()
+{
+    const QString title = QString("LOOP %1").arg(m_config.loopNumber);
+
+    if (!m_operator->confirm(title, "Fill The Water Container To The Mark.")) return false;
+
+    m_operatorName = (m_config.operatorName.isEmpty()) ? m_operator->askText(title, "Enter Operator's Name.") : m_config.operatorName;
+    m_runStart = m_operator->askValue("Enter Measured Initial Watercut.", m_config.oilRunStart);
+    m_watercut = m_runStart;
+
+    if (!m_config.isMaster) return true;
+
+    if ((m_master.watercut > m_config.masterMax) && !m_operator->confirm(QString("Master Pipe Raw watercut Value Is Greater Than %1").arg(m_config.masterMax), "Do You Want To Continue?")) return false;
+    if ((m_master.watercut < m_config.masterMin) && !m_operator->confirm(QString("Master Pipe Raw watercut Value Is Less Than %1").arg(m_config.masterMin), "Do You Want To Continue?")) return false;
+    if ((qAbs(m_master.watercut - m_runStart) > m_config.masterDelta) && !m_operator->confirm(QString("The difference between master watercut and measured initial watercut is greater than %1").arg(m_config.masterDelta), "Do You Want To Continue?")) return false;
+
+    return true;
+}
+
+
+/// AMB -> min, min -> max, max -> injection temperature: targets, heat
+/// exchanger and the stage files
+CAL_EVENT
+CalEngine::
+setupTempRun()
+{
+    readMasterPipe();
+    updatePipeStability(-1, false);
+
+    for (int pipe = 0; pipe < m_pipes.size(); pipe++)
+    {
+        m_pipes[pipe].tempSettling.reset();
+        m_pipes[pipe].freqSettling.reset();
+    }
+
+    restartChannels();
+
+    if (m_runMode == TEMPRUN_MIN)
+    {
+        if (!initTempRun()) return EVENT_DECLINED;
+
+        m_currentTemp = "AMB";
+        m_targetTemp = QString::number(m_config.minTemp);
+    }
+    else if (m_runMode == TEMPRUN_HIGH)
+    {
+        m_currentTemp = QString::number(m_config.minTemp);
+        m_targetTemp = QString::number(m_config.maxTemp);
+    }
+    else
+    {
+        m_currentTemp = QString::number(m_config.maxTemp);
+        m_targetTemp = QString::number(m_config.injectTemp);
+    }
+
+    if (!m_operator->setHeatExchanger(m_targetTemp.toDouble())) return EVENT_DECLINED;
+
+    for (int pipe = 0; pipe < m_pipes.size(); pipe++)
+    {
+        if (m_pipes[pipe].status != ENABLED) continue;
+
+        setFileNameForNextStage(pipe, m_currentTemp+"_"+m_targetTemp+m_filExt);
+        if (!QFileInfo(m_pipes[pipe].file).exists()) createTempRunFile(pipe, m_currentTemp, m_targetTemp);
+    }
+
+    return EVENT_CONFIRMED;
+}
+
+
+/// a stage ends once every pipe has been stable near its target
+CAL_EVENT
+CalEngine::
+sampleTempRun()
+{
+    m_nextSample = m_clock.elapsed() + m_config.xDelay;
+
+    readMasterPipe();
+
+    for (int pipe = 0; pipe < m_pipes.size(); pipe++)
+    {
+        CAL_PIPES & p = m_pipes[pipe];
+
+        if (p.status != ENABLED) continue;
+
+        if (m_isSkip)
+        {
+            p.tempStability = CAL_STABLE_COUNT;
+            p.freqStability = CAL_STABLE_COUNT;
+        }
+
+        if ((p.tempStability != CAL_STABLE_COUNT) || (p.freqStability != CAL_STABLE_COUNT))
+        {
+            if (!readPipe(pipe, true)) break;
+
+            writeSample(pipe);
+            predictStability(pipe);
+        }
+        else
+        {
+            p.status = DONE;
+            p.tempStability = 0;
+            p.freqStability = 0;
+            emit message(QString("%1 SN%2 stable at %3 °C").arg(p.pipeId).arg(p.slave).arg(p.temperature, 0, 'f', 2));
+        }
+    }
+
+    return (isEnabledLeft()) ? EVENT_SAMPLE_READY : EVENT_STABLE;
+}
+
+
+/// every pipe is done, next temperature stage or on to the injection
+CAL_EVENT
+CalEngine::
+nextTempRun()
+{
+    m_isSkip = 0;
+
+    for (int pipe = 0; pipe < m_pipes.size(); pipe++)
+    {
+        if (m_pipes[pipe].status == DONE) m_pipes[pipe].status = ENABLED;
+    }
+
+    if (m_runMode == TEMPRUN_MIN)
+    {
+        m_runMode = TEMPRUN_HIGH;
+        return EVENT_NEXT_STAGE;
+    }
+
+    if (m_runMode == TEMPRUN_HIGH)
+    {
+        m_runMode = TEMPRUN_INJECT;
+        return EVENT_NEXT_STAGE;
+    }
+
+    if (m_config.isTempRunOnly)
+    {
+        m_endText = "Temp Run Has Finished.";
+        return EVENT_FINISHED;
+    }
+
+    for (int pipe = 0; pipe < m_pipes.size(); pipe++)
+    {
+        if (m_pipes[pipe].status != ENABLED) continue;
+
+        if (m_config.cut == CUT_LOW) setFileNameForNextStage(pipe, "CALIBRAT"+m_calExt);
+        else if (m_isWaterRun) setFileNameForNextStage(pipe, QString::number(SALINITY[m_salinityIndex].toDouble()*100).append("_100").append(m_filExt));
+        else setFileNameForNextStage(pipe, QString("OIL__").append(m_targetTemp).append(m_filExt));
+
+        m_pipes[pipe].frequency_start = m_pipes[pipe].frequency;
+    }
+
+    m_runMode = INJECT_RUN;
+    return EVENT_NEXT_RUN;
+}
+
+
+/// operator checks before a water or oil run and the file headers
+bool
+CalEngine::
+initInjection()
+{
+    const QString title = QString("LOOP %1").arg(m_config.loopNumber);
+
+    m_injectionTime = 0;
+    m_totalInjectionTime = 0;
+    m_totalInjectionVolume = 0;
+    m_accumulatedInjectionTime = 0;
+    m_deliveredInjectionTime = 0;
+    m_phaseRolloverCounter = 0;
+    m_isIgnoreMaxInjection = false;
+
+    if (m_isWaterRun)
+    {
+        if (!m_operator->confirm(title, QString("Fill The Loop With Water At %1 % Salinity").arg(SALINITY[m_salinityIndex]))) return false;
+        if (!m_operator->confirm(QString("WATER_RUN : OIL INJECTION WILL START IN LOOP %1").arg(m_config.loopNumber), "Please Make Sure There Is Enough Oil In The Injection Bucket")) return false;
+        if (!m_operator->setHeatExchanger(38)) return false;
+
+        /// no need to ask, a water run starts at 99% and more
+        m_runStart = m_config.waterRunStart;
+    }
+    else
+    {
+        if (!m_operator->confirm(title, "Fill The Loop With Oil At 1 % Salinity")) return false;
+        if (!m_operator->confirm(QString("OIL_RUN : WATER INJECTION WILL START IN LOOP %1").arg(m_config.loopNumber), "Please Make Sure There Is Enough Water In The Injection Bucket")) return false;
+        if (!m_operator->setHeatExchanger((m_config.isEEA) ? 60 : 38)) return false;
+
+        m_runStart = m_operator->askValue("Enter Measured Initial Watercut", m_config.oilRunStart);
+    }
+
+    m_watercut = m_runStart;
+    m_model.start(m_isWaterRun, m_runStart, m_config.loopVolume, (m_isWaterRun) ? m_config.injectionOilPumpRate : m_config.injectionWaterPumpRate);
+
+    if (m_operatorName.isEmpty()) m_operatorName = (m_config.operatorName.isEmpty()) ? m_operator->askText(title, "Enter Operator's Name.") : m_config.operatorName;
+
+    for (int pipe = 0; pipe < m_pipes.size(); pipe++)
+    {
+        if (m_pipes[pipe].status != ENABLED) continue;
+
+        if (m_config.cut == CUT_LOW) createInjectFile(pipe, "CALIBRAT", QString::number(m_runStart), QString::number(m_config.oilRunStop), "1");
+        else if (m_isWaterRun) createInjectFile(pipe, "ANY", QString::number(m_config.waterRunStart), QString::number(m_config.waterRunStop), SALINITY[m_salinityIndex]);
+        else createInjectFile(pipe, "ANY", QString::number(m_runStart), QString::number(m_config.oilRunStop), "1");
+    }
+
+    return true;
+}
+
+
+CAL_EVENT
+CalEngine::
+setupInjection()
+{
+    m_runMode = (m_config.isSimulation) ? SIMULATION_RUN : INJECT_RUN;
+
+    return (initInjection()) ? EVENT_CONFIRMED : EVENT_DECLINED;
+}
+
+
+/// logs every pipe of a water or oil run until it passes its last watercut
+CAL_EVENT
+CalEngine::
+sampleInjection()
+{
+    m_nextSample = m_clock.elapsed() + m_config.xDelay;
+
+    /// the master before every step is what the loop model learns from
+    if (readMasterPipe() && !m_config.isMaster && m_config.isInjectionModel && !m_pipes.isEmpty())
+    {
+        const CAL_PIPES & first = m_pipes.first();
+
+        m_model.observe((first.elapsedBase + first.etimer.elapsed())/1000.0, m_deliveredInjectionTime, m_master.watercut);
+    }
+
+    if ((m_isOilRun && (m_config.oilRunStop < m_watercut)) || (m_isWaterRun && (m_config.waterRunStop > m_watercut))) return EVENT_TARGET_REACHED;
+
+    for (int pipe = 0; pipe < m_pipes.size(); pipe++)
+    {
+        if (m_pipes[pipe].status != ENABLED) continue;
+        if (!readPipe(pipe, false)) break;
+
+        writeSample(pipe);
+    }
+
+    return EVENT_SAMPLE_READY;
+}
+
+
+/// injects towards the next watercut of the run
+CAL_EVENT
+CalEngine::
+injectStep()
+{
+    const CAL_EVENT event = (m_config.isMaster) ? injectToTarget() : injectByPumpRate();
+
+    if (event == EVENT_INJECTED)
+    {
+        restartChannels();
+        nextWatercut();
+    }
+
+    return event;
+}
+
+
+void
+CalEngine::
+nextWatercut()
+{
+    if (m_config.cut == CUT_LOW) m_watercut += m_config.intervalSmallPump;
+    else if (m_config.cut == CUT_MID) m_watercut += m_config.intervalBigPump;
+    else if (m_isWaterRun) m_watercut -= m_config.intervalBigPump;
+    else m_watercut += m_config.intervalBigPump;
+}
+
+
+/// measured watercut and totals close the run, then on to the next
+/// salinity, the oil run or the lowcut rollover
+CAL_EVENT
+CalEngine::
+finalizeInjection()
+{
+    const QString title = QString("LOOP %1").arg(m_config.loopNumber);
+    const double measuredWatercut = m_operator->askValue("Enter Measured Watercut [%]", (m_config.isMaster) ? m_master.watercut : m_watercut);
+
+    if ((m_config.isMaster) && (qAbs(m_master.watercut - measuredWatercut) > m_config.masterDeltaFinal))
+    {
+        if (!m_operator->confirm(QString("MASTER PIPE %1 Difference between measured watercut and master watercut is greater than %2").arg(m_config.loopNumber).arg(m_config.masterDeltaFinal), "Do You Want To Continue?")) return EVENT_DECLINED;
+    }
+
+    QStringList totals;
+    totals << QString("Total injection time   = %1 s").arg(m_totalInjectionTime, 10, 'g', -1, ' ')
+           << QString("Total injection volume = %1 mL").arg(m_totalInjectionVolume, 10, 'g', -1, ' ')
+           << QString("Initial loop volume    = %1 mL").arg(m_config.loopVolume, 10, 'g', -1, ' ')
+           << QString("Measured watercut      = %1 %").arg(measuredWatercut, 10, 'f', 2, ' ')
+           << QString("[%1] [%2]").arg(m_timebase->now().toString()).arg(m_operatorName);
+
+    double correctedWatercut = m_watercut;
+    bool isAdjusted = false;
+
+    /// the pulses delivered another volume than the pump rate gives: the
+    /// lowcut file is kept again as ADJUSTED, with the modelled watercut
+    if ((m_config.cut == CUT_LOW) && (qAbs(m_totalInjectionVolume - (m_config.injectionWaterPumpRate/60)*m_totalInjectionTime) > 0))
+    {
+        for (int pipe = 0; pipe < m_pipes.size(); pipe++)
+        {
+            if (m_pipes[pipe].status == ENABLED) isAdjusted |= writeAdjusted(pipe, correctedWatercut);
+        }
+    }
+
+    for (int pipe = 0; pipe < m_pipes.size(); pipe++)
+    {
+        if (m_pipes[pipe].status == ENABLED) appendTotals((m_config.cut == CUT_LOW) ? m_pipes[pipe].fileCalibrate : m_pipes[pipe].file, totals);
+        if (m_config.cut == CUT_LOW) appendTotals(m_pipes[pipe].fileAdjusted, totals);
+    }
+
+    if ((!m_config.isEEA) || (m_config.cut == CUT_MID)) return EVENT_FINISHED;
+
+    if ((m_config.cut == CUT_HIGH) || (m_config.cut == CUT_FULL))
+    {
+        m_operator->inform(title, QString("Calibration has finished at %1 % Salinity.").arg(SALINITY[m_salinityIndex]));
+
+        if (!m_isWaterRun) return EVENT_FINISHED;
+
+        if ((SALINITY[m_salinityIndex] == m_config.saltStop) || (m_salinityIndex + 1 >= SALINITY_COUNT))
+        {
+            m_operator->inform(title, "Water Run Has Finished Successfully. Oil Run Will Get Started.");
+
+            m_isOilRun = true;
+            m_isWaterRun = false;
+            m_salinityIndex = 0;
+
+            for (int pipe = 0; pipe < m_pipes.size(); pipe++)
+            {
+                if (m_pipes[pipe].status == ENABLED) m_pipes[pipe].file = m_pipes[pipe].mainDirPath+"/"+QString("OIL__140").append(m_filExt);
+            }
+        }
+        else
+        {
+            m_salinityIndex++;
+
+            for (int pipe = 0; pipe < m_pipes.size(); pipe++)
+            {
+                if (m_pipes[pipe].status == ENABLED) m_pipes[pipe].file = m_pipes[pipe].mainDirPath+"/"+QString::number(SALINITY[m_salinityIndex].toDouble()*100).append("_100").append(m_filExt);
+            }
+        }
+
+        return EVENT_NEXT_RUN;
+    }
+
+    /// lowcut goes on with the rollover, from the modelled watercut once
+    /// there is one
+    m_operator->inform(title, "Please Switch The Injection Pump.");
+    m_watercut = (isAdjusted) ? correctedWatercut : m_watercut + m_config.intervalBigPump;
+
+    for (int pipe = 0; pipe < m_pipes.size(); pipe++)
+    {
+        if (m_pipes[pipe].status != ENABLED) continue;
+
+        setFileNameForNextStage(pipe, "ROLLOVER"+m_rolExt);
+        m_pipes[pipe].fileRollover = m_pipes[pipe].file;
+        m_pipes[pipe].rolloverTracker = 0;
+        m_pipes[pipe].frequency_prev = m_pipes[pipe].frequency;
+    }
+
+    m_runMode = ROLLOVER_RUN;
+    return EVENT_NEXT_STAGE;
+}
+
+
+/// copies CALIBRAT to ADJUSTED line by line; every data line gets the
+/// watercut the loop would have at its time with the water pump at its
+/// nominal rate, laid out as the GUI always wrote it. The last one is
+/// where the rollover starts.
+bool
+CalEngine::
+writeAdjusted(const int pipe, double & correctedWatercut)
+{
+    const CAL_PIPES & p = m_pipes[pipe];
+    QFile calibrate(p.fileCalibrate);
+    QFile adjusted(p.fileAdjusted);
+    const bool isListed = QFileInfo(p.fileAdjusted).exists();
+
+    if (p.fileAdjusted.isEmpty() || !calibrate.open(QIODevice::ReadOnly | QIODevice::Text)) return false;
+
+    if (!adjusted.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    {
+        calibrate.close();
+        return false;
+    }
+
+    QTextStream in(&calibrate);
+    QTextStream out(&adjusted);
+    bool isAdjusted = false;
+
+    while (!in.atEnd())
+    {
+        QString line = in.readLine();
+        const QStringList data = line.split(' ', QString::SkipEmptyParts);
+        CAL_SAMPLES sample;
+
+        /// headers, pulses and model lines are copied as they are
+        if (calDataParse(line, sample) && (data.size() > ADJUSTED_TIME_COLUMN))
+        {
+            correctedWatercut = (m_runStart + 100) - (100*exp(-(m_config.injectionWaterPumpRate/60)*data[ADJUSTED_TIME_COLUMN].toDouble()/m_config.loopVolume));
+            isAdjusted = true;
+
+            line = QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10 %11 %12 %13 %14 %15 %16 %17 %18 %19").arg(data[0].toDouble(), 9, 'g', -1, ' ').arg(correctedWatercut,7,'f',2,' ').arg(data[2].toDouble(), 4, 'g', -1, ' ').arg(" INT").arg(1, 7, 'g', -1, ' ').arg(data[5].toDouble(),9,'f',3,' ').arg(0,8,'f',2,' ').arg(data[7].toDouble(),9,'f',2,' ').arg(data[8].toDouble(),11,'f',2,' ').arg(0,8,'f',2,' ').arg(data[10].toDouble(),12,'f',2,' ').arg(data[11].toDouble(),12,'f',2,' ').arg(0,10,'f',2,' ').arg(data[13].toDouble(), 11,'f',2,' ').arg(data[14].toDouble(), 11,'f',2,' ').arg(data[15].toDouble(), 11,'f',2,' ').arg(data[16].toDouble(), 11,'f',2,' ').arg(data[17].toDouble(), 11,'f',2,' ').arg(0,12,'f',2,' ');
+        }
+
+        out << line << '\n';
+    }
+
+    calibrate.close();
+    adjusted.close();
+
+    if (!isListed) updateFileList(QFileInfo(p.fileAdjusted).fileName(), pipe);
+
+    return isAdjusted;
+}
+
+
+/// the rollover keeps injecting until the frequency of every pipe has
+/// fallen for more than two readings in a row
+CAL_EVENT
+CalEngine::
+sampleRollover()
+{
+    m_nextSample = m_clock.elapsed() + m_config.xDelay;
+
+    readMasterPipe();
+
+    for (int pipe = 0; pipe < m_pipes.size(); pipe++)
+    {
+        CAL_PIPES & p = m_pipes[pipe];
+
+        if (p.status != ENABLED) continue;
+        if (!readPipe(pipe, false)) break;
+
+        if (p.frequency < p.frequency_prev)
+        {
+            if (p.rolloverTracker > 2) p.status = DONE;
+            else p.rolloverTracker++;
+        }
+        else p.rolloverTracker = 0;
+
+        p.frequency_prev = p.frequency;
+
+        createInjectFile(pipe, "ROLLOVER", "Rollover", QString::number(m_watercut), "1");
+        writeSample(pipe);
+
+        if (p.status == DONE) emit message(QString("%1 SN%2 rolled over at %3 %").arg(p.pipeId).arg(p.slave).arg(m_watercut, 0, 'f', 2));
+    }
+
+    if (isEnabledLeft()) return EVENT_SAMPLE_READY;
+
+    QStringList totals;
+    totals << QString("Total injection time   = %1 s").arg(m_totalInjectionTime, 10, 'g', -1, ' ')
+           << QString("Total injection volume = %1 mL").arg(m_totalInjectionVolume, 10, 'g', -1, ' ')
+           << QString("Initial loop volume    = %1 mL").arg(m_config.loopVolume, 10, 'g', -1, ' ')
+           << QString("[%1] [%2]").arg(m_timebase->now().toString()).arg(m_operatorName);
+
+    for (int pipe = 0; pipe < m_pipes.size(); pipe++)
+    {
+        if (m_pipes[pipe].status == DONE) appendTotals(m_pipes[pipe].fileRollover, totals);
+    }
+
+    return EVENT_FINISHED;
+}
+
+
+CAL_EVENT
+CalEngine::
+injectRollover()
+{
+    const CAL_EVENT event = (m_config.isMaster) ? injectToTarget() : injectByPumpRate();
+
+    if (event == EVENT_INJECTED)
+    {
+        restartChannels();
+        m_watercut += m_config.intervalBigPump;
+    }
+
+    return event;
+}
+
+
+/// master pipe mode: the pump runs until the control box reads the target
+CAL_EVENT
+CalEngine::
+injectToTarget()
+{
+    const int phase = (m_isOilRun) ? PHASE_OIL : PHASE_WATER;
+    const int coil = (m_isWaterRun) ? COIL_OIL_PUMP : COIL_WATER_PUMP;
+    const double rate = ((m_isWaterRun) ? m_config.injectionOilPumpRate : m_config.injectionWaterPumpRate)/60;
+    const int maxInjection = (m_isWaterRun) ? m_config.maxInjectionOil : m_config.maxInjectionWater;
+    CalTimer timer;
+    CAL_STEPS step;
+    CAL_STEPS recorded;
+    bool isRecorded = false;
+    qint64 polled;          /// run time the last master read started
+
+    if ((int) m_master.phase != phase)
+    {
+        if (++m_phaseRolloverCounter <= MAX_PHASE_CHECKING) return EVENT_NOT_READY;
+
+        m_endText = QString("Master Pipe Is In The Wrong Phase (%1), Watercut %2 %").arg(m_master.phase).arg(m_master.watercut);
+        return EVENT_ERROR;
+    }
+
+    m_phaseRolloverCounter = 0;
+    step.target = m_watercut;
+    timer.start(m_timebase);
+
+    /// an unacknowledged on may still have switched the pump
+    if (!switchPump(coil, true))
+    {
+        if (switchPump(coil, false)) return EVENT_NOT_READY;
+
+        m_endText = QString("The %1 pump could not be switched off, switch it off at the control box!").arg((coil == COIL_OIL_PUMP) ? "oil" : "water");
+        return EVENT_ERROR;
+    }
+
+    const qint64 pumpOn = timer.elapsed();
+    polled = pumpOn;
+
+    /// a recording has no master in between its samples: the pump runs as
+    /// long as the recorded step, the master of the next sample ends it
+    if (m_replay != NULL)
+    {
+        isRecorded = m_replay->step(recordedMasterPath(), recorded);
+
+        if (isRecorded) m_timebase->sleep(qRound64(recorded.reads*recorded.interval));
+    }
+
+    /// watercut and phase back to back at the bus's pace, the rest of the
+    /// master waits for the end of the step
+    while ((m_isOilRun) ? (m_master.watercut < m_watercut) : (m_master.watercut > m_watercut))
+    {
+        if (m_isAborted) break;
+
+        if (!m_isIgnoreMaxInjection && (timer.elapsed()/1000 > maxInjection))
+        {
+            if (!m_operator->confirm(QString("Injection Time %1 Is Greater Than Max Injection Time %2").arg(timer.elapsed()/1000).arg(maxInjection), "Do You Want To Continue?"))
+            {
+                if (switchPump(coil, false)) return EVENT_DECLINED;
+
+                m_endText = QString("The %1 pump could not be switched off, switch it off at the control box!").arg((coil == COIL_OIL_PUMP) ? "oil" : "water");
+                return EVENT_ERROR;
+            }
+
+            m_isIgnoreMaxInjection = true;
+        }
+
+        polled = timer.elapsed();
+        readMasterFast();
+        step.reads++;
+
+        /// the loop left the phase of the run, the next step's check decides
+        if (((int) m_master.phase != phase) || (m_replay != NULL)) break;
+    }
+
+    const qint64 pumpOff = timer.elapsed();
+
+    if (!switchPump(coil, false))
+    {
+        m_endText = QString("The %1 pump could not be switched off, switch it off at the control box!").arg((coil == COIL_OIL_PUMP) ? "oil" : "water");
+        return EVENT_ERROR;
+    }
+
+    if (isRecorded)
+    {
+        m_timebase->sleep(qRound64(recorded.latency));
+
+        step.reads = recorded.reads;
+        step.latency = recorded.latency;
+        step.interval = recorded.interval;
+    }
+    else
+    {
+        step.latency = timer.elapsed() - polled;
+        step.interval = (step.reads > 0) ? (double) (pumpOff - pumpOn)/step.reads : 0;
+    }
+
+    m_injectionTime = timer.elapsed()/1000.0;
+    m_totalInjectionTime += m_injectionTime;
+    m_totalInjectionVolume += m_injectionTime*rate;
+
+    readMasterPipe();
+
+    step.reached = m_master.watercut;
+    step.overshoot = (m_isOilRun) ? step.reached - step.target : step.target - step.reached;
+
+    for (int pipe = 0; pipe < m_pipes.size(); pipe++)
+    {
+        QFile file(m_pipes[pipe].file);
+
+        if (m_pipes[pipe].status == ENABLED) appendCalLine(file, calStepStream(step));
+    }
+
+    emit message(calStepStream(step));
+
+    return (m_isAborted) ? EVENT_ABORT : EVENT_INJECTED;
+}
+
+
+/// pump rate mode: the time for the next watercut comes from the loop
+/// volume, the pulse from the injection scheduler
+CAL_EVENT
+CalEngine::
+injectByPumpRate()
+{
+    const int coil = (m_isWaterRun) ? COIL_OIL_PUMP : COIL_WATER_PUMP;
+    const double rate = ((m_isWaterRun) ? m_config.injectionOilPumpRate : m_config.injectionWaterPumpRate)/60;
+    const int maxInjection = (m_isWaterRun) ? m_config.maxInjectionOil : m_config.maxInjectionWater;
+    double accumulatedInjectionTime;
+
+    /// oil into water thins the water out, water into oil fills the loop up;
+    /// the model goes from what the pulses delivered, so their jitter does
+    /// not add up either
+    if (m_config.isInjectionModel) accumulatedInjectionTime = m_model.injectionTime(m_watercut);
+    else if (m_isWaterRun) accumulatedInjectionTime = -(m_config.loopVolume/rate)*log(m_watercut/m_runStart);
+    else accumulatedInjectionTime = -(m_config.loopVolume/rate)*log(1 - (m_watercut - m_runStart)/100);
+
+    m_injectionTime = accumulatedInjectionTime - ((m_config.isInjectionModel) ? m_deliveredInjectionTime : m_accumulatedInjectionTime);
+    m_accumulatedInjectionTime = accumulatedInjectionTime;
+    m_totalInjectionTime += m_injectionTime;
+    m_totalInjectionVolume = m_totalInjectionTime*rate;
+
+    if (m_injectionTime <= 0) return EVENT_INJECTED;
+
+    if ((m_injectionTime > maxInjection) && !m_operator->confirm(QString("Injection Time %1 Is Greater Than Max Injection Time %2").arg(m_injectionTime).arg(maxInjection), "Do You Want To Continue?")) return EVENT_DECLINED;
+
+    /// the timer slave only runs the water pump
+    m_injection->setTimer((m_config.isInjectionTimer && m_isOilRun) ? MODBUS_TIMER_SLAVE : -1);
+
+    const INJECTION_PULSES pulse = (m_replay != NULL) ? replayPulse() : busWait(m_injection->pulse(CONTROLBOX_SLAVE, coil-ADDR_OFFSET, m_injectionTime));
+
+    /// only an acknowledged off counts, otherwise try once more from here
+    const bool isPumpOff = pulse.isStopped || switchPump(coil, false);
+
+    /// a failed pulse delivered an unknown amount, it is not credited
+    m_deliveredInjectionTime += pulse.achieved;
+
+    for (int pipe = 0; pipe < m_pipes.size(); pipe++)
+    {
+        QFile file(m_pipes[pipe].file);
+
+        if (m_pipes[pipe].status != ENABLED) continue;
+
+        appendCalLine(file, calPulseStream(pulse));
+        if (m_config.isInjectionModel) appendCalLine(file, calModelStream(m_model.fit()));
+    }
+
+    emit injected(pulse);
+
+    if (!isPumpOff)
+    {
+        m_endText = QString("The %1 pump could not be switched off, switch it off at the control box!").arg((coil == COIL_OIL_PUMP) ? "oil" : "water");
+        return EVENT_ERROR;
+    }
+
+    return (m_isAborted) ? EVENT_ABORT : EVENT_INJECTED;
+}
+
+
+bool
+CalEngine::
+switchPump(const int coil, const bool isOn)
+{
+    if (m_replay != NULL) return true;
+
+    return busWait(m_bus->submit<bool>(CONTROLBOX_SLAVE, [coil, isOn](modbus_t * modbus)
+    {
+        return (modbus != NULL) && (modbus_write_bit(modbus, coil-ADDR_OFFSET, isOn) == 1);
+    }));
+}
+
+
+/// false if a frame failed
+bool
+CalEngine::
+readMasterPipe()
+{
+    if (m_replay != NULL) return replayMaster();
+
+    ReadPlanner planner(m_config.readGap);
+
+    planner.addFloat(EEA_ID_WATERCUT-ADDR_OFFSET, &m_master.watercut);
+    planner.addFloat(EEA_ID_SALINITY-ADDR_OFFSET, &m_master.salinity);
+    planner.addFloat(EEA_ID_OIL_ADJUST-ADDR_OFFSET, &m_master.oilAdj);
+    planner.addFloat(EEA_ID_OIL_RP-ADDR_OFFSET, &m_master.oilRp);
+    planner.addFloat(EEA_ID_TEMPERATURE-ADDR_OFFSET, &m_master.temperature);
+    planner.addFloat(EEA_ID_FREQ-ADDR_OFFSET, &m_master.freq);
+    planner.addFloat(MASTER_ID_PHASE-ADDR_OFFSET, &m_master.phase);
+    planner.addFloat(EEA_ID_PRESSURE-ADDR_OFFSET, &m_master.pressure);
+
+    const int failed = busWait(m_bus->submit<int>(CONTROLBOX_SLAVE, [&planner](modbus_t * modbus) { return planner.execute(modbus); }));
+
+    m_failedFrames += failed;
+    return (failed == 0);
+}
+
+
+/// only what closes the injection loop, one frame when the planner can
+/// bridge the gap; false if the frame failed
+bool
+CalEngine::
+readMasterFast()
+{
+    if (m_replay != NULL) return replayMaster();
+
+    ReadPlanner planner(m_config.readGap);
+
+    planner.addFloat(EEA_ID_WATERCUT-ADDR_OFFSET, &m_master.watercut);
+    planner.addFloat(MASTER_ID_PHASE-ADDR_OFFSET, &m_master.phase);
+
+    const int failed = busWait(m_bus->submit<int>(CONTROLBOX_SLAVE, [&planner](modbus_t * modbus) { return planner.execute(modbus); }));
+
+    m_failedFrames += failed;
+    return (failed == 0);
+}
+
+
+/// false only when a replay has run out of recording; checkStability
+/// counts the reading towards the temperature stage's stability
+bool
+CalEngine::
+readPipe(const int pipe, const bool checkStability)
+{
+    CAL_PIPES & p = m_pipes[pipe];
+    double temperature = NAN;
+    double frequency = NAN;
+    double oilrp = NAN;
+
+    if (m_replay != NULL)
+    {
+        if (!replayPipe(pipe, temperature, frequency, oilrp)) return false;
+    }
+    else
+    {
+        ReadPlanner planner(m_config.readGap);
+
+        if (m_config.isSimulation) planner.addFloat(m_idWatercut-ADDR_OFFSET, &p.watercut);
+
+        /// the channels do the range check; a failed frame leaves NAN,
+        /// which they turn away like any other bad reading
+        planner.addFloat(m_idTemperature-ADDR_OFFSET, &temperature);
+        planner.addFloat(m_idFreq-ADDR_OFFSET, &frequency);
+        planner.addFloat(m_idOilRp-ADDR_OFFSET, &oilrp);
+        planner.addFloat(RAZ_MEAS_AI-ADDR_OFFSET, &p.measai, -100, 100);
+        planner.addFloat(RAZ_TRIM_AI-ADDR_OFFSET, &p.trimai, -100, 100);
+
+        m_failedFrames += busWait(m_bus->submit<int>(p.slave, [&planner](modbus_t * modbus) { return planner.execute(modbus); }));
+    }
+
+    p.tempStats.add(temperature);
+    p.freqStats.add(frequency);
+    p.oilrpStats.add(oilrp);
+
+    p.temperature = p.tempStats.value();
+    p.frequency = p.freqStats.value();
+    p.oilrp = p.oilrpStats.value();
+
+    /// only a reading near the stage's target counts, the one just taken
+    updatePipeStability(pipe, checkStability && (qAbs(m_targetTemp.toDouble() - p.temperature) < CAL_STABLE_WINDOW));
+
+    return true;
+}
+
+
+/// the loop was moved on purpose, the outlier filter must not take the
+/// new level for a spike
+void
+CalEngine::
+restartChannels()
+{
+    for (int pipe = 0; pipe < m_pipes.size(); pipe++)
+    {
+        m_pipes[pipe].tempStats.restart();
+        m_pipes[pipe].freqStats.restart();
+        m_pipes[pipe].oilrpStats.restart();
+    }
+}
+
+
+/// counts readings in a row within zTemp and yFreq, -1 resets every pipe
+void
+CalEngine::
+updatePipeStability(const int pipe, const bool checkStability)
+{
+    if (!checkStability)
+    {
+        for (int i = 0; i < m_pipes.size(); i++)
+        {
+            if ((pipe >= 0) && (i != pipe)) continue;
+
+            m_pipes[i].tempStability = 0;
+            m_pipes[i].freqStability = 0;
+        }
+
+        return;
+    }
+
+    CAL_PIPES & p = m_pipes[pipe];
+
+    if (p.tempStability < CAL_STABLE_COUNT)
+    {
+        if (qAbs(p.temperature - p.temperature_prev) <= m_config.zTemp) p.tempStability++;
+        else p.tempStability = 0;
+
+        p.temperature_prev = p.temperature;
+    }
+
+    if (p.freqStability < CAL_STABLE_COUNT)
+    {
+        if (qAbs(p.frequency - p.frequency_prev) <= m_config.yFreq) p.freqStability++;
+        else p.freqStability = 0;
+
+        p.frequency_prev = p.frequency;
+    }
+}
+
+
+/// a pipe is also stable once the fitted approach says neither its
+/// temperature nor its frequency will move more than zTemp and yFreq, and
+/// the temperature settles near the target; the statistics go to the file
+void
+CalEngine::
+predictStability(const int pipe)
+{
+    CAL_PIPES & p = m_pipes[pipe];
+    const double z = SettlingEstimator::zScore(m_config.stableConfidence);
+    SETTLING_FITS temp;
+    SETTLING_FITS freq;
+
+    p.tempSettling.add(p.temperature);
+    p.freqSettling.add(p.frequency);
+
+    if (m_config.stableConfidence <= 0) return;
+    if (!p.tempSettling.isSettled(m_config.zTemp, z, temp) || !p.freqSettling.isSettled(m_config.yFreq, z, freq)) return;
+    if (qAbs(m_targetTemp.toDouble() - temp.final) >= CAL_STABLE_WINDOW) return;
+
+    QFile file(p.file);
+
+    p.tempStability = CAL_STABLE_COUNT;
+    p.freqStability = CAL_STABLE_COUNT;
+    appendCalLine(file, calSettlingStream(temp, freq, m_config.stableConfidence));
+}
+
+
+void
+CalEngine::
+writeSample(const int pipe)
+{
+    const CAL_PIPES & p = m_pipes[pipe];
+    CAL_SAMPLES sample;
+    QFile file(p.file);
+
+    sample.elapsed = (p.elapsedBase + p.etimer.elapsed())/1000;
+    sample.watercut = (m_config.isMaster) ? m_master.watercut : m_watercut;
+    sample.osc = p.osc;
+    sample.frequency = p.frequency;
+    sample.oilrp = p.oilrp;
+    sample.temperature = p.temperature;
+    sample.masterPressure = m_master.pressure;
+    sample.masterTemp = m_master.temperature;
+    sample.masterOilAdj = m_master.oilAdj;
+    sample.masterFreq = m_master.freq;
+    sample.masterWatercut = m_master.watercut;
+    sample.masterOilRp = m_master.oilRp;
+    sample.masterPhase = m_master.phase;
+    sample.pipeWatercut = (m_config.isSimulation) ? p.watercut : 0;
+
+    appendCalLine(file, calDataStream(sample));
+
+    emit progressed(pipe, progress(pipe));
+    emit sampled(pipe, sample);
+}
+
+
+bool
+CalEngine::
+isEnabledLeft() const
+{
+    for (int pipe = 0; pipe < m_pipes.size(); pipe++)
+    {
+        if (m_pipes[pipe].status == ENABLED) return true;
+    }
+
+    return false;
+}
+
+
+void
+CalEngine::
+setFileNameForNextStage(const int pipe, const QString & nextFileId)
+{
+    m_pipes[pipe].file = m_pipes[pipe].mainDirPath+"/"+nextFileId;
+    m_pipes[pipe].freqStability = 0;
+    m_pipes[pipe].tempStability = 0;
+}
+
+
+QString
+CalEngine::
+header1(const int pipe) const
+{
+    return "SN"+QString::number(m_pipes[pipe].slave)+" | "+calCutName(m_config)+" | "+m_timebase->now().toString()+" | L"+QString::number(m_config.loopNumber)+m_pipes[pipe].pipeId+" | "+PROJECT_NAME+RELEASE_VERSION;
+}
+
+
+void
+CalEngine::
+createTempRunFile(const int pipe, const QString & startValue, const QString & stopValue)
+{
+    QString header2 = "INJECTION:  "+startValue+" % "+"to "+stopValue+" % "+"Watercut at 1 % "+"Salinity\n";
+
+    if ((m_config.cut == CUT_LOW) || (!m_config.isEEA)) header2 = "TEMPERATURE:  "+startValue+" °C "+"to "+stopValue+" °C\n";
+
+    writeHeader(pipe, m_pipes[pipe].file, header2);
+}
+
+
+/// CALIBRAT and ROLLOVER are the lowcut files, anything else goes to the
+/// pipe's current file; an existing file is left as it is
+void
+CalEngine::
+createInjectFile(const int pipe, const QString & fileId, const QString & startValue, const QString & stopValue, const QString & saltValue)
+{
+    CAL_PIPES & p = m_pipes[pipe];
+    QString header2 = "INJECTION:  "+startValue+" % "+"to "+stopValue+" % "+"Watercut at "+saltValue+" % "+"Salinity\n";
+    QString path = p.file;
+
+    if (fileId == "CALIBRAT")
+    {
+        p.fileCalibrate = p.mainDirPath+"/"+QString("CALIBRAT").append(m_calExt);
+        p.fileAdjusted = p.mainDirPath+"/"+QString("ADJUSTED").append(m_calExt);
+        if (!m_config.isSimulation) p.file = p.fileCalibrate;
+        path = p.fileCalibrate;
+        header2 = "INJECTION:  "+startValue+" % "+"to "+stopValue+" % Watercut\n";
+    }
+    else if (fileId == "ROLLOVER")
+    {
+        path = p.fileRollover;
+        header2 = "ROLLOVER:  "+stopValue+" % "+"to "+"rollover\n";
+    }
+
+    if (!QFileInfo(path).exists()) writeHeader(pipe, path, header2);
+}
+
+
+void
+CalEngine::
+writeHeader(const int pipe, const QString & path, const QString & header2)
+{
+    const QString header3 = HEADER3;
+    const QString header4 = HEADER4;
+    const QString header5 = HEADER5;
+    QFile file(path);
+    QTextStream stream(&file);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) return;
+
+    stream << ((m_config.isEEA) ? EEA_INJECTION_FILE : RAZ_INJECTION_FILE) << '\n' << header1(pipe) << '\n' << header2 << '\n' << header3 << '\n' << header4 << '\n' << header5 << '\n';
+    file.close();
+
+    updateFileList(QFileInfo(path).fileName(), pipe);
+}
+
+
+void
+CalEngine::
+appendTotals(const QString & path, const QStringList & totals)
+{
+    QFile file(path);
+    QTextStream stream(&file);
+
+    if (!QFileInfo(path).exists() || !file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) return;
+
+    stream << '\n' << '\n' << totals.join('\n') << '\n';
+    file.close();
+}
+
+
+void
+CalEngine::
+updateFileList(const QString & fileName, const int pipe)
+{
+    QFile file(m_pipes[pipe].mainDirPath+"/"+FILE_LIST);
+    QTextStream stream(&file);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) return;
+
+    if (file.size() == 0) stream << ((m_config.isEEA) ? EEA_INJECTION_FILE : RAZ_INJECTION_FILE) << '\n' << header1(pipe) << '\n' << '\n' << fileName << '\n';
+    else stream << fileName << '\n';
+
+    file.close();
+}
+
+
+/// where the recording has the file the engine writes to
+QString
+CalEngine::
+recordedPath(const QString & file) const
+{
+    return QDir(m_replay->root()).filePath(QDir(m_config.mainServer).relativeFilePath(file));
+}
+
+
+/// the master and the pump were logged with every pipe, the first one
+/// still running is read for them
+QString
+CalEngine::
+recordedMasterPath() const
+{
+    for (int pipe = 0; pipe < m_pipes.size(); pipe++)
+    {
+        if (m_pipes[pipe].status == ENABLED) return recordedPath(m_pipes[pipe].file);
+    }
+
+    return QString();
+}
+
+
+/// the pipe's next recorded line in place of the bus; the run's time goes
+/// on to when it was read. A recording that ends before the sequence
+/// does ends the run.
+bool
+CalEngine::
+replayPipe(const int pipe, double & temperature, double & frequency, double & oilrp)
+{
+    const CAL_PIPES & p = m_pipes[pipe];
+    CAL_SAMPLES s;
+
+    if (!m_replay->sample(recordedPath(p.file), s))
+    {
+        if (m_endText.isEmpty()) m_endText = QString("%1 SN%2: the recording ends before %3 does").arg(p.pipeId).arg(p.slave).arg(QFileInfo(p.file).fileName());
+
+        m_isAborted = 1;
+        return false;
+    }
+
+    m_timebase->sleep(s.elapsed*1000 - (p.elapsedBase + p.etimer.elapsed()));
+
+    temperature = s.temperature;
+    frequency = s.frequency;
+    oilrp = s.oilrp;
+
+    return true;
+}
+
+
+/// the master as it was read with the next sample, false past the end
+bool
+CalEngine::
+replayMaster()
+{
+    CAL_SAMPLES s;
+
+    if (!m_replay->peek(recordedMasterPath(), s)) return false;
+
+    m_master.watercut = s.masterWatercut;
+    m_master.oilAdj = s.masterOilAdj;
+    m_master.oilRp = s.masterOilRp;
+    m_master.temperature = s.masterTemp;
+    m_master.freq = s.masterFreq;
+    m_master.phase = s.masterPhase;
+    m_master.pressure = s.masterPressure;
+
+    return true;
+}
+
+
+/// the pulse asked for now, as wide as the recorded one was; without a
+/// recorded pulse it is exact. The run's time goes on by its width.
+INJECTION_PULSES
+CalEngine::
+replayPulse()
+{
+    INJECTION_PULSES pulse;
+
+    if (!m_replay->pulse(recordedMasterPath(), pulse))
+    {
+        pulse.isOk = true;
+        pulse.achieved = m_injectionTime;
+    }
+
+    /// nothing was switched, there is nothing left to switch off
+    pulse.isStarted = (pulse.achieved > 0);
+    pulse.isStopped = true;
+    pulse.requested = m_injectionTime;
+    m_timebase->sleep(qRound64(((pulse.achieved > 0) ? pulse.achieved : pulse.requested)*1000));
+
+    return pulse;
+}
@@ -0,0 +1,383 @@
+#ifndef CALENGINE_H
+#define CALENGINE_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QAtomicInt>
+#include <QMap>
+#include <QMutex>
+#include <QMetaType>
+#include "calclock.h"
+#include "calconfig.h"
+#include "calstream.h"
+#include "caljournal.h"
+#include "calreplay.h"
+#include "channelstats.h"
+#include "loopmodel.h"
+#include "modbusbus.h"
+#include "injectionscheduler.h"
+
+/// longest sleep while waiting for the next sample, so an abort or a
+/// skip is noticed (ms)
+#define CAL_WAIT_SLICE              50
+
+/// lowest frequency and reflected power taken as a reading; an unplugged
+/// or dead channel answers exactly 0
+#define CAL_MIN_READING             1e-6
+
+/// column of a CALIBRAT data line ADJUSTED takes the time from, the one
+/// the GUI always took it from
+#define ADJUSTED_TIME_COLUMN        12
+
+/// states of the calibration sequence
+enum CAL_STATE
+{
+    STATE_ANY = -1,         /// matches every state in the transition table
+    STATE_IDLE,
+    STATE_TEMP_SETUP,       /// operator questions and files of a temperature stage
+    STATE_TEMP_SAMPLE,
+    STATE_TEMP_WAIT,
+    STATE_TEMP_NEXT,
+    STATE_INJECT_SETUP,     /// operator questions and files of a water or oil run
+    STATE_INJECT_SAMPLE,
+    STATE_INJECT,
+    STATE_INJECT_WAIT,
+    STATE_INJECT_FINAL,
+    STATE_ROLLOVER_SAMPLE,
+    STATE_ROLLOVER_INJECT,
+    STATE_ROLLOVER_WAIT,
+    STATE_DONE,
+    STATE_FAILED,
+    CAL_STATE_COUNT
+};
+
+/// what moves the sequence from one state to the next
+enum CAL_EVENT
+{
+    EVENT_START,
+    EVENT_CONFIRMED,        /// the operator answered yes
+    EVENT_DECLINED,         /// the operator answered no
+    EVENT_SAMPLE_READY,     /// readings of every running pipe arrived
+    EVENT_STABLE,           /// every pipe of the temperature stage is stable
+    EVENT_TIMEOUT,          /// the sample period is over
+    EVENT_TARGET_REACHED,   /// the run reached its last watercut
+    EVENT_INJECTED,
+    EVENT_NOT_READY,        /// nothing injected, the master pipe is not in phase yet
+    EVENT_NEXT_STAGE,
+    EVENT_NEXT_RUN,
+    EVENT_FINISHED,
+    EVENT_ABORT,
+    EVENT_ERROR,
+    CAL_EVENT_COUNT
+};
+
+typedef struct CAL_TRANSITION
+{
+    CAL_STATE from;
+    CAL_EVENT event;
+    CAL_STATE to;
+
+} CAL_TRANSITIONS;
+
+
+/// one record per transition, times on the run clock (ms)
+typedef struct CAL_TIMING
+{
+    CAL_STATE from;
+    CAL_EVENT event;
+    CAL_STATE to;
+    qint64 at;              /// since run() started
+    qint64 duration;        /// spent in from
+
+    CAL_TIMING() : from(STATE_IDLE), event(EVENT_START), to(STATE_IDLE), at(0), duration(0) {}
+
+} CAL_TIMINGS;
+
+const char * calStateName(const int);
+const char * calEventName(const int);
+
+typedef struct CAL_PIPE
+{
+    int slave;
+    int row;                /// panel row, the pipe id follows it
+    QString pipeId;
+    int status;
+    int osc;
+    int tempStability;
+    int freqStability;
+    int rolloverTracker;
+    double temperature;
+    double temperature_prev;
+    double frequency;
+    double frequency_prev;
+    double frequency_start;
+    double oilrp;
+    double measai;
+    double trimai;
+    double watercut;        /// the pipe's own watercut, simulation only
+    QString mainDirPath;
+    QString file;           /// file the samples go to
+    QString fileCalibrate;  /// LOWCUT only
+    QString fileAdjusted;   /// CALIBRAT with the modelled watercut, LOWCUT only
+    QString fileRollover;
+    CalTimer etimer;
+    qint64 elapsedBase;     /// ms the pipe had run before a resume
+    SettlingEstimator tempSettling;
+    SettlingEstimator freqSettling;
+    ChannelStats tempStats;     /// temperature, frequency and oilrp are their value()
+    ChannelStats freqStats;
+    ChannelStats oilrpStats;
+
+    CAL_PIPE() : slave(0), row(0), status(DISABLED), osc(1), tempStability(0), freqStability(0), rolloverTracker(0), temperature(0), temperature_prev(0), frequency(0), frequency_prev(0), frequency_start(0), oilrp(0), measai(0), trimai(0), watercut(0), elapsedBase(0), tempStats(-100, 100), freqStats(CAL_MIN_READING, 1000), oilrpStats(CAL_MIN_READING, 100) {}
+
+} CAL_PIPES;
+
+
+typedef struct CAL_MASTER
+{
+    double watercut;
+    double salinity;
+    double oilAdj;
+    double oilRp;
+    double temperature;
+    double freq;
+    double phase;
+    double pressure;
+
+    CAL_MASTER() : watercut(0), salinity(0), oilAdj(0), oilRp(0), temperature(0), freq(0), phase(1), pressure(1) {}
+
+} CAL_MASTERS;
+
+
+/// where a pipe and the run stand, a copy for a front end that is not on
+/// the engine's thread; a pipe's comes before its sample, pipe -1 carries
+/// the run alone
+typedef struct CAL_PROGRESS
+{
+    int status;
+    int tempStability;
+    int freqStability;
+    CAL_MASTERS master;
+    double watercut;
+    double salinity;
+    double injectionTime;
+    double totalInjectionVolume;
+
+    CAL_PROGRESS() : status(DISABLED), tempStability(0), freqStability(0), watercut(0), salinity(0), injectionTime(0), totalInjectionVolume(0) {}
+
+} CAL_PROGRESSES;
+
+
+/// What the engine needs from whoever runs the loop. The GUI answers with
+/// dialogs, the command line runner from stdin or from the config.
+class CalOperator
+{
+public:
+    virtual ~CalOperator() {}
+
+    virtual bool confirm(const QString & title, const QString & text) = 0;
+    virtual double askValue(const QString & title, const double value) = 0;
+    virtual QString askText(const QString & title, const QString & text) = 0;
+    virtual void inform(const QString & title, const QString & text) = 0;
+
+    /// the heat exchanger is turned by hand on a real loop
+    virtual bool setHeatExchanger(const double target) { return confirm("Set The Heat Exchanger Temperature (°C)", QString::number(target)); }
+};
+
+
+/// The calibration sequence: temperature runs, water and oil injection
+/// runs and the lowcut rollover, for MainWindow and sparky-cli alike.
+/// run() blocks the calling thread; bus traffic goes through the engine's
+/// own ModbusBus, or the one it is handed, pulses through its own
+/// InjectionScheduler. MainWindow and sparky-cli both run it on a thread
+/// of its own through CalLoops.
+///
+/// The sequence is a state machine. Each state does its work on entry and
+/// answers with an event, the transition table picks the next state. A
+/// sample state hands over as soon as its readings arrive; the wait states
+/// only sleep what is left of the sample period (LOOP.XDelay) since the
+/// last sample started.
+///
+/// In pump rate mode the injections are timed by a LoopModel fitted to
+/// the master reading of every step (LOOP.InjectionModel), starting from
+/// the entered loop volume and pump rate.
+///
+/// Every transition leaves a checkpoint in the loop's journal. prepare()
+/// with isResume set rebuilds the run from the last one instead of
+/// starting over, and run() goes on from the state it names.
+///
+/// All of the engine's time comes from one CalClock, the system clock
+/// unless setClock() gives it another. With a CalReplay the pipes and the
+/// master are read from a recorded run instead of the bus and the pumps
+/// only pass time, so on a VirtualClock hours of calibration take seconds.
+class CalEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    CalEngine(const CAL_CONFIGS &, CalOperator *, QObject * parent = 0);
+    CalEngine(const CAL_CONFIGS &, CalOperator *, ModbusBus *, QObject * parent = 0);
+    ~CalEngine();
+
+    const CAL_CONFIGS & config() const { return m_config; }
+    ModbusBus * bus() { return m_bus; }
+    const QVector<CAL_PIPES> & pipes() const { return m_pipes; }
+    const CAL_MASTERS & master() const { return m_master; }
+    QString runMode() const { return m_runMode; }
+    CAL_STATE state() const { return m_state; }
+    qint64 stateTime(const CAL_STATE state) const { return m_stateTime.value(state); }
+    const QString & endText() const { return m_endText; }
+
+    /// where the run stands, for the loop status panel
+    double watercut() const { return m_watercut; }
+    double injectionTime() const { return m_injectionTime; }
+    double totalInjectionVolume() const { return m_totalInjectionVolume; }
+    QString salinity() const { return SALINITY[m_salinityIndex]; }
+
+    QString journalPath() const;
+    static bool isResumable(const QVariantMap &);
+
+    /// both before prepare(), neither is taken over
+    void setClock(CalClock * clock) { m_timebase = (clock) ? clock : &m_systemClock; }
+    void setReplay(CalReplay * replay) { m_replay = replay; }
+
+    bool prepare(QString &, const bool isResume = false);
+    bool run();
+    void abort();
+    void skip();
+    void pause(const bool);
+    bool isPaused() const { return m_isPaused; }
+    bool isAborted() const { return m_isAborted; }
+    void stopInjection();
+    void setPipeStatus(const int, const int);
+
+    /// one acquisition cycle is the master, then a reading and a data line
+    /// per pipe; bench/cyclebench times them one by one after prepare()
+    bool readMasterPipe();
+    bool readPipe(const int, const bool);
+    void writeSample(const int);
+    int failedFrames() const { return m_failedFrames; }
+
+signals:
+    void stageChanged(const QString &);
+    void sampled(const int, const CAL_SAMPLES &);
+    void progressed(const int, const CAL_PROGRESSES &);
+    void injected(const INJECTION_PULSES &);
+    void message(const QString &);
+    void transition(const CAL_TIMINGS &);
+
+private:
+    void readLoopConfiguration();
+    bool validateSerialNumber();
+    bool startCalibration(QString &);
+    void dispatch(const CAL_EVENT);
+    void applyPipeStatus();
+    CAL_PROGRESSES progress(const int) const;
+    QVariantMap checkpoint(const CAL_TIMINGS &) const;
+    bool restore(const QVariantMap &, QString &);
+
+    /// state actions
+    CAL_EVENT setupTempRun();
+    CAL_EVENT sampleTempRun();
+    CAL_EVENT nextTempRun();
+    CAL_EVENT setupInjection();
+    CAL_EVENT sampleInjection();
+    CAL_EVENT injectStep();
+    CAL_EVENT finalizeInjection();
+    CAL_EVENT sampleRollover();
+    CAL_EVENT injectRollover();
+    CAL_EVENT waitForSample();
+
+    bool initTempRun();
+    bool initInjection();
+    CAL_EVENT injectToTarget();
+    CAL_EVENT injectByPumpRate();
+    void nextWatercut();
+    bool writeAdjusted(const int, double &);
+
+    bool readMasterFast();
+    void restartChannels();
+    void updatePipeStability(const int, const bool);
+    void predictStability(const int);
+    bool isEnabledLeft() const;
+
+    void setFileNameForNextStage(const int, const QString &);
+    QString header1(const int) const;
+    void createTempRunFile(const int, const QString &, const QString &);
+    void createInjectFile(const int, const QString &, const QString &, const QString &, const QString &);
+    void writeHeader(const int, const QString &, const QString &);
+    void appendTotals(const QString &, const QStringList &);
+    void updateFileList(const QString &, const int);
+    bool switchPump(const int, const bool);
+
+    /// replay
+    QString recordedPath(const QString &) const;
+    QString recordedMasterPath() const;
+    bool replayPipe(const int, double &, double &, double &);
+    bool replayMaster();
+    INJECTION_PULSES replayPulse();
+
+    CAL_CONFIGS m_config;
+    CalOperator * m_operator;
+    ModbusBus * m_bus;
+    bool m_isOwnBus;        /// a bus handed in stays with its owner
+    InjectionScheduler * m_injection;
+    QVector<CAL_PIPES> m_pipes;
+    CAL_MASTERS m_master;
+    QAtomicInt m_isAborted;
+    QAtomicInt m_isSkip;
+    QAtomicInt m_isPaused;
+    SystemClock m_systemClock;
+    CalClock * m_timebase;
+    CalReplay * m_replay;
+    int m_failedFrames;     /// read frames that got no valid answer
+    QMutex m_pipeStatusMutex;
+    QMap<int, int> m_pipeStatus;    /// switched from another thread, not applied yet
+
+    /// state machine
+    CAL_STATE m_state;
+    CalTimer m_clock;
+    qint64 m_entered;       /// run clock when m_state was entered
+    qint64 m_nextSample;    /// run clock the next sample is due
+    QVector<qint64> m_stateTime;
+    QString m_stage;        /// last stage reported by stageChanged
+    QString m_endText;
+    CAL_STATE m_resume;     /// state a resumed run starts in, STATE_IDLE for a new one
+    CalJournal m_journal;
+
+    /// run state, same meaning as in LOOP_OBJECT
+    QString m_runMode;
+    QString m_cut;
+    QString m_filExt;
+    QString m_calExt;
+    QString m_rolExt;
+    QString m_currentTemp;
+    QString m_targetTemp;
+    bool m_isWaterRun;
+    bool m_isOilRun;
+    bool m_isIgnoreMaxInjection;
+    int m_salinityIndex;
+    int m_phaseRolloverCounter;
+    int m_idSn;
+    int m_idWatercut;
+    int m_idTemperature;
+    int m_idFreq;
+    int m_idOilRp;
+    double m_watercut;
+    double m_runStart;      /// measured watercut the injection run started from
+    double m_injectionTime;
+    double m_totalInjectionTime;
+    double m_totalInjectionVolume;
+    double m_accumulatedInjectionTime;
+    double m_deliveredInjectionTime;    /// pump time the pulses achieved this run
+    LoopModel m_model;
+    QString m_operatorName;
+};
+
+Q_DECLARE_METATYPE(CAL_SAMPLES)
+Q_DECLARE_METATYPE(CAL_PROGRESSES)
+Q_DECLARE_METATYPE(CAL_TIMINGS)
+Q_DECLARE_METATYPE(INJECTION_PULSES)
+
+#endif // CALENGINE_H
@@ -0,0 +1,106 @@
+#include <QJsonDocument>
+#include <QJsonObject>
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#include "caljournal.h"
+
+CalJournal::
+CalJournal()
+{
+}
+
+
+CalJournal::
+~CalJournal()
+{
+    close();
+}
+
+
+/// a new calibration starts an empty journal, a resumed one goes on
+/// after its last complete record; a torn line left by a crash is cut
+/// off first, or the next record would be glued onto it
+bool
+CalJournal::
+open(const QString & fileName, const bool isContinue)
+{
+    close();
+
+    m_file.setFileName(fileName);
+
+    if (!isContinue) return m_file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+
+    if (!m_file.open(QIODevice::ReadWrite)) return false;
+
+    const QByteArray content = m_file.readAll();
+
+    if (!content.isEmpty() && !content.endsWith('\n') && !m_file.resize(content.lastIndexOf('\n') + 1))
+    {
+        m_file.close();
+        return false;
+    }
+
+    return m_file.seek(m_file.size());
+}
+
+
+void
+CalJournal::
+close()
+{
+    if (m_file.isOpen()) m_file.close();
+}
+
+
+bool
+CalJournal::
+append(const QVariantMap & record)
+{
+    QByteArray line = QJsonDocument(QJsonObject::fromVariantMap(record)).toJson(QJsonDocument::Compact);
+
+    if (!m_file.isOpen()) return false;
+
+    line.append('\n');
+
+    if ((m_file.write(line) != line.size()) || !m_file.flush()) return false;
+
+#ifdef Q_OS_WIN
+    return (_commit(m_file.handle()) == 0);
+#else
+    return (fsync(m_file.handle()) == 0);
+#endif
+}
+
+
+/// the last record that parses, a torn line at the end is left out
+bool
+CalJournal::
+last(const QString & fileName, QVariantMap & record, QString & error)
+{
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        error = QString("cannot open %1").arg(fileName);
+        return false;
+    }
+
+    const QList<QByteArray> lines = file.readAll().split('\n');
+    file.close();
+
+    for (int i = lines.size() - 1; i >= 0; i--)
+    {
+        const QJsonDocument jsonDoc = QJsonDocument::fromJson(lines[i]);
+
+        if (!jsonDoc.isObject()) continue;
+
+        record = jsonDoc.object().toVariantMap();
+        return true;
+    }
+
+    error = QString("%1 holds no checkpoint").arg(fileName);
+    return false;
+}
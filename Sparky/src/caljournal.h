@@ -0,0 +1,34 @@
+#ifndef CALJOURNAL_H
+#define CALJOURNAL_H
+
+#include <QFile>
+#include <QString>
+#include <QVariantMap>
+
+#define JOURNAL_EXT                 ".JNL"
+
+/// Append-only checkpoint journal of a calibration, one compact JSON
+/// object per line. append() flushes and syncs every record before it
+/// returns, so after a crash or a power cut the journal ends with the last
+/// complete checkpoint, at worst followed by a torn line that last() skips
+/// and a resuming open() cuts off.
+class CalJournal
+{
+public:
+    CalJournal();
+    ~CalJournal();
+
+    bool open(const QString &, const bool isContinue);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+    QString fileName() const { return m_file.fileName(); }
+
+    bool append(const QVariantMap &);
+
+    static bool last(const QString &, QVariantMap &, QString &);
+
+private:
+    QFile m_file;
+};
+
+#endif // CALJOURNAL_H
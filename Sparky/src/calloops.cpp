@@ -0,0 +1,101 @@
+#include "calloops.h"
+
+CalLoops::
+CalLoops(QObject * parent) :
+    QObject(parent),
+    m_running(0)
+{
+}
+
+
+CalLoops::
+~CalLoops()
+{
+    abort();
+
+    foreach (QThread * thread, m_threads)
+    {
+        thread->quit();
+        thread->wait();
+        delete thread;
+    }
+
+    qDeleteAll(m_engines);
+}
+
+
+void
+CalLoops::
+add(CalEngine * engine)
+{
+    if (isRunning()) return;
+
+    m_engines.append(engine);
+    m_results.append(false);
+}
+
+
+/// true once every loop finished its sequence
+bool
+CalLoops::
+isOk() const
+{
+    if (isRunning() || m_results.isEmpty()) return false;
+
+    foreach (const bool isOk, m_results)
+    {
+        if (!isOk) return false;
+    }
+
+    return true;
+}
+
+
+void
+CalLoops::
+start()
+{
+    if (isRunning() || !m_threads.isEmpty()) return;
+
+    for (int index = 0; index < m_engines.size(); index++)
+    {
+        CalEngine * engine = m_engines.at(index);
+        QThread * thread = new QThread;
+
+        engine->moveToThread(thread);
+        thread->start();
+        m_threads.append(thread);
+        m_running++;
+
+        QMetaObject::invokeMethod(engine, [this, engine, index]()
+        {
+            const bool isOk = engine->run();
+
+            QMetaObject::invokeMethod(this, [this, index, isOk]() { onLoopFinished(index, isOk); }, Qt::QueuedConnection);
+        }, Qt::QueuedConnection);
+    }
+
+    if (m_engines.isEmpty()) emit finished();
+}
+
+
+/// safe from any thread, the loops stop at their next step
+void
+CalLoops::
+abort()
+{
+    foreach (CalEngine * engine, m_engines) engine->abort();
+}
+
+
+void
+CalLoops::
+onLoopFinished(const int index, const bool isOk)
+{
+    m_results[index] = isOk;
+    m_threads.at(index)->quit();
+    m_running--;
+
+    emit loopFinished(index, isOk);
+    if (m_running == 0) emit finished();
+}
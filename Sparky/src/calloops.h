@@ -0,0 +1,45 @@
+#ifndef CALLOOPS_H
+#define CALLOOPS_H
+
+#include <QObject>
+#include <QVector>
+#include <QThread>
+#include "calengine.h"
+
+/// Runs several calibration loops in one process. Each CalEngine gets a
+/// thread for its sequence next to the bus and pulse threads it already
+/// owns, so a loop waiting on its port or its operator never holds up the
+/// others. Results come back on the thread that owns this object.
+class CalLoops : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CalLoops(QObject * parent = 0);
+    ~CalLoops();
+
+    /// takes the engine over, it must not have a parent
+    void add(CalEngine *);
+
+    int count() const { return m_engines.size(); }
+    CalEngine * engine(const int index) const { return m_engines.at(index); }
+    bool isRunning() const { return (m_running > 0); }
+    bool isOk() const;
+
+    void start();
+    void abort();
+
+signals:
+    void loopFinished(const int, const bool);
+    void finished();
+
+private:
+    void onLoopFinished(const int, const bool);
+
+    QVector<CalEngine *> m_engines;
+    QVector<QThread *> m_threads;
+    QVector<bool> m_results;
+    int m_running;
+};
+
+#endif // CALLOOPS_H
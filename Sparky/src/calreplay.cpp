@@ -0,0 +1,152 @@
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QTextStream>
+#include "calreplay.h"
+
+CalReplay::
+CalReplay()
+{
+}
+
+
+/// the recording is the folder the run wrote to, the one above the cut
+/// folders; its start is taken from the earliest file header
+bool
+CalReplay::
+open(const QString & root, QString & error)
+{
+    m_root = QDir::cleanPath(root);
+    m_started = QDateTime();
+    m_streams.clear();
+
+    if (!QDir(m_root).exists())
+    {
+        error = QString("No recording at %1").arg(m_root);
+        return false;
+    }
+
+    QDirIterator it(m_root, QDir::Files, QDirIterator::Subdirectories);
+
+    while (it.hasNext())
+    {
+        QFile file(it.next());
+        QTextStream stream(&file);
+
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) continue;
+
+        stream.readLine();
+
+        /// SN | cut | date | loop and pipe | release
+        const QStringList header = stream.readLine().split(" | ");
+        const QDateTime created = (header.size() > 2) ? QDateTime::fromString(header[2]) : QDateTime();
+
+        if (created.isValid() && (!m_started.isValid() || (created < m_started))) m_started = created;
+    }
+
+    if (!m_started.isValid())
+    {
+        error = QString("No calibration files in %1").arg(m_root);
+        return false;
+    }
+
+    return true;
+}
+
+
+/// the next data line of the file, false once it has none left
+bool
+CalReplay::
+sample(const QString & path, CAL_SAMPLES & s)
+{
+    REPLAY_STREAMS & r = stream(path);
+
+    while (r.next < r.lines.size())
+    {
+        if (calDataParse(r.lines[r.next++], s)) return true;
+    }
+
+    return false;
+}
+
+
+/// the next data line without taking it
+bool
+CalReplay::
+peek(const QString & path, CAL_SAMPLES & s)
+{
+    const REPLAY_STREAMS & r = stream(path);
+
+    for (int i = r.next; i < r.lines.size(); i++)
+    {
+        if (calDataParse(r.lines[i], s)) return true;
+    }
+
+    return false;
+}
+
+
+/// the pulse logged before the next data line, if there is one
+bool
+CalReplay::
+pulse(const QString & path, INJECTION_PULSES & p)
+{
+    REPLAY_STREAMS & r = stream(path);
+    CAL_SAMPLES s;
+
+    for (int i = r.next; (i < r.lines.size()) && !calDataParse(r.lines[i], s); i++)
+    {
+        if (!calPulseParse(r.lines[i], p)) continue;
+
+        r.next = i + 1;
+        return true;
+    }
+
+    return false;
+}
+
+
+/// the master pipe step logged before the next data line, if there is one
+bool
+CalReplay::
+step(const QString & path, CAL_STEPS & st)
+{
+    REPLAY_STREAMS & r = stream(path);
+    CAL_SAMPLES s;
+
+    for (int i = r.next; (i < r.lines.size()) && !calDataParse(r.lines[i], s); i++)
+    {
+        if (!calStepParse(r.lines[i], st)) continue;
+
+        r.next = i + 1;
+        return true;
+    }
+
+    return false;
+}
+
+
+/// read on first use, a missing file is an empty stream
+REPLAY_STREAMS &
+CalReplay::
+stream(const QString & path)
+{
+    const QString key = QDir::cleanPath(path);
+
+    if (!m_streams.contains(key))
+    {
+        QFile file(key);
+        REPLAY_STREAMS r;
+
+        if (file.open(QIODevice::ReadOnly | QIODevice::Text))
+        {
+            QTextStream in(&file);
+
+            while (!in.atEnd()) r.lines.append(in.readLine());
+        }
+
+        m_streams.insert(key, r);
+    }
+
+    return m_streams[key];
+}
@@ -0,0 +1,50 @@
+#ifndef CALREPLAY_H
+#define CALREPLAY_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QDateTime>
+#include "calstream.h"
+
+/// one recorded calibration file and how far the replay has read it
+typedef struct REPLAY_STREAM
+{
+    QStringList lines;
+    int next;
+
+    REPLAY_STREAM() : next(0) {}
+
+} REPLAY_STREAMS;
+
+
+/// Plays the calibration files of an earlier run (.LCT, .LCI, .MCI, .HCI
+/// and the rest) back to the engine as if the pipes and the master were
+/// answering: every data line is one reading of its pipe, with the master
+/// as it was read with it, and the pulse and step lines say what the pump
+/// did. Each file is a stream of its own, read in order as the engine
+/// asks for it; the paths are those of the recording, the engine maps its
+/// output onto them. Not thread safe, a loop needs one of its own.
+class CalReplay
+{
+public:
+    CalReplay();
+
+    bool open(const QString &, QString &);
+    const QString & root() const { return m_root; }
+    const QDateTime & started() const { return m_started; }
+
+    bool sample(const QString &, CAL_SAMPLES &);
+    bool peek(const QString &, CAL_SAMPLES &);
+    bool pulse(const QString &, INJECTION_PULSES &);
+    bool step(const QString &, CAL_STEPS &);
+
+private:
+    REPLAY_STREAMS & stream(const QString &);
+
+    QString m_root;
+    QDateTime m_started;    /// earliest header of the recording
+    QHash<QString, REPLAY_STREAMS> m_streams;
+};
+
+#endif // CALREPLAY_H
@@ -0,0 +1,142 @@
+#include <QRegExp>
+#include <QStringList>
+#include <QTextStream>
+#include "calstream.h"
+
+QString
+calDataStream(const CAL_SAMPLES & s)
+{
+    return QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10 %11 %12 %13 %14 %15 %16 %17 %18").arg(s.elapsed, 9, 'g', -1, ' ').arg(s.watercut,7,'f',2,' ').arg(s.osc, 4, 'g', -1, ' ').arg(" INT").arg(1, 7, 'g', -1, ' ').arg(s.frequency,9,'f',3,' ').arg(0,8,'f',2,' ').arg(s.oilrp,9,'f',2,' ').arg(s.temperature,11,'f',2,' ').arg(0,10,'f',2,' ').arg(s.masterPressure,8,'f',2,' ').arg(s.masterTemp, 11,'f',2,' ').arg(s.masterOilAdj, 11,'f',2,' ').arg(s.masterFreq, 11,'f',2,' ').arg(s.masterWatercut, 11,'f',2,' ').arg(s.masterOilRp, 11,'f',2,' ').arg(s.masterPhase, 6,'f',1,' ').arg(s.pipeWatercut,8,'f',2,' ');
+}
+
+
+/// requested and achieved width of an injection pulse
+QString
+calPulseStream(const INJECTION_PULSES & pulse)
+{
+    if (!pulse.isStarted) return QString("Injection pulse = %1 s, failed to start").arg(pulse.requested, 0, 'f', 3);
+    if (!pulse.isOk) return QString("Injection pulse = %1 s, failed").arg(pulse.requested, 0, 'f', 3);
+
+    return QString("Injection pulse = %1 s, achieved %2 s, jitter %3 ms (%4)").arg(pulse.requested, 0, 'f', 3).arg(pulse.achieved, 0, 'f', 3).arg(pulse.jitter, 0, 'f', 1).arg((pulse.mode == INJECTION_TIMER) ? "timer" : "local");
+}
+
+
+/// reaction and overshoot of a master pipe injection step
+QString
+calStepStream(const CAL_STEPS & step)
+{
+    return QString("Injection step to %1 %, reached %2 %, overshoot %3 %, reaction %4 ms, %5 reads every %6 ms").arg(step.target, 0, 'f', 2).arg(step.reached, 0, 'f', 2).arg(step.overshoot, 0, 'f', 2).arg(step.latency, 0, 'f', 1).arg(step.reads).arg(step.interval, 0, 'f', 1);
+}
+
+
+/// what the next injection of a pump rate run is timed by
+QString
+calModelStream(const LOOPMODEL_FITS & fit)
+{
+    if (!fit.isFitted) return QString("Loop model = entered loop volume %1 mL, %2 steps").arg(fit.volume, 0, 'f', 0).arg(fit.steps);
+
+    return QString("Loop model = effective loop volume %1 mL (%2 % of entered), mixing lag %3 s, %4 steps").arg(fit.volume, 0, 'f', 0).arg(100*fit.entered/fit.rate, 0, 'f', 1).arg(fit.lagTime, 0, 'f', 1).arg(fit.steps);
+}
+
+
+/// why a temperature stage ended before the stability count was reached
+QString
+calSettlingStream(const SETTLING_FITS & temp, const SETTLING_FITS & freq, const double confidence)
+{
+    return QString("Predicted stable at %1 % confidence, %2 samples: temperature %3 °C (drift %4 ± %5, ratio %6), frequency %7 MHz (drift %8 ± %9, ratio %10)").arg(confidence*100, 0, 'f', 1).arg(temp.samples).arg(temp.final, 0, 'f', 2).arg(temp.drift, 0, 'f', 3).arg(temp.error, 0, 'f', 3).arg(temp.ratio, 0, 'f', 2).arg(freq.final, 0, 'f', 3).arg(freq.drift, 0, 'f', 4).arg(freq.error, 0, 'f', 4).arg(freq.ratio, 0, 'f', 2);
+}
+
+
+void
+appendCalLine(QFile & file, const QString & data_stream)
+{
+    QTextStream stream(&file);
+    file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
+    stream << data_stream << '\n' ;
+    file.close();
+}
+
+
+/// a calDataStream line, 18 numbers with INT as the fourth
+bool
+calDataParse(const QString & line, CAL_SAMPLES & s)
+{
+    const QStringList c = line.split(' ', QString::SkipEmptyParts);
+    double v[18];
+    bool ok;
+
+    if ((c.size() != 18) || (c[3] != "INT")) return false;
+
+    for (int i = 0; i < c.size(); i++)
+    {
+        if (i == 3) continue;
+
+        v[i] = c[i].toDouble(&ok);
+        if (!ok) return false;
+    }
+
+    s.elapsed = (qint64) v[0];
+    s.watercut = v[1];
+    s.osc = (int) v[2];
+    s.frequency = v[5];
+    s.oilrp = v[7];
+    s.temperature = v[8];
+    s.masterPressure = v[10];
+    s.masterTemp = v[11];
+    s.masterOilAdj = v[12];
+    s.masterFreq = v[13];
+    s.masterWatercut = v[14];
+    s.masterOilRp = v[15];
+    s.masterPhase = v[16];
+    s.pipeWatercut = v[17];
+
+    return true;
+}
+
+
+/// a calPulseStream line; start and stop are not in it
+bool
+calPulseParse(const QString & line, INJECTION_PULSES & pulse)
+{
+    QRegExp done("^Injection pulse = (\\S+) s, achieved (\\S+) s, jitter (\\S+) ms \\((\\w+)\\)$");
+    QRegExp failed("^Injection pulse = (\\S+) s, failed( to start)?$");
+
+    pulse = INJECTION_PULSES();
+
+    if (failed.indexIn(line) == 0)
+    {
+        pulse.requested = failed.cap(1).toDouble();
+        pulse.isStarted = failed.cap(2).isEmpty();
+        return true;
+    }
+
+    if (done.indexIn(line) != 0) return false;
+
+    pulse.isOk = true;
+    pulse.isStarted = true;
+    pulse.isStopped = true;
+    pulse.requested = done.cap(1).toDouble();
+    pulse.achieved = done.cap(2).toDouble();
+    pulse.jitter = done.cap(3).toDouble();
+    pulse.mode = (done.cap(4) == "timer") ? INJECTION_TIMER : INJECTION_LOCAL;
+
+    return true;
+}
+
+
+bool
+calStepParse(const QString & line, CAL_STEPS & step)
+{
+    QRegExp rx("^Injection step to (\\S+) %, reached (\\S+) %, overshoot (\\S+) %, reaction (\\S+) ms, (\\d+) reads every (\\S+) ms$");
+
+    if (rx.indexIn(line) != 0) return false;
+
+    step.target = rx.cap(1).toDouble();
+    step.reached = rx.cap(2).toDouble();
+    step.overshoot = rx.cap(3).toDouble();
+    step.latency = rx.cap(4).toDouble();
+    step.reads = rx.cap(5).toInt();
+    step.interval = rx.cap(6).toDouble();
+
+    return true;
+}
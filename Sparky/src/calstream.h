@@ -0,0 +1,63 @@
+#ifndef CALSTREAM_H
+#define CALSTREAM_H
+
+#include <QFile>
+#include <QString>
+#include "injectionscheduler.h"
+#include "settlingestimator.h"
+#include "loopmodel.h"
+
+/// one line of a calibration file
+typedef struct CAL_SAMPLE
+{
+    qint64 elapsed;         /// s since the stage started
+    double watercut;        /// reference watercut, master or entered
+    int osc;
+    double frequency;
+    double oilrp;
+    double temperature;
+    double masterPressure;
+    double masterTemp;
+    double masterOilAdj;
+    double masterFreq;
+    double masterWatercut;
+    double masterOilRp;
+    double masterPhase;
+    double pipeWatercut;    /// analyzer watercut, simulation runs only
+
+    CAL_SAMPLE() : elapsed(0), watercut(0), osc(0), frequency(0), oilrp(0), temperature(0), masterPressure(0), masterTemp(0), masterOilAdj(0), masterFreq(0), masterWatercut(0), masterOilRp(0), masterPhase(0), pipeWatercut(0) {}
+
+} CAL_SAMPLES;
+
+
+/// one injection step of master pipe mode, the pump running until the
+/// control box reads the target
+typedef struct CAL_STEP
+{
+    double target;          /// watercut the step ran to
+    double reached;         /// master watercut once the pump was off and the master refreshed
+    double overshoot;       /// how far reached went past target in the run's direction
+    double latency;         /// ms from the read that saw the target to the pump off
+    double interval;        /// mean ms between master reads while the pump ran
+    int reads;
+
+    CAL_STEP() : target(0), reached(0), overshoot(0), latency(0), interval(0), reads(0) {}
+
+} CAL_STEPS;
+
+
+/// Formats and appends calibration lines. Shared by the calibration loop
+/// and the cycle benchmark so both measure the same code.
+QString calDataStream(const CAL_SAMPLES &);
+QString calPulseStream(const INJECTION_PULSES &);
+QString calStepStream(const CAL_STEPS &);
+QString calModelStream(const LOOPMODEL_FITS &);
+QString calSettlingStream(const SETTLING_FITS &, const SETTLING_FITS &, const double);
+void appendCalLine(QFile &, const QString &);
+
+/// Reads the same lines back, false for a line of another kind.
+bool calDataParse(const QString &, CAL_SAMPLES &);
+bool calPulseParse(const QString &, INJECTION_PULSES &);
+bool calStepParse(const QString &, CAL_STEPS &);
+
+#endif // CALSTREAM_H
@@ -0,0 +1,293 @@
+#include <limits.h>
+#include <algorithm>
+#include <QBrush>
+#include <QDir>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <QHeaderView>
+#include "captureviewer.h"
+
+CaptureModel::
+CaptureModel(BusCaptureReader * reader, QObject * parent) :
+    QAbstractTableModel(parent),
+    m_reader(reader),
+    m_isFiltered(false),
+    m_cached(-1)
+{
+}
+
+
+void
+CaptureModel::
+reload()
+{
+    beginResetModel();
+    m_isFiltered = false;
+    m_hits.clear();
+    m_cached = -1;
+    endResetModel();
+}
+
+
+void
+CaptureModel::
+setHits(const QVector<qint64> & hits)
+{
+    beginResetModel();
+    m_isFiltered = true;
+    m_hits = hits;
+    endResetModel();
+}
+
+
+void
+CaptureModel::
+clearHits()
+{
+    reload();
+}
+
+
+qint64
+CaptureModel::
+recordAt(const int row) const
+{
+    return (m_isFiltered) ? m_hits.value(row, -1) : row;
+}
+
+
+int
+CaptureModel::
+rowOf(const qint64 n) const
+{
+    if (!m_isFiltered) return (int) n;
+
+    return (int) (std::lower_bound(m_hits.begin(), m_hits.end(), n) - m_hits.begin());
+}
+
+
+int
+CaptureModel::
+rowCount(const QModelIndex & parent) const
+{
+    if (parent.isValid()) return 0;
+
+    /// a view holds int rows, the rest of a huge capture is reached by jumping
+    return (m_isFiltered) ? m_hits.size() : (int) qMin(m_reader->count(), (qint64) INT_MAX);
+}
+
+
+int
+CaptureModel::
+columnCount(const QModelIndex & parent) const
+{
+    return (parent.isValid()) ? 0 : CAPTURE_COLUMNS;
+}
+
+
+QVariant
+CaptureModel::
+data(const QModelIndex & index, int role) const
+{
+    if (!index.isValid()) return QVariant();
+
+    const qint64 n = recordAt(index.row());
+
+    if (n < 0) return QVariant();
+
+    if (n != m_cached)
+    {
+        if (!m_reader->record(n, m_record, &m_raw)) return QVariant();
+        m_cached = n;
+    }
+
+    if (role == Qt::ForegroundRole) return (BusCaptureReader::isError(m_record)) ? QVariant(QBrush(Qt::red)) : QVariant();
+
+    if (role != Qt::DisplayRole) return QVariant();
+
+    switch (index.column())
+    {
+        case 0: return QString::number((m_record.time - m_reader->header().timeStart)/1000000.0, 'f', 6);
+        case 1: return (m_record.kind == TRACE_RAW) ? tr("Raw") : ((m_record.flags & CAPTURE_REQUEST) ? tr("Req >>") : tr("<< Resp"));
+        case 2: return BusCaptureReader::describe(m_record, m_raw);
+        default: return QVariant();
+    }
+}
+
+
+QVariant
+CaptureModel::
+headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole) return QVariant();
+    if (orientation == Qt::Vertical) return QString::number(recordAt(section) + 1);
+
+    switch (section)
+    {
+        case 0: return tr("Time [s]");
+        case 1: return tr("I/O");
+        case 2: return tr("Frame");
+        default: return QVariant();
+    }
+}
+
+
+CaptureViewer::
+CaptureViewer(QWidget * parent) :
+    QDialog(parent),
+    m_model(new CaptureModel(&m_reader, this)),
+    m_view(new QTableView),
+    m_info(new QLabel),
+    m_time(new QDoubleSpinBox),
+    m_slave(new QSpinBox),
+    m_func(new QSpinBox),
+    m_errors(new QCheckBox(tr("Errors only")))
+{
+    QPushButton * openButton = new QPushButton(tr("Open"));
+    QPushButton * jumpButton = new QPushButton(tr("Go To"));
+    QPushButton * filterButton = new QPushButton(tr("Filter"));
+    QPushButton * clearButton = new QPushButton(tr("Clear"));
+    QHBoxLayout * tools = new QHBoxLayout;
+    QVBoxLayout * layout = new QVBoxLayout(this);
+
+    setWindowTitle(tr("Capture Viewer"));
+    resize(900, 600);
+
+    m_time->setDecimals(3);
+    m_time->setMaximum(1e9);
+    m_time->setSuffix(" s");
+
+    /// -1 shows as "any"
+    m_slave->setRange(CAPTURE_ANY, 65535);
+    m_slave->setSpecialValueText(tr("any slave"));
+    m_slave->setValue(CAPTURE_ANY);
+    m_func->setRange(CAPTURE_ANY, 127);
+    m_func->setSpecialValueText(tr("any function"));
+    m_func->setValue(CAPTURE_ANY);
+
+    tools->addWidget(openButton);
+    tools->addWidget(m_time);
+    tools->addWidget(jumpButton);
+    tools->addStretch();
+    tools->addWidget(m_slave);
+    tools->addWidget(m_func);
+    tools->addWidget(m_errors);
+    tools->addWidget(filterButton);
+    tools->addWidget(clearButton);
+
+    m_view->setModel(m_model);
+    m_view->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_view->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    m_view->verticalHeader()->setDefaultSectionSize(21);
+    m_view->horizontalHeader()->setStretchLastSection(true);
+    m_view->setColumnWidth(0, 120);
+    m_view->setColumnWidth(1, 70);
+
+    layout->addLayout(tools);
+    layout->addWidget(m_view);
+    layout->addWidget(m_info);
+
+    connect(openButton, SIGNAL(clicked()), this, SLOT(onOpen()));
+    connect(jumpButton, SIGNAL(clicked()), this, SLOT(onJump()));
+    connect(filterButton, SIGNAL(clicked()), this, SLOT(onFilter()));
+    connect(clearButton, SIGNAL(clicked()), this, SLOT(onClearFilter()));
+
+    updateInfo();
+}
+
+
+bool
+CaptureViewer::
+openCapture(const QString & fileName)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const bool isOpen = m_reader.open(fileName);
+    m_model->reload();
+
+    updateInfo((isOpen) ? tr("indexed in %1 ms").arg(timer.elapsed()) : tr("not a capture file"));
+    return isOpen;
+}
+
+
+void
+CaptureViewer::
+onOpen()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Open Capture"), QDir::currentPath(), tr("Capture files (*%1);;All Files (*)").arg(CAPTURE_EXT));
+
+    if (!fileName.isEmpty()) openCapture(fileName);
+}
+
+
+void
+CaptureViewer::
+onJump()
+{
+    if (!m_reader.isOpen()) return;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const qint64 n = m_reader.find(m_reader.header().timeStart + (int64_t) (m_time->value()*1000000.0));
+    const int row = m_model->rowOf(n);
+
+    m_view->scrollTo(m_model->index(qMin(row, m_model->rowCount() - 1), 0), QAbstractItemView::PositionAtTop);
+    m_view->selectRow(row);
+
+    updateInfo(tr("record %1 found in %2 ms").arg(n + 1).arg(timer.elapsed()));
+}
+
+
+/// scans a window from the first visible record on, jump first to filter elsewhere
+void
+CaptureViewer::
+onFilter()
+{
+    if (!m_reader.isOpen()) return;
+
+    QElapsedTimer timer;
+    QVector<qint64> hits;
+    const qint64 from = qMax(m_model->recordAt(m_view->rowAt(0)), (qint64) 0);
+
+    timer.start();
+    m_reader.filter(from, from + CAPTURE_FILTER_WINDOW, m_slave->value(), m_func->value(), m_errors->isChecked(), hits);
+    m_model->setHits(hits);
+
+    updateInfo(tr("%1 hits in records %2 to %3, %4 ms").arg(hits.size()).arg(from + 1).arg(qMin(from + CAPTURE_FILTER_WINDOW, m_reader.count())).arg(timer.elapsed()));
+}
+
+
+void
+CaptureViewer::
+onClearFilter()
+{
+    const qint64 n = m_model->recordAt(m_view->rowAt(0));
+
+    m_model->clearHits();
+    if (n >= 0) m_view->scrollTo(m_model->index((int) n, 0), QAbstractItemView::PositionAtTop);
+
+    updateInfo();
+}
+
+
+void
+CaptureViewer::
+updateInfo(const QString & status)
+{
+    if (!m_reader.isOpen())
+    {
+        m_info->setText(status);
+        return;
+    }
+
+    const QString started = QDateTime::fromMSecsSinceEpoch(m_reader.header().wallStart).toString("yyyy-MM-dd hh:mm:ss");
+    const double duration = (m_reader.lastTime() - m_reader.firstTime())/1000000.0;
+
+    m_info->setText(tr("%1 records, started %2, %3 s").arg(m_reader.count()).arg(started).arg(duration, 0, 'f', 1) + ((status.isEmpty()) ? QString() : ", " + status));
+}
@@ -0,0 +1,82 @@
+#ifndef CAPTUREVIEWER_H
+#define CAPTUREVIEWER_H
+
+#include <QDialog>
+#include <QAbstractTableModel>
+#include <QTableView>
+#include <QLabel>
+#include <QSpinBox>
+#include <QDoubleSpinBox>
+#include <QCheckBox>
+#include <QPushButton>
+#include "buscapture.h"
+
+/// records scanned by one filter pass, starting at the current row
+#define CAPTURE_FILTER_WINDOW       2000000
+
+#define CAPTURE_COLUMNS             3
+
+
+/// Rows of a mapped capture, either every record or the hits of the last
+/// filter. Records are only read for the rows the view paints.
+class CaptureModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit CaptureModel(BusCaptureReader *, QObject * parent = 0);
+
+    void reload();
+    void setHits(const QVector<qint64> &);
+    void clearHits();
+    bool isFiltered() const { return m_isFiltered; }
+    qint64 recordAt(const int) const;
+    int rowOf(const qint64) const;
+
+    int rowCount(const QModelIndex & parent = QModelIndex()) const;
+    int columnCount(const QModelIndex & parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &, int role = Qt::DisplayRole) const;
+    QVariant headerData(int, Qt::Orientation, int role = Qt::DisplayRole) const;
+
+private:
+    BusCaptureReader * m_reader;
+    bool m_isFiltered;
+    QVector<qint64> m_hits;
+
+    /// last record read, a row is asked for once per column
+    mutable qint64 m_cached;
+    mutable CAPTURE_RECORDS m_record;
+    mutable QByteArray m_raw;
+};
+
+
+/// Replay viewer for capture files recorded by the bus monitor.
+class CaptureViewer : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit CaptureViewer(QWidget * parent = 0);
+
+    bool openCapture(const QString &);
+
+private slots:
+    void onOpen();
+    void onJump();
+    void onFilter();
+    void onClearFilter();
+
+private:
+    void updateInfo(const QString & status = QString());
+
+    BusCaptureReader m_reader;
+    CaptureModel * m_model;
+    QTableView * m_view;
+    QLabel * m_info;
+    QDoubleSpinBox * m_time;
+    QSpinBox * m_slave;
+    QSpinBox * m_func;
+    QCheckBox * m_errors;
+};
+
+#endif // CAPTUREVIEWER_H
@@ -0,0 +1,219 @@
+#include <math.h>
+#include <algorithm>
+#include "channelstats.h"
+
+ChannelStats::
+ChannelStats(const double min, const double max) :
+    m_min(min),
+    m_max(max)
+{
+    reset();
+}
+
+
+void
+ChannelStats::
+setRange(const double min, const double max)
+{
+    m_min = min;
+    m_max = max;
+}
+
+
+/// the range stays
+void
+ChannelStats::
+reset()
+{
+    m_value = 0;
+    m_rejected = 0;
+    restart();
+}
+
+
+/// empties the windows but keeps value() and the count of rejects, for a
+/// level the loop was told to change, an injection or the like
+void
+ChannelStats::
+restart()
+{
+    m_rejectRun = 0;
+    m_head = 0;
+    m_count = 0;
+    m_mean = 0;
+    m_m2 = 0;
+    m_sumKY = 0;
+    m_recentHead = 0;
+    m_recentCount = 0;
+}
+
+
+/// false if the reading was rejected, value() then keeps the last good one
+bool
+ChannelStats::
+add(const double x)
+{
+    if (!(x >= m_min) || !(x <= m_max))
+    {
+        m_rejected++;
+        return false;
+    }
+
+    /// the median lags a moving channel by half its window, the slope
+    /// brings it up to now; a few samples make a poor MAD, the window's
+    /// deviation is the floor
+    if (m_recentCount >= CHANNEL_MEDIAN_MIN)
+    {
+        const double expected = median() + slope()*((m_recentCount - 1)/2 + 1);
+        const double spread = std::max(1.4826*mad(), stddev());
+
+        if ((spread > 0) && (fabs(x - expected) > CHANNEL_OUTLIER_K*spread))
+        {
+            m_rejected++;
+
+            if (++m_rejectRun < CHANNEL_MAX_REJECTS) return false;
+
+            /// not a spike but a new level, start over from here
+            restart();
+        }
+    }
+
+    m_rejectRun = 0;
+    accept(x);
+    return true;
+}
+
+
+void
+ChannelStats::
+accept(const double x)
+{
+    m_value = x;
+
+    m_recent[m_recentHead] = x;
+    m_recentHead = (m_recentHead + 1) % CHANNEL_MEDIAN_WINDOW;
+    if (m_recentCount < CHANNEL_MEDIAN_WINDOW) m_recentCount++;
+
+    if (m_count < CHANNEL_WINDOW)
+    {
+        const double delta = x - m_mean;
+
+        m_window[(m_head + m_count) % CHANNEL_WINDOW] = x;
+        m_sumKY += m_count*x;
+        m_count++;
+        m_mean += delta/m_count;
+        m_m2 += delta*(x - m_mean);
+        return;
+    }
+
+    /// every index moves down by one, the new sample comes in at the top
+    const double old = m_window[m_head];
+    const double sum = m_mean*m_count;
+
+    m_sumKY += (CHANNEL_WINDOW - 1)*x - (sum - old);
+
+    /// Welford out with the oldest sample, in with the new one
+    const double mean = m_mean + (x - old)/m_count;
+
+    m_m2 += (x - old)*(x - mean + old - m_mean);
+    m_mean = mean;
+
+    m_window[m_head] = x;
+    m_head = (m_head + 1) % CHANNEL_WINDOW;
+
+    /// once per lap the sums are taken afresh, so rounding cannot pile up
+    if (m_head == 0) recompute();
+}
+
+
+void
+ChannelStats::
+recompute()
+{
+    double sum = 0;
+
+    m_sumKY = 0;
+    m_m2 = 0;
+
+    for (int k = 0; k < m_count; k++)
+    {
+        const double y = m_window[(m_head + k) % CHANNEL_WINDOW];
+
+        sum += y;
+        m_sumKY += k*y;
+    }
+
+    m_mean = sum/m_count;
+
+    for (int k = 0; k < m_count; k++)
+    {
+        const double d = m_window[(m_head + k) % CHANNEL_WINDOW] - m_mean;
+
+        m_m2 += d*d;
+    }
+}
+
+
+/// sample variance of the window
+double
+ChannelStats::
+variance() const
+{
+    return (m_count > 1) ? std::max(m_m2, 0.0)/(m_count - 1) : 0;
+}
+
+
+double
+ChannelStats::
+stddev() const
+{
+    return sqrt(variance());
+}
+
+
+/// per sample, least squares over the window
+double
+ChannelStats::
+slope() const
+{
+    const double n = m_count;
+    const double sumK = n*(n - 1)/2;
+    const double sumKK = (n - 1)*n*(2*n - 1)/6;
+    const double denominator = n*sumKK - sumK*sumK;
+
+    if (m_count < 2) return 0;
+
+    return (n*m_sumKY - sumK*m_mean*n)/denominator;
+}
+
+
+double
+ChannelStats::
+median() const
+{
+    double v[CHANNEL_MEDIAN_WINDOW];
+
+    if (m_recentCount == 0) return m_value;
+
+    std::copy(m_recent, m_recent + m_recentCount, v);
+    std::nth_element(v, v + m_recentCount/2, v + m_recentCount);
+
+    return v[m_recentCount/2];
+}
+
+
+double
+ChannelStats::
+mad() const
+{
+    const double m = median();
+    double v[CHANNEL_MEDIAN_WINDOW];
+
+    for (int i = 0; i < m_recentCount; i++) v[i] = fabs(m_recent[i] - m);
+
+    if (m_recentCount == 0) return 0;
+
+    std::nth_element(v, v + m_recentCount/2, v + m_recentCount);
+
+    return v[m_recentCount/2];
+}
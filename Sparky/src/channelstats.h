@@ -0,0 +1,72 @@
+#ifndef CHANNELSTATS_H
+#define CHANNELSTATS_H
+
+#include <float.h>
+
+/// samples the mean, variance and slope are taken over
+#define CHANNEL_WINDOW              16
+
+/// accepted samples the median and MAD are taken over
+#define CHANNEL_MEDIAN_WINDOW       9
+
+/// the outlier filter needs this many samples to judge
+#define CHANNEL_MEDIAN_MIN          5
+
+/// a sample this many robust deviations (1.4826*MAD) off the median is an outlier
+#define CHANNEL_OUTLIER_K           5.0
+
+/// outliers in a row that are taken as a real step instead; the windows
+/// start over at the new level
+#define CHANNEL_MAX_REJECTS         3
+
+/// Sliding-window statistics of one measured channel of a pipe, in fixed
+/// memory and constant time per sample: Welford mean and variance, the
+/// least squares slope per sample, and a median/MAD filter that keeps
+/// readings outside the channel's range or far off the recent median out
+/// of everything. value() is the last accepted reading; the files, the
+/// display, the chart and the stability checks read that instead of the
+/// raw register.
+class ChannelStats
+{
+public:
+    ChannelStats(const double min = -DBL_MAX, const double max = DBL_MAX);
+
+    void setRange(const double, const double);
+    void reset();
+    void restart();
+    bool add(const double);
+
+    int count() const { return m_count; }
+    int rejected() const { return m_rejected; }
+    double value() const { return m_value; }
+    double mean() const { return m_mean; }
+    double variance() const;
+    double stddev() const;
+    double slope() const;
+    double median() const;
+    double mad() const;
+
+private:
+    void accept(const double);
+    void recompute();
+
+    double m_min;
+    double m_max;
+    double m_value;
+    int m_rejected;
+    int m_rejectRun;
+
+    /// Welford over the sliding window, k = 0 is the oldest sample
+    double m_window[CHANNEL_WINDOW];
+    int m_head;             /// oldest sample once the window is full
+    int m_count;
+    double m_mean;
+    double m_m2;
+    double m_sumKY;
+
+    double m_recent[CHANNEL_MEDIAN_WINDOW];
+    int m_recentHead;
+    int m_recentCount;
+};
+
+#endif // CHANNELSTATS_H
@@ -0,0 +1,232 @@
+#include "registercodec.h"
+#include "injectionscheduler.h"
+
+InjectionScheduler::
+InjectionScheduler(ModbusBus * bus, QObject * parent) :
+    QObject(parent),
+    m_bus(bus),
+    m_context(new QObject),
+    m_timerSlave(-1),
+    m_isAborted(0)
+{
+    m_thread.setObjectName("InjectionScheduler");
+    m_context->moveToThread(&m_thread);
+    m_thread.start(QThread::TimeCriticalPriority);
+}
+
+
+InjectionScheduler::
+~InjectionScheduler()
+{
+    abort();
+
+    m_thread.quit();
+    m_thread.wait();
+    delete m_context;
+}
+
+
+/// runs the pump behind the coil for the given seconds, the future holds
+/// what was achieved on the wire
+QFuture<INJECTION_PULSES>
+InjectionScheduler::
+pulse(const int slave, const int coil, const double seconds)
+{
+    QFutureInterface<INJECTION_PULSES> fi;
+    const int timerSlave = m_timerSlave;
+
+    m_isAborted = 0;
+
+    fi.reportStarted();
+    QMetaObject::invokeMethod(m_context, [this, fi, slave, coil, seconds, timerSlave]() mutable
+    {
+        fi.reportResult((timerSlave >= 0) ? runTimer(timerSlave, seconds) : runLocal(slave, coil, seconds));
+        fi.reportFinished();
+    }, Qt::QueuedConnection);
+
+    return fi.future();
+}
+
+
+/// ends a running pulse now
+void
+InjectionScheduler::
+abort()
+{
+    m_isAborted = 1;
+}
+
+
+/// sleeps towards the deadline and spins the last INJECTION_SPIN_US,
+/// returns early on abort
+void
+InjectionScheduler::
+waitUntil(const int64_t deadline)
+{
+    int64_t remaining;
+
+    while (!m_isAborted && ((remaining = deadline - modbus_rtu_now()) > INJECTION_SPIN_US))
+    {
+        QThread::usleep((unsigned long) qMin(remaining - INJECTION_SPIN_US, (int64_t) 10000));
+    }
+
+    while (!m_isAborted && (modbus_rtu_now() < deadline));
+}
+
+
+/// the pump has to stop, retried until it does
+static bool
+writeOff(modbus_t * modbus, const int coil, int64_t & stop)
+{
+    for (int i = 0; i < INJECTION_OFF_RETRIES; i++)
+    {
+        if (modbus_write_bit(modbus, coil, FALSE) == 1)
+        {
+            stop = modbus_rtu_get_request_end(modbus);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+INJECTION_PULSES
+InjectionScheduler::
+runLocal(const int slave, const int coil, const double seconds)
+{
+    INJECTION_PULSES pulse;
+    int64_t lead = 0;
+
+    pulse.mode = INJECTION_LOCAL;
+    pulse.requested = seconds;
+
+    /// on, the time from the call to the end of the frame is the lead the off write needs
+    const bool isOn = m_bus->submit<bool>(slave, [&pulse, &lead, coil](modbus_t * modbus)
+    {
+        if (modbus == NULL) return false;
+
+        const int64_t called = modbus_rtu_now();
+
+        /// a lost or late reply does not mean the box did not switch
+        pulse.isStarted = true;
+
+        const bool isOk = (modbus_write_bit(modbus, coil, TRUE) == 1);
+
+        pulse.start = modbus_rtu_get_request_end(modbus);
+        lead = pulse.start - called;
+        return isOk;
+    }).result();
+
+    if (!pulse.isStarted) return pulse;
+
+    /// an unacknowledged on is switched off again straight away
+    const int64_t deadline = (isOn) ? pulse.start + (int64_t) (seconds*1000000.0) : 0;
+
+    if (isOn) waitUntil(deadline - lead - INJECTION_GUARD_US);
+
+    pulse.isStopped = m_bus->submit<bool>(slave, [this, &pulse, lead, deadline, coil, isOn](modbus_t * modbus)
+    {
+        if (modbus == NULL) return false;
+
+        if (isOn) waitUntil(deadline - lead);
+
+        return writeOff(modbus, coil, pulse.stop);
+    }).result();
+
+    pulse.isAborted = m_isAborted;
+    pulse.isOk = isOn && pulse.isStopped;
+
+    if (pulse.isOk)
+    {
+        pulse.achieved = (pulse.stop - pulse.start)/1000000.0;
+        pulse.jitter = (pulse.achieved - pulse.requested)*1000.0;
+    }
+
+    return pulse;
+}
+
+
+/// the box times the pulse, the achieved length is what it reports
+INJECTION_PULSES
+InjectionScheduler::
+runTimer(const int slave, const double seconds)
+{
+    INJECTION_PULSES pulse;
+
+    pulse.mode = INJECTION_TIMER;
+    pulse.requested = seconds;
+
+    const bool isOn = m_bus->submit<bool>(slave, [&pulse, seconds](modbus_t * modbus)
+    {
+        uint16_t regs[CODEC_WIDE_REGISTERS];
+
+        if (modbus == NULL) return false;
+
+        DeviceCodec::fromInt32((int32_t) (seconds*1000.0 + 0.5), regs);
+
+        if (modbus_write_registers(modbus, TIMER_REG_DURATION, CODEC_WIDE_REGISTERS, regs) != CODEC_WIDE_REGISTERS) return false;
+
+        /// a lost or late reply does not mean the box did not start
+        pulse.isStarted = true;
+
+        if (modbus_write_bit(modbus, TIMER_COIL_START, TRUE) != 1) return false;
+
+        pulse.start = modbus_rtu_get_request_end(modbus);
+        return true;
+    }).result();
+
+    if (!pulse.isStarted) return pulse;
+
+    /// an unacknowledged start is cleared again straight away
+    if (!isOn)
+    {
+        pulse.isStopped = m_bus->submit<bool>(slave, [&pulse](modbus_t * modbus)
+        {
+            return (modbus != NULL) && writeOff(modbus, TIMER_COIL_START, pulse.stop);
+        }).result();
+
+        pulse.isAborted = m_isAborted;
+        return pulse;
+    }
+
+    /// give the box its pulse and a guard to publish the result
+    waitUntil(pulse.start + (int64_t) (seconds*1000000.0) + INJECTION_GUARD_US);
+
+    pulse.isAborted = m_isAborted;
+
+    pulse.isOk = m_bus->submit<bool>(slave, [&pulse](modbus_t * modbus)
+    {
+        uint16_t regs[CODEC_WIDE_REGISTERS];
+
+        if (modbus == NULL) return false;
+
+        /// cut short, the box has not published anything yet
+        if (pulse.isAborted)
+        {
+            if (!writeOff(modbus, TIMER_COIL_START, pulse.stop)) return false;
+
+            pulse.achieved = (pulse.stop - pulse.start)/1000000.0;
+            return true;
+        }
+
+        if (modbus_read_input_registers(modbus, TIMER_REG_ELAPSED, CODEC_WIDE_REGISTERS, regs) != CODEC_WIDE_REGISTERS) return false;
+
+        pulse.achieved = DeviceCodec::toInt32(regs)/1000.0;
+        pulse.stop = pulse.start + (int64_t) (pulse.achieved*1000000.0);
+        return true;
+    }).result();
+
+    /// the box ends the pulse by itself, but only a reply says it has;
+    /// without one the start is cleared
+    pulse.isStopped = pulse.isOk || m_bus->submit<bool>(slave, [](modbus_t * modbus)
+    {
+        int64_t stop;
+
+        return (modbus != NULL) && writeOff(modbus, TIMER_COIL_START, stop);
+    }).result();
+
+    if (pulse.isOk) pulse.jitter = (pulse.achieved - pulse.requested)*1000.0;
+
+    return pulse;
+}
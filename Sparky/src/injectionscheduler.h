@@ -0,0 +1,81 @@
+#ifndef INJECTIONSCHEDULER_H
+#define INJECTIONSCHEDULER_H
+
+#include <stdint.h>
+#include <QObject>
+#include <QThread>
+#include <QAtomicInt>
+#include <QFuture>
+#include "modbusbus.h"
+
+/// the off write is queued this long before its deadline so a poll already
+/// waiting on the bus cannot make it late (us)
+#define INJECTION_GUARD_US          100000
+
+/// the last stretch before a deadline is spun rather than slept (us)
+#define INJECTION_SPIN_US           2000
+
+/// attempts at switching the pump off before giving up
+#define INJECTION_OFF_RETRIES       3
+
+/// who times the pulse
+#define INJECTION_LOCAL             0
+#define INJECTION_TIMER             1
+
+/// timer slave map, wire addresses. The pulse length is written first,
+/// the start coil runs the water pump for that long and the box reports
+/// how long the pump actually ran. Clearing the start coil ends it early.
+#define TIMER_COIL_START            0
+#define TIMER_REG_DURATION          0       /// ms, two registers
+#define TIMER_REG_ELAPSED           2       /// ms, two input registers
+
+typedef struct INJECTION_PULSE
+{
+    bool isOk;
+    bool isAborted;
+    bool isStarted;         /// the on write went out, the pump may be running
+    bool isStopped;         /// the pump is known to be off again
+    int mode;
+    double requested;       /// s
+    double achieved;        /// s between the on and off frames leaving the wire
+    double jitter;          /// ms, achieved - requested
+    int64_t start;          /// us, rtu clock
+    int64_t stop;
+
+    INJECTION_PULSE() : isOk(false), isAborted(false), isStarted(false), isStopped(false), mode(INJECTION_LOCAL), requested(0), achieved(0), jitter(0), start(0), stop(0) {}
+
+} INJECTION_PULSES;
+
+
+/// Times injection pulses on its own thread against the monotonic clock
+/// the rtu pacing uses, so the pulse width no longer depends on the GUI
+/// event loop. The coil writes go through the loop's bus; the off write is
+/// queued ahead of its deadline and released by a spin on the bus thread.
+class InjectionScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit InjectionScheduler(ModbusBus *, QObject * parent = 0);
+    ~InjectionScheduler();
+
+    /// timer slave the pulses are handed to, -1 times them here
+    void setTimer(const int slave) { m_timerSlave = slave; }
+    int timer() const { return m_timerSlave; }
+
+    QFuture<INJECTION_PULSES> pulse(const int, const int, const double);
+    void abort();
+
+private:
+    INJECTION_PULSES runLocal(const int, const int, const double);
+    INJECTION_PULSES runTimer(const int, const double);
+    void waitUntil(const int64_t);
+
+    ModbusBus * m_bus;
+    QThread m_thread;
+    QObject * m_context;    /// lives in m_thread
+    int m_timerSlave;
+    QAtomicInt m_isAborted;
+};
+
+#endif // INJECTIONSCHEDULER_H
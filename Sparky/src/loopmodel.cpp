@@ -0,0 +1,186 @@
+#include <math.h>
+#include "loopmodel.h"
+
+LoopModel::
+LoopModel() :
+    m_isWaterRun(false),
+    m_start(0),
+    m_pumpRate(0),
+    m_volume(0),
+    m_origin(0)
+{
+}
+
+
+/// a new run: which way it goes, the measured start and the loop as entered
+void
+LoopModel::
+start(const bool isWaterRun, const double start, const double loopVolume, const double pumpRate)
+{
+    m_isWaterRun = isWaterRun;
+    m_start = start;
+    m_pumpRate = pumpRate;
+    m_volume = loopVolume;
+    m_origin = 0;
+    m_at.clear();
+    m_time.clear();
+    m_g.clear();
+
+    m_fit = LOOPMODEL_FITS();
+    m_fit.entered = (loopVolume > 0) ? (pumpRate/60)/loopVolume : 0;
+    m_fit.rate = m_fit.entered;
+    m_fit.volume = loopVolume;
+}
+
+
+/// the readings so far, for the journal
+QVariantMap
+LoopModel::
+state() const
+{
+    QVariantMap record;
+    QVariantList readings;
+
+    for (int i = 0; i < m_g.size(); i++) readings.append(QVariantList() << m_at[i] << m_time[i] << m_g[i]);
+
+    record["isWaterRun"] = m_isWaterRun;
+    record["start"] = m_start;
+    record["loopVolume"] = m_volume;
+    record["pumpRate"] = m_pumpRate;
+    record["origin"] = m_origin;
+    record["readings"] = readings;
+
+    return record;
+}
+
+
+void
+LoopModel::
+setState(const QVariantMap & record)
+{
+    start(record["isWaterRun"].toBool(), record["start"].toDouble(), record["loopVolume"].toDouble(), record["pumpRate"].toDouble());
+
+    m_origin = record["origin"].toDouble();
+
+    foreach (const QVariant & reading, record["readings"].toList())
+    {
+        const QVariantList r = reading.toList();
+
+        if (r.size() != 3) continue;
+
+        m_at.append(r[0].toDouble());
+        m_time.append(r[1].toDouble());
+        m_g.append(r[2].toDouble());
+    }
+
+    refit();
+}
+
+
+/// one master reading per step, taken before the next injection: run
+/// clock (s), pump time delivered so far (s) and the master watercut
+void
+LoopModel::
+observe(const double at, const double delivered, const double watercut)
+{
+    if (!isfinite(watercut)) return;
+
+    if (m_g.isEmpty()) m_origin = watercut;
+
+    const double g = transform(m_start + watercut - m_origin);
+
+    if (!isfinite(g)) return;
+
+    m_at.append(at);
+    m_time.append(delivered);
+    m_g.append(g);
+
+    refit();
+}
+
+
+/// pump time from the start of the run to reach the watercut, 0 while
+/// there is no rate to go by
+double
+LoopModel::
+injectionTime(const double watercut) const
+{
+    const double g = transform(watercut);
+
+    if (!isfinite(g) || (m_fit.rate <= 0)) return 0;
+
+    return g/m_fit.rate;
+}
+
+
+double
+LoopModel::
+transform(const double watercut) const
+{
+    if (m_isWaterRun) return ((watercut > 0) && (m_start > 0)) ? -log(watercut/m_start) : NAN;
+
+    const double oil = 1 - (watercut - m_start)/100;
+
+    return (oil > 0) ? -log(oil) : NAN;
+}
+
+
+/// least squares on g[i] = b1*T[i] + b2*g[i-1], rate = b1/(1 - b2); a lag
+/// outside [0, LOOPMODEL_MAX_LAG] is noise, then the fit goes without it
+void
+LoopModel::
+refit()
+{
+    double stt = 0, stp = 0, spp = 0, sty = 0, spy = 0;
+    double b1, b2;
+    int steps = 0;
+
+    for (int i = 1; i < m_g.size(); i++)
+    {
+        const double t = m_time[i];
+        const double p = m_g[i-1];
+        const double y = m_g[i];
+
+        stt += t*t;
+        stp += t*p;
+        spp += p*p;
+        sty += t*y;
+        spy += p*y;
+
+        if (t > m_time[i-1]) steps++;
+    }
+
+    m_fit.steps = steps;
+    m_fit.isFitted = false;
+    m_fit.rate = m_fit.entered;
+    m_fit.lag = 0;
+    m_fit.lagTime = 0;
+    m_fit.volume = m_volume;
+
+    if ((steps < LOOPMODEL_MIN_STEPS) || (stt <= 0)) return;
+
+    const double det = stt*spp - stp*stp;
+
+    b2 = (det > 1e-9*stt*spp) ? (stt*spy - stp*sty)/det : -1;
+
+    if ((b2 >= 0) && (b2 <= LOOPMODEL_MAX_LAG)) b1 = (sty*spp - stp*spy)/det;
+    else
+    {
+        b2 = 0;
+        b1 = sty/stt;
+    }
+
+    const double rate = b1/(1 - b2);
+
+    if (!(rate > 0)) return;
+    if ((m_fit.entered > 0) && ((rate > m_fit.entered*LOOPMODEL_MAX_CORRECTION) || (rate < m_fit.entered/LOOPMODEL_MAX_CORRECTION))) return;
+
+    /// readings come once a step, the lag in seconds goes by their mean spacing
+    const double spacing = (m_at.last() - m_at.first())/(m_at.size() - 1);
+
+    m_fit.isFitted = true;
+    m_fit.rate = rate;
+    m_fit.lag = b2;
+    m_fit.lagTime = (b2 > 0) ? -spacing/log(b2) : 0;
+    m_fit.volume = (m_pumpRate/60)/rate;
+}
@@ -0,0 +1,74 @@
+#ifndef LOOPMODEL_H
+#define LOOPMODEL_H
+
+#include <QVector>
+#include <QVariantMap>
+
+/// steps with a master reading before the fit replaces the entered loop
+#define LOOPMODEL_MIN_STEPS         3
+
+/// a fitted rate further than this factor from the entered one is taken
+/// for a bad master, not for the loop
+#define LOOPMODEL_MAX_CORRECTION    2.0
+
+/// largest share of a step the master may still owe at the next sample
+#define LOOPMODEL_MAX_LAG           0.9
+
+typedef struct LOOPMODEL_FIT
+{
+    int steps;              /// pairs of master readings the fit used
+    bool isFitted;          /// false while the entered loop volume and pump rate rule
+    double rate;            /// pump rate over loop volume (1/s), what the watercut responds to
+    double entered;         /// the same from the entered loop volume and pump rate
+    double volume;          /// effective loop volume at the entered pump rate
+    double lag;             /// share of a step the master still owes one sample later
+    double lagTime;         /// s, the same as a mixing time constant
+
+    LOOPMODEL_FIT() : steps(0), isFitted(false), rate(0), entered(0), volume(0), lag(0), lagTime(0) {}
+
+} LOOPMODEL_FITS;
+
+
+/// Learns how the loop answers an injection from the master watercut read
+/// before each step. Perfect mixing gives g(w) = rate*T, with T the pump
+/// time delivered so far and g the log transform of the pump rate formula
+/// (-ln(1 - (w - start)/100) filling with water, -ln(w/start) thinning
+/// with oil). The master lags the mixed loop, so a reading is taken as
+///
+///     g(o[i]) = (1 - a)*rate*T[i] + a*g(o[i-1])
+///
+/// and rate and a come from a linear least squares fit over the steps so
+/// far. Only pump rate over loop volume shows in the watercut, so the
+/// fit reports the effective volume at the entered rate. The master is
+/// read against its own first reading, which keeps its offset out.
+class LoopModel
+{
+public:
+    LoopModel();
+
+    void start(const bool, const double, const double, const double);
+    void observe(const double, const double, const double);
+    double injectionTime(const double) const;
+    const LOOPMODEL_FITS & fit() const { return m_fit; }
+
+    QVariantMap state() const;
+    void setState(const QVariantMap &);
+
+private:
+    double transform(const double) const;
+    void refit();
+
+    bool m_isWaterRun;      /// oil goes in, the watercut falls
+    double m_start;         /// measured watercut the run started from
+    double m_pumpRate;      /// as entered, per minute
+    double m_volume;        /// as entered
+    double m_origin;        /// first master reading of the run
+
+    QVector<double> m_at;   /// s, run clock of each reading
+    QVector<double> m_time; /// s of pumping before each reading
+    QVector<double> m_g;
+
+    LOOPMODEL_FITS m_fit;
+};
+
+#endif // LOOPMODEL_H
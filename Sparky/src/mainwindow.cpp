@@ -1,14 +1,18 @@
+#include <math.h>
+#include <algorithm>
 #include <QRegExp>
 #include <QtConcurrent>
 #include <QSettings>
 #include <QDebug>
 #include <QMessageBox>
 #include <QFile>
+#include <QDir>
 #include <QScrollBar>
 #include <QTime>
 #include <QGroupBox>
 #include <QFileDialog>
 #include <QThread>
+#include <QEventLoop>
 #include <errno.h>
 #include <QSignalMapper>
 #include <QListWidget>
@@ -17,6 +21,7 @@
 #include <QInputDialog>
 #include <QProgressDialog>
 #include "mainwindow.h"
+#include "captureviewer.h"
 #include "modbus.h"
 #include "modbus-private.h"
 #include "modbus-rtu.h"
@@ -24,30 +29,31 @@
 #include "qextserialenumerator.h"
 
 QT_CHARTS_USE_NAMESPACE
-#define MAX_PHASE_CHECKING		5
-
-const QString SALINITY[] = {"0.02", "0.10", "0.20", "0.30", "0.40", "0.50", "1.00", "1.50", "2.00", "3.00", "5.00", "8.00", "11.00", "20.00", "25.00", "28.00"};
 
 const int DataTypeColumn = 0;
 const int AddrColumn = 1;
 const int DataColumn = 2;
 
-static QString HIGH = "0";
-static QString FULL = "0";
-static QString MID = "0";
-static QString LOW = "0";
-
 extern MainWindow * globalMainWin;
 
 MainWindow::MainWindow( QWidget * _parent ) :
     QMainWindow( _parent ),
     ui( new Ui::MainWindowClass ),
-    m_modbus_snipping( NULL ),
+    m_monitorRing( new MonitorRing ),
     m_poll(false),
-    isModbusTransmissionFailed(false)
+    isModbusTransmissionFailed(false),
+    m_loops(NULL),
+    m_engine(NULL),
+    m_calState(STATE_IDLE)
 {
     ui->setupUi(this);
 
+    /// what the engine reports crosses over from its thread
+    qRegisterMetaType<CAL_SAMPLES>();
+    qRegisterMetaType<CAL_PROGRESSES>();
+    qRegisterMetaType<CAL_TIMINGS>();
+    qRegisterMetaType<INJECTION_PULSES>();
+
     /// versioning
     setWindowTitle(SPARKY);
 
@@ -98,45 +104,44 @@ MainWindow::MainWindow( QWidget * _parent ) :
     connectProfiler();
     connectToolbar();
     connectLineView();
-    connectMasterPipe();
 
     /// clear connection at start
     updateLoopTabIcon(false);
 
-    /// match pipe colors with chart
-    PIPE[0].slave->setStyleSheet("color: red;");
-    PIPE[0].wc->setStyleSheet("color: red;");
-    PIPE[0].startFreq->setStyleSheet("color: red;");
-    PIPE[0].freq->setStyleSheet("color: red;");
-    PIPE[0].temp->setStyleSheet("color: red;");
-    PIPE[0].reflectedPower->setStyleSheet("color: red;");
-
-    PIPE[1].slave->setStyleSheet("color: blue;");
-    PIPE[1].wc->setStyleSheet("color: blue;");
-    PIPE[1].startFreq->setStyleSheet("color: blue;");
-    PIPE[1].freq->setStyleSheet("color: blue;");
-    PIPE[1].temp->setStyleSheet("color: blue;");
-    PIPE[1].reflectedPower->setStyleSheet("color: blue;");
-
-    PIPE[2].slave->setStyleSheet("color: black;");
-    PIPE[2].wc->setStyleSheet("color: black;");
-    PIPE[2].startFreq->setStyleSheet("color: black;");
-    PIPE[2].freq->setStyleSheet("color: black;");
-    PIPE[2].temp->setStyleSheet("color: black;");
-    PIPE[2].reflectedPower->setStyleSheet("color: black;");
-
 	displayPipeReading(ALL,0,0,0,0,0);
 	updateCurrentStage(RED,STOP_CALIBRATION);
+
+    /// once the window is up
+    QTimer::singleShot(0, this, SLOT(offerResume()));
 }
 
 
 MainWindow::~MainWindow()
 {
-	if (LOOP.isInjectionOn) inject(COIL_WATER_PUMP,false);
+    /// a running calibration lets go of the bus before the port closes; the
+    /// events are served meanwhile, a dialog it is opening may need them
+    if (m_loops)
+    {
+        disconnect(m_loops, 0, this, 0);
+        disconnect(m_engine, 0, this, 0);
+        m_loops->abort();
+
+        if (m_loops->isRunning())
+        {
+            QEventLoop wait;
+
+            connect(m_loops, &CalLoops::finished, &wait, &QEventLoop::quit);
+            wait.exec();
+        }
+
+        delete m_loops;
+    }
+
 	releaseSerialModbus();
     delete m_statusInd;
     delete m_statusText;
     delete ui;
+    qDeleteAll(PIPE);
 }
 
 
@@ -149,9 +154,6 @@ setValidators()
     ui->lineEdit_38->setValidator( new QDoubleValidator(0, 1000000, 2, this) ); // waterRunStop
     ui->lineEdit_39->setValidator( new QDoubleValidator(0, 1000000, 2, this) ); // oilRunStart
     ui->lineEdit_40->setValidator( new QDoubleValidator(0, 1000000, 2, this) ); // oilRunStop
-    ui->lineEdit_2->setValidator( new QDoubleValidator(0, 1000000, 2, this) ); // oilRunStart
-    ui->lineEdit_7->setValidator( new QDoubleValidator(0, 1000000, 2, this) ); // oilRunStart
-    ui->lineEdit_13->setValidator( new QDoubleValidator(0, 1000000, 2, this) ); // oilRunStart
     ui->lineEdit_109->setValidator( new QDoubleValidator(-100000, 1000000, 5, this) ); // float modbus monitor
     ui->lineEdit_111->setValidator( new QDoubleValidator(-100000, 1000000, 5, this) ); // integer modbus monitor
 }
@@ -175,6 +177,17 @@ initializeModbusMonitor()
     ui->groupBox_106->setEnabled(FALSE);
     ui->groupBox_107->setEnabled(FALSE);
     ui->functionCode->setCurrentIndex(3);
+
+    /// bounded monitor views, the row count stays at the configured retention
+    m_busMonitor = new BusMonitorModel( this );
+    m_busMonitor->setRetention( LOOP.monitorRows );
+    ui->busMonTable->setModel( m_busMonitor );
+    ui->busMonTable->verticalHeader()->setSectionResizeMode( QHeaderView::Fixed );
+
+    m_busHex = new BusHexModel( this );
+    m_busHex->setRetention( LOOP.monitorRows );
+    ui->rawData->setModel( m_busHex );
+    ui->rawData->setUniformItemSizes( true );
 }
 
 
@@ -209,7 +222,7 @@ keyPressEvent(QKeyEvent* event)
     if( event->key() == Qt::Key_Control )
     {
         //set flag to request polling
-        if( LOOP.modbus != NULL )	m_poll = true;
+        if( LOOP.bus->isOpen() )	m_poll = true;
         if( ! m_pollTimer->isActive() )	ui->sendBtn->setText( tr("Poll") );
     }
 }
@@ -254,92 +267,76 @@ void MainWindow::onSendButtonPress( void )
     }
 }
 
-void MainWindow::busMonitorAddItem( bool isRequest,
-                    uint16_t slave,
-                    uint8_t func,
-                    uint16_t addr,
-                    uint16_t nb,
-                    uint16_t expectedCRC,
-                    uint16_t actualCRC )
+// static
+void MainWindow::stBusMonitorAddItem( modbus_t * modbus, uint8_t isRequest, uint16_t slave, uint8_t func, uint16_t addr, uint16_t nb, uint16_t expectedCRC, uint16_t actualCRC )
 {
-    QTableWidget * bm = ui->busMonTable;
-    const int rowCount = bm->rowCount();
-    bm->setRowCount( rowCount+1 );
+    Q_UNUSED(modbus);
 
-    QTableWidgetItem * numItem;
-    QTableWidgetItem * ioItem = new QTableWidgetItem( isRequest ? tr( "Req >>" ) : tr( "<< Resp" ) );
-    QTableWidgetItem * slaveItem = new QTableWidgetItem( QString::number( slave ) );
-    QTableWidgetItem * funcItem = new QTableWidgetItem( QString::number( func ) );
-    QTableWidgetItem * addrItem = new QTableWidgetItem( QString::number( addr ) );
-    (ui->radioButton_181->isChecked()) ? numItem  = new QTableWidgetItem( QString::number( 2 ) ) : numItem = new QTableWidgetItem( QString::number( 1 ) );
-    QTableWidgetItem * crcItem = new QTableWidgetItem;
+    /// called on the bus thread in the middle of a transaction, only record it
+    if( globalMainWin ) globalMainWin->m_monitorRing->pushItem( isRequest, slave, func, addr, nb, expectedCRC, actualCRC );
+}
 
-    if( func > 127 )
-    {
-        addrItem->setText( QString() );
-        numItem->setText( QString() );
-        funcItem->setText( tr( "Exception (%1)" ).arg( func-128 ) );
-        funcItem->setForeground( Qt::red );
-    }
-    else
-    {
-        if( expectedCRC == actualCRC )
-        {
-            crcItem->setText( QString().sprintf( "%.4x", actualCRC ) );
-        }
-        else
-        {
-            crcItem->setText( QString().sprintf( "%.4x (%.4x)", actualCRC, expectedCRC ) );
-            crcItem->setForeground( Qt::red );
-        }
-    }
-    ioItem->setFlags( ioItem->flags() & ~Qt::ItemIsEditable );
-    slaveItem->setFlags( slaveItem->flags() & ~Qt::ItemIsEditable );
-    funcItem->setFlags( funcItem->flags() & ~Qt::ItemIsEditable );
-    addrItem->setFlags( addrItem->flags() & ~Qt::ItemIsEditable );
-    numItem->setFlags( numItem->flags() & ~Qt::ItemIsEditable );
-    crcItem->setFlags( crcItem->flags() & ~Qt::ItemIsEditable );
-    bm->setItem( rowCount, 0, ioItem );
-    bm->setItem( rowCount, 1, slaveItem );
-    bm->setItem( rowCount, 2, funcItem );
-    bm->setItem( rowCount, 3, addrItem );
-    bm->setItem( rowCount, 4, numItem );
-    bm->setItem( rowCount, 5, crcItem );
-    bm->verticalScrollBar()->setValue( bm->verticalScrollBar()->maximum() );
+// static
+void MainWindow::stBusMonitorRawData( modbus_t * modbus, uint8_t * data, uint8_t dataLen, uint8_t addNewline )
+{
+    Q_UNUSED(modbus);
+
+    /// data belongs to libmodbus, the ring keeps a copy
+    if( globalMainWin ) globalMainWin->m_monitorRing->pushRaw( data, dataLen, addNewline );
 }
 
 
-void MainWindow::busMonitorRawData( uint8_t * data, uint8_t dataLen, bool addNewline )
+void
+MainWindow::
+drainBusMonitor()
 {
-    if( dataLen > 0 )
+    TRACE_RECORDS record;
+    QVector<BUS_FRAMES> frames;
+
+    /// every session gets its own capture file, a full one is followed by the next
+    if( m_capture.isFull() ) m_capture.close();
+
+    if( LOOP.isCapture && !m_capture.isOpen() && LOOP.bus->isOpen() )
     {
-        QString dump = ui->rawData->toPlainText();
-        for( int i = 0; i < dataLen; ++i )
-        {
-            dump += QString().sprintf( "%.2x ", data[i] );
-        }
-        if( addNewline )
+        QDir().mkpath( QCoreApplication::applicationDirPath()+"/"+CAPTURE_FOLDER );
+        m_capture.open( QCoreApplication::applicationDirPath()+"/"+CAPTURE_FOLDER+"/SPARKY_"+QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")+CAPTURE_EXT );
+    }
+
+    /// everything the bus thread traced since the last frame
+    while( m_monitorRing->pop( record ) )
+    {
+        m_capture.write( record );
+
+        if( record.kind == TRACE_RAW )
         {
-            dump += "\n";
+            m_busHex->append( record.data, record.len, record.isNewline != 0 );
+            continue;
         }
-        ui->rawData->setPlainText( dump );
-        ui->rawData->verticalScrollBar()->setValue( 100000 );
-        ui->rawData->setLineWrapMode( QPlainTextEdit::NoWrap );
+
+        BUS_FRAMES frame;
+        frame.time = record.time;
+        frame.isRequest = ( record.isRequest != 0 );
+        frame.slave = record.slave;
+        frame.func = record.func;
+        frame.addr = record.addr+1;
+        frame.bytes = (ui->radioButton_181->isChecked()) ? 2 : 1;
+        frame.expectedCRC = record.expectedCRC;
+        frame.actualCRC = record.actualCRC;
+        frames.append( frame );
     }
-}
 
-// static
-void MainWindow::stBusMonitorAddItem( modbus_t * modbus, uint8_t isRequest, uint16_t slave, uint8_t func, uint16_t addr, uint16_t nb, uint16_t expectedCRC, uint16_t actualCRC )
-{
-    Q_UNUSED(modbus);
-    globalMainWin->busMonitorAddItem( isRequest, slave, func, addr+1, nb, expectedCRC, actualCRC );
-}
+    m_capture.flush();
 
-// static
-void MainWindow::stBusMonitorRawData( modbus_t * modbus, uint8_t * data, uint8_t dataLen, uint8_t addNewline )
-{
-    Q_UNUSED(modbus);
-    globalMainWin->busMonitorRawData( data, dataLen, addNewline != 0 );
+    const int hexRows = m_busHex->rowCount();
+
+    m_busMonitor->append( frames );
+    m_busHex->flush();
+
+    if( !frames.isEmpty() ) ui->busMonTable->scrollToBottom();
+    if( m_busHex->rowCount() != hexRows ) ui->rawData->scrollToBottom();
+
+    const unsigned dropped = m_monitorRing->takeDropped();
+    if( dropped > 0 ) setStatusError( tr( "Bus monitor dropped %1 records" ).arg( dropped ) );
 }
 
 static QString descriptiveDataTypeName( int funcCode )
@@ -365,6 +362,14 @@ static QString descriptiveDataTypeName( int funcCode )
 }
 
 
+/// the temperature stages, TEMPRUN_MIN to TEMPRUN_ONLY
+static bool
+isTempRunState(const CAL_STATE state)
+{
+    return (state >= STATE_TEMP_SETUP) && (state <= STATE_TEMP_NEXT);
+}
+
+
 static inline QString embracedString( const QString & s )
 {
     return s.section( '(', 1 ).section( ')', 0, 0 );
@@ -463,10 +468,7 @@ void MainWindow::enableHexView( void )
 
 void MainWindow::sendModbusRequest( void )
 {
-    // UPDATE m_modbus_snipping WITH THE CURRENT
-    m_modbus_snipping = LOOP.modbus;
-
-    if( m_modbus_snipping == NULL )
+    if( !LOOP.bus->isOpen() )
     {
         setStatusError( tr("Not configured!") );
         return;
@@ -485,58 +487,49 @@ void MainWindow::sendModbusRequest( void )
     bool is16Bit = false;
     bool writeAccess = false;
     const QString funcType = descriptiveDataTypeName( func );
+    BUS_REPLIES reply;
 
-    modbus_set_slave( m_modbus_snipping, slave );
+    LOOP.bus->setSlave( slave );
 
     switch( func )
     {
         case MODBUS_FC_READ_COILS:
-            ret = modbus_read_bits( m_modbus_snipping, addr, num, dest );
+            reply = busWait( LOOP.bus->readBits( addr, num ) );
             break;
         case MODBUS_FC_READ_DISCRETE_INPUTS:
-            ret = modbus_read_input_bits( m_modbus_snipping, addr, num, dest );
+            reply = busWait( LOOP.bus->readInputBits( addr, num ) );
             break;
         case MODBUS_FC_READ_HOLDING_REGISTERS:
-            ret = modbus_read_registers( m_modbus_snipping, addr, num, dest16 );
+            reply = busWait( LOOP.bus->readRegisters( addr, num ) );
             is16Bit = true;
             break;
         case MODBUS_FC_READ_INPUT_REGISTERS:
-            ret = modbus_read_input_registers(m_modbus_snipping, addr, num, dest16 );
+            reply = busWait( LOOP.bus->readInputRegisters( addr, num ) );
             is16Bit = true;
             break;
         case MODBUS_FC_WRITE_SINGLE_COIL:
-            //ret = modbus_write_bit( m_modbus_snipping, addr,ui->regTable->item( 0, DataColumn )->text().toInt(0, 0) ? 1 : 0 );
-            ret = modbus_write_bit( m_modbus_snipping, addr,ui->radioButton_184->isChecked() ? 1 : 0 );
+            reply = busWait( LOOP.bus->writeBit( addr, ui->radioButton_184->isChecked() ) );
             writeAccess = true;
             num = 1;
             break;
         case MODBUS_FC_WRITE_SINGLE_REGISTER:
-            //ret = modbus_write_register( m_modbus_snipping, addr,ui->regTable->item( 0, DataColumn )->text().toInt(0, 0) );
-            ret = modbus_write_register( m_modbus_snipping, addr,ui->lineEdit_111->text().toInt(0, 0) );
+            reply = busWait( LOOP.bus->writeRegister( addr, ui->lineEdit_111->text().toInt(0, 0) ) );
             writeAccess = true;
             num = 1;
             break;
         case MODBUS_FC_WRITE_MULTIPLE_COILS:
         {
-            uint8_t * data = new uint8_t[num];
+            QVector<uint8_t> data( num );
             for( int i = 0; i < num; ++i ) data[i] = ui->regTable->item( i, DataColumn )->text().toInt(0, 0);
-            ret = modbus_write_bits( m_modbus_snipping, addr, num, data );
-            delete[] data;
+            reply = busWait( LOOP.bus->writeBits( addr, data ) );
             writeAccess = true;
             break;
         }
         case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
         {
-            float value;
-            QString qvalue = ui->lineEdit_109->text();
-            QTextStream floatTextStream(&qvalue);
-            floatTextStream >> value;
-            quint16 (*reg)[2] = reinterpret_cast<quint16(*)[2]>(&value);
-            uint16_t * data = new uint16_t[2];
-            data[0] = (*reg)[1];
-            data[1] = (*reg)[0];
-            ret = modbus_write_registers( m_modbus_snipping, addr, 2, data );
-            delete[] data;
+            QVector<uint16_t> data( CODEC_WIDE_REGISTERS );
+            DeviceCodec::fromFloat( ui->lineEdit_109->text().toFloat(), data.data() );
+            reply = busWait( LOOP.bus->writeRegisters( addr, data ) );
             writeAccess = true;
             break;
         }
@@ -544,6 +537,12 @@ void MainWindow::sendModbusRequest( void )
             break;
     }
 
+    /// copy the answer back where the table code expects it
+    ret = reply.rc;
+    errno = reply.error;
+    for( int i = 0; i < reply.regs.size(); ++i ) dest16[i] = reply.regs[i];
+    for( int i = 0; i < reply.bits.size(); ++i ) dest[i] = reply.bits[i];
+
     if( ret == num  )
     {
         isModbusTransmissionFailed = false;
@@ -558,20 +557,15 @@ void MainWindow::sendModbusRequest( void )
         {
             bool b_hex = false; //is16Bit && ui->checkBoxHexData->checkState() == Qt::Checked;
             QString qs_num;
-            QString qs_output = "0x";
-            bool ok = false;
 
             ui->regTable->setRowCount( num );
             for( int i = 0; i < num; ++i )
             {
                 int data = is16Bit ? dest16[i] : dest[i];
-                QString qs_tmp;
 
                 QTableWidgetItem * dtItem = new QTableWidgetItem( funcType );
                 QTableWidgetItem * addrItem = new QTableWidgetItem(QString::number( ui->startAddr->value()+i ) );
                 qs_num.sprintf( b_hex ? "0x%04x" : "%d", data);
-                qs_tmp.sprintf("%04x", data);
-                qs_output.append(qs_tmp);
                 QTableWidgetItem * dataItem = new QTableWidgetItem( qs_num );
                 dtItem->setFlags( dtItem->flags() & ~Qt::ItemIsEditable );
                 addrItem->setFlags( addrItem->flags() & ~Qt::ItemIsEditable );
@@ -586,12 +580,10 @@ void MainWindow::sendModbusRequest( void )
                 }
             }
 
-            QByteArray array = QByteArray::fromHex(qs_output.toLatin1());
-            const float d = toFloat(array);
-
-            if (ui->radioButton_181->isChecked())
+            if (ui->radioButton_181->isChecked() && (num >= CODEC_WIDE_REGISTERS))
             {
-                (b_hex) ? ui->lineEdit_109->setText(qs_output) : ui->lineEdit_109->setText(QString::number(d,'f',10)) ;
+                const float d = DeviceCodec::toFloat(dest16);
+                (b_hex) ? ui->lineEdit_109->setText(QString("0x%1").arg(DeviceCodec::join(dest16), 8, 16, QChar('0'))) : ui->lineEdit_109->setText(QString::number(d,'f',10)) ;
             }
         }
     }
@@ -642,14 +634,6 @@ void MainWindow::resetStatus( void )
     m_statusInd->setStyleSheet( "background: #aaa;" );
 }
 
-void MainWindow::pollForDataOnBus( void )
-{
-    if( LOOP.modbus )
-    {
-        modbus_poll( LOOP.modbus );
-    }
-}
-
 void MainWindow::aboutQModBus( void )
 {
     AboutDialog( this ).exec();
@@ -658,15 +642,13 @@ void MainWindow::aboutQModBus( void )
 void MainWindow::onRtuPortActive(bool active)
 {
     if (active) {
-        LOOP.modbus = this->modbus();
-
-        //LOOP[loop].modbus = this->modbus();
-        if (LOOP.modbus) {
-            modbus_register_monitor_add_item_fnc(LOOP.modbus, MainWindow::stBusMonitorAddItem);
-            modbus_register_monitor_raw_data_fnc(LOOP.modbus, MainWindow::stBusMonitorRawData);
+        if (LOOP.bus->isOpen()) {
+            LOOP.bus->setMonitor(MainWindow::stBusMonitorAddItem, MainWindow::stBusMonitorRawData);
         }
     }
-    else LOOP.modbus = NULL;
+
+    /// bus sniffing runs on the bus thread
+    LOOP.bus->setPolling(active && LOOP.bus->isOpen());
 }
 
 
@@ -684,58 +666,74 @@ void
 MainWindow::
 initializePipeObjects()
 {
-    /// label
-    PIPE[0].pipeId = "P1";
-    PIPE[1].pipeId = "P2";
-    PIPE[2].pipeId = "P3";
+    for (int pipe = 0; pipe < LOOP.pipeCount; pipe++)
+    {
+        PIPE.append(new PIPES);
 
-    /// slave
-    PIPE[0].slave = ui->lineEdit_2;
-    PIPE[1].slave = ui->lineEdit_7;
-    PIPE[2].slave = ui->lineEdit_13;
+        /// label
+        PIPE[pipe]->pipeId = QString("P%1").arg(pipe+1);
 
-    /// on/off graph line view
-    PIPE[0].lineView = ui->checkBox_19;
-    PIPE[1].lineView = ui->checkBox_20;
-    PIPE[2].lineView = ui->checkBox_21;
+        createPipeRow(pipe);
+    }
+
+    /// rows past the panel scroll
+    ui->pipeRows->setMinimumHeight(PIPE.size()*PIPE_ROW_HEIGHT);
+}
+
+
+/// one row of the pipe panel, laid out like the three rows the panel
+/// used to have
+void
+MainWindow::
+createPipeRow(const int pipe)
+{
+    static const Qt::GlobalColor PIPE_COLORS[PIPE_MAX_COUNT] = {Qt::red, Qt::blue, Qt::black, Qt::darkGreen, Qt::magenta, Qt::darkCyan, Qt::darkYellow, Qt::darkRed, Qt::darkBlue, Qt::darkMagenta, Qt::gray, Qt::green, Qt::cyan, Qt::darkGray, Qt::yellow, Qt::lightGray};
+    const QColor color(PIPE_COLORS[pipe % PIPE_MAX_COUNT]);
+    const QString style = QString("color: %1;").arg(color.name());
+    const int y = pipe*PIPE_ROW_HEIGHT;
+    PIPES * p = PIPE[pipe];
+    QFont font;
+
+    font.setPointSize(14);
 
     /// on/off pipe switch
-    PIPE[0].checkBox = ui->checkBox;
-    PIPE[1].checkBox = ui->checkBox_2;
-    PIPE[2].checkBox = ui->checkBox_3;
-
-    /// lcdWatercut
-    PIPE[0].wc = ui->lineEdit_3;
-    PIPE[1].wc = ui->lineEdit_8;
-    PIPE[2].wc = ui->lineEdit_14;
-
-    /// lcdStartFreq
-    PIPE[0].startFreq = ui->lineEdit_4;
-    PIPE[1].startFreq = ui->lineEdit_9;
-    PIPE[2].startFreq = ui->lineEdit_15;
-
-    /// lcdFreq
-    PIPE[0].freq = ui->lineEdit_5;
-    PIPE[1].freq = ui->lineEdit_10;
-    PIPE[2].freq = ui->lineEdit_16;
-
-    /// lcdTemp
-    PIPE[0].temp = ui->lineEdit_6;
-    PIPE[1].temp = ui->lineEdit_11;
-    PIPE[2].temp = ui->lineEdit_17;
-
-    /// lcd
-    PIPE[0].reflectedPower = ui->lineEdit_12;
-    PIPE[1].reflectedPower = ui->lineEdit_19;
-    PIPE[2].reflectedPower = ui->lineEdit_18;
+    p->checkBox = new QCheckBox(ui->pipeRows);
+    p->checkBox->setGeometry(10, y+10, 21, 16);
+
+    /// on/off graph line view
+    p->lineView = new QCheckBox(p->pipeId, ui->pipeRows);
+    p->lineView->setGeometry(32, y+10, 46, 17);
+    p->lineView->setChecked(true);
+
+    /// slave, lcdWatercut, lcdStartFreq, lcdFreq, lcdTemp and lcd
+    QLineEdit ** edits[] = {&p->slave, &p->wc, &p->startFreq, &p->freq, &p->temp, &p->reflectedPower};
+    const int columns[] = {80, 180, 280, 380, 480, 570};
+
+    for (int i = 0; i < 6; i++)
+    {
+        QLineEdit * edit = new QLineEdit(ui->pipeRows);
+
+        edit->setGeometry(columns[i], y+3, 81, 31);
+        edit->setFont(font);
+        edit->setAlignment(Qt::AlignCenter);
+        edit->setStyleSheet(style);
+        edit->setReadOnly(i > 0);
+        *edits[i] = edit;
+    }
+
+    p->slave->setValidator( new QDoubleValidator(0, 1000000, 2, this) );
 
     /// stability progressbar
-    PIPE[0].freqProgress = ui->progressBar;
-    PIPE[0].tempProgress = ui->progressBar_2;
-    PIPE[1].freqProgress = ui->progressBar_4;
-    PIPE[1].tempProgress = ui->progressBar_3;
-    PIPE[2].freqProgress = ui->progressBar_6;
-    PIPE[2].tempProgress = ui->progressBar_5;
+    p->freqProgress = new QProgressBar(ui->pipeRows);
+    p->freqProgress->setGeometry(670, y+4, 75, 25);
+    p->freqProgress->setAlignment(Qt::AlignCenter);
+    p->tempProgress = new QProgressBar(ui->pipeRows);
+    p->tempProgress->setGeometry(760, y+4, 75, 25);
+    p->tempProgress->setAlignment(Qt::AlignCenter);
+
+    /// set pen color
+    p->pen.setColor(color);
+    p->pen2.setColor(color);
 }
 
 
@@ -780,21 +778,13 @@ initializeGraph()
     LOOP.chartView->setChart(LOOP.chart);
     LOOP.chartView->setRubberBand(QChartView::HorizontalRubberBand);
 
-    /// set pen color
-    PIPE[0].pen.setColor(Qt::red);
-    PIPE[0].pen2.setColor(Qt::red);
-    PIPE[1].pen.setColor(Qt::blue);
-    PIPE[1].pen2.setColor(Qt::blue);
-    PIPE[2].pen.setColor(Qt::black);
-    PIPE[2].pen2.setColor(Qt::black);
-
     /// setPen and addSeries
-    for (int pipe=0; pipe<3; pipe++)
+    for (int pipe=0; pipe<PIPE.size(); pipe++)
     {
-        PIPE[pipe].series->setPen(PIPE[pipe].pen);
-        PIPE[pipe].series_2->setPen(PIPE[pipe].pen2);
-        LOOP.chart->addSeries(PIPE[pipe].series);
-        LOOP.chart->addSeries(PIPE[pipe].series_2);
+        PIPE[pipe]->series->setPen(PIPE[pipe]->pen);
+        PIPE[pipe]->series_2->setPen(PIPE[pipe]->pen2);
+        LOOP.chart->addSeries(PIPE[pipe]->series);
+        LOOP.chart->addSeries(PIPE[pipe]->series_2);
     }
 
     /// addAxis
@@ -821,16 +811,15 @@ initializeGraph()
     LOOP.axisY2->setLabelFormat("%.1f");
     LOOP.axisY2->setTitleText("Reflected Power (V)");
 
-    for (int pipe=0; pipe<3; pipe++)
+    for (int pipe=0; pipe<PIPE.size(); pipe++)
     {
-        PIPE[pipe].series->attachAxis(LOOP.axisX);
-        PIPE[pipe].series->attachAxis(LOOP.axisY);
-        PIPE[pipe].series_2->attachAxis(LOOP.axisX);
-        PIPE[pipe].series_2->attachAxis(LOOP.axisY2);
+        PIPE[pipe]->series->attachAxis(LOOP.axisX);
+        PIPE[pipe]->series->attachAxis(LOOP.axisY);
+        PIPE[pipe]->series_2->attachAxis(LOOP.axisX);
+        PIPE[pipe]->series_2->attachAxis(LOOP.axisY2);
     }
 
-    for (int pipe=0; pipe<3; pipe++)(PIPE[pipe].lineView) ? PIPE[pipe].series->show() : PIPE[pipe].series->hide();
-    for (int pipe=0; pipe<3; pipe++)(PIPE[pipe].lineView) ? PIPE[pipe].series_2->show() : PIPE[pipe].series_2->hide();
+    for (int pipe=0; pipe<PIPE.size(); pipe++) toggleLineView(pipe, PIPE[pipe]->lineView->isChecked());
 }
 
 
@@ -843,37 +832,37 @@ updateGraph(const int pipe, const double x, const double y, const int Series)
 	{
 		if (pipe == ALL)
 		{
-			for (int i=0; i<3; i++)
+			for (int i=0; i<PIPE.size(); i++)
 			{
-				PIPE[i].series->remove(0);
-				PIPE[i].series_2->remove(0);
+				PIPE[i]->series->remove(0);
+				PIPE[i]->series_2->remove(0);
 			}
 			return;
 		}
 
-		PIPE[pipe].series->remove(0);
-		PIPE[pipe].series_2->remove(0);
+		PIPE[pipe]->series->remove(0);
+		PIPE[pipe]->series_2->remove(0);
 		return;
 	}
 
-    if (Series == SERIES_WATERCUT) PIPE[pipe].series->append(x,y);
-    else PIPE[pipe].series_2->append(x,y);
+    if (Series == SERIES_WATERCUT) PIPE[pipe]->series->append(x,y);
+    else PIPE[pipe]->series_2->append(x,y);
 }
 
 void
 MainWindow::
 connectTimers()
 {
-    QTimer * t = new QTimer( this );
-    connect( t, SIGNAL(timeout()), this, SLOT(pollForDataOnBus()));
-    t->start( 5 );
-
     m_pollTimer = new QTimer( this );
     connect( m_pollTimer, SIGNAL(timeout()), this, SLOT(sendModbusRequest()));
 
     m_statusTimer = new QTimer( this );
     connect( m_statusTimer, SIGNAL(timeout()), this, SLOT(resetStatus()));
     m_statusTimer->setSingleShot(true);
+
+    m_monitorTimer = new QTimer( this );
+    connect( m_monitorTimer, SIGNAL(timeout()), this, SLOT(drainBusMonitor()));
+    m_monitorTimer->start( TRACE_DRAIN_INTERVAL );
 }
 
 
@@ -916,6 +905,25 @@ connectActions()
 {
     connect( ui->actionAbout_QModBus, SIGNAL( triggered() ),this, SLOT( aboutQModBus() ) );
     connect( ui->functionCode, SIGNAL( currentIndexChanged( int ) ),this, SLOT( enableHexView() ) );
+    connect( ui->actionCapture_Viewer, SIGNAL( triggered() ),this, SLOT( onCaptureViewer() ) );
+}
+
+
+void
+MainWindow::
+onCaptureViewer()
+{
+    CaptureViewer * viewer = new CaptureViewer( this );
+    viewer->setAttribute( Qt::WA_DeleteOnClose );
+
+    /// open on the running session
+    if( m_capture.isOpen() )
+    {
+        m_capture.flush();
+        viewer->openCapture( m_capture.fileName() );
+    }
+
+    viewer->show();
 }
 
 
@@ -944,6 +952,7 @@ connectToolbar()
     connect(ui->actionSettings, SIGNAL(triggered()),this,SLOT(onActionSettings()));
     connect(ui->actionSync, SIGNAL(triggered()),this,SLOT(onActionSync()));
     connect(ui->actionStart, SIGNAL(triggered()),this,SLOT(onActionStart()));
+    connect(ui->actionReplay, SIGNAL(triggered()),this,SLOT(onActionReplay()));
     connect(ui->actionStop, SIGNAL(triggered()),this,SLOT(onActionStopPressed()));
     connect(ui->actionPause, SIGNAL(triggered()),this,SLOT(onActionPause()));
     connect(ui->actionReadMasterPipe, SIGNAL(triggered()),this,SLOT(onActionReadMasterPipe()));
@@ -1012,9 +1021,7 @@ void
 MainWindow::
 connectCheckbox()
 {
-    connect(ui->checkBox, SIGNAL(clicked(bool)),this, SLOT(onCheckBoxClicked(bool)));
-    connect(ui->checkBox_2, SIGNAL(clicked(bool)),this, SLOT(onCheckBoxClicked(bool)));
-    connect(ui->checkBox_3, SIGNAL(clicked(bool)),this, SLOT(onCheckBoxClicked(bool)));
+    for (int pipe = 0; pipe < PIPE.size(); pipe++) connect(PIPE[pipe]->checkBox, SIGNAL(clicked(bool)),this, SLOT(onCheckBoxClicked(bool)));
 }
 
 
@@ -1022,35 +1029,23 @@ void
 MainWindow::
 onCheckBoxClicked(const bool isChecked)
 {
-    (ui->checkBox->isChecked()) ?  PIPE[0].status = ENABLED : PIPE[0].status = DONE;
-    (ui->checkBox_2->isChecked()) ?  PIPE[1].status = ENABLED : PIPE[1].status = DONE;
-    (ui->checkBox_3->isChecked()) ?  PIPE[2].status = ENABLED : PIPE[2].status = DONE;
-}
+    for (int pipe = 0; pipe < PIPE.size(); pipe++) (PIPE[pipe]->checkBox->isChecked()) ?  PIPE[pipe]->status = ENABLED : PIPE[pipe]->status = DONE;
 
-
-/// hide/show graph line
-void
-MainWindow::
-toggleLineView_P1(bool b)
-{
-   (b) ? PIPE[0].series->show() : PIPE[0].series->hide();
-   (b) ? PIPE[0].series_2->show() : PIPE[0].series_2->hide();
+    /// a pipe switched off is done for the running stage
+    if (m_engine)
+    {
+        for (int pipe = 0; pipe < m_calRows.size(); pipe++) m_engine->setPipeStatus(pipe, PIPE[m_calRows[pipe]]->status);
+    }
 }
 
-void
-MainWindow::
-toggleLineView_P2(bool b)
-{
-   (b) ? PIPE[1].series->show() : PIPE[1].series->hide();
-   (b) ? PIPE[1].series_2->show() : PIPE[1].series_2->hide();
-}
 
+/// hide/show graph line
 void
 MainWindow::
-toggleLineView_P3(bool b)
+toggleLineView(const int pipe, const bool b)
 {
-   (b) ? PIPE[2].series->show() : PIPE[2].series->hide();
-   (b) ? PIPE[2].series_2->show() : PIPE[2].series_2->hide();
+   (b) ? PIPE[pipe]->series->show() : PIPE[pipe]->series->hide();
+   (b) ? PIPE[pipe]->series_2->show() : PIPE[pipe]->series_2->hide();
 }
 
 void
@@ -1059,19 +1054,19 @@ onViewYAxisData(const bool isTrue)
 {
     if (ui->radioButton_17->isChecked())
     {
-        for (int pipe=0; pipe<3; pipe++) PIPE[pipe].series->show();
-        for (int pipe=0; pipe<3; pipe++) PIPE[pipe].series_2->show();
+        for (int pipe=0; pipe<PIPE.size(); pipe++) PIPE[pipe]->series->show();
+        for (int pipe=0; pipe<PIPE.size(); pipe++) PIPE[pipe]->series_2->show();
     }
 
     else if (ui->radioButton_18->isChecked())
     {
-        for (int pipe=0; pipe<3; pipe++) PIPE[pipe].series->show();
-        for (int pipe=0; pipe<3; pipe++) PIPE[pipe].series_2->hide();
+        for (int pipe=0; pipe<PIPE.size(); pipe++) PIPE[pipe]->series->show();
+        for (int pipe=0; pipe<PIPE.size(); pipe++) PIPE[pipe]->series_2->hide();
     }
     else
     {
-        for (int pipe=0; pipe<3; pipe++) PIPE[pipe].series->hide();
-        for (int pipe=0; pipe<3; pipe++) PIPE[pipe].series_2->show();
+        for (int pipe=0; pipe<PIPE.size(); pipe++) PIPE[pipe]->series->hide();
+        for (int pipe=0; pipe<PIPE.size(); pipe++) PIPE[pipe]->series_2->show();
     }
 }
 
@@ -1080,9 +1075,7 @@ void
 MainWindow::
 connectLineView()
 {
-    connect(ui->checkBox_19, SIGNAL(clicked(bool)), this, SLOT(toggleLineView_P1(bool)));
-    connect(ui->checkBox_20, SIGNAL(clicked(bool)), this, SLOT(toggleLineView_P2(bool)));
-    connect(ui->checkBox_21, SIGNAL(clicked(bool)), this, SLOT(toggleLineView_P3(bool)));
+    for (int pipe = 0; pipe < PIPE.size(); pipe++) connect(PIPE[pipe]->lineView, &QCheckBox::clicked, [this, pipe](bool b) { toggleLineView(pipe, b); });
 
     connect(ui->radioButton_17, SIGNAL(toggled(bool)), this, SLOT(onViewYAxisData(bool)));
     connect(ui->radioButton_18, SIGNAL(toggled(bool)), this, SLOT(onViewYAxisData(bool)));
@@ -1090,20 +1083,6 @@ connectLineView()
 }
 
 
-void
-MainWindow::
-connectMasterPipe()
-{
-    connect(ui->radioButton_11, SIGNAL(toggled(bool)), this, SLOT(onMasterPipeToggled(bool)));
-}
-
-void
-MainWindow::
-onMasterPipeToggled(const bool isEnabled)
-{
-    (isEnabled) ? LOOP.isMaster = true : LOOP.isMaster = false;
-}
-
 void
 MainWindow::
 readJsonConfigFile()
@@ -1116,35 +1095,51 @@ readJsonConfigFile()
     QJsonObject jsonObj = jsonDoc.object();
     QVariantMap json = jsonObj.toVariantMap();
 
+    CAL_CONFIGS config;
+
+    /// the keys the engine runs on are read where the engine reads them
+    readCalConfig(json, config);
+
     /// file server
-    m_mainServer = json[MAIN_SERVER].toString();
+    m_mainServer = config.mainServer;
     m_localServer = json[LOCAL_SERVER].toString();
 
     /// calibration control variables
-    LOOP.injectionOilPumpRate = json[LOOP_OIL_PUMP_RATE].toDouble();
-    LOOP.injectionWaterPumpRate = json[LOOP_WATER_PUMP_RATE].toDouble();
+    LOOP.injectionOilPumpRate = config.injectionOilPumpRate;
+    LOOP.injectionWaterPumpRate = config.injectionWaterPumpRate;
+    LOOP.minTemp = config.minTemp;
+    LOOP.maxTemp = config.maxTemp;
+    LOOP.injectTemp = config.injectTemp;
+    LOOP.xDelay = config.xDelay;
+    LOOP.yFreq = config.yFreq;
+    LOOP.zTemp = config.zTemp;
+    LOOP.intervalSmallPump = config.intervalSmallPump;
+    LOOP.intervalBigPump = config.intervalBigPump;
+    LOOP.intervalOilPump = config.intervalOilPump;
+    LOOP.loopNumber = config.loopNumber;
+    LOOP.masterMin = config.masterMin;
+    LOOP.masterMax = config.masterMax;
+    LOOP.masterDelta = config.masterDelta;
+    LOOP.masterDeltaFinal = config.masterDeltaFinal;
+    LOOP.maxInjectionWater = config.maxInjectionWater;
+    LOOP.maxInjectionOil = config.maxInjectionOil;
+    LOOP.readGap = config.readGap;
+    LOOP.turnaround = config.turnaround;
+    LOOP.isInjectionTimer = config.isInjectionTimer;
+    LOOP.injection->setTimer((LOOP.isInjectionTimer) ? MODBUS_TIMER_SLAVE : -1);
+    LOOP.stableConfidence = config.stableConfidence;
+    LOOP.isInjectionModel = config.isInjectionModel;
+
+    /// the keys only the GUI uses
     LOOP.injectionSmallWaterPumpRate = json[LOOP_SMALL_WATER_PUMP_RATE].toDouble();
     LOOP.injectionBucket = json[LOOP_BUCKET].toDouble();
     LOOP.injectionMark = json[LOOP_MARK].toDouble();
     LOOP.injectionMethod = json[LOOP_METHOD].toDouble();
     LOOP.pressureSensorSlope = json[LOOP_PRESSURE].toDouble();
-    LOOP.minTemp = json[LOOP_MIN_TEMP].toInt();
-    LOOP.maxTemp = json[LOOP_MAX_TEMP].toInt();
-    LOOP.injectTemp = json[LOOP_INJECTION_TEMP].toInt();
-    LOOP.xDelay = json[LOOP_X_DELAY].toInt();
-    LOOP.yFreq = json[LOOP_Y_FREQ].toDouble();
-    LOOP.zTemp = json[LOOP_Z_TEMP].toDouble();
-    LOOP.intervalSmallPump = json[LOOP_INTERVAL_SMALL_PUMP].toDouble();
-    LOOP.intervalBigPump = json[LOOP_INTERVAL_BIG_PUMP].toDouble();
-    LOOP.intervalOilPump = json[LOOP_INTERVAL_OIL_PUMP].toDouble();
-    LOOP.loopNumber = json[LOOP_NUMBER].toInt();
-    LOOP.masterMin = json[LOOP_MASTER_MIN].toDouble();
-    LOOP.masterMax = json[LOOP_MASTER_MAX].toDouble();
-    LOOP.masterDelta = json[LOOP_MASTER_DELTA].toDouble();
-    LOOP.masterDeltaFinal = json[LOOP_MASTER_DELTA_FINAL].toDouble();
-    LOOP.maxInjectionWater = json[LOOP_MAX_INJECTION_WATER].toInt();
-    LOOP.maxInjectionOil = json[LOOP_MAX_INJECTION_OIL].toInt();
     LOOP.portIndex = json[LOOP_PORT_INDEX].toInt();
+    LOOP.monitorRows = json.contains(LOOP_MONITOR_ROWS) ? json[LOOP_MONITOR_ROWS].toInt() : MONITOR_DEFAULT_ROWS;
+    LOOP.isCapture = json.contains(LOOP_CAPTURE) ? json[LOOP_CAPTURE].toBool() : false;
+    LOOP.pipeCount = json.contains(LOOP_PIPES) ? qBound(1, json[LOOP_PIPES].toInt(), PIPE_MAX_COUNT) : PIPE_DEFAULT_COUNT; /// read by the next start
 
     /// main configuration panel
     ui->lineEdit_27->setText(QString::number(LOOP.injectionOilPumpRate));
@@ -1234,6 +1229,14 @@ writeJsonConfigFile(void)
     json[LOOP_MAX_INJECTION_WATER] = QString::number(LOOP.maxInjectionWater);
     json[LOOP_MAX_INJECTION_OIL] = QString::number(LOOP.maxInjectionOil);
     json[LOOP_PORT_INDEX] = QString::number(LOOP.portIndex);
+    json[LOOP_READ_GAP] = QString::number(LOOP.readGap);
+    json[LOOP_TURNAROUND] = QString::number(LOOP.turnaround);
+    json[LOOP_MONITOR_ROWS] = QString::number(LOOP.monitorRows);
+    json[LOOP_CAPTURE] = LOOP.isCapture;
+    json[LOOP_INJECTION_TIMER] = LOOP.isInjectionTimer;
+    json[LOOP_PIPES] = QString::number(LOOP.pipeCount);
+    json[LOOP_STABLE_CONFIDENCE] = QString::number(LOOP.stableConfidence);
+    json[LOOP_INJECTION_MODEL] = LOOP.isInjectionModel;
 
     /// file server
     json[MAIN_SERVER] = m_mainServer;
@@ -1515,26 +1518,24 @@ write_request(int func, int address, double dval, int ival, bool bval)
     int addr = address - ADDR_OFFSET;
     /////////////////////////////////
 
+    BUS_REPLIES reply;
+
     switch( func )
     {
         case FUNC_WRITE_COIL:
-            modbus_write_bit( LOOP.serialModbus, addr, bval);
+            reply = busWait(LOOP.bus->writeBit(addr, bval));
+            isModbusTransmissionFailed = (reply.rc != 1);
 			break;
         case FUNC_WRITE_INT	:
-            modbus_write_register( LOOP.serialModbus, addr, ival);
+            reply = busWait(LOOP.bus->writeRegister(addr, ival));
+            isModbusTransmissionFailed = (reply.rc != 1);
 			break;
         case FUNC_WRITE_FLOAT:
         {
-            float value;
-            QString qvalue = QString::number(dval);
-            QTextStream floatTextStream(&qvalue);
-            floatTextStream >> value;
-            quint16 (*reg)[2] = reinterpret_cast<quint16(*)[2]>(&value);
-            uint16_t * data = new uint16_t[2];
-            data[0] = (*reg)[1];
-            data[1] = (*reg)[0];
-            modbus_write_registers( LOOP.serialModbus, addr, 2, data );
-            delete[] data;
+            QVector<uint16_t> data(CODEC_WIDE_REGISTERS);
+            DeviceCodec::fromFloat((float) dval, data.data());
+            reply = busWait(LOOP.bus->writeRegisters(addr, data));
+            isModbusTransmissionFailed = (reply.rc != CODEC_WIDE_REGISTERS);
 			break;
         }
         default:
@@ -1551,15 +1552,21 @@ read_request(int func, int address, int num, int ret, uint8_t * dest, uint16_t *
     int addr = address - ADDR_OFFSET;
     /////////////////////////////////
 
+    BUS_REPLIES reply;
+
     switch( func )
     {
         case FUNC_READ_COIL:
-            ret = modbus_read_bits( LOOP.serialModbus, addr, num, dest );
+            reply = busWait(LOOP.bus->readBits(addr, num));
+            ret = reply.rc;
+            for (int i = 0; i < reply.bits.size(); i++) dest[i] = reply.bits[i];
             is16Bit = false;
             break;
 		case FUNC_READ_INT:
 		case FUNC_READ_FLOAT:
-            ret = modbus_read_input_registers(LOOP.serialModbus, addr, num, dest16 );
+            reply = busWait(LOOP.bus->readInputRegisters(addr, num));
+            ret = reply.rc;
+            for (int i = 0; i < reply.regs.size(); i++) dest16[i] = reply.regs[i];
             is16Bit = true;
             break;
         default:
@@ -1570,31 +1577,12 @@ read_request(int func, int address, int num, int ret, uint8_t * dest, uint16_t *
     {
         isModbusTransmissionFailed = false;
 
+        switch( func )
         {
-            QString qs_num;
-            QString qs_output = "0x";
-            bool ok = false;
-            float d;
-
-            for( int i = 0; i < num; ++i )
-            {
-                int data = is16Bit ? dest16[i] : dest[i];
-                QString qs_tmp;
-
-                qs_num.sprintf("%d", data);
-                qs_tmp.sprintf("%04x", data);
-                qs_output.append(qs_tmp);
-
-                if (func == FUNC_READ_INT) return data;
-                else if (func == FUNC_READ_COIL) return (data) ? 1 : 0;
-            }
-
-            if (func == FUNC_READ_FLOAT)
-            {
-                QByteArray array = QByteArray::fromHex(qs_output.toLatin1());
-                d = toFloat(array);
-                return (double) d;
-            }
+            case FUNC_READ_INT: return DeviceCodec::toInt(dest16[0]);
+            case FUNC_READ_COIL: return (DeviceCodec::toCoil(dest[0])) ? 1 : 0;
+            case FUNC_READ_FLOAT: return (double) DeviceCodec::toFloat(dest16);
+            default: return 0;
         }
     }
     else
@@ -1637,52 +1625,42 @@ saveCsvFile()
 }
 
 
-void
-MainWindow::
-onActionStartInjection()
-{
-	updateCurrentStage(ORANGE,INJECT_RUN);
-	LOOP.isInjectionOn = true;
-	LOOP.isTempRunSkip = false;
-    inject(COIL_WATER_PUMP,LOOP.isInjectionOn);
-}
-
+/// the pump off by hand; a running pulse is cut short and the calibration
+/// goes on with what it delivered
 void
 MainWindow::
 onActionStopInjection()
 {
-	if (LOOP.isInjectionOn) updateCurrentStage(BLACK,INJECT_STANDBY);
-	LOOP.isInjectionOn = false;
-    inject(COIL_WATER_PUMP,LOOP.isInjectionOn);
-	LOOP.isTempRunSkip = false;
+    if (m_engine) m_engine->stopInjection();
+    LOOP.injection->abort();
+    inject(COIL_WATER_PUMP,false);
+    inject(COIL_OIL_PUMP,false);
 }
 
 void
 MainWindow::
 onActionSkip()
 {
-	if ((LOOP.runMode != TEMPRUN_MIN) && (LOOP.runMode != TEMPRUN_HIGH) && (LOOP.runMode != TEMPRUN_INJECT)) return;
-	if (isUserInputYes("Skip Current Stage", "Do You Want To Skip and Go To Next Stage?")) LOOP.isTempRunSkip = true;
-	if (LOOP.isPause == true)
-	{
-		ui->actionStart->setVisible(false);
-		ui->actionPause->setVisible(true);
-	
-		LOOP.isPause = false;
-	}
+	if (!m_engine || !isTempRunState(m_calState)) return;
+	if (!isUserInputYes("Skip Current Stage", "Do You Want To Skip and Go To Next Stage?")) return;
+
+	/// a paused run goes on for the skip
+	m_engine->skip();
+	ui->actionStart->setVisible(false);
+	ui->actionPause->setVisible(true);
 }
 
 void
 MainWindow::
 onActionPause()
 {
+	if (!m_engine) return;
+
 	ui->actionStart->setVisible(true);
 	ui->actionPause->setVisible(false);
 
-	LOOP.isPause = true;
-	LOOP.isTempRunSkip = false;
-
-	return;
+	m_engine->pause(true);
+	updateCurrentStage(RED,"PAUSE");
 }
 
 void
@@ -1692,71 +1670,56 @@ onActionStart()
 	ui->actionStart->setVisible(false);
 	ui->actionPause->setVisible(true);
 
+	/// a paused calibration goes on where it was
+	if (m_engine)
+	{
+		m_engine->pause(false);
+		updateCurrentStage(BLACK,m_calStage);
+		return;
+	}
+
 	/// update configuration file with the latest select 
     writeJsonConfigFile();
 
-	/// hide settings screen
-    ui->groupBox_18->hide();
-    ui->groupBox_35->hide();
-    ui->groupBox_34->hide();
-    ui->groupBox_33->hide();
-    ui->groupBox_32->hide();
-    ui->groupBox_31->hide();
-    ui->groupBox_30->hide();
-    ui->groupBox_29->hide();
-
-	/// enable main screen
-    ui->groupBox_12->show();
-    ui->groupBox_20->show();
-
-	/// graph display only
-    ui->tabWidget->setTabEnabled(1,false);
-    ui->tabWidget->setTabEnabled(2,false);
-    ui->tabWidget->setTabEnabled(3,false);
-    ui->tabWidget->setTabEnabled(4,false);
+    /// start calibration
+    startCalibration(false);
+}
 
-    updateLoopTabIcon(true);
+/// a recorded calibration runs again on a virtual clock, the files are
+/// written to the main server
+void
+MainWindow::
+onActionReplay()
+{
+	if (m_engine) return;
 
-    ui->groupBox_13->setEnabled(false);
-    ui->groupBox_11->setEnabled(false);
-    ui->groupBox_113->setEnabled(false);
-    ui->groupBox_114->setEnabled(false);
-    ui->groupBox_5->setEnabled(false);
-    ui->groupBox_9->setEnabled(false);
-    ui->groupBox_10->setEnabled(false);
-    ui->groupBox_6->setEnabled(false);
-    ui->groupBox_65->setEnabled(false);
+	const QString recording = QFileDialog::getExistingDirectory(this, tr("Select The Recorded Calibration"), m_mainServer);
 
-	/// flipping trigger
-    LOOP.isCal = !LOOP.isCal;
+	if (recording.isEmpty()) return;
 
-    if (!LOOP.isCal)
-    {
-        onActionStop();
-        return;
-    }
+	ui->actionStart->setVisible(false);
+	ui->actionPause->setVisible(true);
 
-    /// start calibration
-    startCalibration();
+	writeJsonConfigFile();
+	startCalibration(false, recording);
 }
 
 void
 MainWindow::
 onActionStopPressed()
 {
-	if (LOOP.runMode == STOP_CALIBRATION) return;
-	if (isUserInputYes("Cancel Calibration.", "Do You Want To Cancel?")) onActionStop();
+	if (!m_loops) return;
+	if (isUserInputYes("Cancel Calibration.", "Do You Want To Cancel?")) m_loops->abort();
 }
 
 
+/// back to the settings once the engine has returned
 void
 MainWindow::
 onActionStop()
 {
 	updateCurrentStage(RED,STOP_CALIBRATION);
     updateLoopTabIcon(false);
-	LOOP.isTempRunSkip = false;
-	LOOP.isPause = false;
 
     ui->tabWidget->setTabEnabled(1,true);
     ui->tabWidget->setTabEnabled(2,true);
@@ -1776,8 +1739,6 @@ onActionStop()
 	ui->actionStart->setVisible(true);
 	ui->actionPause->setVisible(false);
 
-    if (LOOP.isInjectionOn) onActionStopInjection();
-
     stopCalibration();
 
 	displayPipeReading(ALL,0,0,0,0,0);
@@ -1788,10 +1749,11 @@ void
 MainWindow::
 onActionReadMasterPipe()
 {
+	if (m_engine && !m_engine->isPaused()) return;
+
 	updateCurrentStage(BLACK,READ_MASTERPIPE);
-	if (!LOOP.isCal) readMasterPipe();
-	else if (LOOP.isPause) readMasterPipe();
-	updateCurrentStage(RED,STOP_CALIBRATION);
+	readMasterPipe();
+	updateCurrentStage(RED,(m_engine) ? "PAUSE" : STOP_CALIBRATION);
 }
 
 void
@@ -1804,7 +1766,7 @@ onActionSync()
 		return;
 	}
 
-    if (PIPE[0].slave->text().isEmpty() && PIPE[1].slave->text().isEmpty() && PIPE[2].slave->text().isEmpty()) 
+    if (!isSerialNumberEntered())
 	{
 		informUser(QString("LOOP ")+QString::number(LOOP.loopNumber),QString("LOOP ")+QString::number(LOOP.loopNumber).append(BLANK),"No Valid Serial Number Found!");
 		return;
@@ -1816,78 +1778,35 @@ onActionSync()
 		return;
 	}
 
-	for (int pipe=0; pipe<3; pipe++)
-    {
-        if (!PIPE[pipe].slave->text().isEmpty())
-		{
-			int sn;
-			double temp, fctAdjTemp, masterTemp;
-            uint8_t dest[1024];
-            uint16_t * dest16 = (uint16_t *) dest;
-            int ret = -1;
-            bool is16Bit = false;
-            bool writeAccess = false;
-            //const QString funcType = descriptiveDataTypeName( FUNC_READ_INT );
-
-            /// set slave
-            memset( dest, 0, 1024 );
-            modbus_set_slave( LOOP.serialModbus, PIPE[pipe].slave->text().toInt());
-
-            /// read pipe serial number
-   			sn = read_request(FUNC_READ_INT, RAZ_ID_SN_PIPE, BYTE_READ_INT, ret, dest, dest16, is16Bit);
-			delay();
-
-			//if (ui->lineEdit_111->text() != PIPE[pipe].slave->text())
-			if (QString::number(sn) != PIPE[pipe].slave->text())
-            {
-        		informUser(QString("LOOP ")+QString::number(LOOP.loopNumber),QString("LOOP ")+QString::number(LOOP.loopNumber).append(BLANK),"Invalid Seial Number!");
-				onActionStop();
-                return;
-            }
+    TempSync sync(LOOP.bus);
+    QVector<int> pipes;
+    QStringList report;
 
-			updateCurrentStage(BLACK,TEMP_IN_SYNC);
+    for (int pipe = 0; pipe < PIPE.size(); pipe++)
+    {
+        if (PIPE[pipe]->slave->text().isEmpty()) continue;
 
-			/// get master temp
-			masterTemp = ui->lineEdit_29->text().toDouble();
+        pipes << pipe;
+        sync.addPipe(PIPE[pipe]->slave->text().toInt());
+    }
 
-			/// get target temp
-   			temp = read_request(FUNC_READ_FLOAT, RAZ_ID_TEMPERATURE, BYTE_READ_FLOAT, ret, dest, dest16, is16Bit);
-			delay();
-   			while (temp != temp) 
-			{
-				temp = read_request(FUNC_READ_FLOAT, RAZ_ID_TEMPERATURE, BYTE_READ_FLOAT, ret, dest, dest16, is16Bit);
-				delay();
-			}
+	updateCurrentStage(BLACK,TEMP_IN_SYNC);
 
-			/// get PDI_TEMP_ADJ
-			fctAdjTemp = read_request(FUNC_READ_FLOAT, FCT_RAZ_TEMP_ADJ, BYTE_READ_FLOAT, ret, dest, dest16, is16Bit);
-			delay();
-			while (fctAdjTemp != fctAdjTemp) 
-			{
-				fctAdjTemp = read_request(FUNC_READ_FLOAT, FCT_RAZ_TEMP_ADJ, BYTE_READ_FLOAT, ret, dest, dest16, is16Bit);
-				delay();
-			}
+    /// every pipe against the master temperature at once
+    const bool isOk = sync.run(ui->lineEdit_29->text().toDouble());
 
-			/// unlock fct
-			write_request(FUNC_WRITE_COIL, 999, 0, 0, true);
-			delay();
+    for (int i = 0; i < pipes.size(); i++)
+    {
+        const SYNC_PIPES & p = sync.pipes().at(i);
 
-			/// update PDI_TEMP_ADJ
-			while (abs(temp-masterTemp) > 0.1)
-			{
-				write_request(FUNC_WRITE_FLOAT, FCT_RAZ_TEMP_ADJ, fctAdjTemp + masterTemp - temp, 0, true);
-				delay();
+		/// display final temp
+        if (p.isReady) PIPE[pipes.at(i)]->temp->setText(QString::number(p.temperature));
 
-   				temp = read_request(FUNC_READ_FLOAT, RAZ_ID_TEMPERATURE, BYTE_READ_FLOAT, ret, dest, dest16, is16Bit);
-				delay();
+        report << QString("%1 SN%2: %3 after %4 s, residual %5 °C, %6 steps").arg(PIPE[pipes.at(i)]->pipeId).arg(p.slave).arg(TempSync::statusText(p.status)).arg(p.elapsed/1000.0, 0, 'f', 1).arg(p.residual, 0, 'f', 3).arg(p.iterations);
+    }
 
-			}
+	informUser(QString("LOOP ")+QString::number(LOOP.loopNumber), (isOk) ? "Temperature In Sync" : "Temperature Sync Incomplete", report.join("\n"));
 
-			/// display final temp
-			PIPE[pipe].temp->setText(QString::number(temp));
-		}
-	}
-			
 	updateCurrentStage(RED,STOP_CALIBRATION);
 }
 
@@ -2044,6 +1963,15 @@ onEquationButtonPressed()
             onUploadEquation();
         }
     }
+    else if (ui->radioButton_194->isChecked())
+    {
+        if( m_pollTimer->isActive() )
+        {
+            m_pollTimer->stop();
+            ui->startEquationBtn->setText( tr("Loading") );
+        }
+        else onSyncEquation();
+    }
     else
     {
         if( m_pollTimer->isActive() )
@@ -2104,16 +2032,14 @@ onUploadEquation()
 
 	int value = 0;
     int rangeMax = 0;
-    QMessageBox msgBox;
     isModbusTransmissionFailed = false;
 
    	/// set slave
    	memset( dest, 0, 1024 );
-   	modbus_set_slave( LOOP.serialModbus, ui->lineEdit_32->text().toInt());
+   	LOOP.bus->setSlave(ui->lineEdit_32->text().toInt());
 
 	/// read pipe serial number
    	int sn = read_request(FUNC_READ_INT, RAZ_ID_SN_PIPE, BYTE_READ_INT, ret, dest, dest16, is16Bit);
-	delay();
 
 	if (QString::number(sn) != ui->lineEdit_32->text())
     {
@@ -2121,133 +2047,306 @@ onUploadEquation()
         return;
     }
 
-    /// get rangeMax of progressDialog
-    for (int i = 0; i < ui->tableWidget->rowCount(); i++) rangeMax+=ui->tableWidget->item(i,6)->text().toInt();
+    WritePlanner planner;
+    QVector<int> coilRows;
+
+    planProfileWrite(planner, coilRows);
+
+    /// progress in bytes of payload, one byte per coil
+    rangeMax = planner.registers()*2 + coilRows.size();
 
     QProgressDialog progress("Uploading...", "Abort", 0, rangeMax, this);
     progress.setWindowModality(Qt::WindowModal);
     progress.setAutoClose(true);
     progress.setAutoReset(true);
 
-	/// unlcok FCT
-	write_request(FUNC_WRITE_COIL, 999, 0, 0, true);
-    delay();
+    if (!executeProfileWrite(planner, coilRows, progress, value)) return;
 
-    if (isModbusTransmissionFailed)
-    {
-        isModbusTransmissionFailed = false;
-        msgBox.setText("Modbus Transmission Failed.");
-        msgBox.setInformativeText("Do you want to continue with next item?");
-        msgBox.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
-        msgBox.setDefaultButton(QMessageBox::No);
-        int ret = msgBox.exec();
-        switch (ret) {
-            case QMessageBox::Yes:
-                break;
-            case QMessageBox::No:
-            default: return;
-        }
-    }
+    progress.setValue(rangeMax);
 
-   for (int i = 0; i < ui->tableWidget->rowCount(); i++)
-   {
-        int regAddr = ui->tableWidget->item(i,2)->text().toInt();
-        if (ui->tableWidget->item(i,3)->text().contains("float"))
-        {
-            for (int x=0; x < ui->tableWidget->item(i,6)->text().toInt(); x++)
-            {
-                QString val = ui->tableWidget->item(i,7+x)->text(); // read value
-                if (progress.wasCanceled()) return;
-                if (ui->tableWidget->item(i,6)->text().toInt() > 1) progress.setLabelText("Uploading \""+ui->tableWidget->item(i,0)->text()+"["+QString::number(x+1)+"]"+"\""+","+" \""+val+"\"");
-                else progress.setLabelText("Uploading \""+ui->tableWidget->item(i,0)->text()+"\""+","+" \""+val+"\"");
-                progress.setValue(value++);
-
-				/// send modbus request
-				write_request(FUNC_WRITE_FLOAT, regAddr, val.toInt(), 0, true);
-                delay();
-                regAddr += 2; // update reg address
-
-                if (isModbusTransmissionFailed)
-                {
-                    isModbusTransmissionFailed = false;
-                    if (ui->tableWidget->item(i,6)->text().toInt() > 1) msgBox.setText("Modbus Transmission Failed: "+ui->tableWidget->item(i,0)->text()+"["+QString::number(x+1)+"]");
-                    else msgBox.setText("Modbus Transmission Failed: "+ui->tableWidget->item(i,0)->text());
-                    msgBox.setInformativeText("Do you want to continue with next item?");
-                    msgBox.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
-                    msgBox.setDefaultButton(QMessageBox::No);
-                    int ret = msgBox.exec();
-                    switch (ret) {
-                        case QMessageBox::Yes: break;
-                        case QMessageBox::No:
-                        default: return;
-                    }
-                }
-            }
-        }
-        else if (ui->tableWidget->item(i,3)->text().contains("int"))
+	write_request(FUNC_WRITE_COIL, 999, 0, 0, true); // COIL_UNLOCKED_FACTORY_DEFAULT 
+	write_request(FUNC_WRITE_COIL, 9999, 0, 0, true); // COIL_UPDATE_FACTORY_DEFAULT 
+}
+
+
+void
+MainWindow::
+onSyncEquation()
+{
+	if (ui->lineEdit_32->text().isEmpty()) 
+	{
+       	informUser("SLAVE ID MISSING","No Slave ID                ","No Valid Slave ID Exists!");
+		return;
+	}
+
+   	uint8_t dest[1024];
+   	uint16_t * dest16 = (uint16_t *) dest;
+   	int ret = -1;
+   	bool is16Bit = false;
+
+	int value = 0;
+    isModbusTransmissionFailed = false;
+
+   	/// set slave
+   	memset( dest, 0, 1024 );
+   	LOOP.bus->setSlave(ui->lineEdit_32->text().toInt());
+
+	/// read pipe serial number
+   	int sn = read_request(FUNC_READ_INT, RAZ_ID_SN_PIPE, BYTE_READ_INT, ret, dest, dest16, is16Bit);
+
+	if (QString::number(sn) != ui->lineEdit_32->text())
+    {
+   		informUser("Invalid Serial Number","Invalid Serial Number",ui->lineEdit_32->text());
+        return;
+    }
+
+    ReadPlanner device(0);
+    WritePlanner profile;
+    WritePlanner changed;
+    QVector<int> readCoilRows;
+    QVector<int> coilRows;
+    QVector<int> changedCoilRows;
+
+    planProfileRead(device, readCoilRows);
+    planProfileWrite(profile, coilRows);
+
+    QProgressDialog progress("Comparing...", "Abort", 0, device.registers()*2 + coilRows.size(), this);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setAutoClose(true);
+    progress.setAutoReset(true);
+
+    /// what the device holds now
+    if (!executeProfileRead(device, progress, value)) return;
+
+    /// keep only the values that differ
+    for (int i = 0; i < profile.items().size(); i++)
+    {
+        const WRITE_ITEMS & item = profile.items()[i];
+        QVector<uint16_t> current(item.regs.size());
+
+        if (device.fetch(item.address, current.size(), current.data()) && (current == item.regs)) continue;
+
+        changed.addRegisters(item.address, item.regs.constData(), item.regs.size(), item.tag);
+    }
+
+    for (int c = 0; c < coilRows.size(); c++)
+    {
+        const int i = coilRows[c];
+        const bool val = (ui->tableWidget->item(i,7)->text().toInt() != 0);
+
+        if (progress.wasCanceled()) return;
+        progress.setValue(value++);
+
+        const bool current = read_request(FUNC_READ_COIL, ui->tableWidget->item(i,2)->text().toInt(), BYTE_READ_COIL, ret, dest, dest16, is16Bit);
+
+        if (isModbusTransmissionFailed || (current != val)) changedCoilRows.append(i);
+        isModbusTransmissionFailed = false;
+    }
+
+    changed.plan();
+
+    if ((changed.registers() == 0) && changedCoilRows.isEmpty())
+    {
+        progress.setValue(progress.maximum());
+        informUser("Sync","Device already matches the profile",ui->lineEdit_32->text());
+        return;
+    }
+
+    /// write the difference, coalesced the same way as a full upload
+    progress.setLabelText("Uploading...");
+    progress.setMaximum(value + changed.registers()*2 + changedCoilRows.size());
+
+    if (!executeProfileWrite(changed, changedCoilRows, progress, value)) return;
+
+    progress.setValue(progress.maximum());
+
+	write_request(FUNC_WRITE_COIL, 999, 0, 0, true); // COIL_UNLOCKED_FACTORY_DEFAULT 
+	write_request(FUNC_WRITE_COIL, 9999, 0, 0, true); // COIL_UPDATE_FACTORY_DEFAULT 
+}
+
+
+void
+MainWindow::
+onBatchEquation()
+{
+    QString fileName = QFileDialog::getOpenFileName( this, tr("Open Batch Job List"), QDir::currentPath(), tr("CSV files (*.csv)") );
+
+    if (fileName.isEmpty()) return;
+
+    ProfileStation station;
+    char parity;
+
+    switch( ui->comboBox_3->currentIndex() )
+    {
+        case 1: parity = 'O'; break;
+        case 2: parity = 'E'; break;
+        default:
+        case 0: parity = 'N'; break;
+    }
+
+    station.setSerial(ui->comboBox_2->currentText().toInt(), parity, ui->comboBox_4->currentText().toInt(), ui->comboBox_5->currentText().toInt());
+
+    if (!station.loadJobs(fileName))
+    {
+        informUser("Batch Programming","No Valid Job Found",fileName);
+        return;
+    }
+
+    /// the adapters are handed to the station for the duration of the batch
+    const bool isLoopOpen = LOOP.bus->isOpen();
+    if (isLoopOpen) releaseSerialModbus();
+
+    QProgressDialog progress("Programming...", "Abort", 0, 1, this);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setAutoClose(false);
+    progress.setAutoReset(false);
+
+    QEventLoop loop;
+    int finished = 0;
+
+    connect(&station, &ProfileStation::progress, &progress, [&progress](int done, int total)
+    {
+        progress.setMaximum(qMax(total, 1));
+        progress.setValue(done);
+    });
+    connect(&station, &ProfileStation::jobFinished, &progress, [&progress, &finished, &station](int)
+    {
+        progress.setLabelText("Programming... "+QString::number(++finished)+" of "+QString::number(station.jobs().size())+" finished");
+    });
+    connect(&progress, &QProgressDialog::canceled, &station, &ProfileStation::abort);
+    connect(&station, &ProfileStation::finished, &loop, &QEventLoop::quit);
+
+    station.start();
+    if (station.isRunning()) loop.exec();
+    progress.close();
+
+    if (isLoopOpen) changeSerialPort(ui->comboBox->currentIndex());
+
+    QStringList report;
+    int passed = 0;
+
+    for (int i = 0; i < station.jobs().size(); i++)
+    {
+        const PROFILE_JOBS & job = station.jobs()[i];
+
+        if (job.status == STATION_DONE) passed++;
+        report.append(QString::number(job.serial)+" @ "+job.port+(job.isVerify ? " verify: " : " upload: ")+ProfileStation::statusText(job.status));
+    }
+
+    informUser("Batch Programming",QString::number(passed)+" of "+QString::number(station.jobs().size())+" Jobs Done",report.join("\n"));
+}
+
+
+void
+MainWindow::
+planProfileWrite(WritePlanner & planner, QVector<int> & coilRows)
+{
+    /// same row rules as a batch job's profile
+    for (int i = 0; i < ui->tableWidget->rowCount(); i++)
+    {
+        QStringList cells;
+
+        for (int j = 0; j < ui->tableWidget->columnCount(); j++)
         {
-            QString val = ui->tableWidget->item(i,7)->text(); // read value
+            const QTableWidgetItem * item = ui->tableWidget->item(i,j);
 
-            if (progress.wasCanceled()) return;
-            progress.setLabelText("Uploading \""+ui->tableWidget->item(i,0)->text()+"\""+","+" \""+val+"\"");
-            progress.setValue(value++);
+            if (item == NULL) break;
+            cells.append(item->text());
+        }
 
-			/// send modbus request
-			write_request(FUNC_WRITE_INT, regAddr, 0, val.toInt(), true);
-            delay();
+        if (ProfileStation::planRow(cells, i, planner) == PROFILE_ROW_COIL) coilRows.append(i);
+    }
 
-            if (isModbusTransmissionFailed)
-            {
-                isModbusTransmissionFailed = false;
-                msgBox.setText("Modbus Transmission Failed: "+ui->tableWidget->item(i,0)->text());
-                msgBox.setInformativeText("Do you want to continue with next item?");
-                msgBox.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
-                msgBox.setDefaultButton(QMessageBox::No);
-                int ret = msgBox.exec();
-                switch (ret) {
-                    case QMessageBox::Yes: break;
-                    case QMessageBox::No:
-                    default: return;
-                }
-            }
+    planner.plan();
+}
+
+
+bool
+MainWindow::
+executeProfileWrite(const WritePlanner & planner, const QVector<int> & coilRows, QProgressDialog & progress, int & value)
+{
+    QMessageBox msgBox;
+
+	/// unlcok FCT
+	write_request(FUNC_WRITE_COIL, 999, 0, 0, true);
+
+    if (isModbusTransmissionFailed)
+    {
+        isModbusTransmissionFailed = false;
+        msgBox.setText("Modbus Transmission Failed.");
+        msgBox.setInformativeText("Do you want to continue with next item?");
+        msgBox.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
+        msgBox.setDefaultButton(QMessageBox::No);
+        int ret = msgBox.exec();
+        switch (ret) {
+            case QMessageBox::Yes:
+                break;
+            case QMessageBox::No:
+            default: return false;
         }
-        else
+    }
+
+    for (int s = 0; s < planner.spans().size(); s++)
+    {
+        const WRITE_SPANS & span = planner.spans()[s];
+        const QVector<int> rows = planner.tags(span);
+        QStringList names;
+
+        for (int r = 0; r < rows.size(); r++) names.append(ui->tableWidget->item(rows[r],0)->text());
+
+        if (progress.wasCanceled()) return false;
+        progress.setLabelText("Uploading \""+names.join("\", \"")+"\"");
+        progress.setValue(value);
+
+        /// send modbus request
+        BUS_REPLIES reply = busWait(LOOP.bus->writeRegisters(span.address, span.regs));
+        value += span.regs.size()*2;
+
+        if (reply.rc != span.regs.size())
         {
-			bool val;
-			(ui->tableWidget->item(i,7)->text().toInt()) ? val = true : val = false; // read value
+            msgBox.setText("Modbus Transmission Failed: "+names.join(", "));
+            msgBox.setInformativeText("Do you want to continue with next item?");
+            msgBox.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
+            msgBox.setDefaultButton(QMessageBox::No);
+            int ret = msgBox.exec();
+            switch (ret) {
+                case QMessageBox::Yes: break;
+                case QMessageBox::No:
+                default: return false;
+            }
+        }
+    }
 
-            progress.setLabelText("Uploading \""+ui->tableWidget->item(i,0)->text()+"\""+","+"\""+val+"\"");
-            //if (val) progress.setLabelText("Uploading \""+ui->tableWidget->item(i,0)->text()+"\""+","+"\""+val+"\"");
-            //else progress.setLabelText("Uploading \""+ui->tableWidget->item(i,0)->text()+"\""+","+" \"0\"");
+    for (int c = 0; c < coilRows.size(); c++)
+    {
+        const int i = coilRows[c];
+        const int regAddr = ui->tableWidget->item(i,2)->text().toInt();
+        const bool val = (ui->tableWidget->item(i,7)->text().toInt() != 0); // read value
 
-            if (progress.wasCanceled()) return;
-            progress.setValue(value++);
+        if (progress.wasCanceled()) return false;
+        progress.setLabelText("Uploading \""+ui->tableWidget->item(i,0)->text()+"\""+","+" \""+QString::number(val)+"\"");
+        progress.setValue(value++);
 
-			/// send modbus request
-			write_request(FUNC_WRITE_COIL, regAddr, 0, 0, val);
-            delay();
+        /// send modbus request
+        write_request(FUNC_WRITE_COIL, regAddr, 0, 0, val);
 
-            if (isModbusTransmissionFailed)
-            {
-                isModbusTransmissionFailed = false;
-                msgBox.setText("Modbus Transmission Failed: "+ui->tableWidget->item(i,0)->text());
-                msgBox.setInformativeText("Do you want to continue with next item?");
-                msgBox.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
-                msgBox.setDefaultButton(QMessageBox::No);
-                int ret = msgBox.exec();
-                switch (ret) {
-                    case QMessageBox::Yes: break;
-                    case QMessageBox::No:
-                    default: return;
-                }
+        if (isModbusTransmissionFailed)
+        {
+            isModbusTransmissionFailed = false;
+            msgBox.setText("Modbus Transmission Failed: "+ui->tableWidget->item(i,0)->text());
+            msgBox.setInformativeText("Do you want to continue with next item?");
+            msgBox.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
+            msgBox.setDefaultButton(QMessageBox::No);
+            int ret = msgBox.exec();
+            switch (ret) {
+                case QMessageBox::Yes: break;
+                case QMessageBox::No:
+                default: return false;
             }
         }
     }
 
-	write_request(FUNC_WRITE_COIL, 999, 0, 0, true); // COIL_UNLOCKED_FACTORY_DEFAULT 
-	delay();
-	write_request(FUNC_WRITE_COIL, 9999, 0, 0, true); // COIL_UPDATE_FACTORY_DEFAULT 
-	delay();
+    return true;
 }
 
 
@@ -2268,18 +2367,16 @@ onDownloadEquation()
    	bool writeAccess = false;
     int value = 0;
     int rangeMax = 0;
-	char lcdModelCode[] = "INCDYNAMICSPHASE";
 
     QMessageBox msgBox;
     isModbusTransmissionFailed = false;
 
    	/// set slave
    	memset( dest, 0, 1024 );
-   	modbus_set_slave( LOOP.serialModbus, ui->lineEdit_32->text().toInt());
+   	LOOP.bus->setSlave(ui->lineEdit_32->text().toInt());
 
 	/// read pipe serial number
    	int sn = read_request(FUNC_READ_INT, RAZ_ID_SN_PIPE, BYTE_READ_INT, ret, dest, dest16, is16Bit);
-	delay();
 
 	if (QString::number(sn) != ui->lineEdit_32->text())
     {
@@ -2290,129 +2387,181 @@ onDownloadEquation()
     // load empty equation file
     loadCsvTemplate();
 
-    /// get rangeMax of progressDialog
-    for (int i = 0; i < ui->tableWidget->rowCount(); i++) rangeMax+=ui->tableWidget->item(i,6)->text().toInt();
+    ReadPlanner planner(0);
+    QVector<int> coilRows;
+
+    /// one plan over the whole template, contiguous rows share a frame
+    planProfileRead(planner, coilRows);
+
+    /// progress in bytes of payload, one byte per coil
+    rangeMax = planner.registers()*2 + coilRows.size();
 
     QProgressDialog progress("Downloading...", "Abort", 0, rangeMax, this);
     progress.setWindowModality(Qt::WindowModal);
     progress.setAutoClose(true);
     progress.setAutoReset(true);
 
-    for (int i = 0; i < ui->tableWidget->rowCount(); i++)
+    if (!executeProfileRead(planner, progress, value)) return;
+
+    /// decode everything that arrived
+    showProfileRead(planner);
+
+    for (int c = 0; c < coilRows.size(); c++)
     {
-		int regAddr = ui->tableWidget->item(i,2)->text().toInt();
-		is16Bit = false;
+        const int i = coilRows[c];
+        const int regAddr = ui->tableWidget->item(i,2)->text().toInt();
 
-        if (ui->tableWidget->item(i,3)->text().contains("float"))
+        if (progress.wasCanceled()) return;
+        progress.setLabelText("Downloading \""+ui->tableWidget->item(i,0)->text()+"\"");
+        progress.setValue(value++);
+
+		bool val = read_request(FUNC_READ_COIL, regAddr, BYTE_READ_COIL, ret, dest, dest16, is16Bit);
+		while (isModbusTransmissionFailed)
         {
-            for (int x=0; x < ui->tableWidget->item(i,6)->text().toInt(); x++)
-            {
-				is16Bit = true;
-                if (progress.wasCanceled()) return;
-                if (ui->tableWidget->item(i,6)->text().toInt() > 1) progress.setLabelText("Downloading \""+ui->tableWidget->item(i,0)->text()+"\" "+QString::number(x+1));
-                else progress.setLabelText("Downloading \""+ui->tableWidget->item(i,0)->text()+"\"");
-                progress.setValue(value++);
-  				double val = read_request(FUNC_READ_FLOAT, regAddr, BYTE_READ_FLOAT, ret, dest, dest16, is16Bit);
-                delay();
-				if (isModbusTransmissionFailed)
-                {
-                    isModbusTransmissionFailed = false;
-                    if (ui->tableWidget->item(i,6)->text().toInt() > 1) msgBox.setText("Modbus Transmission Failed: "+ui->tableWidget->item(i,0)->text()+"["+QString::number(x+1)+"]");
-                    else msgBox.setText("Modbus Transmission Failed: "+ui->tableWidget->item(i,0)->text());
-                    msgBox.setInformativeText("Do you want to read again?");
-                    msgBox.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
-                    msgBox.setDefaultButton(QMessageBox::No);
-                    int ret = msgBox.exec();
-                    switch (ret) {
-                        case QMessageBox::Yes: 
-							x--;
-							break;
-                        case QMessageBox::No:
-                        default: return;
-                    }
-                }
-				else
-				{
-					ui->tableWidget->item(i, x+7)->setText(QString("%1").arg(val,10,'f',4,' '));
-            		regAddr += 2; // update reg address
-				}
+           	isModbusTransmissionFailed = false;
+            msgBox.setText("Modbus Transmission Failed: "+ui->tableWidget->item(i,0)->text());
+            msgBox.setInformativeText("Do you want to read again?");
+            msgBox.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
+            msgBox.setDefaultButton(QMessageBox::No);
+            int ret = msgBox.exec();
+            switch (ret) {
+                case QMessageBox::Yes: 
+					val = read_request(FUNC_READ_COIL, regAddr, BYTE_READ_COIL, ret, dest, dest16, is16Bit);
+					break;
+                case QMessageBox::No:
+                default: return;
             }
         }
-        else if (ui->tableWidget->item(i,3)->text().contains("int") || ui->tableWidget->item(i,3)->text().contains("long") )
+
+		ui->tableWidget->item(i, 7)->setText(QString::number(val));
+	}
+
+    progress.setValue(rangeMax);
+}
+
+
+void
+MainWindow::
+planProfileRead(ReadPlanner & planner, QVector<int> & coilRows)
+{
+    for (int i = 0; i < ui->tableWidget->rowCount(); i++)
+    {
+        const int regAddr = ui->tableWidget->item(i,2)->text().toInt() - ADDR_OFFSET;
+        const QString type = ui->tableWidget->item(i,3)->text();
+
+        if (type.contains("float")) planner.addRegisters(regAddr, ui->tableWidget->item(i,6)->text().toInt()*CODEC_WIDE_REGISTERS, i);
+        else if (regAddr == RAZ_MODEL_CODE - ADDR_OFFSET) planner.addRegisters(regAddr, MODEL_CODE_REGISTERS, i);
+        else if (type.contains("long")) planner.addRegisters(regAddr, CODEC_WIDE_REGISTERS, i);
+        else if (type.contains("int")) planner.addRegisters(regAddr, 1, i);
+        else coilRows.append(i);
+    }
+
+    planner.plan();
+}
+
+
+bool
+MainWindow::
+executeProfileRead(ReadPlanner & planner, QProgressDialog & progress, int & value)
+{
+    QMessageBox msgBox;
+    bool isRetry = false;
+
+    do
+    {
+        for (int s = 0; s < planner.spans().size(); s++)
         {
-            if (progress.wasCanceled()) return;
-            progress.setLabelText("Downloading \""+ui->tableWidget->item(i,0)->text()+"\"");
-            progress.setValue(value++);
+            /// first pass reads everything, later passes only what failed
+            if (isRetry && !planner.spans()[s].isFailed) continue;
+            if (progress.wasCanceled()) return false;
 
-			quint32 val; 
+            progress.setLabelText("Downloading \""+ui->tableWidget->item(planner.tags(planner.spans()[s]).first(),0)->text()+"\"");
+            progress.setValue(value);
 
-			if (regAddr == 219)
-			{
-    			for (int k=0;k<4;k++)
-    			{
-					val = read_request(FUNC_READ_INT, regAddr+k, BYTE_READ_INT, ret, dest, dest16, is16Bit);
-				    for (int j=0; j<4; j++) lcdModelCode[k*4+j] = (val >> j*8) & 0xFF;
-    			}
-			}		
-			else
-			{
-				if (ui->tableWidget->item(i,3)->text().contains("int")) val = read_request(FUNC_READ_INT, regAddr, BYTE_READ_INT, ret, dest, dest16, is16Bit);
-				else val = read_request(FUNC_READ_INT, regAddr, BYTE_READ_FLOAT, ret, dest, dest16, is16Bit);
-			}
+            busWait(LOOP.bus->submit<bool>([&planner, s](modbus_t * modbus) { return planner.execute(modbus, s); }));
 
-            delay();
+            if (!isRetry) value += planner.spans()[s].count*2;
+        }
+
+        if (planner.failed() == 0) return true;
 
-			while (isModbusTransmissionFailed)
+        QStringList names;
+
+        for (int s = 0; s < planner.spans().size(); s++)
+        {
+            if (!planner.spans()[s].isFailed) continue;
+
+            const QVector<int> rows = planner.tags(planner.spans()[s]);
+            for (int r = 0; r < rows.size(); r++) names.append(ui->tableWidget->item(rows[r],0)->text());
+        }
+
+        msgBox.setText("Modbus Transmission Failed: "+names.join(", "));
+        msgBox.setInformativeText("Do you want to read again?");
+        msgBox.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
+        msgBox.setDefaultButton(QMessageBox::No);
+        int ret = msgBox.exec();
+        switch (ret) {
+            case QMessageBox::Yes: 
+                isRetry = true;
+                break;
+            case QMessageBox::No:
+            default: return false;
+        }
+
+    } while (true);
+}
+
+
+void
+MainWindow::
+showProfileRead(const ReadPlanner & planner)
+{
+    uint16_t regs[PLANNER_MAX_REGISTERS];
+
+    for (int i = 0; i < ui->tableWidget->rowCount(); i++)
+    {
+        const int regAddr = ui->tableWidget->item(i,2)->text().toInt() - ADDR_OFFSET;
+        const QString type = ui->tableWidget->item(i,3)->text();
+
+        if (type.contains("float"))
+        {
+            const int count = ui->tableWidget->item(i,6)->text().toInt();
+            float values[PLANNER_MAX_REGISTERS/CODEC_WIDE_REGISTERS];
+
+            /// long arrays arrive in frame sized pieces
+            for (int done = 0; done < count; done += PLANNER_MAX_REGISTERS/CODEC_WIDE_REGISTERS)
             {
-            	isModbusTransmissionFailed = false;
-                msgBox.setText("Modbus Transmission Failed: "+ui->tableWidget->item(i,0)->text());
-                msgBox.setInformativeText("Do you want to read again?");
-                msgBox.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
-                msgBox.setDefaultButton(QMessageBox::No);
-                int ret = msgBox.exec();
-                switch (ret) {
-                    case QMessageBox::Yes: 
-						if (ui->tableWidget->item(i,3)->text().contains("int")) val = read_request(FUNC_READ_INT, regAddr, BYTE_READ_INT, ret, dest, dest16, is16Bit);
-						else val = read_request(FUNC_READ_INT, regAddr, BYTE_READ_FLOAT, ret, dest, dest16, is16Bit);
-            			delay();
-						break;
-                    case QMessageBox::No:
-                    default: return;
-                }
-            }
+                const int n = qMin(PLANNER_MAX_REGISTERS/CODEC_WIDE_REGISTERS, count - done);
+
+                if (!planner.fetch(regAddr + done*CODEC_WIDE_REGISTERS, n*CODEC_WIDE_REGISTERS, regs)) continue;
 
-			if (regAddr == 219) ui->tableWidget->item(i, 7)->setText(QString::fromUtf8(lcdModelCode, 16));
-			else ui->tableWidget->item(i, 7)->setText(QString::number(val));
+                DeviceCodec::toFloats(regs, values, n);
+                for (int x = 0; x < n; x++) ui->tableWidget->item(i, done+x+7)->setText(QString("%1").arg(values[x],10,'f',4,' '));
+            }
         }
-        else
+        else if (regAddr == RAZ_MODEL_CODE - ADDR_OFFSET)
         {
-            if (progress.wasCanceled()) return;
-            progress.setLabelText("Downloading \""+ui->tableWidget->item(i,0)->text()+"\"");
-            progress.setValue(value++);
+            char lcdModelCode[] = "INCDYNAMICSPHASE";
 
-			bool val = read_request(FUNC_READ_COIL, regAddr, BYTE_READ_COIL, ret, dest, dest16, is16Bit);
-            delay();
-			while (isModbusTransmissionFailed)
+            if (!planner.fetch(regAddr, MODEL_CODE_REGISTERS, regs)) continue;
+
+            /// same byte layout the single register reads produced
+            for (int k = 0; k < MODEL_CODE_REGISTERS; k++)
             {
-            	isModbusTransmissionFailed = false;
-                msgBox.setText("Modbus Transmission Failed: "+ui->tableWidget->item(i,0)->text());
-                msgBox.setInformativeText("Do you want to read again?");
-                msgBox.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
-                msgBox.setDefaultButton(QMessageBox::No);
-                int ret = msgBox.exec();
-                switch (ret) {
-                    case QMessageBox::Yes: 
-						val = read_request(FUNC_READ_COIL, regAddr, BYTE_READ_COIL, ret, dest, dest16, is16Bit);
-            			delay();
-						break;
-                    case QMessageBox::No:
-                    default: return;
-                }
+                for (int j = 0; j < MODEL_CODE_LENGTH/MODEL_CODE_REGISTERS; j++) lcdModelCode[k*4+j] = ((quint32) regs[k] >> j*8) & 0xFF;
             }
 
-			ui->tableWidget->item(i, 7)->setText(QString::number(val));
+            ui->tableWidget->item(i, 7)->setText(QString::fromUtf8(lcdModelCode, MODEL_CODE_LENGTH));
         }
-	}
+        else if (type.contains("long"))
+        {
+            if (planner.fetch(regAddr, CODEC_WIDE_REGISTERS, regs)) ui->tableWidget->item(i, 7)->setText(QString::number(DeviceCodec::toInt32(regs)));
+        }
+        else if (type.contains("int"))
+        {
+            if (planner.fetch(regAddr, 1, regs)) ui->tableWidget->item(i, 7)->setText(QString::number(DeviceCodec::toInt(regs[0])));
+        }
+    }
 }
 
 
@@ -2450,6 +2599,89 @@ isUserInputYes(const QString t1, const QString t2)
 }
 
 
+/// the dialog opens on the window's thread, the engine's thread waits for
+/// the answer; an aborted engine is not asked anything more
+bool
+DialogOperator::
+exec(const std::function<void()> & dialog)
+{
+    if (m_engine && m_engine->isAborted()) return false;
+
+    if (QThread::currentThread() == m_parent->thread()) dialog();
+    else QMetaObject::invokeMethod(m_parent, dialog, Qt::BlockingQueuedConnection);
+
+    return true;
+}
+
+
+bool
+DialogOperator::
+confirm(const QString & title, const QString & text)
+{
+    bool isYes = false;
+
+    exec([&]()
+    {
+        QMessageBox msgBox(m_parent);
+        msgBox.setWindowTitle(m_caption);
+        msgBox.setText(title);
+        msgBox.setInformativeText(text);
+        msgBox.setStandardButtons(QMessageBox::Yes | QMessageBox::Cancel);
+        msgBox.setDefaultButton(QMessageBox::Yes);
+        isYes = (msgBox.exec() == QMessageBox::Yes);
+    });
+
+    return isYes;
+}
+
+
+/// cancel keeps the value offered
+double
+DialogOperator::
+askValue(const QString & title, const double value)
+{
+    double entered = value;
+
+    exec([&]()
+    {
+        bool ok;
+
+        const double answer = QInputDialog::getDouble(m_parent, m_caption, title, value, -1000000, 1000000, 2, &ok);
+        if (ok) entered = answer;
+    });
+
+    return entered;
+}
+
+
+QString
+DialogOperator::
+askText(const QString & title, const QString & text)
+{
+    QString entered;
+
+    exec([&]() { entered = QInputDialog::getText(m_parent, title, text); });
+
+    return entered;
+}
+
+
+void
+DialogOperator::
+inform(const QString & title, const QString & text)
+{
+    exec([&]()
+    {
+        QMessageBox msgBox(m_parent);
+        msgBox.setWindowTitle(m_caption);
+        msgBox.setText(title);
+        msgBox.setInformativeText(text);
+        msgBox.setStandardButtons(QMessageBox::Ok);
+        msgBox.exec();
+    });
+}
+
+
 void
 MainWindow::
 onUnlockFactoryDefault()
@@ -2461,7 +2693,6 @@ onUnlockFactoryDefault()
     ui->radioButton_184->setChecked(true);          // set value
     ui->startAddr->setValue(999);                   // address 999
     onSendButtonPress();
-    delay();
 }
 
 
@@ -2476,7 +2707,6 @@ onLockFactoryDefault()
     ui->radioButton_185->setChecked(true);          // set value
     ui->startAddr->setValue(999);                   // address 999
     onSendButtonPress();
-    delay();
 }
 
 
@@ -2507,7 +2737,6 @@ onUpdateFactoryDefaultPressed()
     /// update factory default registers
     ui->startAddr->setValue(9999);                  // address 99999
     onSendButtonPress();
-    delay();
 }
 
 
@@ -2519,6 +2748,7 @@ connectProfiler()
     connect(ui->radioButton_192, SIGNAL(pressed()), this, SLOT(onLockFactoryDefault()));
     connect(ui->pushButton_2, SIGNAL(pressed()), this, SLOT(onUpdateFactoryDefaultPressed()));
     connect(ui->startEquationBtn, SIGNAL(pressed()), this, SLOT(onEquationButtonPressed()));
+    connect(ui->pushButton_3, SIGNAL(pressed()), this, SLOT(onBatchEquation()));
     connect(ui->radioButton_189, SIGNAL(toggled(bool)), this, SLOT(onDownloadButtonChecked(bool)));
 }
 
@@ -2572,9 +2802,7 @@ void
 MainWindow::
 releaseSerialModbus()
 {
-    modbus_close( LOOP.serialModbus );
-    modbus_free( LOOP.serialModbus );
-    LOOP.serialModbus = NULL;
+    LOOP.bus->close();
     updateLoopTabIcon(false);
 }
 
@@ -2626,15 +2854,18 @@ MainWindow::
 changeModbusInterface(const QString& port, char parity)
 {
     releaseSerialModbus();
-    LOOP.serialModbus = modbus_new_rtu( port.toLatin1().constData(),ui->comboBox_2->currentText().toInt(),parity,ui->comboBox_3->currentText().toInt(),ui->comboBox_4->currentText().toInt() );
 
-    if( modbus_connect( LOOP.serialModbus ) == -1 )
+    if( !LOOP.bus->open( port, ui->comboBox_2->currentText().toInt(), parity, ui->comboBox_3->currentText().toInt(), ui->comboBox_4->currentText().toInt() ) )
     {
         emit connectionError( tr( "Could not connect serial port at LOOP " )+QString::number(0) );
         releaseSerialModbus();
     }
     else
+    {
+        /// inter-frame pacing is done by the rtu backend
+        LOOP.bus->setTurnaround(LOOP.turnaround);
         updateLoopTabIcon(true);
+    }
 }
 
 
@@ -2659,62 +2890,12 @@ void
 MainWindow::
 clearMonitors()
 {
-    ui->rawData->clear();
+    m_busHex->clear();
     ui->regTable->setRowCount(0);
-    ui->busMonTable->setRowCount(0);
+    m_busMonitor->clear();
 }
 
 
-void
-MainWindow::
-updatePipeStability(const int pipe, const bool checkStability)
-{
-    if (checkStability)
-    {
-        /// check temp stability
-        if (PIPE[pipe].tempStability < 5)
-        {
-            if (abs(PIPE[pipe].temperature - PIPE[pipe].temperature_prev) <= LOOP.zTemp) PIPE[pipe].tempStability++;
-            else PIPE[pipe].tempStability = 0;
-
-            PIPE[pipe].temperature_prev = PIPE[pipe].temperature;
-            PIPE[pipe].tempProgress->setValue(PIPE[pipe].tempStability*20);
-        }
-        else PIPE[pipe].tempStability = 5;
-
-        /// check freq stability
-        if (PIPE[pipe].freqStability < 5)
-        {
-            if (abs(PIPE[pipe].frequency - PIPE[pipe].frequency_prev) <= LOOP.yFreq) PIPE[pipe].freqStability++;
-            else PIPE[pipe].freqStability = 0;
-
-            PIPE[pipe].frequency_prev = PIPE[pipe].frequency;
-            PIPE[pipe].freqProgress->setValue(PIPE[pipe].freqStability*20);
-        }
-        else PIPE[pipe].freqStability = 5;
-    }
-    else
-    {
-        if (pipe == ALL)
-        {
-            for (int i=0; i<3; i++)
-            {
-                PIPE[i].freqStability = 0;
-                PIPE[i].tempStability = 0;
-                PIPE[i].freqProgress->setValue(PIPE[i].freqStability);
-                PIPE[i].tempProgress->setValue(PIPE[i].tempStability);
-            }
-        }
-        else
-        {
-            PIPE[pipe].freqStability = 0;
-            PIPE[pipe].tempStability = 0;
-            PIPE[pipe].freqProgress->setValue(PIPE[pipe].freqStability);
-            PIPE[pipe].tempProgress->setValue(PIPE[pipe].tempStability);
-        }
-    }
-}
-
 void
 MainWindow::
 onHighSelected()
@@ -2790,1509 +2971,474 @@ initializeTabIcons()
 
 void
 MainWindow::
-createTempRunFile(const int sn, const QString startValue, const QString stopValue, const QString saltValue, const int pipe)
+updateCurrentStage(const QString color, const QString label)
 {
-    /// set file names
-    QDateTime currentDataTime = QDateTime::currentDateTime();
-
-    /// headers
-    QString header0;
-    LOOP.isEEA ? header0 = EEA_INJECTION_FILE : header0 = RAZ_INJECTION_FILE;
-    QString header1("SN"+QString::number(sn)+" | "+LOOP.cut.split("\\").at(1) +" | "+currentDataTime.toString()+" | L"+QString::number(LOOP.loopNumber)+PIPE[pipe].pipeId+" | "+PROJECT+RELEASE_VERSION);
-    QString header2("INJECTION:  "+startValue+" % "+"to "+stopValue+" % "+"Watercut at "+saltValue+" % "+"Salinity\n");
-    if ((LOOP.cut == LOW) || (!LOOP.isEEA)) header2 = "TEMPERATURE:  "+startValue+" °C "+"to "+stopValue+" °C\n";
-    QString header3 = HEADER3;
-    QString header4 = HEADER4;
-    QString header5 = HEADER5;
-
-    /// stream
-    QTextStream stream(&PIPE[pipe].file);
-
-    /// open file
-    PIPE[pipe].file.open(QIODevice::WriteOnly | QIODevice::Text);
-
-    /// write headers to stream
-    stream << header0 << '\n' << header1 << '\n' << header2 << '\n' << header3 << '\n' << header4 << '\n' << header5 << '\n';
-
-    /// close file
-    PIPE[pipe].file.close();
-
-    /// update file list
-    updateFileList(QFileInfo(PIPE[pipe].file).fileName(), sn, pipe);
-}
-
-
-void
-MainWindow::
-createInjectFile(const int pipe, const QString startValue, const QString stopValue, const QString saltValue, const QString filename)
-{
-    /// headers
-	int sn = PIPE[pipe].slave->text().toInt();
-    QDateTime currentDataTime = QDateTime::currentDateTime();
-    QString header0;
-    LOOP.isEEA ? header0 = EEA_INJECTION_FILE : header0 = RAZ_INJECTION_FILE;
-    QString header1("SN"+QString::number(sn)+" | "+LOOP.cut.split("\\").at(1) +" | "+currentDataTime.toString()+" | L"+QString::number(LOOP.loopNumber)+PIPE[pipe].pipeId+" | "+PROJECT+RELEASE_VERSION);
-    QString header2("INJECTION:  "+startValue+" % "+"to "+stopValue+" % "+"Watercut at "+saltValue+" % "+"Salinity\n");
-    QString header3 = HEADER3;
-    QString header4 = HEADER4;
-    QString header5 = HEADER5;
-    QString header21; // LOWCUT ONLY
-    QString header22; // LOWCUT ONLY
-
-    /// CALIBRAT, ADJUSTED, ROLLOVER (LOWCUT ONLY)
-    if (LOOP.cut == LOW)
-    {
-        /// create headers
-        header2 = "TEMPERATURE:  "+startValue+" °C "+"to "+stopValue+" °C\n";
-        header21 = "INJECTION:  "+LOOP.oilRunStart->text()+" % "+"to "+LOOP.oilRunStop->text()+" % Watercut\n";
-        header22 = "ROLLOVER:  "+QString::number(LOOP.watercut)+" % "+"to "+"rollover\n";
-
-        /// set filenames
-        PIPE[pipe].fileCalibrate.setFileName(PIPE[pipe].mainDirPath+"\\"+QString("CALIBRAT").append(LOOP.calExt));
-        PIPE[pipe].fileAdjusted.setFileName(PIPE[pipe].mainDirPath+"\\"+QString("ADJUSTED").append(LOOP.adjExt));
-        PIPE[pipe].fileRollover.setFileName(PIPE[pipe].mainDirPath+"\\"+QString("ROLLOVER").append(LOOP.rolExt));
-
-        /// update PIPE object
-        if (filename == "CALIBRAT")
-        {
-            /// CALIBRAT
-            if (!QFileInfo(PIPE[pipe].fileCalibrate).exists())
-            {
-                QTextStream streamCalibrate(&PIPE[pipe].fileCalibrate);
-                PIPE[pipe].fileCalibrate.open(QIODevice::WriteOnly | QIODevice::Text);
-                streamCalibrate << header0 << '\n' << header1 << '\n' << header21 << '\n' << header3 << '\n' << header4 << '\n' << header5 << '\n';
-                PIPE[pipe].fileCalibrate.close();
-
-                /// update file list
-                updateFileList(QFileInfo(PIPE[pipe].fileCalibrate).fileName(), sn, pipe);
-            }
-        }
-        else if (filename == "ADJUSTED")
-        {
-            if (!QFileInfo(PIPE[pipe].fileAdjusted).exists())
-            {
-                QTextStream streamAdjusted(&PIPE[pipe].fileAdjusted);
-                PIPE[pipe].fileAdjusted.open(QIODevice::WriteOnly | QIODevice::Text);
-                streamAdjusted << header0 << '\n' << header1 << '\n' << header21 << '\n' << header3 << '\n' << header4 << '\n' << header5 << '\n';
-                PIPE[pipe].fileAdjusted.close();
-
-                /// update file list
-                updateFileList(QFileInfo(PIPE[pipe].fileAdjusted).fileName(), sn, pipe);
-            }
-        }
-        else if (filename == "ROLLOVER")
-        {
-            /// ROLLOVER
-            if (!QFileInfo(PIPE[pipe].fileRollover).exists())
-            {
-                QTextStream streamRollover(&PIPE[pipe].fileRollover);
-                PIPE[pipe].fileRollover.open(QIODevice::WriteOnly | QIODevice::Text);
-                streamRollover << header0 << '\n' << header1 << '\n' << header22 << '\n' << header3 << '\n' << header4 << '\n' << header5 << '\n';
-                PIPE[pipe].fileRollover.close();
-
-                /// update file list
-                updateFileList(QFileInfo(PIPE[pipe].fileRollover).fileName(), sn, pipe);
-            }
-        }
-    }
-    else if (LOOP.cut == MID)
-    {
-        /// OIL_INJECTION TEMP
-        if (!QFileInfo(PIPE[pipe].file).exists())
-        {
-            QTextStream stream(&PIPE[pipe].file);
-            PIPE[pipe].file.open(QIODevice::WriteOnly | QIODevice::Text);
-            stream << header0 << '\n' << header1 << '\n' << header2 << '\n' << header3 << '\n' << header4 << '\n' << header5 << '\n';
-            PIPE[pipe].file.close();
-
-            /// update file list
-            updateFileList(QFileInfo(PIPE[pipe].file).fileName(), sn, pipe);
-        }
-    }
-	else if (LOOP.cut == FULL)
-    {
-        /// OIL_INJECTION TEMP
-        if (!QFileInfo(PIPE[pipe].file).exists())
-        {
-            QTextStream stream(&PIPE[pipe].file);
-            PIPE[pipe].file.open(QIODevice::WriteOnly | QIODevice::Text);
-            stream << header0 << '\n' << header1 << '\n' << header2 << '\n' << header3 << '\n' << header4 << '\n' << header5 << '\n';
-            PIPE[pipe].file.close();
-
-            /// update file list
-            updateFileList(QFileInfo(PIPE[pipe].file).fileName(), sn, pipe);
-        }
-    }
-	else if (LOOP.cut == HIGH)
-    {
-        /// OIL_INJECTION TEMP
-        if (!QFileInfo(PIPE[pipe].file).exists())
-        {
-            QTextStream stream(&PIPE[pipe].file);
-            PIPE[pipe].file.open(QIODevice::WriteOnly | QIODevice::Text);
-            stream << header0 << '\n' << header1 << '\n' << header2 << '\n' << header3 << '\n' << header4 << '\n' << header5 << '\n';
-            PIPE[pipe].file.close();
-
-            /// update file list
-            updateFileList(QFileInfo(PIPE[pipe].file).fileName(), sn, pipe);
-        }
-    }
+	ui->runModeStatus->setStyleSheet(color);
+	ui->runModeStatus->setText(label); 	
 }
 
-
+/// the run settings of the loop tab, one pipe per serial number entered;
+/// m_calRows keeps which panel row each pipe of the engine is
 void
 MainWindow::
-updateFileList(const QString fileName, const int sn, const int pipe)
-{
-    QString header0;
-    QFile file;
-    QTextStream streamList(&file);
-    QDateTime currentDataTime = QDateTime::currentDateTime();
-
-    LOOP.isEEA ? header0 = EEA_INJECTION_FILE : header0 = RAZ_INJECTION_FILE;
-    QString header1("SN"+QString::number(sn)+" | "+LOOP.cut.split("\\").at(1) +" | "+currentDataTime.toString()+" | L"+QString::number(LOOP.loopNumber)+PIPE[pipe].pipeId+" | "+PROJECT+RELEASE_VERSION);
-
-    if (!QFileInfo(file).exists()) file.setFileName(PIPE[pipe].mainDirPath+"\\"+FILE_LIST);
-    file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
-
-    /// write header to streamList
-    if (QFileInfo(file).exists())
-    {
-        if (QFileInfo(file).size() == 0) streamList << header0 << '\n' << header1 << '\n' << '\n' << fileName << '\n';
-        else streamList << fileName << '\n';
-    }
-
-    file.close();
-}
-
-bool
-MainWindow::
-validateSerialNumber(modbus_t * serialModbus)
+readLoopConfiguration(CAL_CONFIGS & config)
 {
-    for (int pipe=0; pipe<3; pipe++)
-    {
-        if (PIPE[pipe].status == ENABLED)
-        {
-            uint8_t dest[1024];
-            uint16_t * dest16 = (uint16_t *) dest;
-            int ret = -1;
-    		int num = ui->numCoils->value();
-            bool is16Bit = false;
-            bool writeAccess = false;
-            const QString funcType = descriptiveDataTypeName( FUNC_READ_INT );
-
-            /// set slave
-            memset( dest, 0, 1024 );
-            modbus_set_slave( serialModbus, PIPE[pipe].slave->text().toInt());
-
-            /// read pipe serial number
-            read_request(FUNC_READ_INT, LOOP.ID_SN_PIPE, BYTE_READ_INT, ret, dest, dest16, is16Bit);
-
-            /// verify if serial number matches with pipe
-            if (*dest16 != PIPE[pipe].slave->text().toInt())
-            {
-        		informUser(QString("LOOP ")+QString::number(LOOP.loopNumber),QString("LOOP ")+QString::number(LOOP.loopNumber).append(BLANK),"Invalid Seial Number!");
-
-                /// cancel calibration
-                LOOP.isCal = false;
-                PIPE[pipe].status = DISABLED;
-
-                /// sn is valid but serial port invalid then it's an error
-                return false;
-            }
-            else
-            {
-                PIPE[pipe].status = ENABLED;
-                PIPE[pipe].checkBox->setChecked(true);
-            }
-        }
-        else
-        {
-            PIPE[pipe].status = DISABLED;
-            PIPE[pipe].checkBox->setChecked(false);
-        }
-    }
-
-    return true;
-}
-
-
-void
-MainWindow::
-readLoopConfiguration()
-{
-    /// reset triggers
-    LOOP.isInitTempRun = false;
-    LOOP.isInitInject = false;
-    LOOP.isInjectionOn = false;
-	LOOP.isPause = false;
-    LOOP.isTempRunSkip = false;
-	LOOP.isTempRunOnly = false;
-	LOOP.isWaterRun = false;
-	LOOP.isOilRun = false;
-	LOOP.salinityIndex = 0;
-
-    /// set product
+    /// set product and the register ids of the manual reads
     LOOP.isEEA = ui->radioButton->isChecked();
-
-    /// set register ids
     onUpdateRegisters(LOOP.isEEA);
 
-    /// set master pipe
-    LOOP.isMaster = ui->radioButton_11->isChecked();
-
-	/// set file path
-	if (LOOP.isEEA)
-	{
-		HIGH = HIGH_EEA;
-		FULL = FULL_EEA;
-		MID = MID_EEA;
-		LOW = LOW_EEA;
-	}
-	else
-	{
-		HIGH = HIGH_RAZ;
-		FULL = FULL_RAZ;
-		MID = MID_RAZ;
-		LOW = LOW_RAZ;
-	}
-
-    /// set cut
-    if (ui->radioButton_3->isChecked()) 
-	{
-		LOOP.cut = HIGH;
-		LOOP.isInitInject = true;
-		LOOP.isWaterRun = true;
-		LOOP.isOilRun = false;
-	}
-    else if (ui->radioButton_4->isChecked()) 
-	{
-		LOOP.cut = FULL;
-		LOOP.isInitInject = true;
-		LOOP.isWaterRun = true;
-		LOOP.isOilRun = false;
-	}
-    else if (ui->radioButton_5->isChecked()) 
-	{
-		LOOP.cut = MID;
-		if (LOOP.isEEA) 
-		{
-			LOOP.isInitTempRun = false;
-			LOOP.isInitInject = true;
-		}
-		else 
-		{
-			LOOP.isInitTempRun = true;
-			LOOP.isInitInject = false;
-		}
-		LOOP.isWaterRun = false;
-		LOOP.isOilRun = true;
-	}
-    else if (ui->radioButton_6->isChecked()) 
-	{
-		LOOP.cut = LOW;
-		LOOP.isInitTempRun = true;
-		LOOP.isInitInject = false;
-		LOOP.isWaterRun = false;
-		LOOP.isOilRun = true;
-	}
-
-    /// set run mode
-	if (LOOP.isEEA)
-	{
-    	if (ui->radioButton_14->isChecked()) LOOP.runMode = SIMULATION_RUN;
-    	else
-		{
-			if (LOOP.cut == LOW) LOOP.runMode = TEMPRUN_MIN;
-			else LOOP.runMode = INJECT_RUN;
-		}
-	}
-	else
-	{
-    	if (ui->radioButton_14->isChecked()) LOOP.runMode = SIMULATION_RUN;
-		else 
-		{
-			LOOP.runMode = TEMPRUN_MIN;
-			if (ui->radioButton_15->isChecked()) LOOP.isTempRunOnly = true;
-		}
-	}
-
-    /// set file extensions
-    if (LOOP.cut == HIGH)
-    {
-        LOOP.filExt = ".HCI";
-        LOOP.calExt = ".HCI";
-        LOOP.adjExt = ".HCI";
-        LOOP.rolExt = ".HCR";
-    }
-    else if (LOOP.cut == FULL)
-    {
-        LOOP.filExt = ".FCI";
-        LOOP.calExt = ".FCI";
-        LOOP.adjExt = ".FCI";
-        LOOP.rolExt = ".FCR";
-    }
-    else if (LOOP.cut == MID)
-    {
-        LOOP.filExt = ".MCI";
-        LOOP.calExt = ".MCI";
-        LOOP.adjExt = ".MCI";
-        LOOP.rolExt = ".MCR";
-    }
-    else if (LOOP.cut == LOW)
-    {
-        LOOP.filExt = ".LCT";
-        LOOP.calExt = ".LCI";
-        LOOP.adjExt = ".LCI";
-        LOOP.rolExt = ".LCR";
-    }
-}
-
-
-bool
-MainWindow::
-prepareCalibration()
-{
-	/// disable empty pipes
-    for (int pipe=0; pipe<3; pipe++)
-    {
-        if (PIPE[pipe].slave->text().isEmpty()) PIPE[pipe].status = DISABLED;
-        else PIPE[pipe].status = ENABLED;
-    }
-
-	/// cancle calibration if pipes are all empty
-    if (PIPE[0].slave->text().isEmpty() && PIPE[1].slave->text().isEmpty() && PIPE[2].slave->text().isEmpty())
-    {
-        onActionStop();
-        informUser(QString("LOOP ")+QString::number(LOOP.loopNumber),QString("LOOP ")+QString::number(LOOP.loopNumber).append(BLANK),"No Valid Serial Number Exists!");
-        return false;
-    }
+    /// calibration control variables
+    config.mainServer = m_mainServer;
+    config.injectionOilPumpRate = LOOP.injectionOilPumpRate;
+    config.injectionWaterPumpRate = LOOP.injectionWaterPumpRate;
+    config.minTemp = LOOP.minTemp;
+    config.maxTemp = LOOP.maxTemp;
+    config.injectTemp = LOOP.injectTemp;
+    config.xDelay = LOOP.xDelay;
+    config.yFreq = LOOP.yFreq;
+    config.zTemp = LOOP.zTemp;
+    config.intervalSmallPump = LOOP.intervalSmallPump;
+    config.intervalBigPump = LOOP.intervalBigPump;
+    config.intervalOilPump = LOOP.intervalOilPump;
+    config.loopNumber = LOOP.loopNumber;
+    config.masterMin = LOOP.masterMin;
+    config.masterMax = LOOP.masterMax;
+    config.masterDelta = LOOP.masterDelta;
+    config.masterDeltaFinal = LOOP.masterDeltaFinal;
+    config.maxInjectionWater = LOOP.maxInjectionWater;
+    config.maxInjectionOil = LOOP.maxInjectionOil;
+    config.readGap = LOOP.readGap;
+    config.turnaround = LOOP.turnaround;
+    config.isInjectionTimer = LOOP.isInjectionTimer;
+    config.stableConfidence = LOOP.stableConfidence;
+    config.isInjectionModel = LOOP.isInjectionModel;
+    config.operatorName = LOOP.operatorName;
 
-    /// validatae loop volume
-    if (LOOP.loopVolume->text().toDouble() < 1)
-    {
-        onActionStop();
-        informUser(QString("LOOP ")+QString::number(LOOP.loopNumber),QString("LOOP ")+QString::number(LOOP.loopNumber).append(BLANK),"No Valid Loop Volume Exists!");
-        return false;
-    }
+    /// run settings
+    config.isEEA = LOOP.isEEA;
+    config.isMaster = ui->radioButton_11->isChecked();
+    config.isTempRunOnly = (!LOOP.isEEA) && ui->radioButton_15->isChecked();
+    config.isSimulation = ui->radioButton_14->isChecked();
 
-    /// validate serial port
-    if (LOOP.modbus == NULL)
-    {
-        /// update tab icon
-        onActionStop();
-        informUser(QString("LOOP ")+QString::number(LOOP.loopNumber),QString("LOOP ")+QString::number(LOOP.loopNumber).append(BLANK),"Bad Serial Connection");
-        return false;
-    }
+    if (ui->radioButton_3->isChecked()) config.cut = CUT_HIGH;
+    else if (ui->radioButton_4->isChecked()) config.cut = CUT_FULL;
+    else if (ui->radioButton_6->isChecked()) config.cut = CUT_LOW;
+    else config.cut = CUT_MID;
 
-    /// LOOP configuration
-    readLoopConfiguration();
+    if (ui->radioButton_7->isChecked()) config.osc = 1;
+    else if (ui->radioButton_8->isChecked()) config.osc = 2;
+    else if (ui->radioButton_9->isChecked()) config.osc = 3;
+    else config.osc = 4;
 
-    /// reset stability progressbar
-    updatePipeStability(ALL,NO_STABILITY_CHECK);
+    config.loopVolume = LOOP.loopVolume->text().toDouble();
+    config.saltStart = LOOP.saltStart->currentText();
+    config.saltStop = LOOP.saltStop->currentText();
+    config.waterRunStart = LOOP.waterRunStart->text().toDouble();
+    config.waterRunStop = LOOP.waterRunStop->text().toDouble();
+    config.oilRunStart = LOOP.oilRunStart->text().toDouble();
+    config.oilRunStop = LOOP.oilRunStop->text().toDouble();
 
-    /// validate serial numbers
-    if (!validateSerialNumber(LOOP.serialModbus))
-    {
-        /// stop calibration
-        onActionStop();
-        return false;
-    }
+    /// empty rows leave the pipe out
+    config.serials.clear();
+    config.rows.clear();
 
-    /// set file path
-    for (int pipe = 0; pipe < 3; pipe++)
+    for (int pipe = 0; pipe < PIPE.size(); pipe++)
     {
-		if (PIPE[pipe].status == ENABLED)
-		{
-        	PIPE[pipe].etimer->restart();
-        	PIPE[pipe].mainDirPath = m_mainServer+LOOP.cut+QString::number(((int)(PIPE[pipe].slave->text().toInt()/100))*100).append("'s").append("\\")+LOOP.cut.split("\\").at(2)+PIPE[pipe].slave->text();
+        if (PIPE[pipe]->slave->text().toInt() <= 0) continue;
 
-        	if (ui->radioButton_7->isChecked()) PIPE[pipe].osc = 1;
-        	else if (ui->radioButton_8->isChecked()) PIPE[pipe].osc = 2;
-        	else if (ui->radioButton_9->isChecked()) PIPE[pipe].osc = 3;
-        	else PIPE[pipe].osc = 4;
-		}
+        config.serials.append(PIPE[pipe]->slave->text().toInt());
+        config.rows.append(pipe);
     }
 
-    return true;
+    m_calRows = config.rows;
 }
 
 
+/// the loop tab as it was when the checkpoint was written, each serial
+/// number back in its row
 void
 MainWindow::
-startCalibration()
+restoreLoopConfiguration(const QVariantMap & record)
 {
-    /// scan calibration variables
-    if (!prepareCalibration()) return;
-
-    /// LOOP calibration on
-    if (LOOP.isCal)
-    {
-        for (int pipe = 0; pipe < 3; pipe++)
-        {
-            if (PIPE[pipe].status == ENABLED)
-            {
-                PIPE[pipe].isStartFreq = true;
-                QDir dir;
-                int fileCounter = 2;
+    const QVariantList pipes = record["pipes"].toList();
 
-                /// corresponding folder should exist before starting SIMULATION
-                if (LOOP.runMode == SIMULATION_RUN) // simulation
-                {
-                    if (!dir.exists(PIPE[pipe].mainDirPath))
-                    {
-                        informUser(QString("LOOP ")+QString::number(LOOP.loopNumber),QString("No Simulation Directory Exists!!                     "),PIPE[pipe].mainDirPath);
-                        onActionStop();
-                        return;
-                    }
-                }
-                else // calibration
-                {
-					/// set folder
-                    if (!dir.exists(PIPE[pipe].mainDirPath)) dir.mkpath(PIPE[pipe].mainDirPath);
-                    else
-                    {
-                        while (1)
-                        {
-                            if (!dir.exists(PIPE[pipe].mainDirPath+"_"+QString::number(fileCounter)))
-                            {
-                                dir.rename(PIPE[pipe].mainDirPath,PIPE[pipe].mainDirPath + "_"+QString::number(fileCounter) ); // rename existing folder"
-                                dir.mkpath(PIPE[pipe].mainDirPath); // create new folder
-
-                                break;
-                            }
-                            else fileCounter++;
-                        }
-                    }
-                }
+    /// product and cut
+    (record["isEEA"].toBool()) ? ui->radioButton->setChecked(true) : ui->radioButton_2->setChecked(true);
 
-                /// set file name
-				if (LOOP.runMode == SIMULATION_RUN)
-				{
-					PIPE[pipe].file.setFileName(PIPE[pipe].mainDirPath+"\\"+ QString("CALIBRAT__").append(QString::number(LOOP.injectTemp)).append(LOOP.simExt));
-				}
-				else
-				{
-					if (LOOP.isEEA) // eea
-					{
-                		if ((LOOP.cut == HIGH) || (LOOP.cut == FULL))
-						{
-							/// set file name
-							PIPE[pipe].file.setFileName(PIPE[pipe].mainDirPath+"\\"+ QString::number(LOOP.saltStart->currentText().toDouble()*100).append("_100").append(LOOP.filExt));
-
-							/// get salinity index
-							LOOP.salinityIndex = 0;
-							while (SALINITY[LOOP.salinityIndex] != LOOP.saltStart->currentText()) LOOP.salinityIndex++;
-						}
-						else // midcut or lowcut or razor
-						{
-							/// lowcut
-							if (LOOP.cut == LOW) PIPE[pipe].file.setFileName(PIPE[pipe].mainDirPath+"\\"+ QString("AMB").append("_").append(QString::number(LOOP.minTemp)).append(LOOP.filExt));
-
-							/// midcut
-							else PIPE[pipe].file.setFileName(PIPE[pipe].mainDirPath+"\\"+ QString("OIL_").append(QString::number(LOOP.injectTemp)).append(LOOP.filExt));
-						}
-					}
-					else // razor
-					{
-						PIPE[pipe].file.setFileName(PIPE[pipe].mainDirPath+"\\"+ QString("AMB").append("_").append(QString::number(LOOP.minTemp)).append(LOOP.filExt));
-					}
-            	}
-        	}
-		}
-		///////////////////////////
-		///////////////////////////
-		///////////////////////////
-        /// start calibration
-		///////////////////////////
-		///////////////////////////
-		///////////////////////////
-
-        while (LOOP.isCal)
-        {
-			if (LOOP.isPause)
-			{
-				updateCurrentStage(RED,"PAUSE");
-			}
-			else
-			{
-				updateCurrentStage(BLACK,LOOP.runMode);
-
-            	if ((LOOP.runMode == TEMPRUN_ONLY) || (LOOP.runMode == TEMPRUN_MIN) || (LOOP.runMode == TEMPRUN_HIGH) || (LOOP.runMode == TEMPRUN_INJECT)) runTempRun();
-            	else if ((LOOP.runMode == INJECT_RUN) || (LOOP.runMode == SIMULATION_RUN)) runInjection();
-            	else
-				{
-					onActionStop();
-					return;
-				}
-			}
-
-            delay(LOOP.xDelay);
-        }
-    }
-    else
+    switch (record["cut"].toInt())
     {
-        onActionStop();
-        informUser(QString("LOOP ")+QString::number(LOOP.loopNumber),BLANK,"Calibration cancelled!");
+        case CUT_HIGH: ui->radioButton_3->setChecked(true); break;
+        case CUT_FULL: ui->radioButton_4->setChecked(true); break;
+        case CUT_LOW: ui->radioButton_6->setChecked(true); break;
+        default: ui->radioButton_5->setChecked(true); break;
     }
-}
-
-void
-MainWindow::
-updateCurrentStage(const QString color, const QString label)
-{
-	ui->runModeStatus->setStyleSheet(color);
-	ui->runModeStatus->setText(label); 	
-}
 
-void
-MainWindow::
-stopCalibration()
-{
-    int i;
-
-	LOOP.isOilRun = false;
-	LOOP.isWaterRun = false;
-    LOOP.isCal = false;
-    LOOP.isMaster = false;
-    LOOP.isEEA = false;
-    LOOP.isInitTempRun = false;
-    LOOP.isInitInject = false;
-	LOOP.salinityIndex = 0;
-    LOOP.runMode = STOP_CALIBRATION;
+    /// run type, master pipe and oscillator
+    if (record["isSimulation"].toBool()) ui->radioButton_14->setChecked(true);
+    else (record["isTempRunOnly"].toBool()) ? ui->radioButton_15->setChecked(true) : ui->radioButton_16->setChecked(true);
+    (record["isMaster"].toBool()) ? ui->radioButton_11->setChecked(true) : ui->radioButton_12->setChecked(true);
 
-    for (i=0;i<3;i++)
+    switch (record["osc"].toInt())
     {
-        PIPE[i].freqProgress->setValue(0);
-        PIPE[i].tempProgress->setValue(0);
-        PIPE[i].status = DISABLED;
-        PIPE[i].checkBox->setChecked(false);
-        PIPE[i].isStartFreq = true;
-        PIPE[i].tempStability = 0;
-        PIPE[i].freqStability = 0;
+        case 1: ui->radioButton_7->setChecked(true); break;
+        case 2: ui->radioButton_8->setChecked(true); break;
+        case 3: ui->radioButton_9->setChecked(true); break;
+        default: ui->radioButton_10->setChecked(true); break;
     }
 
-	LOOP.axisY->setTitleText("Watercut (%)");
-    updateGraph(ALL, RESET_SERIES, RESET_SERIES, SERIES_WATERCUT); // reset chart
-
-    return;
-}
+    /// loop volume, salinities and run bounds
+    LOOP.loopVolume->setText(QString::number(record["loopVolume"].toDouble()));
+    LOOP.saltStart->setCurrentText(record["saltStart"].toString());
+    LOOP.saltStop->setCurrentText(record["saltStop"].toString());
+    LOOP.waterRunStart->setText(QString::number(record["waterRunStart"].toDouble()));
+    LOOP.waterRunStop->setText(QString::number(record["waterRunStop"].toDouble()));
+    LOOP.oilRunStart->setText(QString::number(record["oilRunStart"].toDouble()));
+    LOOP.oilRunStop->setText(QString::number(record["oilRunStop"].toDouble()));
 
+    /// serial numbers, a journal without rows had them from the first row on
+    for (int pipe = 0; pipe < PIPE.size(); pipe++) PIPE[pipe]->slave->setText("");
 
-void
-MainWindow::
-readPipe(const int pipe, const bool checkStability)
-{
-    double val;
-    uint8_t dest[1024];
-    uint16_t * dest16 = (uint16_t *) dest;
-    int ret = -1;
-    bool is16Bit = false;
-    bool writeAccess = false;
-    const QString funcType = descriptiveDataTypeName( FUNC_READ_FLOAT );
-
-    /// reset connection
-    memset( dest, 0, 1024 );
-    modbus_set_slave( LOOP.serialModbus, PIPE[pipe].slave->text().toInt() );
-
-    /// watercut
-    if (LOOP.runMode == SIMULATION_RUN) PIPE[pipe].watercut = read_request(FUNC_READ_FLOAT, LOOP.ID_WATERCUT, BYTE_READ_FLOAT, ret, dest, dest16, is16Bit);
-    delay(SLEEP_TIME);
-
-    /// temperature
-    val = read_request(FUNC_READ_FLOAT, LOOP.ID_TEMPERATURE, BYTE_READ_FLOAT, ret, dest, dest16, is16Bit);
-    if ((val<100) && (val>-100)) PIPE[pipe].temperature = val;
-    delay(SLEEP_TIME);
-
-    /// get frequency
-    val = read_request(FUNC_READ_FLOAT, LOOP.ID_FREQ, BYTE_READ_FLOAT, ret, dest, dest16, is16Bit);
-    if ((val<1000) && (val>0)) PIPE[pipe].frequency = val;
-    delay(SLEEP_TIME);
-
-    /// get oil_rp
-    val = read_request(FUNC_READ_FLOAT, LOOP.ID_OIL_RP, BYTE_READ_FLOAT, ret, dest, dest16, is16Bit);
-    if ((val<100) && (val>0)) PIPE[pipe].oilrp = val;
-    delay(SLEEP_TIME);
-
-    /// get measured ai
-    val = read_request(FUNC_READ_FLOAT, RAZ_MEAS_AI, BYTE_READ_FLOAT, ret, dest, dest16, is16Bit);
-    if ((val<100) && (val>-100)) PIPE[pipe].measai = val;
-    delay(SLEEP_TIME);
-
-    /// get trimmed ai
-    val = read_request(FUNC_READ_FLOAT, RAZ_TRIM_AI, BYTE_READ_FLOAT, ret, dest, dest16, is16Bit);
-    if ((val<100) && (val>-100)) PIPE[pipe].trimai = val;
-    delay(SLEEP_TIME);
-
-    /// update display
-    if (PIPE[pipe].status != DISABLED)
+    for (int pipe = 0; pipe < pipes.size(); pipe++)
     {
-        if ((LOOP.runMode != TEMPRUN_MIN) && (LOOP.runMode != TEMPRUN_HIGH) && (LOOP.runMode != TEMPRUN_INJECT) && (LOOP.runMode != TEMPRUN_ONLY)) displayPipeReading(pipe, PIPE[pipe].watercut, PIPE[pipe].frequency_start, PIPE[pipe].frequency, PIPE[pipe].temperature, PIPE[pipe].oilrp);
-        else displayPipeReading(pipe, LOOP.watercut, PIPE[pipe].frequency_start, PIPE[pipe].frequency, PIPE[pipe].temperature, PIPE[pipe].oilrp);
-        delay(SLEEP_TIME);
-    }
-
-    /// update chart
-    if ((LOOP.runMode == INJECT_RUN) || (LOOP.runMode == SIMULATION_RUN))
-    {
-        updateGraph(pipe, PIPE[pipe].frequency, LOOP.masterWatercut, SERIES_WATERCUT);
-        updateGraph(pipe, PIPE[pipe].frequency, PIPE[pipe].oilrp, SERIES_RP);
-        delay(SLEEP_TIME);
-    }
-    else
-    {
-        updateGraph(pipe, PIPE[pipe].frequency, PIPE[pipe].temperature, SERIES_WATERCUT);
-        updateGraph(pipe, PIPE[pipe].frequency, PIPE[pipe].oilrp, SERIES_RP);
-        delay(SLEEP_TIME);
-    }
-
-    updatePipeStability(pipe,checkStability);
-}
-
-
-void
-MainWindow::
-readMasterPipe()
-{
-    uint8_t dest[1024];
-    uint16_t * dest16 = (uint16_t *) dest;
-    int ret = -1;
-    bool is16Bit = false;
-    bool writeAccess = false;
-    const QString funcType = descriptiveDataTypeName( FUNC_READ_FLOAT );
-
-    /// reset connection
-    memset( dest, 0, 1024 );
-    modbus_set_slave( LOOP.serialModbus, CONTROLBOX_SLAVE);
+        const QVariantMap entry = pipes[pipe].toMap();
+        const int row = (entry.contains("row")) ? entry["row"].toInt() : pipe;
 
-    /// watercut
-    LOOP.masterWatercut = read_request(FUNC_READ_FLOAT, LOOP.ID_MASTER_WATERCUT, BYTE_READ_FLOAT, ret, dest, dest16, is16Bit);
-    delay(SLEEP_TIME);
+        if ((row >= 0) && (row < PIPE.size())) PIPE[row]->slave->setText(QString::number(entry["slave"].toInt()));
+    }
+}
 
-    /// salinity
-    LOOP.masterSalinity = read_request(FUNC_READ_FLOAT, LOOP.ID_MASTER_SALINITY, BYTE_READ_FLOAT, ret, dest, dest16, is16Bit);
-    delay(SLEEP_TIME);
 
-    /// oil adjust
-    LOOP.masterOilAdj = read_request(FUNC_READ_FLOAT, LOOP.ID_MASTER_OIL_ADJUST, BYTE_READ_FLOAT, ret, dest, dest16, is16Bit);
-    delay(SLEEP_TIME);
+/// a run the journal of the loop leaves unfinished is offered at start;
+/// yes fills the loop tab from its last checkpoint and goes on from there
+void
+MainWindow::
+offerResume()
+{
+    CAL_CONFIGS config;
+    QVariantMap record;
+    QString error;
 
-    /// oil rp
-    LOOP.masterOilRp = read_request(FUNC_READ_FLOAT, LOOP.ID_MASTER_OIL_RP, BYTE_READ_FLOAT, ret, dest, dest16, is16Bit);
-    delay(SLEEP_TIME);
+    readLoopConfiguration(config);
 
-    /// temp
-    LOOP.masterTemp = read_request(FUNC_READ_FLOAT, LOOP.ID_MASTER_TEMPERATURE, BYTE_READ_FLOAT, ret, dest, dest16, is16Bit);
-    delay(SLEEP_TIME);
+    if (!CalJournal::last(calJournalPath(config), record, error) || !CalEngine::isResumable(record)) return;
 
-    /// freq
-    LOOP.masterFreq = read_request(FUNC_READ_FLOAT, LOOP.ID_MASTER_FREQ, BYTE_READ_FLOAT, ret, dest, dest16, is16Bit);
-    delay(SLEEP_TIME);
+    /// a journal from before the run settings were kept cannot fill the tab
+    if (!record.contains("loopVolume")) return;
 
-    /// phase
-    LOOP.masterPhase = read_request(FUNC_READ_FLOAT, LOOP.ID_MASTER_PHASE, BYTE_READ_FLOAT, ret, dest, dest16, is16Bit);
-    delay(SLEEP_TIME);
+    if (record["pipes"].toList().size() > PIPE.size()) return;
 
-	/// pressure 
-    LOOP.masterPressure = read_request(FUNC_READ_FLOAT, LOOP.ID_MASTER_PRESSURE, BYTE_READ_FLOAT, ret, dest, dest16, is16Bit);
-    delay(SLEEP_TIME);
+    if (!isUserInputYes(QString("Resume Calibration Of LOOP ")+QString::number(LOOP.loopNumber), QString("The Last Calibration Stopped In %1 On %2. Do You Want To Resume It?").arg(record["stateName"].toString()).arg(record["time"].toString()))) return;
 
-    /// update master pipe display
-    updateMasterPipeStatus(LOOP.masterWatercut,LOOP.masterFreq,LOOP.masterTemp,LOOP.masterPhase,LOOP.masterOilAdj,LOOP.masterSalinity);
-    delay(SLEEP_TIME);
-}
+    restoreLoopConfiguration(record);
 
+	ui->actionStart->setVisible(false);
+	ui->actionPause->setVisible(true);
 
-void
-MainWindow::
-initTempRun()
-{
-	bool ok;
-	/// popup questions
-   	if (!isUserInputYes(QString("LOOP ")+QString::number(LOOP.loopNumber),"Fill The Water Container To The Mark."))
-   	{
-       	onActionStop();
-       	return;
-   	}
-
-   	LOOP.operatorName = QInputDialog::getText(this, QString("LOOP ")+QString::number(LOOP.loopNumber)+QString(" "),tr(qPrintable("Enter Operator's Name.")), QLineEdit::Normal," ", &ok);
-   	LOOP.oilRunStart->setText(QInputDialog::getText(this, QString("LOOP ")+QString::number(LOOP.loopNumber)+QString(" "),tr(qPrintable("Enter Measured Initial Watercut.")), QLineEdit::Normal,"0.0", &ok));
-   	LOOP.watercut = LOOP.oilRunStart->text().toDouble();
-
-  	/// master pipe validation
-   	if (LOOP.isMaster)
-   	{
-      	if (LOOP.masterWatercut > LOOP.masterMax)
-       	{
-           	if (!isUserInputYes(QString("Master Pipe Raw watercut Value Is Greater Than ")+QString::number(LOOP.masterMax), "Do You Want To Continue?"))
-           	{
-               	onActionStop();
-               	return;
-           	}
-       	}
-
-       	if (LOOP.masterWatercut < LOOP.masterMin)
-       	{
-           	if (!isUserInputYes(QString("Master Pipe Raw watercut Value Is Less Than ")+QString::number(LOOP.masterMin), "Do You Want To Continue?"))
-           	{
-               	onActionStop();
-               	return;
-           	}
-       	}
-                   
-		if (abs(LOOP.masterWatercut - LOOP.oilRunStart->text().toDouble()) > LOOP.masterDelta)
-      	{
-          	if (!isUserInputYes(QString("The difference between master watercut and measured initial watercut is greater than ")+QString::number(LOOP.masterDelta), "Do You Want To Continue?"))
-          	{
-               	onActionStop();
-              	return;
-           	}
-     	}
-   	}
+    startCalibration(true);
 }
 
 
+/// The calibration runs on CalEngine, the same sequence sparky-cli runs.
+/// The engine shares the bus the port is open on and runs on a thread of
+/// its own through CalLoops, what it reports arrives queued and its
+/// questions open here. The call returns once the run has started,
+/// onCalFinished() takes it down. With a recording the run is replayed
+/// from it.
 void
 MainWindow::
-runTempRun()
+startCalibration(const bool isResume, const QString & recording)
 {
-    QString data_stream;
+    const QString caption = QString("LOOP ")+QString::number(LOOP.loopNumber);
+    CAL_CONFIGS config;
+    QString error;
 
-    if (LOOP.isCal)
-    {
-		/// read master pipe no matter what
-        readMasterPipe();
+    if (m_loops) return;
 
-		/// variable initialization 
-        if (LOOP.isInitTempRun)
-        {
-        	LOOP.isInitTempRun = false;
-            updatePipeStability(ALL,NO_STABILITY_CHECK);
-            LOOP.axisY->setTitleText("Temperature (°C)");
+    m_calClock.reset(new SystemClock);
+    m_calReplay.reset(new CalReplay);
 
-			/// set target temperature
-        	if (LOOP.runMode == TEMPRUN_MIN) 
-			{
-				initTempRun(); /// get initial user inputs
-				LOOP.currentTemp = "AMB";
-				LOOP.targetTemp = QString::number(LOOP.minTemp);
-			}
-       		else if (LOOP.runMode == TEMPRUN_HIGH)
-			{
-				LOOP.currentTemp = QString::number(LOOP.minTemp);
-				LOOP.targetTemp = QString::number(LOOP.maxTemp);
-			}
-       		else if (LOOP.runMode == TEMPRUN_INJECT) 
-			{
-				LOOP.currentTemp = QString::number(LOOP.maxTemp);
-				LOOP.targetTemp = QString::number(LOOP.injectTemp);
-			}
-			
-			/// ask op to set heat exchanger temperature
-            if (!isUserInputYes(QString("Set The Heat Exchanger Temperature (°C)"), LOOP.targetTemp))
-            {
-                onActionStop();
-                return;
-            }
+	/// hide settings screen
+    ui->groupBox_18->hide();
+    ui->groupBox_35->hide();
+    ui->groupBox_34->hide();
+    ui->groupBox_33->hide();
+    ui->groupBox_32->hide();
+    ui->groupBox_31->hide();
+    ui->groupBox_30->hide();
+    ui->groupBox_29->hide();
 
-            /// create files
-            for (int pipe = 0; pipe < 3; pipe++)
-            {
-                if (PIPE[pipe].status == ENABLED)
-                {
-          			setFileNameForNextStage(pipe, LOOP.currentTemp+"_"+LOOP.targetTemp+LOOP.filExt);
-                    if (!QFileInfo(PIPE[pipe].file).exists()) createTempRunFile(PIPE[pipe].slave->text().toInt(), LOOP.currentTemp, LOOP.targetTemp, "1", pipe);
-                }
-            }
+	/// enable main screen
+    ui->groupBox_12->show();
+    ui->groupBox_20->show();
 
-			/// reset chart
-    		updateGraph(ALL, RESET_SERIES, RESET_SERIES, SERIES_WATERCUT);
+	/// graph display only
+    ui->tabWidget->setTabEnabled(1,false);
+    ui->tabWidget->setTabEnabled(2,false);
+    ui->tabWidget->setTabEnabled(3,false);
+    ui->tabWidget->setTabEnabled(4,false);
 
-		} //---- end LOOP.isInitTempRun here ---//
+    updateLoopTabIcon(true);
 
-        /// start reading values and write to file
-        for (int pipe = 0; pipe < 3; pipe++)
-        {
-			/// skip to next temprun stage?
-			if (LOOP.isTempRunSkip)
-			{
-				if ((PIPE[pipe].status == ENABLED) && PIPE[pipe].checkBox->isChecked()) 
-				{
-					PIPE[pipe].tempStability = 5;
-					PIPE[pipe].freqStability = 5;
-				}
-			}
+    ui->groupBox_13->setEnabled(false);
+    ui->groupBox_11->setEnabled(false);
+    ui->groupBox_113->setEnabled(false);
+    ui->groupBox_114->setEnabled(false);
+    ui->groupBox_5->setEnabled(false);
+    ui->groupBox_9->setEnabled(false);
+    ui->groupBox_10->setEnabled(false);
+    ui->groupBox_6->setEnabled(false);
+    ui->groupBox_65->setEnabled(false);
 
-            /// if not stable yet && read pipe and update temprun file
-            if ((PIPE[pipe].status == ENABLED) && PIPE[pipe].checkBox->isChecked() && ((PIPE[pipe].tempStability != 5) || (PIPE[pipe].freqStability != 5)))
-            {
-            	(abs(LOOP.targetTemp.toDouble() - PIPE[pipe].temperature) < 2.0) ? readPipe(pipe, STABILITY_CHECK) : readPipe(pipe, NO_STABILITY_CHECK);
-                createDataStream(pipe,data_stream);
-                writeToCalFile(pipe, data_stream);
-            }
-            else /// now stable
-            {
-                if (PIPE[pipe].status == ENABLED) /// "ENABLED" pipe is now stable 
-                {
-                    PIPE[pipe].status = DONE; /// set status DONE 
-					PIPE[pipe].tempStability = 0;
-					PIPE[pipe].freqStability = 0;
-
-					/// all pipes are finished
-                    if ((PIPE[0].status != ENABLED) && (PIPE[1].status != ENABLED) && (PIPE[2].status != ENABLED)) 
-					{
-						LOOP.isInitTempRun = true;
-						LOOP.isTempRunSkip = false;
-						for (int x=0; x<3; x++) if (PIPE[x].status == DONE) PIPE[x].status = ENABLED;
-
-						/// change mode
-						if (LOOP.runMode == TEMPRUN_MIN) LOOP.runMode = TEMPRUN_HIGH;
-						else if (LOOP.runMode == TEMPRUN_HIGH) LOOP.runMode = TEMPRUN_INJECT;
-						else // TEMPRUN_INJECT
-						{
-							if (LOOP.isTempRunOnly) 
-							{
-								informUser("Temp Run Has Finished.", "Calibration Stopped" ); // TEMPRUN_ONLY mode
-								onActionStop();
-							}
-                        	else /// temprun is over. moving to inject_run
-							{
-								for (int pipe=0; pipe<3; pipe++)	
-								{
-                    				if (PIPE[pipe].status == DONE)
-									{
-										if (LOOP.cut == LOW) setFileNameForNextStage(pipe,"CALIBRAT.LCI");
-                        				else setFileNameForNextStage(pipe,QString("OIL__").append(LOOP.targetTemp).append(".MCI"));
-                        				PIPE[pipe].frequency_start = PIPE[pipe].frequency;
-									}
-								}
-
-								LOOP.runMode = INJECT_RUN;
-								LOOP.isInitInject = true;
-								LOOP.isInitTempRun = false;
-							}
-						}
-					}
-                }
-            }
+    /// LOOP configuration
+    readLoopConfiguration(config);
+
+    /// the recording is read, the run is written to the main server
+    if (!recording.isEmpty())
+    {
+        config.isSimulation = false;
+
+        if (QDir::cleanPath(recording) == QDir::cleanPath(m_mainServer)) error = "The Recording Cannot Be The Main Server!";
+        else m_calReplay->open(recording, error);
+
+        if (!error.isEmpty())
+        {
+            m_calReplay.reset();
+            m_calClock.reset();
+            onActionStop();
+            informUser(caption, caption+BLANK, error);
+            return;
         }
+
+        m_calClock.reset(new VirtualClock(m_calReplay->started()));
     }
-}
 
+    m_calOperator.reset(new DialogOperator(this, caption));
 
-void
-MainWindow::
-runInjection()
-{
-	if (LOOP.runMode == STOP_CALIBRATION) return;
+    /// no parent, CalLoops moves it to its thread and deletes it
+    CalEngine * engine = new CalEngine(config, m_calOperator.data(), LOOP.bus);
+
+    engine->setClock(m_calClock.data());
+    if (!m_calReplay->root().isEmpty()) engine->setReplay(m_calReplay.data());
 
-    static double injectionTime = 0;
-    static double totalInjectionTime = 0;
-    static double accumulatedInjectionTime_prev = 0;
-    static double correctedWatercut = 0;
-    static double measuredWatercut = 0;
-    static double totalInjectionVolume = 0;
-    QString data_stream;
+    connect(engine, &CalEngine::stageChanged, this, &MainWindow::onCalStage, Qt::QueuedConnection);
+    connect(engine, &CalEngine::sampled, this, &MainWindow::onCalSampled, Qt::QueuedConnection);
+    connect(engine, &CalEngine::progressed, this, &MainWindow::onCalProgress, Qt::QueuedConnection);
+    connect(engine, &CalEngine::message, this, &MainWindow::onCalMessage, Qt::QueuedConnection);
+    connect(engine, &CalEngine::transition, this, &MainWindow::onCalTransition, Qt::QueuedConnection);
+
+    isModbusTransmissionFailed = false;
 
-    if ((LOOP.runMode == INJECT_RUN) || (LOOP.runMode == SIMULATION_RUN))
+    if (!engine->prepare(error, isResume))
     {
-        if (LOOP.isInitInject)
-        {
- 			/// user notice
-            bool ok;
-  
-         	/// chage y axis and reset series
-            LOOP.axisY->setTitleText("Watercut (%)");
-    		updateGraph(ALL, RESET_SERIES, RESET_SERIES, SERIES_WATERCUT);
-
-			if (LOOP.isWaterRun)
-			{
-				/// confirm salinity
-				if (!isUserInputYes(QString("LOOP ")+QString::number(LOOP.loopNumber),QString("Fill The Loop With Water At ").append(SALINITY[LOOP.salinityIndex]).append(" \% Salinity")))
-				{
-					onActionStop();
-               		return;
-				}
-
-				/// confirm enough oil
-				if (!isUserInputYes(QString("WATER_RUN : OIL INJECTION WILL START IN LOOP ")+QString::number(LOOP.loopNumber),"Please Make Sure There Is Enough Oil In The Injection Bucket"))
-           		{
-               		onActionStop();
-               		return;
-           		}
-
-				/// confirm temperature
-               	if (!isUserInputYes(QString("Set The Heat Exchanger Temperature"), "38 °C  (100 °F)"))
-				{
-					onActionStop();
-               		return;
-				}
-
-				/* no need to ask initial watercut - 99% always */
-           		LOOP.watercut = LOOP.waterRunStart->text().toDouble();
-           		LOOP.phaseRolloverCounter = 0;
-				LOOP.isOilRun = false;
-			}
-			else if (LOOP.isOilRun)
-			{
-				/// confirm salinity
-				if (!isUserInputYes(QString("LOOP ")+QString::number(LOOP.loopNumber),QString("Fill The Loop With Oil At ").append("1 \% Salinity")))
-				{
-					onActionStop();
-               		return;
-				}
-
-				if (!isUserInputYes(QString("OIL_RUN : WATER INJECTION WILL START IN LOOP")+QString::number(LOOP.loopNumber),"Please Make Sure There Is Enough Water In The Injection Bucket"))
-           		{
-               		onActionStop();
-               		return;
-           		}
-
-				/// confirm temperature
-				if (LOOP.isEEA)
-				{
-               		if (!isUserInputYes(QString("Set The Heat Exchanger Temperature"), "60 °C  (140 °F)"))
-					{
-						onActionStop();
-               			return;
-					}
-				}
-				else
-				{
-					if (!isUserInputYes(QString("Set The Heat Exchanger Temperature"), "38 °C  (100 °F)"))
-					{
-						onActionStop();
-               			return;
-					}
-				}
-
-				/// get initial watercut
-           		LOOP.oilRunStart->setText(QInputDialog::getText(this, QString("LOOP ")+QString::number(LOOP.loopNumber),tr(qPrintable("Enter Measured Initial Watercut")), QLineEdit::Normal,"0.0", &ok));
-           		LOOP.watercut = LOOP.oilRunStart->text().toDouble();
-           		LOOP.phaseRolloverCounter = 0;
-				LOOP.isWaterRun = false;
-			}
+        delete engine;
+        m_calOperator.reset();
+        m_calReplay.reset();
+        m_calClock.reset();
+        onActionStop();
+        informUser(caption, caption+BLANK, error);
+        return;
+    }
 
-			/// create inject file	
-			for (int pipe = 0; pipe < 3; pipe++)
-            {
-                if (PIPE[pipe].status == ENABLED)
-                {
-                    if (LOOP.cut == LOW) createInjectFile(pipe, LOOP.oilRunStart->text(), LOOP.oilRunStop->text(), "1", "CALIBRAT");
-                    else if (LOOP.cut == MID) createInjectFile(pipe, LOOP.oilRunStart->text(), LOOP.oilRunStop->text(), "1", "MID");
-					else if (LOOP.cut == HIGH) createInjectFile(pipe, LOOP.waterRunStart->text(), LOOP.waterRunStop->text(), SALINITY[LOOP.salinityIndex], "ANY");
-                    else if (LOOP.cut == FULL)
-					{
-						if (LOOP.isWaterRun) createInjectFile(pipe, LOOP.waterRunStart->text(), LOOP.waterRunStop->text(), SALINITY[LOOP.salinityIndex], "ANY");
-						else createInjectFile(pipe, LOOP.oilRunStart->text(),LOOP.oilRunStop->text(), "1", "ANY");
-					}
-
-                    //delay(SLEEP_TIME);
-                }
-            }
+    /// the pipes the engine runs, the other rows stay off
+    for (int pipe = 0; pipe < engine->pipes().size(); pipe++)
+    {
+        PIPE[m_calRows[pipe]]->status = engine->pipes().at(pipe).status;
+        PIPE[m_calRows[pipe]]->checkBox->setChecked(engine->pipes().at(pipe).status == ENABLED);
+        PIPE[m_calRows[pipe]]->isStartFreq = true;
+    }
 
-			LOOP.isInitInject = false;
-        	updateGraph(ALL, RESET_SERIES, RESET_SERIES, SERIES_WATERCUT); // reset chart
+    m_calOperator->setEngine(engine);
+    m_calState = engine->state();
+    m_calStage.clear();
 
-        } //---- end LOOP.isInitInject ---//
+    m_loops = new CalLoops;
+    m_loops->add(engine);
+    connect(m_loops, &CalLoops::finished, this, &MainWindow::onCalFinished, Qt::QueuedConnection);
 
-        // 
-        if (( LOOP.isOilRun && (LOOP.oilRunStop->text().toDouble() >= LOOP.watercut)) || 
-			( LOOP.isWaterRun && (LOOP.waterRunStop->text().toDouble() <= LOOP.watercut)))
-        {
-            if (!LOOP.isMaster) updateLoopStatus(LOOP.watercut, 0, injectionTime, injectionTime*LOOP.injectionWaterPumpRate/60);
+    m_engine = engine;
+    LOOP.isCal = true;
 
-            //// write data to file 
-            for (int pipe = 0; pipe < 3; pipe++)
-            {
-                if ((PIPE[pipe].status == ENABLED) && PIPE[pipe].checkBox->isChecked())
-                {
-                    /// read data
-                    readPipe(pipe, NO_STABILITY_CHECK);
+    m_loops->start();
+}
 
-                    /// write to calibration file
-                    createDataStream(pipe,data_stream);
-                    writeToCalFile(pipe, data_stream);
-                }
-            }
 
-            /// reset LOOP.watercut and disable initialization
-            /*if (LOOP.isInitInject)
-            {
-                LOOP.isInitInject = false;
-                //LOOP.watercut = 0;
-        		updateGraph(ALL, RESET_SERIES, RESET_SERIES, SERIES_WATERCUT); // reset chart
-            }*/
+/// the engine has returned, its thread is done with it
+void
+MainWindow::
+onCalFinished()
+{
+    const QString caption = QString("LOOP ")+QString::number(LOOP.loopNumber);
+    const QString endText = m_engine->endText();
 
-            /// inject water or oil in master pipe mode
-            if (LOOP.isMaster)
-            {
-				if (LOOP.runMode == STOP_CALIBRATION) return;
-
-                int masterInjectionStartTime = PIPE[0].etimer->elapsed()/1000;
-
-				if (LOOP.isOilRun)
-				{
-                	/// check phase rollover
-                	if ((int)LOOP.masterPhase == PHASE_OIL)
-                	{
-						/// start injecting
-    					onActionStartInjection();
-                    	LOOP.phaseRolloverCounter = 0;
-                	}
-                	else
-                	{
-    					onActionStopInjection();
-                    	LOOP.phaseRolloverCounter++;
-
-                    	if (LOOP.phaseRolloverCounter > MAX_PHASE_CHECKING)
-                    	{
-                        	if (LOOP.masterPhase == PHASE_WATER) informUser("Master Piple Is In Water Phase Now", QString("Watercut ").append(QString::number(LOOP.masterWatercut)).append(" %"));
-                        	else informUser("Master Piple Is In ERROR Phase",QString("Phase Value Is ").append(QString::number(LOOP.masterPhase)));
-                    	}
-				
-						onActionStop();
-						return;	
-                	}
-				}
-				else // LOOP.isWaterRun
-				{
-					/// check phase rollover
-                	if ((int)LOOP.masterPhase == PHASE_WATER)
-                	{
-						/// start injecting
-    					onActionStartInjection();
-                    	LOOP.phaseRolloverCounter = 0;
-                	}
-                	else
-                	{
-    					onActionStopInjection();
-                    	LOOP.phaseRolloverCounter++;
-
-                    	if (LOOP.phaseRolloverCounter > MAX_PHASE_CHECKING)
-                    	{
-                        	if (LOOP.masterPhase == PHASE_OIL) informUser("Master Piple Is In Oil Phase Now", QString("Watercut ").append(QString::number(LOOP.masterWatercut)).append(" %"));
-                        	else informUser("Master Piple Is In ERROR Phase",QString("Phase Value Is ").append(QString::number(LOOP.masterPhase)));
-
-							onActionStop();
-							return;
-                    	}
-                	}
-				}
-
-				/// comparing with master pipe
-                while (1)
-                {
-					/// breaking condition
-					if (LOOP.isOilRun && (LOOP.masterWatercut >= LOOP.watercut)) break;
-					if (LOOP.isWaterRun && (LOOP.masterWatercut <= LOOP.watercut)) break;
-
-                    int masterInjectionTime = PIPE[0].etimer->elapsed()/1000;
-
-                    /// validate injection time
-                    if ((masterInjectionTime - masterInjectionStartTime) > LOOP.maxInjectionWater)
-                    {
-                        static bool ignore = false;
-                        if (!ignore)
-                        {
-                            /// stop water injection?
-                            if (!isUserInputYes(QString("Injection Time ")+QString::number(masterInjectionTime - masterInjectionStartTime)+QString(" Is Greater Than Max Water Injection Time ")+QString::number(LOOP.maxInjectionWater), "Do You Want To Continue?"))
-                            {
-    							onActionStopInjection();
-                                onActionStop();
-                                return;
-                            }
-                            else ignore = true;
-                        }
-                    }
-
-					/// read master pipe again
-                    readMasterPipe();
-                }
+    m_loops->deleteLater();
+    m_loops = NULL;
+    m_engine = NULL;
+    m_calState = STATE_IDLE;
 
-                /// stop water injection
-    			onActionStopInjection();
-
-				/// update injection results
-                int masterInjectionEndTime = PIPE[0].etimer->elapsed()/1000;
-                totalInjectionVolume += (masterInjectionEndTime-masterInjectionStartTime)*LOOP.injectionWaterPumpRate/60;
-                totalInjectionTime += masterInjectionEndTime-masterInjectionStartTime;
- 
-                /// set next watercut target
-                if (LOOP.cut == LOW) LOOP.watercut += LOOP.intervalSmallPump; 
-				else if (LOOP.cut == MID) LOOP.watercut += LOOP.intervalBigPump;
-				else if (LOOP.cut == FULL) 
-				{
-					if (LOOP.isWaterRun) LOOP.watercut -= LOOP.intervalBigPump;
-					else LOOP.watercut += LOOP.intervalBigPump;
-				}
-				else if (LOOP.cut == HIGH) LOOP.watercut -= LOOP.intervalBigPump;
-            }
+    m_calOperator.reset();
+    m_calReplay.reset();
+    m_calClock.reset();
 
-            ///////////////////////////////////////
-            //// IN PUMP RATE MODE
-            ///////////////////////////////////////
+    onActionStop();
+    informUser(caption, caption+BLANK, endText);
+}
 
-            else 
-            {
-				if (LOOP.runMode == STOP_CALIBRATION) return;
 
-                /// next injection time and update totalInjectionTime
-                double accumulatedInjectionTime = -(LOOP.loopVolume->text().toDouble()/(LOOP.injectionWaterPumpRate/60))*log((1-(LOOP.watercut - LOOP.oilRunStart->text().toDouble())/100));
-                injectionTime = accumulatedInjectionTime - accumulatedInjectionTime_prev;
-                totalInjectionTime += injectionTime;
-                totalInjectionVolume = totalInjectionTime*LOOP.injectionWaterPumpRate/60;
-                accumulatedInjectionTime_prev = accumulatedInjectionTime;
+/// a new stage starts on an empty chart, temperature runs plot the
+/// temperature against the frequency and the injection runs the watercut
+void
+MainWindow::
+onCalStage(const QString & stage)
+{
+    if ((m_engine == NULL) || (m_calState == STATE_DONE) || (m_calState == STATE_FAILED)) return;
 
-                /// validate injection time
-                if (injectionTime > LOOP.maxInjectionWater)
-                {
-                    /// stop water injection?
-                    if (!isUserInputYes(QString("Injection Time ")+QString::number(injectionTime)+QString(" Is Greater Than Max Water Injection Time ")+QString::number(LOOP.maxInjectionWater), "Do You Want To Continue?"))
-                    {
-                        onActionStop();
-    					onActionStopInjection();
-                        return;
-                    }
-                }
+    m_calStage = stage;
+    updateCurrentStage(BLACK,stage);
 
-                /// inject water to the pipe for "injectionTime" seconds
-    			onActionStartInjection();
-                delay(injectionTime*1000);
-    			onActionStopInjection();
-
-                /// set next watercut
-                if (LOOP.cut == LOW) LOOP.watercut += LOOP.intervalSmallPump; 
-				else if (LOOP.cut == MID) LOOP.watercut += LOOP.intervalBigPump;
-				else if (LOOP.cut == FULL) 
-				{
-					if (LOOP.isWaterRun) LOOP.watercut -= LOOP.intervalBigPump;
-					else LOOP.watercut += LOOP.intervalBigPump;
-				}
-				else if (LOOP.cut == HIGH) LOOP.watercut -= LOOP.intervalBigPump;
-            }
-        }
-        else
-        {
-            /// enter measured watercut and injected volume
-            bool ok;
-            measuredWatercut = QInputDialog::getDouble(this, QString("LOOP ")+QString::number(LOOP.loopNumber),tr(qPrintable("Enter Measured Watercut [%]")), 0.0, 0, 100, 2, &ok,Qt::WindowFlags(), 1);
+    for (int pipe = 0; pipe < PIPE.size(); pipe++)
+    {
+        PIPE[pipe]->freqProgress->setValue(0);
+        PIPE[pipe]->tempProgress->setValue(0);
+    }
 
-            if (LOOP.isMaster)
-            {
-                if (abs(LOOP.masterWatercut - measuredWatercut) > LOOP.masterDeltaFinal)
-                {
-                    /// stop water injection?
-                    if (!isUserInputYes(QString("MASTER PIPE ")+QString::number(LOOP.loopNumber)+QString(" Difference between measured watercut and master watercut is greater than ")+QString::number(LOOP.masterDeltaFinal), "Do You Want To Continue?"))
-                    {
-                        onActionStop();
-                        return;
-                    }
-                }
-            }
+	LOOP.axisY->setTitleText((isTempRunState(m_calState)) ? "Temperature (°C)" : "Watercut (%)");
+    updateGraph(ALL, RESET_SERIES, RESET_SERIES, SERIES_WATERCUT);
+}
 
-            /// finalize and close
-            QDateTime currentDataTime = QDateTime::currentDateTime();
-            QString data_stream   = QString("Total injection time   = %1 s").arg(totalInjectionTime, 10, 'g', -1, ' ');
-            QString data_stream_2 = QString("Total injection volume = %1 mL").arg(totalInjectionVolume, 10, 'g', -1, ' ');
-            QString data_stream_3 = QString("Initial loop volume    = %1 mL").arg(LOOP.loopVolume->text().toDouble(), 10, 'g', -1, ' ');
-            QString data_stream_4 = QString("Measured watercut      = %1 %").arg(measuredWatercut, 10, 'f', 2, ' ');
-            QString data_stream_5 = QString("[%1] [%2]").arg(currentDataTime.toString()).arg(LOOP.operatorName);
 
-            for (int pipe=0; pipe<3; pipe++)
-            {
-                if ((PIPE[pipe].status == ENABLED) && (QFileInfo(PIPE[pipe].file).exists()))
-                {
-                    QTextStream stream(&PIPE[pipe].file);
-                    PIPE[pipe].file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
-                    stream << '\n' << '\n' << data_stream << '\n' << data_stream_2 << '\n' << data_stream_3 << '\n' << data_stream_4 << '\n' << data_stream_5 << '\n';
-                    PIPE[pipe].file.close();
-                }
-            }
+void
+MainWindow::
+onCalSampled(const int pipe, const CAL_SAMPLES & sample)
+{
+    if (m_engine == NULL) return;
 
-			/// stop if razor
-			if ((!LOOP.isEEA) || (LOOP.cut == MID))
-            {
-                /// finish calibration if razor
-                informUser(QString("LOOP ")+QString::number(LOOP.loopNumber),BLANK,"Calibration has finished successfully.");
-                onActionStop();
-                return;
-            }
-			else if ((LOOP.cut == HIGH) || (LOOP.cut == FULL))
-            {
-                informUser(QString("LOOP ")+QString::number(LOOP.loopNumber),("Calibration has finished at "), QString(SALINITY[LOOP.salinityIndex]).append(" \% Salinity."));
-       
-				if (LOOP.isWaterRun) 
-				{
-					/// finish if reached at stop_salinity
-					if (SALINITY[LOOP.salinityIndex] == LOOP.saltStop->currentText())
-					{
-        				informUser(QString("LOOP ")+QString::number(LOOP.loopNumber),QString("Water Run Has Finished Successfully.      "),"Oil Run Will Get Started.");
-				
-						/// update run triggers	
-						LOOP.isOilRun = true;
-						LOOP.isWaterRun = false;
-						LOOP.isInitInject = true;
-						LOOP.salinityIndex = 0;
-
-						/// set oil run file name
-						for (int pipe=0; pipe<3; pipe++)
-						{
-							if (PIPE[pipe].status == ENABLED) PIPE[pipe].file.setFileName(PIPE[pipe].mainDirPath+"\\"+ QString("OIL__140").append(LOOP.filExt));
-						}
-					}
-					else // otherwise, go to next salinity
-					{
-						LOOP.isInitInject = true;
-						LOOP.salinityIndex++; // go to next salinity
-						for (int pipe=0; pipe<3; pipe++) if (PIPE[pipe].status == ENABLED) PIPE[pipe].file.setFileName(PIPE[pipe].mainDirPath+"\\"+ QString::number(SALINITY[LOOP.salinityIndex].toDouble()*100).append("_100").append(LOOP.filExt));
-					}
-				}
-				else // oil run needs to stop here
-				{	/// entire calibration has finished after oilRun finished
-					onActionStop(); 
-                	informUser(QString("LOOP ")+QString::number(LOOP.loopNumber),BLANK,"Calibration has finished successfully.");
-				}
-
-               	return;
-            }
+    const int row = m_calRows.at(pipe);
 
-			//---------- LOWCUT starts here -------------//
+    /// a simulation shows what the pipe itself reads; the config is not
+    /// touched once the engine runs
+    displayPipeReading(row, (m_engine->config().isSimulation) ? sample.pipeWatercut : sample.watercut, 0, sample.frequency, sample.temperature, sample.oilrp);
 
-            /// ADJUSTED.LCI
-            if (abs(totalInjectionVolume - (LOOP.injectionWaterPumpRate/60)*totalInjectionTime) > 0)
-            {
-                for (int pipe=0; pipe<3; pipe++)
-                {
-                    if ((PIPE[pipe].status == ENABLED) && PIPE[pipe].fileCalibrate.open(QIODevice::ReadOnly))
-                    {
-                        int i = 0;
-                        PIPE[pipe].fileAdjusted.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
-                        QTextStream in(&PIPE[pipe].fileCalibrate);
-                        QTextStream out(&PIPE[pipe].fileAdjusted);
-                        while (!in.atEnd())
-                        {
-                            QString line = in.readLine();
-                            if (i > 6)
-                            {
-                                /// process string and correct watercut
-                                QStringList data = line.split(" ");
-                                QString newData[data.size()];
-                                int k = 0;
-                                int x = 0;
-
-                                for (int j=0; j<data.size(); j++)
-                                {
-                                    if (data[j] != "")
-                                    {
-                                        newData[k] = data[j];
-                                        if (k==1) x = j; /// saving index for watercut
-                                        if (k==12)
-                                        {
-                                            correctedWatercut = (LOOP.oilRunStart->text().toDouble() + 100) - (100*exp(-(LOOP.injectionWaterPumpRate/60)*QString(newData[k]).toDouble()/LOOP.loopVolume->text().toDouble()));
-                                            data[x] = QString("%1").arg(correctedWatercut,7,'f',2,' ');
-                                        }
-                                        k++;
-                                    }
-                                }
-
-                                /// re-create a corrected data_stream
-                                line = QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10 %11 %12 %13 %14 %15 %16 %17 %18 %19").arg(newData[0].toDouble(), 9, 'g', -1, ' ').arg(correctedWatercut,7,'f',2,' ').arg(newData[2].toDouble(), 4, 'g', -1, ' ').arg(" INT").arg(1, 7, 'g', -1, ' ').arg(newData[5].toDouble(),9,'f',3,' ').arg(0,8,'f',2,' ').arg(newData[7].toDouble(),9,'f',2,' ').arg(newData[8].toDouble(),11,'f',2,' ').arg(0,8,'f',2,' ').arg(newData[10].toDouble(),12,'f',2,' ').arg(newData[11].toDouble(),12,'f',2,' ').arg(0,10,'f',2,' ').arg(newData[13].toDouble(), 11,'f',2,' ').arg(newData[14].toDouble(), 11,'f',2,' ').arg(newData[15].toDouble(), 11,'f',2,' ').arg(newData[16].toDouble(), 11,'f',2,' ').arg(newData[17].toDouble(), 11,'f',2,' ').arg(0,12,'f',2,' ');
-                            }
-
-                            out << line << '\n';
-                            i++;
-                        }
-
-                        PIPE[pipe].fileCalibrate.close();
-                        PIPE[pipe].fileAdjusted.close();
-                    }
-                }
-            }
+    updateGraph(row, sample.frequency, (isTempRunState(m_calState)) ? sample.temperature : sample.masterWatercut, SERIES_WATERCUT);
+    updateGraph(row, sample.frequency, sample.oilrp, SERIES_RP);
+}
 
-            /// finalize current file
-            for (int pipe=0; pipe<3; pipe++)
-            {
-                if ((PIPE[pipe].status == ENABLED) && QFileInfo(PIPE[pipe].fileCalibrate).exists())
-                {
-                    QTextStream stream(&PIPE[pipe].fileCalibrate);
-                    PIPE[pipe].fileCalibrate.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
-                    stream << '\n' << '\n' << data_stream << '\n' << data_stream_2 << '\n' << data_stream_3 << '\n' << data_stream_4 << '\n' << data_stream_5 << '\n';
-                    PIPE[pipe].fileCalibrate.close();
-                }
 
-                if (QFileInfo(PIPE[pipe].fileAdjusted).exists())
-                {
-                    QTextStream stream(&PIPE[pipe].fileAdjusted);
-                    PIPE[pipe].fileAdjusted.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
-                    stream << '\n' << '\n' << data_stream << '\n' << data_stream_2 << '\n' << data_stream_3 << '\n' << data_stream_4 << '\n' << data_stream_5 << '\n';
-                    PIPE[pipe].fileAdjusted.close();
-                }
-            }
+/// the engine's own numbers, copied on its thread
+void
+MainWindow::
+onCalProgress(const int pipe, const CAL_PROGRESSES & p)
+{
+    if (m_engine == NULL) return;
 
-            /// prepare for ROLLOVER.LCR
-            informUser(QString("LOOP ")+QString::number(LOOP.loopNumber),BLANK,"Please Switch The Injection Pump.");
-            LOOP.watercut += LOOP.intervalBigPump;
-            for (int pipe = 0; pipe < 3; pipe++)
-            {
-                if (PIPE[pipe].status == ENABLED)
-                {
-                    setFileNameForNextStage(pipe,"ROLLOVER.LCR");
-                    LOOP.watercut = correctedWatercut;
-                    PIPE[pipe].rolloverTracker = 0;
-                }
-            }
-        }
-    }
-    else if ((QFileInfo(PIPE[0].file).fileName() == "ROLLOVER.LCR") ||
-             (QFileInfo(PIPE[1].file).fileName() == "ROLLOVER.LCR") ||
-             (QFileInfo(PIPE[2].file).fileName() == "ROLLOVER.LCR")) // ROLLOVER.LCR
+    /// the loop status panel follows every injection
+    if (pipe < 0)
     {
-        for (int pipe = 0; pipe < 3; pipe++)
-        {
-            if ((PIPE[pipe].status == ENABLED) && PIPE[pipe].checkBox->isChecked())
-            {
-                readPipe(pipe, NO_STABILITY_CHECK);
-
-                if (PIPE[pipe].frequency < PIPE[pipe].frequency_prev)
-                {
-                    if (PIPE[pipe].rolloverTracker > 2) PIPE[pipe].status == DONE;
-                    else PIPE[pipe].rolloverTracker++;
-                    PIPE[pipe].frequency_prev = PIPE[pipe].frequency;
-                }
-                else PIPE[pipe].rolloverTracker = 0;
+        updateLoopStatus(p.watercut, p.salinity, p.injectionTime, p.totalInjectionVolume);
+        return;
+    }
 
-                /// read data
-                createDataStream(pipe,data_stream);
+    const int row = m_calRows.at(pipe);
+    const CAL_MASTERS & m = p.master;
 
-                /// create a new file if needed
-                if (!QFileInfo(PIPE[pipe].file).exists())
-                {
-                    /// re-read data
-                    createInjectFile(pipe, "Rollver", QString::number(LOOP.watercut), "1", "ROLLOVER");
-                    displayPipeReading(pipe, LOOP.watercut, PIPE[pipe].frequency_start, PIPE[pipe].frequency, PIPE[pipe].temperature, PIPE[pipe].oilrp);
-                }
+    PIPE[row]->status = p.status;
+    PIPE[row]->tempProgress->setValue(qMin(p.tempStability, CAL_STABLE_COUNT)*100/CAL_STABLE_COUNT);
+    PIPE[row]->freqProgress->setValue(qMin(p.freqStability, CAL_STABLE_COUNT)*100/CAL_STABLE_COUNT);
 
-                writeToCalFile(pipe, data_stream);
-            }
-        }
+    updateMasterPipeStatus(m.watercut, m.freq, m.temperature, m.phase, m.oilAdj, m.salinity);
+}
 
-        if (LOOP.isMaster)
-        {
-            int masterInjectionStartTime = PIPE[0].etimer->elapsed()/1000;
 
-            while (LOOP.masterWatercut < LOOP.watercut)
-            {
-                int masterInjectionTime = PIPE[0].etimer->elapsed()/1000;
+void
+MainWindow::
+onCalMessage(const QString & text)
+{
+    m_statusText->setText(text);
+}
 
-				/// start injection
-    			onActionStartInjection();
 
-                /// validate injection time
-                if ((masterInjectionTime - masterInjectionStartTime) > LOOP.maxInjectionWater)
-                {
-                    if (!isUserInputYes(QString("Injection Time")+QString::number(masterInjectionTime - masterInjectionStartTime)+QString(" Is Greater Than Max Water Injection Time ")+QString::number(LOOP.maxInjectionWater), "Do You Want To Continue?"))
-                    {
-                    	/// stop water injection
-    					onActionStopInjection();
-                        onActionStop();
-                        return;
-                    }
-                }
-            }
+/// the state the engine is in, as far as the window has heard
+void
+MainWindow::
+onCalTransition(const CAL_TIMINGS & timing)
+{
+    m_calState = timing.to;
+}
 
-            /// stop water injection
-    		onActionStopInjection();
 
-            /// set next watercut
-            LOOP.watercut += LOOP.intervalBigPump;
-        }
-        else
-        {
-            /// next injection time and update totalInjectionTime
-            double accumulatedInjectionTime = -(LOOP.loopVolume->text().toDouble()/(LOOP.injectionWaterPumpRate/60))*log((1-(LOOP.watercut - LOOP.oilRunStart->text().toDouble())/100));
-            injectionTime = accumulatedInjectionTime - accumulatedInjectionTime_prev;
-            totalInjectionTime += injectionTime;
-            totalInjectionVolume = totalInjectionTime*LOOP.injectionWaterPumpRate/60;
-            accumulatedInjectionTime_prev = accumulatedInjectionTime;
-
-            /// validate injection time
-            if (injectionTime > LOOP.maxInjectionWater)
-            {
-                if (!isUserInputYes(QString("Injection Time ")+QString::number(injectionTime)+QString(" Is Greater Than Max Water Injection Time ")+QString::number(LOOP.maxInjectionWater), "Do You Want To Continue?"))
-                {
-                    onActionStop();
-                    return;
-                }
-            }
+void
+MainWindow::
+stopCalibration()
+{
+    int i;
 
-            /// inject water to the pipe for "injectionTime" seconds
-            onActionStartInjection();
-            delay(injectionTime*1000);
-            onActionStopInjection();
+    LOOP.isCal = false;
+    LOOP.isEEA = false;
 
-            /// set next watercut
-            LOOP.watercut += LOOP.intervalBigPump;
-        }
-    }
-    else
+    for (i=0;i<PIPE.size();i++)
     {
-        /// finalize and close
-        QDateTime currentDataTime = QDateTime::currentDateTime();
-        QString data_stream   = QString("Total injection time   = %1 s").arg(totalInjectionTime, 10, 'g', -1, ' ');
-        QString data_stream_2 = QString("Total injection volume = %1 mL").arg(totalInjectionVolume, 10, 'g', -1, ' ');
-        QString data_stream_3 = QString("Initial loop volume    = %1 mL").arg(LOOP.loopVolume->text().toDouble(), 10, 'g', -1, ' ');
-        QString data_stream_4 = QString("[%1] [%2]").arg(currentDataTime.toString()).arg(LOOP.operatorName);
-
-        for (int pipe=0; pipe<3; pipe++)
-        {
-            if ((PIPE[pipe].status == DONE) && QFileInfo(PIPE[pipe].fileRollover).exists())
-            {
-                QTextStream stream(&PIPE[pipe].fileRollover);
-                PIPE[pipe].fileRollover.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
-                stream << '\n' << '\n' << data_stream << '\n' << data_stream_2 << '\n' << data_stream_3 << '\n' << data_stream_4 << '\n';
-                PIPE[pipe].fileRollover.close();
-                PIPE[pipe].checkBox->setChecked(false);
-            }
-        }
-   }
+        PIPE[i]->freqProgress->setValue(0);
+        PIPE[i]->tempProgress->setValue(0);
+        PIPE[i]->status = DISABLED;
+        PIPE[i]->checkBox->setChecked(false);
+        PIPE[i]->isStartFreq = true;
+    }
+
+	LOOP.axisY->setTitleText("Watercut (%)");
+    updateGraph(ALL, RESET_SERIES, RESET_SERIES, SERIES_WATERCUT); // reset chart
 
     return;
 }
 
 
-void
+/// true if any pipe row has a serial number
+bool
 MainWindow::
-inject(const int coil,const bool value)
+isSerialNumberEntered() const
 {
-    uint8_t dest[1024];
+    for (int pipe = 0; pipe < PIPE.size(); pipe++)
+    {
+        if (!PIPE[pipe]->slave->text().isEmpty()) return true;
+    }
 
-    /// set slave
-    memset( dest, 0, 1024 );
-    modbus_set_slave(LOOP.serialModbus, CONTROLBOX_SLAVE);
-    modbus_write_bit(LOOP.serialModbus,coil-ADDR_OFFSET, value);
+    return false;
 }
 
 
 void
 MainWindow::
-setFileNameForNextStage(const int pipe, const QString nextFileId)
+readMasterPipe()
 {
-    PIPE[pipe].file.setFileName(PIPE[pipe].mainDirPath+"\\"+nextFileId);
-    PIPE[pipe].freqStability = 0;
-    PIPE[pipe].tempStability = 0;
+    ReadPlanner planner(LOOP.readGap);
+
+    /// reset connection
+    LOOP.bus->setSlave(CONTROLBOX_SLAVE);
+
+    /// watercut, salinity, oil adjust, oil rp, temp, freq, phase and pressure
+    planner.addFloat(LOOP.ID_MASTER_WATERCUT-ADDR_OFFSET, &LOOP.masterWatercut);
+    planner.addFloat(LOOP.ID_MASTER_SALINITY-ADDR_OFFSET, &LOOP.masterSalinity);
+    planner.addFloat(LOOP.ID_MASTER_OIL_ADJUST-ADDR_OFFSET, &LOOP.masterOilAdj);
+    planner.addFloat(LOOP.ID_MASTER_OIL_RP-ADDR_OFFSET, &LOOP.masterOilRp);
+    planner.addFloat(LOOP.ID_MASTER_TEMPERATURE-ADDR_OFFSET, &LOOP.masterTemp);
+    planner.addFloat(LOOP.ID_MASTER_FREQ-ADDR_OFFSET, &LOOP.masterFreq);
+    planner.addFloat(LOOP.ID_MASTER_PHASE-ADDR_OFFSET, &LOOP.masterPhase);
+    planner.addFloat(LOOP.ID_MASTER_PRESSURE-ADDR_OFFSET, &LOOP.masterPressure);
+
+    /// one FC04 per coalesced range, run on the bus thread
+    isModbusTransmissionFailed = (busWait(LOOP.bus->submit<int>([&planner](modbus_t * modbus) { return planner.execute(modbus); })) > 0);
+
+    /// update master pipe display
+    updateMasterPipeStatus(LOOP.masterWatercut,LOOP.masterFreq,LOOP.masterTemp,LOOP.masterPhase,LOOP.masterOilAdj,LOOP.masterSalinity);
 }
 
 
-void
+/// false if the coil write failed
+bool
 MainWindow::
-writeToCalFile(int pipe, QString data_stream)
+inject(const int coil,const bool value)
 {
-    /// write to file
-    QTextStream stream(&PIPE[pipe].file);
-    PIPE[pipe].file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
-    stream << data_stream << '\n' ;
-    PIPE[pipe].file.close();
+    /// set slave
+    LOOP.bus->setSlave(CONTROLBOX_SLAVE);
+    return (busWait(LOOP.bus->writeBit(coil-ADDR_OFFSET, value)).rc == 1);
 }
 
 
@@ -4364,35 +3510,6 @@ onWriteButtonPressed()
 }
 
 
-float
-MainWindow::
-toFloat(QByteArray f)
-{
-    bool ok;
-    int sign = 1;
-
-    f = f.toHex(); // Convert to Hex
-
-    f = QByteArray::number(f.toLongLong(&ok, 16), 2);    // Convert hex to binary
-
-    if(f.length() == 32) {
-        if(f.at(0) == '1') sign =-1;     // If bit 0 is 1 number is negative
-        f.remove(0,1);                   // Remove sign bit
-    }
-
-    QByteArray fraction = f.right(23);  // Get the fractional part
-    double mantissa = 0;
-    for(int i = 0; i < fraction.length(); i++){  // Iterate through the array to claculate the fraction as a decimal.
-        if(fraction.at(i) == '1')
-            mantissa += 1.0 / (pow(2, i+1));
-    }
-
-    int exponent = f.left(f.length() - 23).toLongLong(&ok, 2) - 127;     // Calculate the exponent
-
-    return (sign * pow(2, exponent) * (mantissa + 1.0));
-}
-
-
 void
 MainWindow::
 onUpdateRegisters(const bool isEEA)
@@ -4428,26 +3545,26 @@ void
 MainWindow::
 displayPipeReading(const int pipe, const double watercut, const double startfreq, const double freq, const double temp, const double rp)
 {
-    if ((PIPE[pipe].status == ENABLED) && (!isModbusTransmissionFailed))
-    {
-        PIPE[pipe].wc->setText(QString("%1").arg(watercut,7,'f',2,' '));
-        if (PIPE[pipe].isStartFreq) PIPE[pipe].startFreq->setText(QString("%1").arg(freq,7,'f',3,' '));
-        PIPE[pipe].freq->setText(QString("%1").arg(freq,7,'f',3,' '));
-        PIPE[pipe].temp->setText(QString("%1").arg(temp,7,'f',2,' '));
-        PIPE[pipe].reflectedPower->setText(QString("%1").arg(rp,7,'f',3,' '));
-        if (freq > 100) PIPE[pipe].isStartFreq = false;
-    }
-	else if (pipe == ALL)
+    if (pipe == ALL)
     {
-		for (int i=0; i<ALL; i++)
+		for (int i=0; i<PIPE.size(); i++)
 		{ 
-			PIPE[i].wc->setText("0");
-        	PIPE[i].startFreq->setText("0");
-        	PIPE[i].freq->setText("0");
-        	PIPE[i].temp->setText("0");
-        	PIPE[i].reflectedPower->setText("0");
+			PIPE[i]->wc->setText("0");
+        	PIPE[i]->startFreq->setText("0");
+        	PIPE[i]->freq->setText("0");
+        	PIPE[i]->temp->setText("0");
+        	PIPE[i]->reflectedPower->setText("0");
 		}
     }
+    else if ((PIPE[pipe]->status == ENABLED) && (!isModbusTransmissionFailed))
+    {
+        PIPE[pipe]->wc->setText(QString("%1").arg(watercut,7,'f',2,' '));
+        if (PIPE[pipe]->isStartFreq) PIPE[pipe]->startFreq->setText(QString("%1").arg(freq,7,'f',3,' '));
+        PIPE[pipe]->freq->setText(QString("%1").arg(freq,7,'f',3,' '));
+        PIPE[pipe]->temp->setText(QString("%1").arg(temp,7,'f',2,' '));
+        PIPE[pipe]->reflectedPower->setText(QString("%1").arg(rp,7,'f',3,' '));
+        if (freq > 100) PIPE[pipe]->isStartFreq = false;
+    }
 }
 
 void
@@ -4481,28 +3598,6 @@ updateLoopStatus(const double watercut, const double salt, const double injectio
     }
 }
 
-void
-MainWindow::
-createDataStream(const int pipe, QString & data_stream)
-{
-    if (LOOP.isMaster)
-    {
-        if (LOOP.runMode == SIMULATION_RUN) data_stream = QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10 %11 %12 %13 %14 %15 %16 %17 %18").arg(PIPE[pipe].etimer->elapsed()/1000, 9, 'g', -1, ' ').arg(LOOP.masterWatercut,7,'f',2,' ').arg(PIPE[pipe].osc, 4, 'g', -1, ' ').arg(" INT").arg(1, 7, 'g', -1, ' ').arg(PIPE[pipe].frequency,9,'f',3,' ').arg(0,8,'f',2,' ').arg(PIPE[pipe].oilrp,9,'f',2,' ').arg(PIPE[pipe].temperature,11,'f',2,' ').arg(0,10,'f',2,' ').arg(LOOP.masterPressure,8,'f',2,' ').arg(LOOP.masterTemp, 11,'f',2,' ').arg(LOOP.masterOilAdj, 11,'f',2,' ').arg(LOOP.masterFreq, 11,'f',2,' ').arg(LOOP.masterWatercut, 11,'f',2,' ').arg(LOOP.masterOilRp, 11,'f',2,' ').arg(LOOP.masterPhase, 6,'f',1,' ').arg(PIPE[pipe].watercut,8,'f',2,' ');
-
-        else data_stream = QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10 %11 %12 %13 %14 %15 %16 %17 %18").arg(PIPE[pipe].etimer->elapsed()/1000, 9, 'g', -1, ' ').arg(LOOP.masterWatercut,7,'f',2,' ').arg(PIPE[pipe].osc, 4, 'g', -1, ' ').arg(" INT").arg(1, 7, 'g', -1, ' ').arg(PIPE[pipe].frequency,9,'f',3,' ').arg(0,8,'f',2,' ').arg(PIPE[pipe].oilrp,9,'f',2,' ').arg(PIPE[pipe].temperature,11,'f',2,' ').arg(0,10,'f',2,' ').arg(LOOP.masterPressure,8,'f',2,' ').arg(LOOP.masterTemp, 11,'f',2,' ').arg(LOOP.masterOilAdj, 11,'f',2,' ').arg(LOOP.masterFreq, 11,'f',2,' ').arg(LOOP.masterWatercut, 11,'f',2,' ').arg(LOOP.masterOilRp, 11,'f',2,' ').arg(LOOP.masterPhase, 6,'f',1,' ').arg(0,8,'f',2,' ');
-    }
-
-    else
-    {
-        if (LOOP.runMode == SIMULATION_RUN) data_stream = QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10 %11 %12 %13 %14 %15 %16 %17 %18").arg(PIPE[pipe].etimer->elapsed()/1000, 9, 'g', -1, ' ').arg(LOOP.watercut,7,'f',2,' ').arg(PIPE[pipe].osc, 4, 'g', -1, ' ').arg(" INT").arg(1, 7, 'g', -1, ' ').arg(PIPE[pipe].frequency,9,'f',3,' ').arg(0,8,'f',2,' ').arg(PIPE[pipe].oilrp,9,'f',2,' ').arg(PIPE[pipe].temperature,11,'f',2,' ').arg(0,10,'f',2,' ').arg(LOOP.masterPressure,8,'f',2,' ').arg(LOOP.masterTemp, 11,'f',2,' ').arg(LOOP.masterOilAdj, 11,'f',2,' ').arg(LOOP.masterFreq, 11,'f',2,' ').arg(LOOP.masterWatercut, 11,'f',2,' ').arg(LOOP.masterOilRp, 11,'f',2,' ').arg(LOOP.masterPhase, 6,'f',1,' ').arg(PIPE[pipe].watercut,8,'f',2,' ');
-
-        else data_stream = QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10 %11 %12 %13 %14 %15 %16 %17 %18").arg(PIPE[pipe].etimer->elapsed()/1000, 9, 'g', -1, ' ').arg(LOOP.watercut,7,'f',2,' ').arg(PIPE[pipe].osc, 4, 'g', -1, ' ').arg(" INT").arg(1, 7, 'g', -1, ' ').arg(PIPE[pipe].frequency,9,'f',3,' ').arg(0,8,'f',2,' ').arg(PIPE[pipe].oilrp,9,'f',2,' ').arg(PIPE[pipe].temperature,11,'f',2,' ').arg(0,10,'f',2,' ').arg(LOOP.masterPressure,8,'f',2,' ').arg(LOOP.masterTemp, 11,'f',2,' ').arg(LOOP.masterOilAdj, 11,'f',2,' ').arg(LOOP.masterFreq, 11,'f',2,' ').arg(LOOP.masterWatercut, 11,'f',2,' ').arg(LOOP.masterOilRp, 11,'f',2,' ').arg(LOOP.masterPhase, 6,'f',1,' ').arg(0,8,'f',2,' ');
-    }
-
-    delay(SLEEP_TIME);
-}
-
-
 void
 MainWindow::
 mousePressEvent(QMouseEvent *event)
@@ -19,12 +19,26 @@
 #include <QtCharts/QValueAxis>
 #include <QtCharts/QCategoryAxis>
 #include <QProgressDialog>
+#include <QScopedPointer>
+#include <functional>
 #include "modbus.h"
 #include "ui_about.h"
 #include "modbus-rtu.h"
 #include "modbus.h"
-
-#define RELEASE_VERSION             "0.1.5"
+#include "readplanner.h"
+#include "writeplanner.h"
+#include "modbusbus.h"
+#include "registercodec.h"
+#include "profilestation.h"
+#include "tempsync.h"
+#include "tracering.h"
+#include "busmonitormodel.h"
+#include "buscapture.h"
+#include "calstream.h"
+#include "injectionscheduler.h"
+#include "calconfig.h"
+#include "calengine.h"
+#include "calloops.h"
 
 #define RAZ                         0 
 #define EEA                         1 
@@ -40,45 +54,6 @@
 #define STABILITY_CHECK				true
 #define NO_STABILITY_CHECK			false
 
-#define PHASE_OIL					0
-#define PHASE_WATER					1
-#define PHASE_ERROR					2
-
-/// sub system	
-#define CONTROLBOX_SLAVE 	        100
-#define MODBUS_TIMER_SLAVE 			101
-#define OIL_MICROMOTION_SLAVE 	 	102
-#define WATER_MICROMOTION_SLAVE  	103
-
-#define COIL_OIL_PUMP				60
-#define COIL_WATER_PUMP				61
-
-#define EEA_ID_SN_PIPE  			40001 
-#define EEA_ID_WATERCUT  			11
-#define EEA_ID_SALINITY 			21
-#define EEA_ID_OIL_ADJUST  			23
-#define EEA_ID_TEMPERATURE  		15
-#define EEA_ID_WATER_ADJUST  		25
-#define EEA_ID_FREQ  				111 
-#define EEA_ID_OIL_RP  				115 
-#define EEA_ID_PRESSURE  			1005
-
-#define RAZ_ID_SN_PIPE  			201 
-#define RAZ_ID_WATERCUT  			3
-#define RAZ_ID_TEMPERATURE  		33 /// REG_TEMP_USER
-#define RAZ_ID_SALINITY  			9 
-#define RAZ_ID_OIL_ADJUST  			15
-#define RAZ_ID_WATER_ADJUST  		17
-#define RAZ_ID_FREQ  				19
-#define RAZ_ID_OIL_RP  				61
-
-#define FCT_RAZ_TEMP_ADJ    		781
-
-/// pipe cal status
-#define DONE						0
-#define ENABLED						1	
-#define DISABLED					2		
-
 /// master pipe
 #define MASTER_WATERCUT             3
 #define MASTER_WRITE                1
@@ -89,35 +64,15 @@
 #define T_BAR                       0
   
 #define BLANK						"                                                 " 
-/// calibration file names
-#define HIGH_EEA                    "\\HIGHCUT\\HC"
-#define FULL_EEA                    "\\FULLCUT\\FC" 
-#define MID_EEA                     "\\MIDCUT\\MC"
-#define LOW_EEA                     "\\LOWCUT\\LC"
-#define HIGH_RAZ                    "\\HIGHCUT_RAZ\\HC"
-#define FULL_RAZ                    "\\FULLCUT_RAZ\\FC" 
-#define MID_RAZ                     "\\MIDCUT_RAZ\\MC"
-#define LOW_RAZ                     "\\LOWCUT_RAZ\\LC"
-
-/// header lines
-#define HEADER3                     "Time From  Water  Osc  Tune Tuning            Incident Reflected              Injection  Master    Master      Master      Master      Master       Master   Master Pipe";
-#define HEADER4                     "Run Start   Cut   Band Type Voltage Frequency  Power     Power   Temperature    Time    Pressure Temperature Oil Adjust   Frequency   Watercut      Oil Rp   Phase  Watercut";
-#define HEADER5                     "========= ======= ==== ==== ======= ========= ======== ========= =========== ========== ======== =========== =========== =========== =========== =========== ====== ========";
 
 /// loop
 #define L1                          0
 
 /// pipe
-#define P1                          0
-#define P2                          1
-#define P3                          2
-#define ALL                         3
-
-#define EEA_INJECTION_FILE          "EEA INJECTION FILE"
-#define RAZ_INJECTION_FILE          "RAZOR INJECTION FILE"
-
-#define MAIN_SERVER                 "MainServer"
-#define LOCAL_SERVER                "LocalServer"
+#define ALL                         -1      /// every pipe of the loop
+#define PIPE_DEFAULT_COUNT          3
+#define PIPE_MAX_COUNT              16
+#define PIPE_ROW_HEIGHT             40
 
 /// stage update
 #define ORANGE						"color: rgba(232, 126, 4, 1);"
@@ -126,50 +81,8 @@
 #define BLACK						"color: black;"
 #define BLUE						"color: blue;"
 
-/// LOOP.runMode
-#define TEMPRUN_MIN					"TEMPRUN MIN"	
-#define TEMPRUN_HIGH				"TEMPRUN HIGH"	
-#define TEMPRUN_INJECT				"TEMPRUN INJ"	
-#define TEMPRUN_ONLY				"TEMPRUN ONLY"	
-#define INJECT_RUN					"INJECT"	
-#define INJECT_STANDBY				"INJECT STANDBY"	
-#define SIMULATION_RUN				"SIMULATION"	
-#define STOP_CALIBRATION			"STOP"	
-#define READ_MASTERPIPE				"READ MASTER PIPE"	
-#define TEMP_IN_SYNC				"TEMP IN SYNC"	
-#define WATER_RUN					"WATER RUN"	
-#define OIL_RUN						"OIL RUN"	
-
-//////////////////////////
-/////// JSON KEYS ////////
-//////////////////////////
-
-#define LOOP_OIL_PUMP_RATE            "LOOP.OilPumpRate"
-#define LOOP_WATER_PUMP_RATE          "LOOP.WaterPumpRate"
-#define LOOP_SMALL_WATER_PUMP_RATE    "LOOP.SmallWaterPumpRate"
-#define LOOP_BUCKET                   "LOOP.Bucket"
-#define LOOP_MARK                     "LOOP.Mark"
-#define LOOP_METHOD                   "LOOP.Method"
-#define LOOP_PRESSURE                 "LOOP.PresssureSensorSlope"
-#define LOOP_MIN_TEMP                 "LOOP.MinRefTemp"
-#define LOOP_MAX_TEMP                 "LOOP.MaxRefTemp"
-#define LOOP_INJECTION_TEMP           "LOOP.InjectionTemp"
-#define LOOP_X_DELAY                  "LOOP.XDelay"
-#define LOOP_Y_FREQ                   "LOOP.YFreq"
-#define LOOP_Z_TEMP                   "LOOP.ZTemp"
-#define LOOP_INTERVAL_SMALL_PUMP      "LOOP.IntervalSmallPump"
-#define LOOP_INTERVAL_BIG_PUMP  	  "LOOP.IntervalBigPump"
-#define LOOP_INTERVAL_OIL_PUMP  	  "LOOP.IntervalOilPump"
-#define LOOP_NUMBER  	  			  "LOOP.LoopNumber"
-#define LOOP_MASTER_MIN  			  "LOOP.MasterMin"
-#define LOOP_MASTER_MAX  			  "LOOP.MasterMax"
-#define LOOP_MASTER_DELTA  			  "LOOP.MasterDelta"
-#define LOOP_MASTER_DELTA_FINAL		  "LOOP.MasterDeltaFinal"
-#define LOOP_MAX_INJECTION_WATER   	  "LOOP.MaxInjectionWater"
-#define LOOP_MAX_INJECTION_OIL   	  "LOOP.MaxInjectionOil"
-#define LOOP_PORT_INDEX    	          "LOOP.PortIndex"
-
-#define FILE_LIST                   "Filelist.LST"
+/// bus captures, next to the executable
+#define CAPTURE_FOLDER              "capture"
 
 #define TIMER_DELAY         6000
 #define NO_FILE             0
@@ -195,10 +108,15 @@
 #define INT_W               3
 #define COIL_R              4
 #define COIL_W              5
-#define ADDR_OFFSET         1
 
-#define RAZ_MEAS_AI         173
-#define RAZ_TRIM_AI         175
+/// factory default table access
+#define COIL_UNLOCKED_FACTORY_DEFAULT   999
+#define COIL_UPDATE_FACTORY_DEFAULT     9999
+
+/// lcd model code, 4 registers holding 16 characters
+#define RAZ_MODEL_CODE      219
+#define MODEL_CODE_REGISTERS 4
+#define MODEL_CODE_LENGTH   16
 
 #define RESET_SERIES		-10000
 
@@ -215,26 +133,37 @@ public:
     }
 };
 
+/// CalEngine's questions as message boxes, titled with the loop. The
+/// engine asks from its own thread, the boxes open on the window's; once
+/// the engine is aborted nothing more is asked.
+class DialogOperator : public CalOperator
+{
+public:
+    DialogOperator(QWidget * parent, const QString & caption) : m_parent(parent), m_caption(caption), m_engine(NULL) {}
+
+    void setEngine(const CalEngine * engine) { m_engine = engine; }
+
+    bool confirm(const QString &, const QString &);
+    double askValue(const QString &, const double);
+    QString askText(const QString &, const QString &);
+    void inform(const QString &, const QString &);
+
+private:
+    bool exec(const std::function<void()> &);
+
+    QWidget * m_parent;
+    QString m_caption;
+    const CalEngine * m_engine;
+};
+
 typedef struct PIPE_OBJECT 
 {
 	bool isStartFreq;
-    int osc;
-    int tempStability;
-    int freqStability;
 	int status;
-	int rolloverTracker;
-	QString calFile;
-    QString mainDirPath;
-    QString localDirPath;
     QString pipeId;
-    QFile file;
-    QFile fileCalibrate;
-    QFile fileAdjusted;
-    QFile fileRollover;
     QLineEdit * slave; 
     QSplineSeries * series;
     QSplineSeries * series_2;
-    QElapsedTimer * etimer;
     QCheckBox * checkBox;
     QCheckBox * lineView; 
     QLineEdit * wc;
@@ -245,60 +174,23 @@ typedef struct PIPE_OBJECT
 	QProgressBar * freqProgress;
 	QProgressBar * tempProgress;
 
-	double watercut;
-	double temperature;
-    double temperature_prev;
-    double frequency;
-    double frequency_prev;
-    double frequency_start;
-    double oilrp;
-    double measai;
-    double trimai;
-
 	QPen pen;
 	QPen pen2;
 
-	PIPE_OBJECT() : isStartFreq(true), osc(0), tempStability(0), freqStability(0), status(ENABLED), rolloverTracker(0), calFile(""),  mainDirPath(""), localDirPath(""), pipeId(""), file(""), fileCalibrate("CALIBRATE"), fileAdjusted("ADJUSTED"), fileRollover("ROLLOVER"), slave(new QLineEdit), series(new QSplineSeries), series_2(new QSplineSeries), etimer(new QElapsedTimer), lineView(new QCheckBox), checkBox(new QCheckBox), wc(new QLineEdit), startFreq(new QLineEdit), freq(new QLineEdit), temp(new QLineEdit), reflectedPower(new QLineEdit), freqProgress(new QProgressBar), tempProgress(new QProgressBar), watercut(0), temperature(0), frequency(0), temperature_prev(0), frequency_prev(0), frequency_start(0), oilrp(0), measai(0), trimai(0), pen (Qt::green, 3, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin), pen2 (Qt::green, 3, Qt::DotLine, Qt::RoundCap, Qt::RoundJoin)  {}
-
-    //This is the destructor.  Will delete the array of vertices, if present.
-    ~PIPE_OBJECT()
-    {
-        if (slave) delete slave;
-        if (series) delete series;
-        if (etimer) delete etimer;
-        if (checkBox) delete checkBox;
-        if (lineView) delete lineView; 
-        if (wc) delete wc;
-        if (startFreq) delete startFreq;
-        if (freq) delete freq;
-        if (temp) delete temp;
-        if (reflectedPower) delete reflectedPower;
-		if (freqProgress) delete freqProgress;
-		if (tempProgress) delete tempProgress;
-    }
+	/// the row widgets belong to the pipe panel and the series to the chart
+	PIPE_OBJECT() : isStartFreq(true), status(ENABLED), pipeId(""), slave(NULL), series(new QSplineSeries), series_2(new QSplineSeries), checkBox(NULL), lineView(NULL), wc(NULL), startFreq(NULL), freq(NULL), temp(NULL), reflectedPower(NULL), freqProgress(NULL), tempProgress(NULL), pen (Qt::green, 3, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin), pen2 (Qt::green, 3, Qt::DotLine, Qt::RoundCap, Qt::RoundJoin)  {}
 
 } PIPES;
 
 
 typedef struct LOOP_OBJECT 
 {
-	bool isWaterRun;
-	bool isOilRun;
-	bool isPause;
-	bool isTempRunSkip;
-	bool isInjectionOn;
-	bool isMaster;
     bool isCal;
 	bool isEEA;
-	bool isInitTempRun;
-	bool isInitInject;
-	bool isTempRunOnly;
-	QString cut;
 	double masterMin;
 	double masterMax;
 	double masterDelta;
 	double masterDeltaFinal;
-    double watercut;
 	double injectionOilPumpRate;
     double injectionWaterPumpRate;
     double injectionSmallWaterPumpRate;
@@ -309,28 +201,24 @@ typedef struct LOOP_OBJECT
     double minTemp;
     double maxTemp;
     double injectTemp;
-    QString currentTemp;
-    QString targetTemp;
-	int phaseRolloverCounter;
     int xDelay;
 	int loopNumber;
 	int maxInjectionWater;
 	int maxInjectionOil;
 	int portIndex;
-	int maxGraphDataPoint;
-	int salinityIndex;
+	int readGap;
+	int turnaround;
+	int monitorRows;
+	bool isCapture;
+	bool isInjectionTimer;
+	int pipeCount;
+	double stableConfidence;
+	bool isInjectionModel;
     double yFreq;
     double zTemp;
 	double intervalOilPump;
 	double intervalBigPump;
 	double intervalSmallPump;
-	double intervalRollover;
-	QString runMode;
-	QString filExt;
-	QString calExt;
-	QString adjExt;
-	QString rolExt;
-	QString simExt;
 	QString operatorName;
     
 	/// register address for calibration
@@ -370,18 +258,21 @@ typedef struct LOOP_OBJECT
 	double masterPhase;
 	double masterPressure;
 
-	modbus_t * modbus;
-    modbus_t * serialModbus;
+    ModbusBus * bus;
+    InjectionScheduler * injection;
     QChart * chart;
     QChartView * chartView;
     QValueAxis * axisX;
     QValueAxis * axisY;
     QValueAxis * axisY2;
 
-	LOOP_OBJECT() : isWaterRun(false), isOilRun(false), isPause(false), isTempRunSkip(false), isInjectionOn(false), isTempRunOnly(false), isMaster(true), isCal(true), isEEA(false), isInitTempRun(1), isInitInject(1), cut(MID_EEA), masterMin(0), masterMax(0),masterDelta(0), masterDeltaFinal(0), watercut(0), injectionOilPumpRate(0), injectionWaterPumpRate(0), injectionSmallWaterPumpRate(0), injectionBucket(0), injectionMark(0), injectionMethod(0), pressureSensorSlope(0), minTemp(0), maxTemp(0),currentTemp("0"), targetTemp("0"), injectTemp(0), phaseRolloverCounter(0), xDelay(0), loopNumber(0), maxInjectionWater(80), maxInjectionOil(200), portIndex(0), maxGraphDataPoint(0), salinityIndex(0), yFreq(0), zTemp(0), intervalOilPump(0.25), intervalBigPump(1), intervalSmallPump(0.25), runMode(""), filExt(""), calExt(""), adjExt(""),rolExt(""),  simExt(".SIM"), operatorName(""), ID_SN_PIPE(0), ID_WATERCUT(0), ID_TEMPERATURE(0), ID_SALINITY(0), ID_OIL_ADJUST(0), ID_WATER_ADJUST(0), ID_FREQ(0), ID_OIL_RP(0), ID_PRESSURE(0), ID_MASTER_WATERCUT(11), ID_MASTER_SALINITY(21), ID_MASTER_OIL_ADJUST(23), ID_MASTER_OIL_RP(115), ID_MASTER_TEMPERATURE(15),ID_MASTER_FREQ(111),ID_MASTER_PHASE(17),ID_MASTER_PRESSURE(1005), loopVolume(new QLineEdit), saltStart(new QComboBox), saltStop(new QComboBox), oilTemp(new QComboBox), waterRunStart(new QLineEdit), waterRunStop(new QLineEdit), oilRunStart(new QLineEdit), oilRunStop(new QLineEdit), masterWatercut(0), masterSalinity(0), masterOilAdj(0), masterOilRp(0), masterFreq(0), masterTemp(0), masterPhase(1),masterPressure(1), modbus(NULL), serialModbus(NULL), chart(new QChart), chartView(new QChartView), axisX(new QValueAxis), axisY(new QValueAxis), axisY2(new QValueAxis) {};
+	LOOP_OBJECT() : isCal(true), isEEA(false), masterMin(0), masterMax(0),masterDelta(0), masterDeltaFinal(0), injectionOilPumpRate(0), injectionWaterPumpRate(0), injectionSmallWaterPumpRate(0), injectionBucket(0), injectionMark(0), injectionMethod(0), pressureSensorSlope(0), minTemp(0), maxTemp(0),injectTemp(0), xDelay(0), loopNumber(0), maxInjectionWater(80), maxInjectionOil(200), portIndex(0), readGap(PLANNER_DEFAULT_GAP), turnaround(BUS_DEFAULT_TURNAROUND), monitorRows(MONITOR_DEFAULT_ROWS), isCapture(false), isInjectionTimer(false), pipeCount(PIPE_DEFAULT_COUNT), stableConfidence(SETTLING_DEFAULT_CONFIDENCE), isInjectionModel(true), yFreq(0), zTemp(0), intervalOilPump(0.25), intervalBigPump(1), intervalSmallPump(0.25), operatorName(""), ID_SN_PIPE(0), ID_WATERCUT(0), ID_TEMPERATURE(0), ID_SALINITY(0), ID_OIL_ADJUST(0), ID_WATER_ADJUST(0), ID_FREQ(0), ID_OIL_RP(0), ID_PRESSURE(0), ID_MASTER_WATERCUT(11), ID_MASTER_SALINITY(21), ID_MASTER_OIL_ADJUST(23), ID_MASTER_OIL_RP(115), ID_MASTER_TEMPERATURE(15),ID_MASTER_FREQ(111),ID_MASTER_PHASE(17),ID_MASTER_PRESSURE(1005), loopVolume(new QLineEdit), saltStart(new QComboBox), saltStop(new QComboBox), oilTemp(new QComboBox), waterRunStart(new QLineEdit), waterRunStop(new QLineEdit), oilRunStart(new QLineEdit), oilRunStop(new QLineEdit), masterWatercut(0), masterSalinity(0), masterOilAdj(0), masterOilRp(0), masterFreq(0), masterTemp(0), masterPhase(1),masterPressure(1), bus(new ModbusBus), injection(new InjectionScheduler(bus)), chart(new QChart), chartView(new QChartView), axisX(new QValueAxis), axisY(new QValueAxis), axisY2(new QValueAxis) {};
 
 	~LOOP_OBJECT()
 	{
+		/// the scheduler's pulses run on the bus, it goes first
+		if (injection) delete injection;
+		if (bus) delete bus;
 		if (chart) delete chart;
 		if (chartView) delete chartView;
         if (loopVolume) delete loopVolume;
@@ -410,38 +301,34 @@ public:
     ~MainWindow();
 
     void delay(int);
-    modbus_t*  modbus() { return LOOP.serialModbus; }
 
     int setupModbusPort();
 
-	void initTempRun();
 	double read_request(int, int, int, int, uint8_t *, uint16_t *, bool);
+	void planProfileRead(ReadPlanner &, QVector<int> &);
+	bool executeProfileRead(ReadPlanner &, QProgressDialog &, int &);
+	void showProfileRead(const ReadPlanner &);
+	void planProfileWrite(WritePlanner &, QVector<int> &);
+	bool executeProfileWrite(const WritePlanner &, const QVector<int> &, QProgressDialog &, int &);
 	void write_request(int, int, double, int, bool);
-	void createDataStream(const int pipe, QString & data_stream);
-	void startTempRun();
 	void updateCurrentStage(const QString, const QString);
 	void updateLoopStatus(const double, const double, const double, const double);
-	void readPipe(const int, const bool);
-	void inject(const int, const bool);
-	void readLoopConfiguration();
-    void masterPipe(int, QString, bool);
-    void setFileNameForNextStage(const int, const QString);
-    void writeToCalFile(int, QString);
-    void closeCalibrationFile(int, int, double);
+	bool isSerialNumberEntered() const;
+	bool inject(const int, const bool);
+	void readLoopConfiguration(CAL_CONFIGS &);
+	void restoreLoopConfiguration(const QVariantMap &);
     void changeModbusInterface(const QString &port, char parity);
     void releaseSerialModbus();
 	void setValidators();
     void initializeGraph();
     void initializePipeObjects();
+    void createPipeRow(const int);
     void initializeLoopObjects();
-    bool validateSerialNumber(modbus_t *);   
     void displayPipeReading(const int, const double, const double, const double, const double, const double); 
 	void updateMasterPipeStatus(const double, const double, const double, const double, const double, const double);
     bool informUser(const QString, const QString, const QString);
-    void busMonitorAddItem( bool isRequest,uint16_t slave,uint8_t func,uint16_t addr,uint16_t nb,uint16_t expectedCRC,uint16_t actualCRC );
     static void stBusMonitorAddItem( modbus_t * modbus,uint8_t isOut, uint16_t slave, uint8_t func, uint16_t addr,uint16_t nb, uint16_t expectedCRC, uint16_t actualCRC );
     static void stBusMonitorRawData( modbus_t * modbus, uint8_t * data,uint8_t dataLen, uint8_t addNewline );
-    void busMonitorRawData( uint8_t * data, uint8_t dataLen, bool addNewline );
     void connectSerialPort();
     void connectActions();
     void connectModbusMonitor();
@@ -453,17 +340,20 @@ public:
     void connectLineView();
     void connectReturnPressed();
     void connectProductBtnPressed();
-	void connectMasterPipe();
 	void connectCheckbox();
     void setupModbusPorts();
     void updateLoopTabIcon(const bool);
-    bool prepareCalibration();
     void initializeTabIcons();
-    float toFloat(QByteArray arr);
     void initializeModbusMonitor();
     void onFunctionCodeChanges();
     void updateChart(QSplineSeries *, double, double, double, double, double, double, double, double);
     void updateGraph(const int, const double, const double, const int);
+    void onCalStage(const QString &);
+    void onCalSampled(const int, const CAL_SAMPLES &);
+    void onCalProgress(const int, const CAL_PROGRESSES &);
+    void onCalMessage(const QString &);
+    void onCalTransition(const CAL_TIMINGS &);
+    void onCalFinished();
 
 protected:
 	void mousePressEvent(QMouseEvent *event) override;
@@ -471,9 +361,7 @@ protected:
 private slots:
 
 	/// graph 
-	void toggleLineView_P1(bool); 
-    void toggleLineView_P2(bool); 
-    void toggleLineView_P3(bool); 
+	void toggleLineView(const int, const bool);
 	void onViewYAxisData(bool);
 
     /// config menu
@@ -510,22 +398,18 @@ private slots:
     void onActionSettings();
     void onActionSync();
     void onActionStart();
+    void onActionReplay();
     void onActionStop();
     void onActionStopPressed();
     void onActionSkip();
     void onActionPause();
     void onActionStopInjection();
-    void onActionStartInjection();
-	void onMasterPipeToggled(const bool);
-    void runInjection();
-    void runTempRun();
     void stopCalibration();
-	void updateFileList(const QString, const int, const int);
-	void createInjectFile(const int, const QString, const QString, const QString, const QString);
-    void startCalibration();
+    void startCalibration(const bool, const QString & recording = QString());
     void onRtuPortActive(bool);
     void changeSerialPort(int);
-    void createTempRunFile(const int, const QString, const QString, const QString, const int);
+    void drainBusMonitor();
+    void onCaptureViewer();
     void initializeToolbarIcons(void);
     void clearMonitors( void );
     void updateRequestPreview( void );
@@ -533,7 +417,6 @@ private slots:
     void enableHexView( void );
     void sendModbusRequest( void );
     void onSendButtonPress( void );
-    void pollForDataOnBus( void );
     void aboutQModBus( void );
     void onCheckBoxChecked(bool);
 	void onCheckBoxClicked(const bool);
@@ -546,6 +429,8 @@ private slots:
     void loadCsvFile();
     void loadCsvTemplate();
     void onUploadEquation();
+    void onSyncEquation();
+    void onBatchEquation();
     void onDownloadEquation();
     void onUpdateRegisters(const bool);
     void onDownloadButtonChecked(bool);
@@ -554,8 +439,8 @@ private slots:
 	void onLockFactoryDefault();
 	void onUnlockFactoryDefault();
     void onUpdateFactoryDefaultPressed();
-    void updatePipeStability(const int, const bool);
     void readJsonConfigFile();
+    void offerResume();
     void writeJsonConfigFile();
 
 signals:
@@ -578,12 +463,16 @@ private:
 	QString m_mainServer;
 
 	/// connection
-    modbus_t * m_modbus_snipping;
     QIntValidator *serialNumberValidator;
     QWidget * m_statusInd;
     QLabel * m_statusText;
     QTimer * m_pollTimer;
     QTimer * m_statusTimer;
+    QTimer * m_monitorTimer;
+    QScopedPointer<MonitorRing> m_monitorRing;    /// filled by the bus thread, outlives LOOP
+    BusMonitorModel * m_busMonitor;
+    BusHexModel * m_busHex;
+    BusCaptureWriter m_capture;
     bool m_tcpActive;
     bool m_poll;
 	bool isModbusTransmissionFailed;
@@ -591,8 +480,21 @@ private:
 	/// loop objects
 	LOOPS LOOP;
 
-	/// pipe objects
-	PIPES PIPE [3];
+	/// pipe objects, LOOP.pipeCount of them
+	QVector<PIPES *> PIPE;
+
+	/// the running calibration, NULL between runs. The engine runs on the
+	/// thread m_loops gives it and is only told to pause, skip or stop from
+	/// here, what it reports arrives queued. Pipe i of the engine is row
+	/// m_calRows[i] of the panel.
+	CalLoops * m_loops;
+	CalEngine * m_engine;
+	QScopedPointer<DialogOperator> m_calOperator;
+	QScopedPointer<CalClock> m_calClock;
+	QScopedPointer<CalReplay> m_calReplay;
+	CAL_STATE m_calState;
+	QString m_calStage;
+	QVector<int> m_calRows;
 };
 
 #endif // MAINWINDOW_H
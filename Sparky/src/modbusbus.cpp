@@ -0,0 +1,246 @@
+#include <errno.h>
+#include "modbusbus.h"
+
+ModbusBus::
+ModbusBus(QObject * parent) :
+    QObject(parent),
+    m_context(new QObject),
+    m_pollTimer(NULL),
+    m_modbus(NULL),
+    m_slave(0),
+    m_isOpen(false),
+    m_isPolling(false)
+{
+    m_thread.setObjectName("ModbusBus");
+    m_context->moveToThread(&m_thread);
+    m_thread.start();
+
+    /// the poll timer has to be born in the bus thread
+    QMetaObject::invokeMethod(m_context, [this]()
+    {
+        m_pollTimer = new QTimer(m_context);
+        connect(m_pollTimer, &QTimer::timeout, m_context, [this]() { poll(); });
+    }, Qt::BlockingQueuedConnection);
+}
+
+
+ModbusBus::
+~ModbusBus()
+{
+    close();
+
+    QMetaObject::invokeMethod(m_context, [this]() { m_pollTimer->stop(); }, Qt::BlockingQueuedConnection);
+
+    m_thread.quit();
+    m_thread.wait();
+    delete m_context;
+}
+
+
+bool
+ModbusBus::
+open(const QString & port, const int baud, const char parity, const int dataBit, const int stopBit)
+{
+    const QByteArray device = port.toLatin1();
+
+    close();
+
+    m_isOpen = submit<bool>([device, baud, parity, dataBit, stopBit, this](modbus_t *)
+    {
+        m_modbus = modbus_new_rtu(device.constData(), baud, parity, dataBit, stopBit);
+        if (m_modbus == NULL) return false;
+
+        if (modbus_connect(m_modbus) == -1)
+        {
+            modbus_free(m_modbus);
+            m_modbus = NULL;
+            return false;
+        }
+
+        return true;
+    }).result();
+
+    return m_isOpen;
+}
+
+
+void
+ModbusBus::
+close()
+{
+    m_isOpen = false;
+
+    submit<bool>([this](modbus_t * modbus)
+    {
+        if (modbus == NULL) return false;
+
+        modbus_close(modbus);
+        modbus_free(modbus);
+        m_modbus = NULL;
+        return true;
+    }).waitForFinished();
+}
+
+
+void
+ModbusBus::
+setMonitor(modbus_monitor_add_item_fnc_t addItem, modbus_monitor_raw_data_fnc_t rawData)
+{
+    submit<bool>([addItem, rawData](modbus_t * modbus)
+    {
+        if (modbus == NULL) return false;
+
+        modbus_register_monitor_add_item_fnc(modbus, addItem);
+        modbus_register_monitor_raw_data_fnc(modbus, rawData);
+        return true;
+    });
+}
+
+
+void
+ModbusBus::
+setPolling(const bool isPolling)
+{
+    /// the flag is read by poll() on the bus thread, it changes there too
+    QMetaObject::invokeMethod(m_context, [this, isPolling]()
+    {
+        m_isPolling = isPolling;
+        (isPolling) ? m_pollTimer->start(BUS_POLL_INTERVAL) : m_pollTimer->stop();
+    }, Qt::QueuedConnection);
+}
+
+
+void
+ModbusBus::
+setTurnaround(const int usec)
+{
+    submit<bool>([usec](modbus_t * modbus)
+    {
+        return (modbus) && (modbus_rtu_set_turnaround(modbus, MODBUS_RTU_TURNAROUND_DEFAULT, usec) == 0);
+    });
+}
+
+
+void
+ModbusBus::
+poll()
+{
+    /// sniff the line for frames we did not send ourselves
+    if (m_modbus && m_isPolling) modbus_poll(m_modbus);
+}
+
+
+QFuture<BUS_REPLIES>
+ModbusBus::
+readBits(const int addr, const int nb)
+{
+    return submit<BUS_REPLIES>([addr, nb](modbus_t * modbus)
+    {
+        BUS_REPLIES reply;
+        reply.bits.resize(nb);
+        reply.rc = (modbus) ? modbus_read_bits(modbus, addr, nb, reply.bits.data()) : -1;
+        reply.error = errno;
+        return reply;
+    });
+}
+
+
+QFuture<BUS_REPLIES>
+ModbusBus::
+readInputBits(const int addr, const int nb)
+{
+    return submit<BUS_REPLIES>([addr, nb](modbus_t * modbus)
+    {
+        BUS_REPLIES reply;
+        reply.bits.resize(nb);
+        reply.rc = (modbus) ? modbus_read_input_bits(modbus, addr, nb, reply.bits.data()) : -1;
+        reply.error = errno;
+        return reply;
+    });
+}
+
+
+QFuture<BUS_REPLIES>
+ModbusBus::
+readRegisters(const int addr, const int nb)
+{
+    return submit<BUS_REPLIES>([addr, nb](modbus_t * modbus)
+    {
+        BUS_REPLIES reply;
+        reply.regs.resize(nb);
+        reply.rc = (modbus) ? modbus_read_registers(modbus, addr, nb, reply.regs.data()) : -1;
+        reply.error = errno;
+        return reply;
+    });
+}
+
+
+QFuture<BUS_REPLIES>
+ModbusBus::
+readInputRegisters(const int addr, const int nb)
+{
+    return submit<BUS_REPLIES>([addr, nb](modbus_t * modbus)
+    {
+        BUS_REPLIES reply;
+        reply.regs.resize(nb);
+        reply.rc = (modbus) ? modbus_read_input_registers(modbus, addr, nb, reply.regs.data()) : -1;
+        reply.error = errno;
+        return reply;
+    });
+}
+
+
+QFuture<BUS_REPLIES>
+ModbusBus::
+writeBit(const int addr, const bool status)
+{
+    return submit<BUS_REPLIES>([addr, status](modbus_t * modbus)
+    {
+        BUS_REPLIES reply;
+        reply.rc = (modbus) ? modbus_write_bit(modbus, addr, status) : -1;
+        reply.error = errno;
+        return reply;
+    });
+}
+
+
+QFuture<BUS_REPLIES>
+ModbusBus::
+writeRegister(const int addr, const int value)
+{
+    return submit<BUS_REPLIES>([addr, value](modbus_t * modbus)
+    {
+        BUS_REPLIES reply;
+        reply.rc = (modbus) ? modbus_write_register(modbus, addr, value) : -1;
+        reply.error = errno;
+        return reply;
+    });
+}
+
+
+QFuture<BUS_REPLIES>
+ModbusBus::
+writeBits(const int addr, const QVector<uint8_t> & data)
+{
+    return submit<BUS_REPLIES>([addr, data](modbus_t * modbus)
+    {
+        BUS_REPLIES reply;
+        reply.rc = (modbus) ? modbus_write_bits(modbus, addr, data.size(), data.constData()) : -1;
+        reply.error = errno;
+        return reply;
+    });
+}
+
+
+QFuture<BUS_REPLIES>
+ModbusBus::
+writeRegisters(const int addr, const QVector<uint16_t> & data)
+{
+    return submit<BUS_REPLIES>([addr, data](modbus_t * modbus)
+    {
+        BUS_REPLIES reply;
+        reply.rc = (modbus) ? modbus_write_registers(modbus, addr, data.size(), data.constData()) : -1;
+        reply.error = errno;
+        return reply;
+    });
+}
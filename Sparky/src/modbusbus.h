@@ -0,0 +1,129 @@
+#ifndef MODBUSBUS_H
+#define MODBUSBUS_H
+
+#include <functional>
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QString>
+#include <QVector>
+#include <QFuture>
+#include <QFutureInterface>
+#include <QFutureWatcher>
+#include <QEventLoop>
+#include "modbus.h"
+#include "modbus-rtu.h"
+
+/// idle sniffing period of the bus thread (ms)
+#define BUS_POLL_INTERVAL           5
+
+/// silence granted to a slave on top of t3.5 before it is addressed (us)
+#define BUS_DEFAULT_TURNAROUND      5000
+
+typedef struct BUS_REPLY
+{
+    int rc;
+    int error;
+    QVector<uint16_t> regs;
+    QVector<uint8_t> bits;
+
+    BUS_REPLY() : rc(-1), error(0) {}
+
+} BUS_REPLIES;
+
+
+/// Owns the serial modbus context on a dedicated thread. Every request is
+/// queued to that thread and answered through a QFuture, so the GUI thread
+/// never sits inside a libmodbus call.
+class ModbusBus : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ModbusBus(QObject * parent = 0);
+    ~ModbusBus();
+
+    bool open(const QString &, const int, const char, const int, const int);
+    void close();
+    bool isOpen() const { return m_isOpen; }
+
+    /// slave used by every request submitted after this call
+    void setSlave(const int slave) { m_slave = slave; }
+    int slave() const { return m_slave; }
+
+    void setMonitor(modbus_monitor_add_item_fnc_t, modbus_monitor_raw_data_fnc_t);
+    void setPolling(const bool);
+    void setTurnaround(const int);
+
+    template <typename T> QFuture<T> submit(std::function<T(modbus_t *)>);
+    template <typename T> QFuture<T> submit(const int, std::function<T(modbus_t *)>);
+
+    QFuture<BUS_REPLIES> readBits(const int, const int);
+    QFuture<BUS_REPLIES> readInputBits(const int, const int);
+    QFuture<BUS_REPLIES> readRegisters(const int, const int);
+    QFuture<BUS_REPLIES> readInputRegisters(const int, const int);
+    QFuture<BUS_REPLIES> writeBit(const int, const bool);
+    QFuture<BUS_REPLIES> writeRegister(const int, const int);
+    QFuture<BUS_REPLIES> writeBits(const int, const QVector<uint8_t> &);
+    QFuture<BUS_REPLIES> writeRegisters(const int, const QVector<uint16_t> &);
+
+private:
+    void poll();
+
+    QThread m_thread;
+    QObject * m_context;    /// lives in m_thread, every libmodbus call runs there
+    QTimer * m_pollTimer;   /// created in m_thread
+    modbus_t * m_modbus;    /// only touched from m_thread
+    int m_slave;
+    bool m_isOpen;
+    bool m_isPolling;       /// only touched from m_thread
+};
+
+
+template <typename T>
+QFuture<T>
+ModbusBus::
+submit(std::function<T(modbus_t *)> fn)
+{
+    return submit<T>(m_slave, fn);
+}
+
+
+/// for threads other than the GUI, which owns setSlave()
+template <typename T>
+QFuture<T>
+ModbusBus::
+submit(const int slave, std::function<T(modbus_t *)> fn)
+{
+    QFutureInterface<T> fi;
+
+    fi.reportStarted();
+    QMetaObject::invokeMethod(m_context, [this, fi, fn, slave]() mutable
+    {
+        if (m_modbus) modbus_set_slave(m_modbus, slave);
+        fi.reportResult(fn(m_modbus));
+        fi.reportFinished();
+    }, Qt::QueuedConnection);
+
+    return fi.future();
+}
+
+
+/// wait for a bus result while the GUI keeps processing events
+template <typename T>
+T
+busWait(const QFuture<T> & future)
+{
+    if (!future.isFinished())
+    {
+        QEventLoop loop;
+        QFutureWatcher<T> watcher;
+        QObject::connect(&watcher, SIGNAL(finished()), &loop, SLOT(quit()));
+        watcher.setFuture(future);
+        if (!future.isFinished()) loop.exec();
+    }
+
+    return future.result();
+}
+
+#endif // MODBUSBUS_H
@@ -0,0 +1,391 @@
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QTextStream>
+#include <QStringList>
+#include "profilestation.h"
+#include "readplanner.h"
+#include "mainwindow.h"
+
+ProfileStation::
+ProfileStation(QObject * parent) :
+    QObject(parent),
+    m_baud(9600),
+    m_parity('N'),
+    m_dataBit(8),
+    m_stopBit(1),
+    m_total(0),
+    m_done(0),
+    m_running(0),
+    m_isAborted(0)
+{
+}
+
+
+ProfileStation::
+~ProfileStation()
+{
+    abort();
+    closeBuses();
+}
+
+
+void
+ProfileStation::
+setSerial(const int baud, const char parity, const int dataBit, const int stopBit)
+{
+    m_baud = baud;
+    m_parity = parity;
+    m_dataBit = dataBit;
+    m_stopBit = stopBit;
+}
+
+
+void
+ProfileStation::
+clear()
+{
+    m_jobs.clear();
+    m_total = 0;
+    m_done = 0;
+}
+
+
+/// one job per line: port, serial number, profile csv [, verify]
+/// a relative profile path is taken from the job list's folder
+bool
+ProfileStation::
+loadJobs(const QString & fileName)
+{
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QTextStream str(&file);
+    const QDir dir = QFileInfo(fileName).absoluteDir();
+
+    while (!str.atEnd())
+    {
+        const QString s = str.readLine().trimmed();
+
+        if (s.isEmpty() || s.startsWith("*") || s.startsWith("#")) continue;
+
+        const QStringList valueList = s.split(',');
+
+        if (valueList.size() < 3) continue;
+
+        const QString profile = valueList[2].trimmed();
+        const bool isVerify = (valueList.size() > 3) && valueList[3].trimmed().toLower().startsWith("verify");
+
+        addJob(valueList[0].trimmed(), valueList[1].trimmed().toInt(), QDir::isRelativePath(profile) ? dir.filePath(profile) : profile, isVerify);
+    }
+
+    file.close();
+
+    return !m_jobs.isEmpty();
+}
+
+
+void
+ProfileStation::
+addJob(const QString & port, const int serial, const QString & fileName, const bool isVerify)
+{
+    PROFILE_JOBS job;
+
+    job.port = port;
+    job.serial = serial;
+    job.fileName = fileName;
+    job.isVerify = isVerify;
+
+    /// use windows communication device name "\\.\COMn"
+    if (job.port.startsWith("COM")) job.port = "\\\\.\\" + job.port;
+
+    if (!loadProfile(fileName, job.planner, job.coils)) job.status = STATION_NO_PROFILE;
+
+    m_jobs.append(job);
+}
+
+
+/// same csv layout and row rules as the equation table
+bool
+ProfileStation::
+loadProfile(const QString & fileName, WritePlanner & planner, QVector<PROFILE_COILS> & coils)
+{
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QTextStream str(&file);
+    int row = -1;
+
+    planner.clear();
+    coils.clear();
+
+    while (!str.atEnd())
+    {
+        const QString s = str.readLine();
+        const QStringList valueList = s.split(',');
+
+        if (s.isEmpty() || (valueList.size() < 7)) continue;
+        if (valueList[0].contains("*") || valueList[0].contains("#")) continue;
+
+        row++;
+
+        if (planRow(valueList, row, planner) != PROFILE_ROW_COIL) continue;
+
+        PROFILE_COILS coil;
+        coil.address = valueList[2].toInt() - ADDR_OFFSET;
+        coil.value = (valueList[7].toInt() != 0);
+        coils.append(coil);
+    }
+
+    file.close();
+    planner.plan();
+
+    return true;
+}
+
+
+/// one equation row (name, slave, address, type, scale, rw, qty, values...)
+/// into the planner; float, int and long rows are packed into FC16 frames,
+/// coils are left to the caller as single writes
+int
+ProfileStation::
+planRow(const QStringList & cells, const int tag, WritePlanner & planner)
+{
+    if (cells.size() < 8) return PROFILE_ROW_SKIPPED;
+
+    const int regAddr = cells[2].toInt() - ADDR_OFFSET;
+    const int count = qMin(cells[6].toInt(), cells.size() - 7);
+    const QString type = cells[3];
+
+    if (count <= 0) return PROFILE_ROW_SKIPPED;
+
+    if (type.contains("float"))
+    {
+        for (int x = 0; x < count; x++) planner.addFloat(regAddr + x*CODEC_WIDE_REGISTERS, cells[7+x].toFloat(), tag);
+    }
+    else if (type.contains("int") || type.contains("long"))
+    {
+        bool ok = false;
+        const qint32 val = cells[7].mid(0, cells[7].indexOf(".")).toInt(&ok);
+
+        /// cells that are not numbers (the model code) are left as they are on the device
+        if (!ok) return PROFILE_ROW_SKIPPED;
+
+        (type.contains("long")) ? planner.addInt32(regAddr, val, tag) : planner.addInt(regAddr, val, tag);
+    }
+    else return PROFILE_ROW_COIL;
+
+    return PROFILE_ROW_REGISTERS;
+}
+
+
+void
+ProfileStation::
+start()
+{
+    m_isAborted = 0;
+    m_total = 0;
+    m_done = 0;
+    m_running = 0;
+
+    for (int i = 0; i < m_jobs.size(); i++)
+    {
+        PROFILE_JOBS & job = m_jobs[i];
+
+        if (job.status == STATION_NO_PROFILE) continue;
+
+        job.status = STATION_PENDING;
+
+        /// one bus, and so one thread, per adapter
+        if (!m_buses.contains(job.port))
+        {
+            ModbusBus * bus = new ModbusBus;
+
+            if (bus->open(job.port, m_baud, m_parity, m_dataBit, m_stopBit)) bus->setTurnaround(BUS_DEFAULT_TURNAROUND);
+            m_buses.insert(job.port, bus);
+        }
+
+        ModbusBus * bus = m_buses.value(job.port);
+
+        if (!bus->isOpen())
+        {
+            job.status = STATION_NO_PORT;
+            continue;
+        }
+
+        m_total += job.planner.registers()*2 + job.coils.size();
+        m_running++;
+
+        /// the job runs as a whole on the bus thread of its port
+        const PROFILE_JOBS copy = job;
+        bus->setSlave(job.serial);
+        bus->submit<int>([this, copy, i](modbus_t * modbus)
+        {
+            const int status = run(modbus, copy);
+            QMetaObject::invokeMethod(this, [this, i, status]() { onJobDone(i, status); }, Qt::QueuedConnection);
+            return status;
+        });
+    }
+
+    emit progress(m_done, m_total);
+
+    if (m_running == 0)
+    {
+        closeBuses();
+        emit finished();
+    }
+}
+
+
+/// bus thread
+int
+ProfileStation::
+run(modbus_t * modbus, const PROFILE_JOBS & job)
+{
+    uint16_t sn = 0;
+
+    if (m_isAborted) return STATION_ABORTED;
+    if (modbus == NULL) return STATION_NO_PORT;
+
+    /// the slave id is the pipe serial number, make sure the right one answers
+    if ((modbus_read_input_registers(modbus, RAZ_ID_SN_PIPE - ADDR_OFFSET, 1, &sn) != 1) || (sn != job.serial)) return STATION_INVALID_SN;
+
+    return (job.isVerify) ? verify(modbus, job) : upload(modbus, job);
+}
+
+
+/// bus thread
+int
+ProfileStation::
+upload(modbus_t * modbus, const PROFILE_JOBS & job)
+{
+    int status = STATION_DONE;
+
+    if (modbus_write_bit(modbus, COIL_UNLOCKED_FACTORY_DEFAULT - ADDR_OFFSET, true) != 1) return STATION_WRITE_FAILED;
+
+    for (int s = 0; s < job.planner.spans().size(); s++)
+    {
+        const WRITE_SPANS & span = job.planner.spans()[s];
+
+        if (m_isAborted) return STATION_ABORTED;
+
+        if (modbus_write_registers(modbus, span.address, span.regs.size(), span.regs.constData()) != span.regs.size()) status = STATION_WRITE_FAILED;
+        addProgress(span.regs.size()*2);
+    }
+
+    for (int c = 0; c < job.coils.size(); c++)
+    {
+        if (m_isAborted) return STATION_ABORTED;
+
+        if (modbus_write_bit(modbus, job.coils[c].address, job.coils[c].value) != 1) status = STATION_WRITE_FAILED;
+        addProgress(1);
+    }
+
+    /// commit only a complete profile
+    if (status != STATION_DONE) return status;
+
+    if (modbus_write_bit(modbus, COIL_UNLOCKED_FACTORY_DEFAULT - ADDR_OFFSET, true) != 1) return STATION_WRITE_FAILED;
+    if (modbus_write_bit(modbus, COIL_UPDATE_FACTORY_DEFAULT - ADDR_OFFSET, true) != 1) return STATION_WRITE_FAILED;
+
+    return STATION_DONE;
+}
+
+
+/// bus thread
+int
+ProfileStation::
+verify(modbus_t * modbus, const PROFILE_JOBS & job)
+{
+    int status = STATION_DONE;
+    ReadPlanner device(0);
+    const QVector<WRITE_ITEMS> & items = job.planner.items();
+
+    for (int i = 0; i < items.size(); i++) device.addRegisters(items[i].address, items[i].regs.size(), i);
+
+    device.plan();
+
+    for (int s = 0; s < device.spans().size(); s++)
+    {
+        if (m_isAborted) return STATION_ABORTED;
+
+        if (!device.execute(modbus, s)) status = STATION_VERIFY_FAILED;
+        addProgress(device.spans()[s].count*2);
+    }
+
+    for (int i = 0; i < items.size(); i++)
+    {
+        QVector<uint16_t> current(items[i].regs.size());
+
+        if (!device.fetch(items[i].address, current.size(), current.data()) || (current != items[i].regs)) status = STATION_VERIFY_FAILED;
+    }
+
+    for (int c = 0; c < job.coils.size(); c++)
+    {
+        uint8_t bit = 0;
+
+        if (m_isAborted) return STATION_ABORTED;
+
+        if ((modbus_read_bits(modbus, job.coils[c].address, 1, &bit) != 1) || (DeviceCodec::toCoil(bit) != job.coils[c].value)) status = STATION_VERIFY_FAILED;
+        addProgress(1);
+    }
+
+    return status;
+}
+
+
+/// any thread
+void
+ProfileStation::
+addProgress(const int bytes)
+{
+    QMetaObject::invokeMethod(this, [this, bytes]()
+    {
+        m_done += bytes;
+        emit progress(m_done, m_total);
+    }, Qt::QueuedConnection);
+}
+
+
+void
+ProfileStation::
+onJobDone(const int index, const int status)
+{
+    m_jobs[index].status = status;
+    emit jobFinished(index);
+
+    if (--m_running > 0) return;
+
+    closeBuses();
+    emit progress(m_total, m_total);
+    emit finished();
+}
+
+
+void
+ProfileStation::
+closeBuses()
+{
+    foreach (ModbusBus * bus, m_buses) delete bus;
+    m_buses.clear();
+}
+
+
+QString
+ProfileStation::
+statusText(const int status)
+{
+    switch (status)
+    {
+        case STATION_PENDING: return "pending";
+        case STATION_DONE: return "done";
+        case STATION_NO_PORT: return "port not available";
+        case STATION_NO_PROFILE: return "profile not readable";
+        case STATION_INVALID_SN: return "invalid serial number";
+        case STATION_WRITE_FAILED: return "modbus transmission failed";
+        case STATION_VERIFY_FAILED: return "device differs from profile";
+        case STATION_ABORTED: return "aborted";
+        default: return "unknown";
+    }
+}
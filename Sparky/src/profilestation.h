@@ -0,0 +1,110 @@
+#ifndef PROFILESTATION_H
+#define PROFILESTATION_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QMap>
+#include <QAtomicInt>
+#include "modbusbus.h"
+#include "writeplanner.h"
+
+/// job results
+#define STATION_PENDING             0
+#define STATION_DONE                1
+#define STATION_NO_PORT             2
+#define STATION_NO_PROFILE          3
+#define STATION_INVALID_SN          4
+#define STATION_WRITE_FAILED        5
+#define STATION_VERIFY_FAILED       6
+#define STATION_ABORTED             7
+
+/// what planRow made of a profile row
+#define PROFILE_ROW_SKIPPED         0
+#define PROFILE_ROW_REGISTERS       1
+#define PROFILE_ROW_COIL            2
+
+typedef struct PROFILE_COIL
+{
+    int address;
+    bool value;
+
+    PROFILE_COIL() : address(0), value(false) {}
+
+} PROFILE_COILS;
+
+
+typedef struct PROFILE_JOB
+{
+    QString port;
+    int serial;
+    QString fileName;
+    bool isVerify;
+    int status;
+
+    /// parsed profile, wire addresses
+    WritePlanner planner;
+    QVector<PROFILE_COILS> coils;
+
+    PROFILE_JOB() : serial(0), isVerify(false), status(STATION_PENDING) {}
+
+} PROFILE_JOBS;
+
+
+/// Programs or verifies equation profiles on several analyzers at once.
+/// Every port gets its own ModbusBus, so jobs on different adapters run
+/// side by side on their own bus threads while jobs sharing a port are
+/// queued on it in list order. Progress is counted in payload bytes over
+/// all jobs, the same way the single slave upload counts it.
+class ProfileStation : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ProfileStation(QObject * parent = 0);
+    ~ProfileStation();
+
+    void setSerial(const int, const char, const int, const int);
+    bool loadJobs(const QString &);
+    void addJob(const QString &, const int, const QString &, const bool);
+    void clear();
+
+    void start();
+    void abort() { m_isAborted = 1; }
+    bool isRunning() const { return (m_running > 0); }
+
+    int total() const { return m_total; }
+    int done() const { return m_done; }
+    const QVector<PROFILE_JOBS> & jobs() const { return m_jobs; }
+
+    static bool loadProfile(const QString &, WritePlanner &, QVector<PROFILE_COILS> &);
+    static int planRow(const QStringList &, const int, WritePlanner &);
+    static QString statusText(const int);
+
+signals:
+    void progress(int, int);
+    void jobFinished(int);
+    void finished();
+
+private:
+    int run(modbus_t *, const PROFILE_JOBS &);
+    int upload(modbus_t *, const PROFILE_JOBS &);
+    int verify(modbus_t *, const PROFILE_JOBS &);
+    void addProgress(const int);
+    void onJobDone(const int, const int);
+    void closeBuses();
+
+    int m_baud;
+    char m_parity;
+    int m_dataBit;
+    int m_stopBit;
+    int m_total;
+    int m_done;
+    int m_running;
+    QAtomicInt m_isAborted;
+    QVector<PROFILE_JOBS> m_jobs;
+    QMap<QString, ModbusBus *> m_buses;
+};
+
+#endif // PROFILESTATION_H
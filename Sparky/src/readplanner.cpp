@@ -0,0 +1,234 @@
+#include <algorithm>
+#include "readplanner.h"
+#include "registercodec.h"
+
+ReadPlanner::
+ReadPlanner(const int gap) :
+    m_gap(gap),
+    m_isPlanned(false)
+{
+    setGapTolerance(gap);
+}
+
+
+void
+ReadPlanner::
+setGapTolerance(const int gap)
+{
+    /// a negative gap makes no sense, anything wider than a frame is pointless
+    if (gap < 0) m_gap = 0;
+    else if (gap > PLANNER_MAX_REGISTERS) m_gap = PLANNER_MAX_REGISTERS;
+    else m_gap = gap;
+
+    m_isPlanned = false;
+}
+
+
+void
+ReadPlanner::
+clear()
+{
+    m_items.clear();
+    m_spans.clear();
+    m_isPlanned = false;
+}
+
+
+void
+ReadPlanner::
+addItem(const READ_ITEMS & item)
+{
+    m_items.append(item);
+    m_isPlanned = false;
+}
+
+
+void
+ReadPlanner::
+addFloat(const int address, double * target)
+{
+    READ_ITEMS item;
+    item.address = address;
+    item.target = target;
+    addItem(item);
+}
+
+
+void
+ReadPlanner::
+addFloat(const int address, double * target, const double min, const double max)
+{
+    READ_ITEMS item;
+    item.address = address;
+    item.target = target;
+    item.isGuarded = true;
+    item.min = min;
+    item.max = max;
+    addItem(item);
+}
+
+
+void
+ReadPlanner::
+addRegisters(const int address, const int count, const int tag)
+{
+    /// a range longer than a frame is cut into frame sized items
+    for (int done = 0; done < count; done += PLANNER_MAX_REGISTERS)
+    {
+        READ_ITEMS item;
+        item.address = address + done;
+        item.count = qMin(PLANNER_MAX_REGISTERS, count - done);
+        item.tag = tag;
+        addItem(item);
+    }
+}
+
+
+void
+ReadPlanner::
+plan()
+{
+    m_spans.clear();
+
+    std::sort(m_items.begin(), m_items.end(), [](const READ_ITEMS & a, const READ_ITEMS & b) { return a.address < b.address; });
+
+    for (int i = 0; i < m_items.size(); i++)
+    {
+        const int end = m_items[i].address + m_items[i].count;
+
+        if (!m_spans.isEmpty())
+        {
+            READ_SPANS & span = m_spans.last();
+            const int spanEnd = span.address + span.count;
+
+            /// extend the current frame if the gap is tolerated and it still fits
+            if ((m_items[i].address - spanEnd <= m_gap) && (qMax(end, spanEnd) - span.address <= PLANNER_MAX_REGISTERS))
+            {
+                span.count = qMax(end, spanEnd) - span.address;
+                span.last = i;
+                continue;
+            }
+        }
+
+        READ_SPANS span;
+        span.address = m_items[i].address;
+        span.count = m_items[i].count;
+        span.first = i;
+        span.last = i;
+        m_spans.append(span);
+    }
+
+    m_isPlanned = true;
+}
+
+
+int
+ReadPlanner::
+execute(modbus_t * ctx)
+{
+    int failed = 0;
+
+    if (!m_isPlanned) plan();
+
+    for (int s = 0; s < m_spans.size(); s++)
+    {
+        if (!execute(ctx, s)) failed++;
+    }
+
+    return failed;
+}
+
+
+bool
+ReadPlanner::
+execute(modbus_t * ctx, const int s)
+{
+    if (!m_isPlanned) plan();
+    if ((s < 0) || (s >= m_spans.size())) return false;
+
+    READ_SPANS & span = m_spans[s];
+
+    span.regs.fill(0, span.count);
+    span.isFailed = (ctx == NULL) || (modbus_read_input_registers(ctx, span.address, span.count, span.regs.data()) != span.count);
+
+    if (span.isFailed) return false;
+
+    /// split the frame back into the fields
+    for (int i = span.first; i <= span.last; i++)
+    {
+        const READ_ITEMS & item = m_items[i];
+
+        if (item.target == NULL) continue;
+
+        const double val = DeviceCodec::toFloat(&span.regs[item.address - span.address]);
+
+        if (item.isGuarded && !((val < item.max) && (val > item.min))) continue;
+
+        *item.target = val;
+    }
+
+    return true;
+}
+
+
+int
+ReadPlanner::
+registers() const
+{
+    int count = 0;
+    for (int s = 0; s < m_spans.size(); s++) count += m_spans[s].count;
+    return count;
+}
+
+
+int
+ReadPlanner::
+failed() const
+{
+    int count = 0;
+    for (int s = 0; s < m_spans.size(); s++) if (m_spans[s].isFailed) count++;
+    return count;
+}
+
+
+QVector<int>
+ReadPlanner::
+tags(const READ_SPANS & span) const
+{
+    QVector<int> list;
+
+    for (int i = span.first; i <= span.last; i++)
+    {
+        if (!list.contains(m_items[i].tag)) list.append(m_items[i].tag);
+    }
+
+    return list;
+}
+
+
+bool
+ReadPlanner::
+fetch(const int address, const int count, uint16_t * dest) const
+{
+    /// copy a range out of the frames that were read successfully
+    for (int r = 0; r < count; r++)
+    {
+        bool isFound = false;
+
+        for (int s = 0; s < m_spans.size(); s++)
+        {
+            const READ_SPANS & span = m_spans[s];
+
+            if (span.isFailed || (span.regs.size() != span.count)) continue;
+            if ((address + r < span.address) || (address + r >= span.address + span.count)) continue;
+
+            dest[r] = span.regs[address + r - span.address];
+            isFound = true;
+            break;
+        }
+
+        if (!isFound) return false;
+    }
+
+    return true;
+}
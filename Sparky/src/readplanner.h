@@ -0,0 +1,82 @@
+#ifndef READPLANNER_H
+#define READPLANNER_H
+
+#include <QVector>
+#include "modbus.h"
+
+/// FC04 limit per frame
+#define PLANNER_MAX_REGISTERS       125
+
+/// unused registers tolerated between two items before a new frame is started
+#define PLANNER_DEFAULT_GAP         32
+
+/// register count of a float value
+#define PLANNER_FLOAT_REGISTERS     2
+
+typedef struct READ_ITEM
+{
+    int address;
+    int count;
+    int tag;
+    double * target;
+    bool isGuarded;
+    double min;
+    double max;
+
+    READ_ITEM() : address(0), count(PLANNER_FLOAT_REGISTERS), tag(-1), target(NULL), isGuarded(false), min(0), max(0) {}
+
+} READ_ITEMS;
+
+
+typedef struct READ_SPAN
+{
+    int address;
+    int count;
+    int first;
+    int last;
+    bool isFailed;
+    QVector<uint16_t> regs;
+
+    READ_SPAN() : address(0), count(0), first(0), last(0), isFailed(false) {}
+
+} READ_SPANS;
+
+
+/// Collects the registers one poll cycle needs, merges nearby addresses
+/// into as few FC04 transactions as possible and splits the answers back
+/// into the caller's fields. Raw ranges keep their registers in the span
+/// for the caller to decode. Addresses are wire addresses (ADDR_OFFSET
+/// already removed).
+class ReadPlanner
+{
+public:
+    ReadPlanner(const int gap = PLANNER_DEFAULT_GAP);
+
+    void setGapTolerance(const int);
+    int gapTolerance() const { return m_gap; }
+
+    void clear();
+    void addFloat(const int, double *);
+    void addFloat(const int, double *, const double, const double);
+    void addRegisters(const int, const int, const int);
+    void plan();
+    int execute(modbus_t *);
+    bool execute(modbus_t *, const int);
+
+    int transactions() const { return m_spans.size(); }
+    int registers() const;
+    int failed() const;
+    const QVector<READ_SPANS> & spans() const { return m_spans; }
+    QVector<int> tags(const READ_SPANS &) const;
+    bool fetch(const int, const int, uint16_t *) const;
+
+private:
+    void addItem(const READ_ITEMS &);
+
+    int m_gap;
+    bool m_isPlanned;
+    QVector<READ_ITEMS> m_items;
+    QVector<READ_SPANS> m_spans;
+};
+
+#endif // READPLANNER_H
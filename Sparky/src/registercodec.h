@@ -0,0 +1,103 @@
+#ifndef REGISTERCODEC_H
+#define REGISTERCODEC_H
+
+#include <stdint.h>
+#include <string.h>
+
+/// order of the four bytes of a 32 bit value over two registers,
+/// A being the most significant byte
+enum WORD_ORDER
+{
+    ORDER_ABCD,     /// big endian, high word first
+    ORDER_CDAB,     /// low word first
+    ORDER_BADC,     /// high word first, bytes swapped
+    ORDER_DCBA      /// little endian
+};
+
+/// register count of a 32 bit value
+#define CODEC_WIDE_REGISTERS        2
+
+
+/// Decodes and encodes register spans into typed values without touching
+/// the heap. Every call works on caller owned buffers and the word order
+/// is resolved at compile time, so the batch loops reduce to shifts and
+/// byte swaps the compiler can vectorize.
+template <int Order>
+class RegisterCodec
+{
+public:
+    static inline uint16_t swap16(const uint16_t w)
+    {
+        return (uint16_t) ((w << 8) | (w >> 8));
+    }
+
+    static inline uint32_t join(const uint16_t * regs)
+    {
+        switch (Order)
+        {
+            case ORDER_CDAB: return ((uint32_t) regs[1] << 16) | regs[0];
+            case ORDER_BADC: return ((uint32_t) swap16(regs[0]) << 16) | swap16(regs[1]);
+            case ORDER_DCBA: return ((uint32_t) swap16(regs[1]) << 16) | swap16(regs[0]);
+            case ORDER_ABCD:
+            default: return ((uint32_t) regs[0] << 16) | regs[1];
+        }
+    }
+
+    static inline void split(const uint32_t raw, uint16_t * regs)
+    {
+        const uint16_t hi = (uint16_t) (raw >> 16);
+        const uint16_t lo = (uint16_t) (raw & 0xFFFF);
+
+        switch (Order)
+        {
+            case ORDER_CDAB: regs[0] = lo; regs[1] = hi; break;
+            case ORDER_BADC: regs[0] = swap16(hi); regs[1] = swap16(lo); break;
+            case ORDER_DCBA: regs[0] = swap16(lo); regs[1] = swap16(hi); break;
+            case ORDER_ABCD:
+            default: regs[0] = hi; regs[1] = lo; break;
+        }
+    }
+
+    /// single values
+    static inline float toFloat(const uint16_t * regs)
+    {
+        const uint32_t raw = join(regs);
+        float f;
+        memcpy(&f, &raw, sizeof(f));
+        return f;
+    }
+
+    static inline void fromFloat(const float f, uint16_t * regs)
+    {
+        uint32_t raw;
+        memcpy(&raw, &f, sizeof(raw));
+        split(raw, regs);
+    }
+
+    static inline int32_t toInt32(const uint16_t * regs) { return (int32_t) join(regs); }
+    static inline void fromInt32(const int32_t i, uint16_t * regs) { split((uint32_t) i, regs); }
+
+    static inline int toInt(const uint16_t reg) { return reg; }
+    static inline bool toCoil(const uint8_t bit) { return (bit != 0); }
+
+    /// batch path, n values from/to 2*n registers
+    static inline void toFloats(const uint16_t * regs, float * values, const int n)
+    {
+        for (int i = 0; i < n; i++) values[i] = toFloat(regs + i*CODEC_WIDE_REGISTERS);
+    }
+
+    static inline void fromFloats(const float * values, uint16_t * regs, const int n)
+    {
+        for (int i = 0; i < n; i++) fromFloat(values[i], regs + i*CODEC_WIDE_REGISTERS);
+    }
+
+    static inline void toInt32s(const uint16_t * regs, int32_t * values, const int n)
+    {
+        for (int i = 0; i < n; i++) values[i] = toInt32(regs + i*CODEC_WIDE_REGISTERS);
+    }
+};
+
+/// order used by the Razor and EEA firmware
+typedef RegisterCodec<ORDER_ABCD> DeviceCodec;
+
+#endif // REGISTERCODEC_H
@@ -0,0 +1,151 @@
+#include <math.h>
+#include <stdlib.h>
+#include "settlingestimator.h"
+
+SettlingEstimator::
+SettlingEstimator()
+{
+}
+
+
+void
+SettlingEstimator::
+reset()
+{
+    m_values.clear();
+}
+
+
+void
+SettlingEstimator::
+add(const double value)
+{
+    m_values.append(value);
+
+    if (m_values.size() > SETTLING_WINDOW) m_values.remove(0);
+}
+
+
+/// least squares of y = final + a*ratio^k, returns the sum of squared
+/// residuals
+double
+SettlingEstimator::
+fitRatio(const double ratio, double & final, double & a, double & sxx) const
+{
+    const int n = m_values.size();
+    double x = 1;
+    double sumX = 0;
+    double sumY = 0;
+    double sxy = 0;
+    double sse = 0;
+
+    for (int k = 0; k < n; k++, x *= ratio)
+    {
+        sumX += x;
+        sumY += m_values[k];
+    }
+
+    const double meanX = sumX/n;
+    const double meanY = sumY/n;
+
+    sxx = 0;
+    x = 1;
+
+    for (int k = 0; k < n; k++, x *= ratio)
+    {
+        sxx += (x - meanX)*(x - meanX);
+        sxy += (x - meanX)*(m_values[k] - meanY);
+    }
+
+    a = (sxx > 0) ? sxy/sxx : 0;
+    final = meanY - a*meanX;
+    x = 1;
+
+    for (int k = 0; k < n; k++, x *= ratio)
+    {
+        const double residual = m_values[k] - final - a*x;
+
+        sse += residual*residual;
+    }
+
+    return sse;
+}
+
+
+/// false until there are enough samples, or while the best fit is the
+/// slowest ratio: the window then shows a ramp, not a settling curve
+bool
+SettlingEstimator::
+fit(const double z, SETTLING_FITS & f) const
+{
+    const int n = m_values.size();
+    double sse[SETTLING_RATIO_STEPS + 1];
+    double final, a, sxx;
+    int best = 0;
+
+    f.samples = n;
+    if (n < SETTLING_MIN_SAMPLES) return false;
+
+    for (int i = 0; i <= SETTLING_RATIO_STEPS; i++)
+    {
+        sse[i] = fitRatio(i*SETTLING_MAX_RATIO/SETTLING_RATIO_STEPS, final, a, sxx);
+        if (sse[i] < sse[best]) best = i;
+    }
+
+    if (best == SETTLING_RATIO_STEPS) return false;
+
+    /// two parameters and the ratio
+    const double variance = sse[best]/(n - 3);
+    const double limit = sse[best]*(1 + z*z/(n - 3));
+
+    f.noise = sqrt(variance);
+    f.bound = 0;
+
+    for (int i = 0; i <= SETTLING_RATIO_STEPS; i++)
+    {
+        /// the grid is no finer than its step, the neighbours of the best ratio are always plausible
+        if ((abs(i - best) > 1) && (sse[i] > limit)) continue;
+
+        const double ratio = i*SETTLING_MAX_RATIO/SETTLING_RATIO_STEPS;
+
+        fitRatio(ratio, final, a, sxx);
+
+        const double tail = pow(ratio, n - 1);
+        const double drift = -a*tail;
+        const double error = (sxx > 0) ? sqrt(variance/sxx)*tail : 0;
+
+        f.bound = qMax(f.bound, fabs(drift) + z*error);
+
+        if (i == best)
+        {
+            f.ratio = ratio;
+            f.final = final;
+            f.current = final + a*tail;
+            f.drift = drift;
+            f.error = error;
+        }
+    }
+
+    return true;
+}
+
+
+bool
+SettlingEstimator::
+isSettled(const double tolerance, const double z, SETTLING_FITS & f) const
+{
+    return fit(z, f) && (f.bound <= tolerance);
+}
+
+
+/// one-sided normal quantile of a confidence in (0.5, 1), Abramowitz and
+/// Stegun 26.2.23, good to 4.5e-4
+double
+SettlingEstimator::
+zScore(const double confidence)
+{
+    const double p = qBound(0.5, confidence, 0.9999);
+    const double t = sqrt(-2*log(1 - p));
+
+    return t - (2.515517 + 0.802853*t + 0.010328*t*t)/(1 + 1.432788*t + 0.189269*t*t + 0.001308*t*t*t);
+}
@@ -0,0 +1,64 @@
+#ifndef SETTLINGESTIMATOR_H
+#define SETTLINGESTIMATOR_H
+
+#include <QVector>
+
+/// samples kept per pipe and quantity, enough to span the approach
+#define SETTLING_WINDOW             60
+
+/// fewest samples a fit is made from
+#define SETTLING_MIN_SAMPLES        8
+
+/// step ratios tried between 0 and SETTLING_MAX_RATIO
+#define SETTLING_RATIO_STEPS        98
+
+/// slowest settling curve told apart from a ramp, exp(-1/50)
+#define SETTLING_MAX_RATIO          0.98
+
+/// confidence of the drift bound when LOOP.StableConfidence is not set; 0
+/// leaves the stages to the classic count (see bench/settlingbench)
+#define SETTLING_DEFAULT_CONFIDENCE 0
+
+typedef struct SETTLING_FIT
+{
+    int samples;
+    double ratio;           /// per sample, exp(-period/tau)
+    double final;           /// predicted settled value
+    double current;         /// fitted value at the newest sample
+    double drift;           /// final - current
+    double error;           /// standard error of drift
+    double noise;           /// standard deviation of a sample around the fit
+    double bound;           /// largest |drift| + z*error of every plausible ratio
+
+    SETTLING_FIT() : samples(0), ratio(0), final(0), current(0), drift(0), error(0), noise(0), bound(0) {}
+
+} SETTLING_FITS;
+
+
+/// Fits y = final + a*ratio^k plus noise to evenly spaced samples. For a
+/// given ratio the fit is linear, so the ratio is found on a grid and
+/// final and a by least squares. Ratios whose fit is not significantly
+/// worse than the best one are all plausible; the quantity is settled once
+/// the drift still to come, widened by z standard errors, is within the
+/// tolerance for every one of them.
+class SettlingEstimator
+{
+public:
+    SettlingEstimator();
+
+    void reset();
+    void add(const double);
+    int count() const { return m_values.size(); }
+
+    bool fit(const double, SETTLING_FITS &) const;
+    bool isSettled(const double, const double, SETTLING_FITS &) const;
+
+    static double zScore(const double);
+
+private:
+    double fitRatio(const double, double &, double &, double &) const;
+
+    QVector<double> m_values;
+};
+
+#endif // SETTLINGESTIMATOR_H
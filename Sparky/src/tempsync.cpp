@@ -0,0 +1,293 @@
+#include <math.h>
+#include "tempsync.h"
+#include "calconfig.h"
+#include "registercodec.h"
+
+TempSync::
+TempSync(ModbusBus * bus, QObject * parent) :
+    QObject(parent),
+    m_bus(bus),
+    m_master(0)
+{
+}
+
+
+void
+TempSync::
+addPipe(const int slave)
+{
+    SYNC_PIPES pipe;
+
+    pipe.slave = slave;
+    m_pipes.append(pipe);
+}
+
+
+/// blocks, the GUI keeps processing events; true if every pipe is in sync
+bool
+TempSync::
+run(const double master)
+{
+    bool isOk = true;
+
+    m_master = master;
+    m_clock.start();
+
+    for (int i = 0; i < m_pipes.size(); i++)
+    {
+        const int slave = m_pipes[i].slave;
+
+        m_pipes[i] = SYNC_PIPES();
+        m_pipes[i].slave = slave;
+    }
+
+    while (true)
+    {
+        bool isPending = false;
+
+        readStart();
+
+        const QVector<SYNC_PIPES> before = m_pipes;
+        const QVector<int> written = correct();
+
+        for (int i = 0; i < m_pipes.size(); i++) if (m_pipes[i].status == SYNC_PENDING) isPending = true;
+
+        if (!isPending) break;
+
+        settle();
+        measure(written, before);
+    }
+
+    for (int i = 0; i < m_pipes.size(); i++) if (m_pipes[i].status != SYNC_DONE) isOk = false;
+
+    return isOk;
+}
+
+
+/// serial number, temperature and the adjustment of the pipes that have
+/// not answered all three yet, then the factory registers are opened
+void
+TempSync::
+readStart()
+{
+    QVector<int> index;
+    QVector<int> slaves;
+
+    for (int i = 0; i < m_pipes.size(); i++)
+    {
+        SYNC_PIPES & p = m_pipes[i];
+
+        if ((p.status != SYNC_PENDING) || p.isReady) continue;
+
+        if (p.iterations >= TEMPSYNC_MAX_ITERATIONS) finish(i, SYNC_NO_READING);
+        else if (m_clock.elapsed() > TEMPSYNC_TIMEOUT) finish(i, SYNC_TIMEOUT);
+        else
+        {
+            p.iterations++;
+            index << i;
+            slaves << p.slave;
+        }
+    }
+
+    if (index.isEmpty()) return;
+
+    QVector<int> sn(index.size(), -1);
+    QVector<double> temperature(index.size(), NAN);
+    QVector<double> adjust(index.size(), NAN);
+
+    busWait(m_bus->submit<int>([&slaves, &sn, &temperature, &adjust](modbus_t * modbus)
+    {
+        uint16_t regs[CODEC_WIDE_REGISTERS];
+
+        for (int k = 0; (modbus != NULL) && (k < slaves.size()); k++)
+        {
+            modbus_set_slave(modbus, slaves.at(k));
+
+            if (modbus_read_input_registers(modbus, RAZ_ID_SN_PIPE-ADDR_OFFSET, 1, regs) == 1) sn[k] = regs[0];
+            if (sn.at(k) != slaves.at(k)) continue;
+
+            if (modbus_read_input_registers(modbus, RAZ_ID_TEMPERATURE-ADDR_OFFSET, CODEC_WIDE_REGISTERS, regs) == CODEC_WIDE_REGISTERS) temperature[k] = DeviceCodec::toFloat(regs);
+            if (modbus_read_input_registers(modbus, FCT_RAZ_TEMP_ADJ-ADDR_OFFSET, CODEC_WIDE_REGISTERS, regs) == CODEC_WIDE_REGISTERS) adjust[k] = DeviceCodec::toFloat(regs);
+
+            if (isfinite(temperature.at(k)) && isfinite(adjust.at(k))) modbus_write_bit(modbus, FCT_RAZ_UNLOCK-ADDR_OFFSET, TRUE);
+        }
+
+        return 0;
+    }));
+
+    for (int k = 0; k < index.size(); k++)
+    {
+        SYNC_PIPES & p = m_pipes[index.at(k)];
+
+        /// a pipe that answers with another number is not the one asked for
+        if ((sn.at(k) >= 0) && (sn.at(k) != p.slave))
+        {
+            finish(index.at(k), SYNC_INVALID_SN);
+            continue;
+        }
+
+        if (!isfinite(temperature.at(k)) || !isfinite(adjust.at(k))) continue;
+
+        p.isReady = true;
+        p.temperature = temperature.at(k);
+        p.adjust = adjust.at(k);
+        p.residual = m_master - p.temperature;
+    }
+}
+
+
+/// the next damped Newton step of every pipe still out of sync, written in
+/// one bus job; answers the pipes written
+QVector<int>
+TempSync::
+correct()
+{
+    QVector<int> index;
+    QVector<int> slaves;
+    QVector<double> adjust;
+
+    for (int i = 0; i < m_pipes.size(); i++)
+    {
+        SYNC_PIPES & p = m_pipes[i];
+
+        if ((p.status != SYNC_PENDING) || !p.isReady) continue;
+
+        if (fabs(p.residual) <= TEMPSYNC_TOLERANCE) finish(i, SYNC_DONE);
+        else if (p.iterations >= TEMPSYNC_MAX_ITERATIONS) finish(i, SYNC_NOT_CONVERGED);
+        else if (m_clock.elapsed() > TEMPSYNC_TIMEOUT) finish(i, SYNC_TIMEOUT);
+        else
+        {
+            p.iterations++;
+            index << i;
+            slaves << p.slave;
+            adjust << p.adjust + p.damping*p.residual/p.slope;
+        }
+    }
+
+    if (index.isEmpty()) return index;
+
+    QVector<bool> isWritten(index.size(), false);
+
+    busWait(m_bus->submit<int>([&slaves, &adjust, &isWritten](modbus_t * modbus)
+    {
+        uint16_t regs[CODEC_WIDE_REGISTERS];
+
+        for (int k = 0; (modbus != NULL) && (k < slaves.size()); k++)
+        {
+            modbus_set_slave(modbus, slaves.at(k));
+            DeviceCodec::fromFloat((float) adjust.at(k), regs);
+            isWritten[k] = (modbus_write_registers(modbus, FCT_RAZ_TEMP_ADJ-ADDR_OFFSET, CODEC_WIDE_REGISTERS, regs) == CODEC_WIDE_REGISTERS);
+        }
+
+        return 0;
+    }));
+
+    QVector<int> written;
+
+    for (int k = 0; k < index.size(); k++)
+    {
+        if (!isWritten.at(k))
+        {
+            finish(index.at(k), SYNC_WRITE_FAILED);
+            continue;
+        }
+
+        m_pipes[index.at(k)].adjust = adjust.at(k);
+        written << index.at(k);
+    }
+
+    return written;
+}
+
+
+/// reads the written pipes back after the settle period; the slope comes
+/// from the step just taken, the damping from whether it helped. A pipe
+/// that does not answer reads its adjustment again in the next round.
+void
+TempSync::
+measure(const QVector<int> & written, const QVector<SYNC_PIPES> & before)
+{
+    QVector<int> slaves;
+
+    if (written.isEmpty()) return;
+
+    foreach (const int i, written) slaves << m_pipes[i].slave;
+
+    QVector<double> temperature(written.size(), NAN);
+
+    busWait(m_bus->submit<int>([&slaves, &temperature](modbus_t * modbus)
+    {
+        uint16_t regs[CODEC_WIDE_REGISTERS];
+
+        for (int k = 0; (modbus != NULL) && (k < slaves.size()); k++)
+        {
+            modbus_set_slave(modbus, slaves.at(k));
+
+            if (modbus_read_input_registers(modbus, RAZ_ID_TEMPERATURE-ADDR_OFFSET, CODEC_WIDE_REGISTERS, regs) == CODEC_WIDE_REGISTERS) temperature[k] = DeviceCodec::toFloat(regs);
+        }
+
+        return 0;
+    }));
+
+    for (int k = 0; k < written.size(); k++)
+    {
+        SYNC_PIPES & p = m_pipes[written.at(k)];
+        const SYNC_PIPES & b = before.at(written.at(k));
+        const double step = p.adjust - b.adjust;
+
+        if (!isfinite(temperature.at(k)))
+        {
+            p.isReady = false;
+            continue;
+        }
+
+        p.temperature = temperature.at(k);
+        p.residual = m_master - p.temperature;
+
+        if (fabs(step) > 1e-6) p.slope = qBound(TEMPSYNC_MIN_SLOPE, (p.temperature - b.temperature)/step, TEMPSYNC_MAX_SLOPE);
+
+        if (fabs(p.residual) >= fabs(b.residual)) p.damping = qMax(TEMPSYNC_MIN_DAMPING, p.damping/2);
+        else p.damping = qMin(1.0, p.damping*2);
+    }
+}
+
+
+void
+TempSync::
+finish(const int pipe, const int status)
+{
+    m_pipes[pipe].status = status;
+    m_pipes[pipe].elapsed = m_clock.elapsed();
+
+    emit pipeFinished(pipe);
+}
+
+
+/// one settle period for every pipe written in the round
+void
+TempSync::
+settle()
+{
+    QEventLoop loop;
+
+    QTimer::singleShot(TEMPSYNC_SETTLE, &loop, SLOT(quit()));
+    loop.exec();
+}
+
+
+QString
+TempSync::
+statusText(const int status)
+{
+    switch (status)
+    {
+        case SYNC_PENDING: return "pending";
+        case SYNC_DONE: return "in sync";
+        case SYNC_INVALID_SN: return "invalid serial number";
+        case SYNC_NO_READING: return "no valid reading";
+        case SYNC_WRITE_FAILED: return "modbus transmission failed";
+        case SYNC_NOT_CONVERGED: return "not in sync after the last step";
+        case SYNC_TIMEOUT: return "timed out";
+        default: return "unknown";
+    }
+}
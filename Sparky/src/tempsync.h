@@ -0,0 +1,96 @@
+#ifndef TEMPSYNC_H
+#define TEMPSYNC_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QElapsedTimer>
+#include "modbusbus.h"
+
+/// a pipe is in sync once it reads within this of the master (°C)
+#define TEMPSYNC_TOLERANCE          0.1
+
+/// the analyzer needs this long to apply a new adjustment (ms)
+#define TEMPSYNC_SETTLE             2000
+
+/// rounds a pipe gets, reads that come back NaN included
+#define TEMPSYNC_MAX_ITERATIONS     10
+
+/// a pipe not in sync this long after the start gives up (ms)
+#define TEMPSYNC_TIMEOUT            30000
+
+/// the secant slope of temperature over adjustment is kept in here, a
+/// sensor that barely moves or jumps must not blow the next step up
+#define TEMPSYNC_MIN_SLOPE          0.25
+#define TEMPSYNC_MAX_SLOPE          4.0
+
+/// smallest share of the Newton step taken after steps that overshot
+#define TEMPSYNC_MIN_DAMPING        0.125
+
+/// pipe results
+#define SYNC_PENDING                0
+#define SYNC_DONE                   1
+#define SYNC_INVALID_SN             2
+#define SYNC_NO_READING             3
+#define SYNC_WRITE_FAILED           4
+#define SYNC_NOT_CONVERGED          5
+#define SYNC_TIMEOUT                6
+
+typedef struct SYNC_PIPE
+{
+    int slave;
+    int status;
+    int iterations;
+    bool isReady;           /// serial number checked, temperature and adjustment read
+    double temperature;
+    double adjust;          /// FCT_RAZ_TEMP_ADJ as last written or read
+    double residual;        /// master - temperature
+    double slope;           /// temperature per unit of adjustment
+    double damping;         /// share of the Newton step taken
+    qint64 elapsed;         /// ms from the start until in sync or given up
+
+    SYNC_PIPE() : slave(0), status(SYNC_PENDING), iterations(0), isReady(false), temperature(0), adjust(0), residual(0), slope(1), damping(1), elapsed(0) {}
+
+} SYNC_PIPES;
+
+
+/// Brings the temperature of every pipe to the master's by correcting
+/// FCT_RAZ_TEMP_ADJ, all pipes in the same rounds: one bus job writes the
+/// corrections of every pipe still out of sync, one settle period serves
+/// them all and one job reads them back. The correction is a damped
+/// Newton step on the secant slope of the pipe's own answers; a step that
+/// leaves the pipe further off halves the damping. Every pipe has a
+/// bounded number of rounds and a timeout, so a stuck sensor ends with a
+/// status instead of holding the sync forever.
+class TempSync : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TempSync(ModbusBus *, QObject * parent = 0);
+
+    void addPipe(const int);
+    void clear() { m_pipes.clear(); }
+
+    bool run(const double);
+    const QVector<SYNC_PIPES> & pipes() const { return m_pipes; }
+
+    static QString statusText(const int);
+
+signals:
+    void pipeFinished(int);
+
+private:
+    void readStart();
+    QVector<int> correct();
+    void measure(const QVector<int> &, const QVector<SYNC_PIPES> &);
+    void finish(const int, const int);
+    void settle();
+
+    ModbusBus * m_bus;
+    QVector<SYNC_PIPES> m_pipes;
+    QElapsedTimer m_clock;
+    double m_master;
+};
+
+#endif // TEMPSYNC_H
@@ -0,0 +1,139 @@
+#ifndef TRACERING_H
+#define TRACERING_H
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+
+/// records held by the monitor ring, a power of two
+#define TRACE_CAPACITY              4096
+
+/// raw bytes per record, longer chunks take several records
+#define TRACE_RAW_BYTES             64
+
+/// gui drain period (ms)
+#define TRACE_DRAIN_INTERVAL        33
+
+#define TRACE_ITEM                  0
+#define TRACE_RAW                   1
+
+typedef struct TRACE_RECORD
+{
+    int64_t time;           /// us, steady clock
+    uint8_t kind;
+    uint8_t isRequest;
+    uint8_t func;
+    uint8_t isNewline;
+    uint16_t slave;
+    uint16_t addr;
+    uint16_t nb;
+    uint16_t expectedCRC;
+    uint16_t actualCRC;
+    uint8_t len;
+    uint8_t data[TRACE_RAW_BYTES];
+
+} TRACE_RECORDS;
+
+
+/// Single producer, single consumer ring of fixed size trace records. The
+/// bus thread pushes from inside the libmodbus hooks without locking or
+/// allocating, the gui thread pops on its own schedule. A full ring drops
+/// the new record and counts it instead of stalling the transaction.
+template <int Capacity>
+class TraceRing
+{
+public:
+    TraceRing() : m_head(0), m_tail(0), m_dropped(0) {}
+
+    static inline int64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /// producer
+    inline bool push(const TRACE_RECORDS & record)
+    {
+        const unsigned head = m_head.load(std::memory_order_relaxed);
+
+        if (head - m_tail.load(std::memory_order_acquire) >= (unsigned) Capacity)
+        {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        m_records[head & (Capacity - 1)] = record;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    inline void pushItem(const uint8_t isRequest, const uint16_t slave, const uint8_t func, const uint16_t addr, const uint16_t nb, const uint16_t expectedCRC, const uint16_t actualCRC)
+    {
+        TRACE_RECORDS record;
+
+        record.time = now();
+        record.kind = TRACE_ITEM;
+        record.isRequest = isRequest;
+        record.slave = slave;
+        record.func = func;
+        record.addr = addr;
+        record.nb = nb;
+        record.expectedCRC = expectedCRC;
+        record.actualCRC = actualCRC;
+        record.isNewline = 0;
+        record.len = 0;
+        push(record);
+    }
+
+    inline void pushRaw(const uint8_t * data, const int dataLen, const uint8_t isNewline)
+    {
+        TRACE_RECORDS record;
+        const int64_t time = now();
+
+        for (int done = 0; done < dataLen; done += TRACE_RAW_BYTES)
+        {
+            const int len = (dataLen - done < TRACE_RAW_BYTES) ? dataLen - done : TRACE_RAW_BYTES;
+
+            record.time = time;
+            record.kind = TRACE_RAW;
+            record.isRequest = 0;
+            record.slave = record.func = 0;
+            record.addr = record.nb = 0;
+            record.expectedCRC = record.actualCRC = 0;
+            record.isNewline = (done + len >= dataLen) ? isNewline : 0;
+            record.len = (uint8_t) len;
+            memcpy(record.data, data + done, len);
+            push(record);
+        }
+    }
+
+    /// consumer
+    inline bool pop(TRACE_RECORDS & record)
+    {
+        const unsigned tail = m_tail.load(std::memory_order_relaxed);
+
+        if (tail == m_head.load(std::memory_order_acquire)) return false;
+
+        record = m_records[tail & (Capacity - 1)];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// consumer, number of records lost since the last call
+    inline unsigned takeDropped()
+    {
+        return m_dropped.exchange(0, std::memory_order_relaxed);
+    }
+
+private:
+    static_assert((Capacity & (Capacity - 1)) == 0, "TraceRing capacity must be a power of two");
+
+    TRACE_RECORDS m_records[Capacity];
+    std::atomic<unsigned> m_head;
+    std::atomic<unsigned> m_tail;
+    std::atomic<unsigned> m_dropped;
+};
+
+typedef TraceRing<TRACE_CAPACITY> MonitorRing;
+
+#endif // TRACERING_H
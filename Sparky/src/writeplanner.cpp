@@ -0,0 +1,128 @@
+#include <algorithm>
+#include "writeplanner.h"
+#include "registercodec.h"
+
+WritePlanner::
+WritePlanner() :
+    m_isPlanned(false)
+{
+}
+
+
+void
+WritePlanner::
+clear()
+{
+    m_items.clear();
+    m_spans.clear();
+    m_isPlanned = false;
+}
+
+
+void
+WritePlanner::
+addRegisters(const int address, const uint16_t * regs, const int count, const int tag)
+{
+    WRITE_ITEMS item;
+    item.address = address;
+    item.tag = tag;
+    for (int i = 0; i < count; i++) item.regs.append(regs[i]);
+
+    m_items.append(item);
+    m_isPlanned = false;
+}
+
+
+void
+WritePlanner::
+addFloat(const int address, const float value, const int tag)
+{
+    uint16_t regs[CODEC_WIDE_REGISTERS];
+    DeviceCodec::fromFloat(value, regs);
+    addRegisters(address, regs, CODEC_WIDE_REGISTERS, tag);
+}
+
+
+void
+WritePlanner::
+addInt(const int address, const int value, const int tag)
+{
+    const uint16_t reg = (uint16_t) value;
+    addRegisters(address, &reg, 1, tag);
+}
+
+
+void
+WritePlanner::
+addInt32(const int address, const int32_t value, const int tag)
+{
+    uint16_t regs[CODEC_WIDE_REGISTERS];
+    DeviceCodec::fromInt32(value, regs);
+    addRegisters(address, regs, CODEC_WIDE_REGISTERS, tag);
+}
+
+
+void
+WritePlanner::
+plan()
+{
+    m_spans.clear();
+
+    std::stable_sort(m_items.begin(), m_items.end(), [](const WRITE_ITEMS & a, const WRITE_ITEMS & b) { return a.address < b.address; });
+
+    for (int i = 0; i < m_items.size(); i++)
+    {
+        const WRITE_ITEMS & item = m_items[i];
+
+        /// an item goes whole into the current frame if it follows it directly and fits
+        if (!m_spans.isEmpty())
+        {
+            WRITE_SPANS & span = m_spans.last();
+
+            if ((item.address == span.address + span.regs.size()) && (span.regs.size() + item.regs.size() <= PLANNER_MAX_WRITE_REGISTERS))
+            {
+                span.regs += item.regs;
+                span.last = i;
+                continue;
+            }
+        }
+
+        /// otherwise it opens new frames, split only if it is larger than a frame
+        for (int r = 0; r < item.regs.size(); r += PLANNER_MAX_WRITE_REGISTERS)
+        {
+            WRITE_SPANS span;
+            span.address = item.address + r;
+            span.first = i;
+            span.last = i;
+            span.regs = item.regs.mid(r, PLANNER_MAX_WRITE_REGISTERS);
+            m_spans.append(span);
+        }
+    }
+
+    m_isPlanned = true;
+}
+
+
+int
+WritePlanner::
+registers() const
+{
+    int count = 0;
+    for (int i = 0; i < m_items.size(); i++) count += m_items[i].regs.size();
+    return count;
+}
+
+
+QVector<int>
+WritePlanner::
+tags(const WRITE_SPANS & span) const
+{
+    QVector<int> list;
+
+    for (int i = span.first; i <= span.last; i++)
+    {
+        if (!list.contains(m_items[i].tag)) list.append(m_items[i].tag);
+    }
+
+    return list;
+}
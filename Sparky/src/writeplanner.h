@@ -0,0 +1,63 @@
+#ifndef WRITEPLANNER_H
+#define WRITEPLANNER_H
+
+#include <QVector>
+#include "modbus.h"
+
+/// FC16 limit per frame
+#define PLANNER_MAX_WRITE_REGISTERS 123
+
+typedef struct WRITE_ITEM
+{
+    int address;
+    int tag;
+    QVector<uint16_t> regs;
+
+    WRITE_ITEM() : address(0), tag(-1) {}
+
+} WRITE_ITEMS;
+
+
+typedef struct WRITE_SPAN
+{
+    int address;
+    int first;
+    int last;
+    bool isFailed;
+    QVector<uint16_t> regs;
+
+    WRITE_SPAN() : address(0), first(0), last(0), isFailed(false) {}
+
+} WRITE_SPANS;
+
+
+/// Collects register values to be written, merges items sitting back to
+/// back into as few FC16 frames as possible and remembers which items
+/// (tags, e.g. profile rows) every frame carries so a failed frame can be
+/// reported per item. Addresses are wire addresses (ADDR_OFFSET already
+/// removed). Unlike reads, a write never bridges a gap.
+class WritePlanner
+{
+public:
+    WritePlanner();
+
+    void clear();
+    void addRegisters(const int, const uint16_t *, const int, const int);
+    void addFloat(const int, const float, const int);
+    void addInt(const int, const int, const int);
+    void addInt32(const int, const int32_t, const int);
+    void plan();
+
+    int transactions() const { return m_spans.size(); }
+    int registers() const;
+    const QVector<WRITE_ITEMS> & items() const { return m_items; }
+    const QVector<WRITE_SPANS> & spans() const { return m_spans; }
+    QVector<int> tags(const WRITE_SPANS &) const;
+
+private:
+    bool m_isPlanned;
+    QVector<WRITE_ITEMS> m_items;
+    QVector<WRITE_SPANS> m_spans;
+};
+
+#endif // WRITEPLANNER_H